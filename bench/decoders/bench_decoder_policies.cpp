@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <glog/logging.h>
+#include "decoders/ctc_decoder.hpp"
+#include "decoders/decoder_resources.hpp"
+
+/*
+Decoding time per frame of every search variant (decoders/decoder_policies.hpp) the decoder
+can pick from its resources:
+
+    no lexicon + no lm          tokens only
+    no lexicon + kenlm          lm, no lexicon (words scored from their n-gram strings)
+    fst lexicon + no lm         lexicon, no lm
+    fst lexicon + kenlm         lexicon and lm (word ids when the fst has word labels, strings otherwise)
+
+The emissions are random and peaky (one token takes most of the mass every frame), so the
+beams keep completing words. Each variant decodes the same frames, num_repeats times, and the
+best run is reported.
+
+usage: decoderPoliciesBench path_to_tokens path_to_fst path_to_lm [num_frames [num_beams [num_repeats]]]
+*/
+
+namespace {
+    typedef std::chrono::steady_clock clock_type;
+
+    // [num_frames, num_tokens] log-probs
+    std::vector<float> make_log_probs(size_t num_frames, size_t num_tokens){
+        std::mt19937 generator(7);
+        std::normal_distribution<float> logit(0.0f, 1.0f);
+        std::uniform_int_distribution<size_t> peak(0, num_tokens - 1);
+        std::vector<float> log_probs(num_frames * num_tokens);
+        for (size_t t = 0; t < num_frames; ++t){
+            float* frame = log_probs.data() + t * num_tokens;
+            for (size_t i = 0; i < num_tokens; ++i) frame[i] = logit(generator);
+            frame[peak(generator)] += 6.0f;
+            float max_logit = *std::max_element(frame, frame + num_tokens);
+            double sum = 0;
+            for (size_t i = 0; i < num_tokens; ++i) sum += std::exp(frame[i] - max_logit);
+            float log_sum = max_logit + static_cast<float>(std::log(sum));
+            for (size_t i = 0; i < num_tokens; ++i) frame[i] -= log_sum;
+        }
+        return log_probs;
+    }
+
+    // best ms per frame over num_repeats utterances
+    double time_decoder(ctcDecoder& decoder, const std::vector<float>& log_probs, size_t num_frames, size_t num_repeats){
+        double best_ms = -1;
+        decoder.decode_log_probs(log_probs.data(), std::min<size_t>(num_frames, 50)); // warm-up
+        for (size_t r = 0; r < num_repeats; ++r){
+            decoder.reset();
+            auto start_time = clock_type::now();
+            decoder.decode_log_probs(log_probs.data(), num_frames);
+            double ms = std::chrono::duration<double, std::milli>(clock_type::now() - start_time).count();
+            if (best_ms < 0 || ms < best_ms) best_ms = ms;
+        }
+        return best_ms / num_frames;
+    }
+} // namespace
+
+
+int main(int argc, char* argv[]){
+    if (argc < 4){
+        std::printf("usage: %s path_to_tokens path_to_fst path_to_lm [num_frames [num_beams [num_repeats]]]\n", argv[0]);
+        return 1;
+    }
+    google::InitGoogleLogging(argv[0]);
+    const std::string tokens_path = argv[1];
+    const fs::path fst_path       = argv[2];
+    const fs::path lm_path        = argv[3];
+    const size_t num_frames       = (argc > 4) ? std::atol(argv[4]) : 2000;
+    const size_t num_beams        = (argc > 5) ? std::atol(argv[5]) : 10;
+    const size_t num_repeats      = (argc > 6) ? std::atol(argv[6]) : 5;
+
+    // one registry per configuration (the decoders pick their search from what is loaded)
+    beam::resourceRegistry lexicon_only, lm_only, lexicon_and_lm;
+    if (!lexicon_only.swap_lexicon(fst_path) || !lm_only.swap_lm(lm_path) ||
+        !lexicon_and_lm.swap(fst_path, lm_path)){
+        std::printf("failed to load %s or %s\n", fst_path.c_str(), lm_path.c_str());
+        return 1;
+    }
+    const beam::resourceRegistry* configurations[] = {nullptr, &lm_only, &lexicon_only, &lexicon_and_lm};
+
+    size_t num_tokens = 0;
+    std::vector<float> log_probs;
+    std::printf("%zu frames, %zu beams, best of %zu\n", num_frames, num_beams, num_repeats);
+    std::printf("%-32s %-12s %-12s\n", "search", "ms/frame", "frames/s");
+    for (const beam::resourceRegistry* registry : configurations){
+        ctcDecoder decoder(tokens_path, num_beams);
+        if (registry) decoder.attach(*registry);
+        if (log_probs.empty()){
+            num_tokens = decoder.get_num_tokens();
+            log_probs  = make_log_probs(num_frames, num_tokens);
+        }
+        double ms_per_frame = time_decoder(decoder, log_probs, num_frames, num_repeats);
+        std::printf("%-32s %-12.4f %-12.0f\n", decoder.get_search_variant().c_str(), ms_per_frame,
+                    ms_per_frame > 0 ? 1000.0 / ms_per_frame : 0.0);
+    }
+    return 0;
+}
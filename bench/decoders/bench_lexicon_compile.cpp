@@ -0,0 +1,123 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <glog/logging.h>
+#include "decoders/lexicon.hpp"
+#include "decoders/lexicon_compiler.hpp"
+#include "utils/fst_artifact.hpp"
+
+/*
+Lexicon fst compilation, wall time and peak resident memory per method:
+
+    trie        LexiconFst (shared_ptr trie, recursive copy into the fst, write; a tree, not minimized)
+    compiler/N  lexiconCompiler with N sorting threads (minimal automaton, written directly)
+
+Every method runs in its own child process, so the peak RSS (ru_maxrss from wait4) is the
+method's alone and not the maximum over the ones before it. Also reported: the size of each
+artifact and the time to map it (read_lexicon_fst), the decoder's startup cost for the lexicon.
+
+usage: lexiconCompileBench [num_words [num_threads [path_to_lexicon]]]
+(without a lexicon, num_words random lower case words of 2..14 letters are generated)
+*/
+
+namespace fs = std::filesystem;
+
+namespace {
+    typedef std::chrono::steady_clock clock_type;
+
+    void write_lexicon(const fs::path& path, size_t num_words){
+        std::mt19937 generator(13);
+        std::uniform_int_distribution<int> length(2, 14), letter(0, 25);
+        std::unordered_set<std::string> words;
+        std::ofstream file(path);
+        while (words.size() < num_words){
+            std::string word;
+            for (int i = length(generator); i > 0; --i) word += static_cast<char>('a' + letter(generator));
+            if (!words.insert(word).second) continue;
+            file << word << "\t";
+            for (size_t i = 0; i < word.size(); ++i) file << word[i] << (i + 1 < word.size() ? " " : "\n");
+        }
+    }
+
+    // runs method in a child process: wall seconds and peak RSS in MB, or -1 when it failed
+    template <typename methodFn>
+    std::pair<double, double> run_isolated(const methodFn& method){
+        auto start_time = clock_type::now();
+        pid_t pid = fork();
+        if (pid == 0) _exit(method() ? 0 : 1);
+        int status = 0;
+        struct rusage usage{};
+        if (pid < 0 || wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0){
+            return {-1, -1};
+        }
+        return {std::chrono::duration<double>(clock_type::now() - start_time).count(), usage.ru_maxrss / 1024.0};
+    }
+
+    void print_row(const std::string& name, std::pair<double, double> result, const fs::path& fst_path){
+        if (result.first < 0){
+            std::printf("%-14s failed\n", name.c_str());
+            return;
+        }
+        std::error_code error;
+        auto fst_size = fs::file_size(fst_path, error);
+
+        // what a decoder pays at startup for the artifact (mapped, the page cache is warm from the write)
+        auto load_start = clock_type::now();
+        std::unique_ptr<fst::StdConstFst> loaded_fst(asr::myfst::read_lexicon_fst(fst_path));
+        double load_ms = std::chrono::duration<double, std::milli>(clock_type::now() - load_start).count();
+
+        std::printf("%-14s %-12.3f %-14.1f %-12.1f %-12.2f\n", name.c_str(), result.first, result.second,
+                    error ? 0.0 : fst_size / double(1 << 20), loaded_fst ? load_ms : -1.0);
+    }
+} // namespace
+
+
+int main(int argc, char* argv[]){
+    google::InitGoogleLogging(argv[0]);
+    FLAGS_logtostderr = false;
+
+    const size_t num_words   = (argc > 1) ? std::atol(argv[1]) : 500000;
+    const size_t num_threads = (argc > 2) ? std::atol(argv[2]) : std::max(1u, std::thread::hardware_concurrency());
+
+    fs::path directory = fs::temp_directory_path() / "bench_lexicon_compile";
+    fs::create_directories(directory);
+    fs::path lexicon_path = (argc > 3) ? fs::path(argv[3]) : directory / "lexicon.txt";
+    if (argc <= 3) write_lexicon(lexicon_path, num_words);
+
+    std::printf("lexicon %s (%.1f MB)\n", lexicon_path.c_str(), fs::file_size(lexicon_path) / double(1 << 20));
+    std::printf("%-14s %-12s %-14s %-12s %-12s\n", "method", "wall (s)", "peak rss (MB)", "fst (MB)", "load (ms)");
+
+    fs::path trie_fst = directory / "trie.fst";
+    print_row("trie", run_isolated([&]{
+        LexiconFst lexicon_fst(lexicon_path.string());
+        lexicon_fst.construct_fst_from_lex_file();
+        lexicon_fst.write_fst(trie_fst, true);
+        return true;
+    }), trie_fst);
+
+    for (size_t threads : {size_t(1), num_threads}){
+        fs::path compiler_fst = directory / ("compiler_" + std::to_string(threads) + ".fst");
+        print_row("compiler/" + std::to_string(threads), run_isolated([&]{
+            asr::lexicon::lexiconCompilerConfig config;
+            config.num_threads = threads;
+            asr::lexicon::lexiconCompiler compiler(config);
+            bool ok = compiler.read_lexicon(lexicon_path) && compiler.compile() && compiler.write(compiler_fst);
+            if (ok) std::fprintf(stderr, "  %s\n", compiler.get_stats().summary().c_str());
+            return ok;
+        }), compiler_fst);
+        if (threads == num_threads) break;
+    }
+
+    fs::remove_all(directory);
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <glog/logging.h>
+#include "models/ngrams_model.hpp"
+
+/*
+Word completion lookups of one decoding frame: batch_size beams complete a word, and a fraction
+of them share their (context, word) with another beam (beams that differ only in blanks and
+repeats). Compared, per completed word:
+
+    ngram      score_ngram over the last order words from the null context (the lookups the
+               string path made: order of them per word)
+    state      one score() from the beam's carried context
+    batch      score_batch over the whole frame (duplicates share a lookup)
+
+Use a large binary (a pruned 3-gram fits in the cache and shows little). The contexts are
+spread over the whole vocabulary so the probes miss the cache as they do while decoding.
+
+usage: lmBatchBench path_to_model [batch_size [duplicate_fraction [num_frames]]]
+*/
+
+using namespace asr;
+
+namespace {
+    typedef std::chrono::steady_clock clock_type;
+
+    double seconds_since(clock_type::time_point start){
+        return std::chrono::duration<double>(clock_type::now() - start).count();
+    }
+
+    struct completion{
+        std::vector<ngrams::WordIndex> history; // the last order - 1 words, then the new one
+        ngrams::State state;                     // context after the history
+    };
+} // namespace
+
+
+int main(int argc, char* argv[]){
+    if (argc < 2){
+        std::printf("usage: %s path_to_model [batch_size [duplicate_fraction [num_frames]]]\n", argv[0]);
+        return 1;
+    }
+    google::InitGoogleLogging(argv[0]);
+    const size_t batch_size   = (argc > 2) ? std::atol(argv[2]) : 64;
+    const double duplicates   = (argc > 3) ? std::atof(argv[3]) : 0.5;
+    const size_t num_frames   = (argc > 4) ? std::atol(argv[4]) : 20000;
+
+    ngrams::nGramsModelWrapper model;
+    if (!model.setup_model_from(argv[1])) return 1;
+    const size_t order = model.get_order();
+    std::printf("%s: %s, order %zu, %u words, load %.2f s\n", argv[1], ngrams::model_type_name(model.get_model_type()),
+                order, model.get_vocab_size(), model.get_load_seconds());
+
+    // every frame: batch_size completions, duplicates of them copied from earlier ones in the frame
+    std::mt19937 generator(1234);
+    std::uniform_int_distribution<ngrams::WordIndex> word(1, model.get_vocab_size() - 1);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    std::vector<completion> completions(batch_size * num_frames);
+    for (size_t frame = 0; frame < num_frames; ++frame){
+        for (size_t i = 0; i < batch_size; ++i){
+            auto& current = completions[frame * batch_size + i];
+            if (i > 0 && uniform(generator) < duplicates){
+                current = completions[frame * batch_size + generator() % i];
+                continue;
+            }
+            ngrams::State out_state;
+            model.begin_sentence_state(&current.state);
+            for (size_t w = 0; w + 1 < order; ++w){
+                current.history.push_back(word(generator));
+                model.score(current.state, current.history.back(), &out_state);
+                current.state = out_state;
+            }
+            current.history.push_back(word(generator));
+        }
+    }
+    const size_t num_queries = completions.size();
+
+    double sink = 0;
+    auto start_time = clock_type::now();
+    for (const auto& current : completions){
+        sink += model.score_ngram(current.history, ngrams::LOGITS);
+    }
+    double ngram_seconds = seconds_since(start_time);
+
+    std::vector<ngrams::State> out_states(batch_size);
+    start_time = clock_type::now();
+    for (size_t q = 0; q < num_queries; ++q){
+        sink += model.score(completions[q].state, completions[q].history.back(), &out_states[q % batch_size]);
+    }
+    double state_seconds = seconds_since(start_time);
+
+    std::vector<ngrams::lmQuery> queries(batch_size);
+    size_t num_lookups = 0;
+    start_time = clock_type::now();
+    for (size_t frame = 0; frame < num_frames; ++frame){
+        for (size_t i = 0; i < batch_size; ++i){
+            const auto& current = completions[frame * batch_size + i];
+            queries[i].in_state  = &current.state;
+            queries[i].word_id   = current.history.back();
+            queries[i].out_state = &out_states[i];
+        }
+        num_lookups += model.score_batch(queries.data(), batch_size);
+        for (const auto& query : queries) sink += query.score;
+    }
+    double batch_seconds = seconds_since(start_time);
+
+    std::printf("%zu frames x %zu completions, %.0f%% duplicates (batch made %zu lookups for %zu words)\n",
+                num_frames, batch_size, duplicates * 100, num_lookups, num_queries);
+    std::printf("%-8s %-14s %-10s\n", "path", "ns per word", "speedup");
+    std::printf("%-8s %-14.1f %-10.2f\n", "ngram", ngram_seconds * 1e9 / num_queries, 1.0);
+    std::printf("%-8s %-14.1f %-10.2f\n", "state", state_seconds * 1e9 / num_queries, ngram_seconds / state_seconds);
+    std::printf("%-8s %-14.1f %-10.2f\n", "batch", batch_seconds * 1e9 / num_queries, ngram_seconds / batch_seconds);
+    if (sink == 1) std::printf(" "); // keeps the scoring from being optimized away
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <glog/logging.h>
+#include "models/ngrams_model.hpp"
+
+/*
+Memory and per-query latency of the KenLM data structures on the same arpa: probing, trie,
+quantized trie, array trie and quantized array trie. Every model is compiled to a temporary
+binary, loaded with READ (so the resident size is the model and not whatever the page cache
+happens to hold) and queried with the same random word sequences through the wrapper's
+lm::base::Model interface.
+
+usage: lmTypesBench path_to_arpa [num_queries]
+*/
+
+namespace fs = std::filesystem;
+using namespace asr;
+
+namespace {
+    typedef std::chrono::steady_clock clock_type;
+
+    size_t resident_bytes(){
+        std::ifstream statm("/proc/self/statm");
+        size_t total_pages = 0, resident_pages = 0;
+        statm >> total_pages >> resident_pages;
+        return resident_pages * sysconf(_SC_PAGESIZE);
+    }
+
+    // sentences of 2-10 random words
+    std::vector<std::vector<std::string>> make_queries(const std::vector<std::string>& words, size_t num_queries){
+        std::mt19937 generator(1234);
+        std::uniform_int_distribution<size_t> word(0, words.size() - 1), length(2, 10);
+        std::vector<std::vector<std::string>> queries(num_queries);
+        for (auto& query : queries){
+            size_t query_length = length(generator);
+            for (size_t i = 0; i < query_length; ++i) query.push_back(words[word(generator)]);
+        }
+        return queries;
+    }
+
+    // the unigrams of the arpa, used as query words
+    std::vector<std::string> read_unigrams(const fs::path& arpa_path, size_t max_words){
+        std::ifstream arpa(arpa_path);
+        std::vector<std::string> words;
+        std::string line;
+        bool in_unigrams = false;
+        while (std::getline(arpa, line) && words.size() < max_words){
+            if (line == "\\1-grams:"){in_unigrams = true; continue;}
+            if (!in_unigrams) continue;
+            if (line.empty() || line[0] == '\\') break;
+            size_t first_tab  = line.find('\t');
+            size_t second_tab = line.find('\t', first_tab + 1);
+            std::string word  = line.substr(first_tab + 1, second_tab - first_tab - 1);
+            if (word != "<s>" && word != "</s>" && word != "<unk>") words.push_back(word);
+        }
+        return words;
+    }
+} // namespace
+
+
+int main(int argc, char* argv[]){
+    if (argc < 2){
+        std::printf("usage: %s path_to_arpa [num_queries]\n", argv[0]);
+        return 1;
+    }
+    google::InitGoogleLogging(argv[0]);
+    fs::path arpa_path       = argv[1];
+    const size_t num_queries = (argc > 2) ? std::atol(argv[2]) : 200000;
+
+    auto words   = read_unigrams(arpa_path, 50000);
+    auto queries = make_queries(words, num_queries);
+    size_t num_words = 0;
+    for (const auto& query : queries) num_words += query.size();
+    std::printf("%s: %zu queries, %zu words\n", arpa_path.c_str(), num_queries, num_words);
+    std::printf("%-22s %-12s %-12s %-12s %-16s\n", "model", "file (MB)", "rss (MB)", "load (s)", "per word (ns)");
+
+    for (auto model_type : {lm::ngram::PROBING, lm::ngram::TRIE, lm::ngram::QUANT_TRIE,
+                            lm::ngram::ARRAY_TRIE, lm::ngram::QUANT_ARRAY_TRIE}){
+        fs::path binary_path = fs::temp_directory_path() / ("bench_lm_types_" + std::to_string(model_type) + ".bin");
+        if (!ngrams::compile_arpa_to_binary(arpa_path, binary_path, model_type)){
+            std::printf("%-22s failed to compile\n", ngrams::model_type_name(model_type));
+            continue;
+        }
+
+        double score_sink = 0;
+        size_t rss_before = resident_bytes();
+        {
+            ngrams::nGramsModelWrapper model;
+            if (!model.setup_model_from(binary_path, util::READ)) continue;
+            size_t rss_model = resident_bytes() - rss_before;
+
+            auto start_time = clock_type::now();
+            for (const auto& query : queries){
+                score_sink += model.score_sentence(query, ngrams::LOGITS);
+            }
+            double elapsed = std::chrono::duration<double>(clock_type::now() - start_time).count();
+            std::printf("%-22s %-12.1f %-12.1f %-12.3f %-16.1f\n", ngrams::model_type_name(model_type),
+                        fs::file_size(binary_path) / double(1 << 20), rss_model / double(1 << 20),
+                        model.get_load_seconds(), elapsed * 1e9 / num_words);
+        }
+        fs::remove(binary_path);
+        if (score_sink == 1) std::printf(" "); // keeps the scoring from being optimized away
+    }
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glog/logging.h>
+#include "pipeline/channel_sessions.hpp"
+#include "utils/wav_reader.hpp"
+
+/*
+End-to-end cost of multi-channel recognition: channelSessions over 1 to max_channels capture
+channels, every channel fed the wav file (shifted, so no two channels carry the same signal)
+as fast as the sessions take it. One torchModelPool serves the forward passes of all the
+channels and every channel has its own decoder (tokens only, no lexicon or lm).
+
+Reported per channel count: wall time, seconds of audio per second of wall time over all the
+channels, and the mean forward (pool wait included) and decode time per chunk. The capture side
+alone (de-interleaving) is measured by bench/utils/bench_multichannel_capture.cpp.
+
+usage: channelSessionsBench path_to_tokens path_to_model path_to_wav [max_channels [num_workers [chunk_frames]]]
+*/
+
+namespace {
+    typedef std::chrono::steady_clock clock_type;
+
+    struct sessionsRun{
+        double wall_seconds = 0;
+        double forward_ms   = 0; // per chunk
+        double decode_ms    = 0; // per chunk
+        size_t num_failed   = 0;
+    };
+
+    sessionsRun run_channels(size_t num_channels,
+                             const std::vector<float>& audio,
+                             const std::string& tokens_path,
+                             torchModelPool& model_pool,
+                             size_t chunk_frames){
+        const double sample_rate = 16000;
+        const size_t block       = 512; // frames per simulated callback
+        const size_t ring_frames = 4 * chunk_frames;
+        asr::audio::multiChannelCaptureSink capture_sink(sample_rate, ring_frames, num_channels);
+        asr::pipeline::channelSessionConfig config;
+        config.chunk_frames = chunk_frames;
+        asr::pipeline::channelSessions sessions(capture_sink, model_pool,
+            [&tokens_path](size_t){return std::make_unique<ctcDecoder>(tokens_path, 10);}, config);
+
+        std::vector<float> interleaved;
+        auto start_time = clock_type::now();
+        sessions.start();
+        for (size_t begin = 0; begin < audio.size(); begin += block){
+            // wait for the sessions instead of dropping frames
+            for (size_t c = 0; c < num_channels; ++c){
+                while (capture_sink.get_channel(c).get_available() + block > ring_frames){
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+                }
+            }
+            size_t num_frames = std::min(block, audio.size() - begin);
+            interleaved.clear();
+            for (size_t t = begin; t < begin + num_frames; ++t){
+                for (size_t c = 0; c < num_channels; ++c){
+                    interleaved.push_back(audio[(t + c * audio.size() / num_channels) % audio.size()]);
+                }
+            }
+            capture_sink.on_audio(interleaved.data(), num_frames, begin / sample_rate, 0, false, false);
+        }
+        for (size_t c = 0; c < num_channels; ++c){
+            while (capture_sink.get_channel(c).get_available() >= chunk_frames){
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        }
+        sessions.stop();
+
+        sessionsRun run;
+        run.wall_seconds = std::chrono::duration<double>(clock_type::now() - start_time).count();
+        size_t num_chunks = 0;
+        for (const auto& channel_stats : sessions.get_stats()){
+            num_chunks    += channel_stats.num_chunks;
+            run.forward_ms += channel_stats.forward_ms;
+            run.decode_ms  += channel_stats.decode_ms;
+            run.num_failed += channel_stats.error.empty() ? 0 : 1;
+        }
+        if (num_chunks > 0){
+            run.forward_ms /= num_chunks;
+            run.decode_ms  /= num_chunks;
+        }
+        return run;
+    }
+} // namespace
+
+
+int main(int argc, char* argv[]){
+    if (argc < 4){
+        std::printf("usage: %s path_to_tokens path_to_model path_to_wav [max_channels [num_workers [chunk_frames]]]\n", argv[0]);
+        return 1;
+    }
+    google::InitGoogleLogging(argv[0]);
+    const std::string tokens_path = argv[1];
+    const std::string model_path  = argv[2];
+    const std::string wav_path    = argv[3];
+    const size_t max_channels     = (argc > 4) ? std::atol(argv[4]) : asr::audio::multiChannelCaptureSink::MAX_CHANNELS;
+    const size_t num_workers      = (argc > 5) ? std::atol(argv[5]) : 2;
+    const size_t chunk_frames     = (argc > 6) ? std::atol(argv[6]) : 16000;
+
+    asr::audio::wavReader wav_reader(wav_path);
+    std::vector<float> audio = wav_reader.read_all();
+    if (audio.empty()){
+        std::printf("failed to read %s\n", wav_path.c_str());
+        return 1;
+    }
+    modelPoolConfig pool_config;
+    pool_config.num_workers = num_workers;
+    torchModelPool model_pool{pool_config};
+    if (!model_pool.load_model(model_path)){
+        std::printf("failed to load %s\n", model_path.c_str());
+        return 1;
+    }
+
+    double audio_seconds = audio.size() / 16000.0;
+    std::printf("%.1f s of audio per channel, %zu pool workers, %zu frames per chunk\n",
+                audio_seconds, num_workers, chunk_frames);
+    std::printf("%-10s %-12s %-16s %-18s %-18s %-8s\n", "channels", "wall (s)", "audio s / wall s",
+                "forward ms/chunk", "decode ms/chunk", "failed");
+    for (size_t num_channels = 1; num_channels <= max_channels; num_channels *= 2){
+        auto run = run_channels(num_channels, audio, tokens_path, model_pool, chunk_frames);
+        std::printf("%-10zu %-12.2f %-16.2f %-18.2f %-18.2f %-8zu\n", num_channels, run.wall_seconds,
+                    num_channels * audio_seconds / run.wall_seconds, run.forward_ms, run.decode_ms, run.num_failed);
+    }
+    return 0;
+}
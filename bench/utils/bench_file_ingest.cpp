@@ -0,0 +1,163 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "utils/file_ingest.hpp"
+#include "utils/wav_reader.hpp"
+
+/*
+Offline ingestion: num_files wav recordings are parsed by num_workers workers that also burn
+compute_ms of cpu per file (a stand-in for inference). Compared:
+
+    ifstream  every worker reads its next file whole, then computes (file at a time, as readwav did)
+    pread     fileIngestor with the pread thread pool
+    io_uring  fileIngestor with io_uring
+
+The page cache of every file is dropped (POSIX_FADV_DONTNEED) before each run, so the reads
+hit the disk. "io wait" is the time the workers spent waiting for data, summed over workers.
+For a truly cold cache run as root after `echo 3 > /proc/sys/vm/drop_caches`.
+
+usage: fileIngestBench [num_files [compute_ms [num_workers [directory]]]]
+(without a directory, 30 s 16-bit files are generated in the temp directory)
+*/
+
+namespace fs = std::filesystem;
+
+namespace {
+    typedef std::chrono::steady_clock clock_type;
+
+    double seconds_since(clock_type::time_point start){
+        return std::chrono::duration<double>(clock_type::now() - start).count();
+    }
+
+    void write_wav(const fs::path& path, size_t num_samples, size_t seed){
+        std::vector<int16_t> samples(num_samples);
+        for (size_t i = 0; i < num_samples; ++i){
+            samples[i] = static_cast<int16_t>(8000 * std::sin(0.01 * (i + seed)));
+        }
+        auto put_u32 = [](std::ofstream& file, uint32_t value){file.write(reinterpret_cast<const char*>(&value), 4);};
+        auto put_u16 = [](std::ofstream& file, uint16_t value){file.write(reinterpret_cast<const char*>(&value), 2);};
+        std::ofstream file(path, std::ios::binary);
+        file << "RIFF"; put_u32(file, 36 + num_samples * 2); file << "WAVE";
+        file << "fmt "; put_u32(file, 16); put_u16(file, 1); put_u16(file, 1);
+        put_u32(file, 16000); put_u32(file, 32000); put_u16(file, 2); put_u16(file, 16);
+        file << "data"; put_u32(file, num_samples * 2);
+        file.write(reinterpret_cast<const char*>(samples.data()), samples.size() * 2);
+    }
+
+    void drop_page_cache(const std::vector<fs::path>& paths){
+        for (const auto& path : paths){
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) continue;
+            fdatasync(fd);
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            ::close(fd);
+        }
+    }
+
+    // parse + convert, then spin for compute_ms (the model's share of the work)
+    double consume(const uint8_t* data, size_t size, double compute_ms){
+        asr::audio::wavReader wav_reader;
+        double checksum = 0;
+        if (wav_reader.open_memory(data, size)){
+            auto audio = wav_reader.read_all();
+            if (!audio.empty()) checksum = audio[audio.size() / 2];
+        }
+        auto start_time = clock_type::now();
+        while (seconds_since(start_time) * 1000 < compute_ms){}
+        return checksum;
+    }
+
+    void print_row(const char* name, double wall, double io_wait, double compute, size_t bytes){
+        std::printf("%-10s %-12.3f %-14.3f %-14.3f %-12.1f\n", name, wall, io_wait, compute, bytes / wall / (1 << 20));
+    }
+
+    void bench_ifstream(const std::vector<fs::path>& paths, double compute_ms, size_t num_workers){
+        std::atomic<size_t> next{0}, bytes{0};
+        std::vector<double> io_wait(num_workers, 0), compute(num_workers, 0);
+        auto start_time = clock_type::now();
+        std::vector<std::thread> workers;
+        for (size_t w = 0; w < num_workers; ++w){
+            workers.emplace_back([&, w]{
+                std::vector<uint8_t> buffer;
+                for (size_t i = next++; i < paths.size(); i = next++){
+                    auto read_start = clock_type::now();
+                    std::ifstream file(paths[i], std::ios::binary);
+                    buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+                    io_wait[w] += seconds_since(read_start);
+                    bytes += buffer.size();
+
+                    auto compute_start = clock_type::now();
+                    consume(buffer.data(), buffer.size(), compute_ms);
+                    compute[w] += seconds_since(compute_start);
+                }
+            });
+        }
+        for (auto& worker : workers) worker.join();
+        double total_wait = 0, total_compute = 0;
+        for (size_t w = 0; w < num_workers; ++w){
+            total_wait    += io_wait[w];
+            total_compute += compute[w];
+        }
+        print_row("ifstream", seconds_since(start_time), total_wait, total_compute, bytes);
+    }
+
+    void bench_ingestor(const std::vector<fs::path>& paths, double compute_ms, size_t num_workers,
+                        asr::audio::ingestBackend backend){
+        asr::audio::ingestConfig config;
+        config.backend     = backend;
+        config.num_workers = num_workers;
+        asr::audio::fileIngestor ingestor(config);
+        auto stats = ingestor.run(paths, [compute_ms](const asr::audio::ingestedFile& file){
+            if (file.ok) consume(file.data, file.size, compute_ms);
+        });
+        print_row(stats.backend == asr::audio::INGEST_IO_URING ? "io_uring" : "pread",
+                  stats.wall_seconds, stats.io_wait_seconds, stats.consumer_seconds, stats.bytes_read);
+    }
+} // namespace
+
+
+int main(int argc, char* argv[]){
+    const size_t num_files   = (argc > 1) ? std::atol(argv[1]) : 200;
+    const double compute_ms  = (argc > 2) ? std::atof(argv[2]) : 5.0;
+    const size_t num_workers = (argc > 3) ? std::atol(argv[3]) : 4;
+
+    fs::path directory;
+    bool generated = argc <= 4;
+    std::vector<fs::path> paths;
+    if (generated){
+        directory = fs::temp_directory_path() / "bench_file_ingest";
+        fs::create_directories(directory);
+        for (size_t i = 0; i < num_files; ++i){
+            paths.push_back(directory / ("recording_" + std::to_string(i) + ".wav"));
+            if (!fs::exists(paths.back())) write_wav(paths.back(), 30 * 16000, i);
+        }
+    }
+    else{
+        directory = argv[4];
+        for (const auto& entry : fs::directory_iterator(directory)){
+            if (entry.path().extension() == ".wav" && paths.size() < num_files) paths.push_back(entry.path());
+        }
+    }
+
+    std::printf("%zu files, %.1f ms compute per file, %zu workers, io_uring available: %s\n", paths.size(),
+                compute_ms, num_workers, asr::audio::fileIngestor::is_io_uring_available() ? "yes" : "no");
+    std::printf("%-10s %-12s %-14s %-14s %-12s\n", "reader", "wall (s)", "io wait (s)", "compute (s)", "MB/s");
+
+    drop_page_cache(paths);
+    bench_ifstream(paths, compute_ms, num_workers);
+    drop_page_cache(paths);
+    bench_ingestor(paths, compute_ms, num_workers, asr::audio::INGEST_PREAD);
+    drop_page_cache(paths);
+    bench_ingestor(paths, compute_ms, num_workers, asr::audio::INGEST_IO_URING);
+
+    if (generated) fs::remove_all(directory);
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "utils/capture_sink.hpp"
+#include "utils/simd_kernels.hpp"
+
+/*
+Front-end cost of N-channel capture: the callback side (de-interleave into per-channel rings)
+and the consumer side (every channel read back as float), for 1 to 8 channels and both sample
+formats. The cost per channel-second should stay flat as channels are added; the per-channel
+recognition cost (one forward pass and one decode per channel) comes on top of it and is
+measured end to end, through channelSessions, by bench/pipeline/bench_channel_sessions.cpp.
+*/
+
+namespace {
+    typedef std::chrono::steady_clock clock_type;
+
+    template <typename T>
+    double bench_channels(size_t num_channels, size_t seconds, asr::audio::captureSampleFormat format){
+        const double sample_rate = 16000;
+        const size_t block       = 256; // frames per callback
+        asr::audio::multiChannelCaptureSink sink(sample_rate, 4 * block, num_channels, format);
+        std::vector<T> interleaved(block * num_channels);
+        for (size_t i = 0; i < interleaved.size(); ++i) interleaved[i] = static_cast<T>(i % 1000);
+        std::vector<float> out(block);
+
+        size_t num_callbacks = static_cast<size_t>(seconds * sample_rate / block);
+        auto start_time = clock_type::now();
+        for (size_t i = 0; i < num_callbacks; ++i){
+            sink.on_audio(interleaved.data(), block, i * block / sample_rate, 0, false, false);
+            for (size_t c = 0; c < num_channels; ++c){
+                sink.get_channel(c).read(out.data(), block);
+            }
+        }
+        return std::chrono::duration<double>(clock_type::now() - start_time).count();
+    }
+} // namespace
+
+
+int main(int argc, char* argv[]){
+    const size_t seconds = (argc > 1) ? std::atol(argv[1]) : 600; // of audio per channel
+
+    std::printf("avx2: %s, %zu s of 16 kHz audio per channel\n", asr::simd::has_avx2() ? "yes" : "no", seconds);
+    std::printf("%-10s %-8s %-14s %-22s %-18s\n", "channels", "format", "total (ms)", "per channel-s (us)", "% of one core");
+    for (size_t num_channels : {1, 2, 4, 8}){
+        for (auto format : {asr::audio::CAPTURE_FLOAT32, asr::audio::CAPTURE_INT16}){
+            double elapsed = (format == asr::audio::CAPTURE_INT16)
+                ? bench_channels<int16_t>(num_channels, seconds, format)
+                : bench_channels<float>(num_channels, seconds, format);
+            double per_channel_second = elapsed / (num_channels * seconds);
+            std::printf("%-10zu %-8s %-14.2f %-22.3f %-18.4f\n", num_channels,
+                        format == asr::audio::CAPTURE_INT16 ? "int16" : "float32",
+                        elapsed * 1000, per_channel_second * 1e6, 100.0 * elapsed / seconds);
+        }
+    }
+    return 0;
+}
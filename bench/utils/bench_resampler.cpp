@@ -0,0 +1,47 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "utils/resampler.hpp"
+#include "utils/simd_kernels.hpp"
+
+/*
+Cost of one resampled stream, fed the way the capture callback feeds it (10 ms chunks).
+Reports the fraction of a core one real-time stream needs at the model rate (16 kHz).
+*/
+
+using namespace asr::audio;
+
+
+int main(int argc, char* argv[]){
+    const double stream_seconds = (argc > 1) ? std::atof(argv[1]) : 60.0;
+    const uint32_t model_rate   = 16000;
+
+    std::printf("avx2: %s\n", asr::simd::has_avx2() ? "on" : "off");
+    std::printf("%-12s %-10s %-12s %-12s %-12s\n", "rate (Hz)", "taps", "ms/stream-s", "x realtime", "% of a core");
+
+    for (uint32_t input_rate : {48000u, 44100u, 22050u, 8000u}){
+        size_t chunk_size  = input_rate / 100;
+        size_t num_samples = static_cast<size_t>(stream_seconds * input_rate);
+        std::vector<float> audio(num_samples);
+        for (size_t i = 0; i < num_samples; ++i){
+            audio[i] = 0.3f * std::sin(0.021f * i) + 0.1f * std::sin(0.37f * i);
+        }
+
+        polyphaseResampler resampler(input_rate, model_rate);
+        std::vector<float> output;
+        output.reserve(chunk_size * 2);
+
+        auto start_time = std::chrono::steady_clock::now();
+        for (size_t begin = 0; begin + chunk_size <= num_samples; begin += chunk_size){
+            output.clear();
+            resampler.process(audio.data() + begin, chunk_size, output);
+        }
+        double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+        std::printf("%-12u %-10zu %-12.3f %-12.0f %-12.4f\n", input_rate, resampler.get_taps_per_phase(),
+                    elapsed_s * 1000 / stream_seconds, stream_seconds / elapsed_s, 100 * elapsed_s / stream_seconds);
+    }
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "utils/ring_buffer.hpp"
+
+/*
+Producer/consumer throughput of the mutex ringBuffer (one element per call, as the capture
+path used it) against spscRingBuffer (bulk blocks of callback size). Both rings hold the same
+number of samples and neither side is allowed to drop data.
+*/
+
+namespace {
+    typedef std::chrono::steady_clock clock_type;
+
+    double seconds_since(clock_type::time_point start){
+        return std::chrono::duration<double>(clock_type::now() - start).count();
+    }
+
+
+    double bench_mutex_ring(size_t total, size_t capacity, size_t block){
+        ringBuffer<float> ring(capacity);
+        auto start_time = clock_type::now();
+        std::thread producer([&]{
+            for (size_t sent = 0; sent < total; ){
+                if (ring.size() + block > capacity){ // insert() would overwrite unread samples
+                    std::this_thread::yield();
+                    continue;
+                }
+                for (size_t i = 0; i < block; ++i) ring.insert(static_cast<float>(sent + i));
+                sent += block;
+            }
+        });
+        volatile float sink = 0;
+        for (size_t received = 0; received < total; ){
+            if (ring.size() == 0){ // pop() throws when empty
+                std::this_thread::yield();
+                continue;
+            }
+            sink = ring.pop();
+            ++received;
+        }
+        producer.join();
+        return seconds_since(start_time);
+    }
+
+
+    double bench_spsc_ring(size_t total, size_t capacity, size_t block){
+        asr::spscRingBuffer<float> ring(capacity);
+        auto start_time = clock_type::now();
+        std::thread producer([&]{
+            std::vector<float> samples(block);
+            for (size_t sent = 0; sent < total; ){
+                if (ring.capacity() - ring.size() < block){
+                    std::this_thread::yield();
+                    continue;
+                }
+                for (size_t i = 0; i < block; ++i) samples[i] = static_cast<float>(sent + i);
+                sent += ring.write(samples.data(), block);
+            }
+        });
+        std::vector<float> out(block);
+        for (size_t received = 0; received < total; ){
+            size_t count = ring.read(out.data(), out.size());
+            if (count == 0) std::this_thread::yield();
+            received += count;
+        }
+        producer.join();
+        return seconds_since(start_time);
+    }
+} // namespace
+
+
+int main(int argc, char* argv[]){
+    const size_t total    = (argc > 1) ? std::atol(argv[1]) : (1 << 24);
+    const size_t capacity = 1 << 14;
+
+    std::printf("%-8s %-26s %-30s %-8s\n", "block", "ringBuffer (Msamples/s)", "spscRingBuffer (Msamples/s)", "speedup");
+    for (size_t block : {64, 256, 1024}){
+        double mutex_s = bench_mutex_ring(total, capacity, block);
+        double spsc_s  = bench_spsc_ring(total, capacity, block);
+        std::printf("%-8zu %-26.1f %-30.1f %-8.1f\n", block, total / mutex_s / 1e6, total / spsc_s / 1e6, mutex_s / spsc_s);
+    }
+    return 0;
+}
@@ -8,7 +8,9 @@
 #include <cstring>
 #include <iostream>
 #include <algorithm>
+#include <atomic>
 #include <fst/fstlib.h>
+#include <kenlm/lm/state.hh>
 #include "utils/fst_glog_safe_log.hpp"
 
 
@@ -201,8 +203,9 @@ struct beamEqual{
 
 
 // for easier readability  
-typedef fst::SortedMatcher<fst::StdVectorFst> FSTMATCH;
-typedef fst::StdVectorFst FSTDICT;
+// the dictionary is read only: a ConstFst, mmapped from the lexicon artifact (utils/fst_artifact.hpp)
+typedef fst::StdConstFst FSTDICT;
+typedef fst::SortedMatcher<FSTDICT> FSTMATCH;
 typedef fst::StdArc::StateId dictState;
 typedef fst::SymbolTable SymbolTable;
 
@@ -210,17 +213,23 @@ typedef fst::SymbolTable SymbolTable;
 struct ctcBeam : public Beam{
 private:
 
-    // fst-related data 
-    static std::unique_ptr<FSTDICT> dictionary_ptr_;
-    static std::unique_ptr<FSTMATCH> matcher_ptr_;
+    // fst-related data: the dictionary of the decoder running on this thread (ctcDecoder binds its
+    // pinned resources version before every step, see decoders/decoder_resources.hpp), so decoders
+    // on different threads can use different lexicon versions and each has its own matcher
+    static inline thread_local const FSTDICT* dictionary_ptr_ = nullptr;
+    static inline thread_local FSTMATCH* matcher_ptr_ = nullptr;
     dictState dictionary_state_;
 
-    // instance control 
-    static inline int instances_count_ = 0;
+    // lexicon ids of the completed words (see decoders/word_map.hpp) and the lm context after them
+    std::vector<int32_t> word_ids_;
+    lm::ngram::State lm_state_;
 
-    // tokens : chars relationship 
-    static std::unordered_map<char, int> char2index_;
-    static std::unique_ptr<SymbolTable> input_symbol_table_; // static inline
+    // instance control (beams are created and deleted by the decoders of every thread)
+    static inline std::atomic<int> instances_count_{0};
+
+    // tokens : chars relationship (per thread, like the fst pointers: decoders never share it)
+    static inline thread_local std::unordered_map<char, int> char2index_;
+    static inline thread_local const SymbolTable* input_symbol_table_ = nullptr;
 
 public:
 
@@ -233,8 +242,8 @@ public:
     prob_nb_prev, prob_b_prev; 
     double score;
     
-    // constructor
-    ctcBeam() : dictionary_state_(0){
+    // constructor (at the start state of the bound dictionary)
+    ctcBeam() : dictionary_state_(get_start_state()){
         ++instances_count_;
         prob_nb_cur  = -INF_DOUBLE;
         prob_b_cur   = -INF_DOUBLE;
@@ -246,7 +255,7 @@ public:
 
     
     ctcBeam(std::string some_sequence) : 
-        Beam(some_sequence, 0), dictionary_state_(0) {
+        Beam(some_sequence, 0), dictionary_state_(get_start_state()) {
             ++instances_count_;
             prob_nb_cur  = -INF_DOUBLE;
             prob_b_cur   = -INF_DOUBLE;
@@ -261,6 +270,8 @@ public:
         */
         // copy the fst related info
         this->dictionary_state_ = other.dictionary_state_;
+        this->word_ids_         = other.word_ids_;
+        this->lm_state_         = other.lm_state_;
         ++instances_count_;
 
         this->last_word_window = other.last_word_window;
@@ -275,6 +286,8 @@ public:
     ctcBeam* Copy(){ 
         ctcBeam* new_copy = new ctcBeam{this->get_sequence()};
         new_copy->dictionary_state_ = this->dictionary_state_;
+        new_copy->word_ids_         = this->word_ids_;
+        new_copy->lm_state_         = this->lm_state_;
         // new_copy->prob_b_prev  = this->prob_b_prev;
         // new_copy->prob_nb_prev = this->prob_nb_prev;
         return new_copy;
@@ -282,10 +295,8 @@ public:
 
     ~ctcBeam(){
         // remove this instance from the count
-        --instances_count_;
-
         // free memory of static members 
-        if (instances_count_ < 1){
+        if (--instances_count_ < 1){
             // dictionary_ptr_.reset();
             // matcher_ptr_.reset();
             // input_symbol_table_ I don't think I need to do anything here, as this recives a copy and not a ptr or reference 
@@ -293,18 +304,28 @@ public:
 
     }
     
-    static int get_instances_count(){return instances_count_;}
+    static int get_instances_count(){return instances_count_.load();}
 
     // fst-related methods 
-    static void set_fst(FSTDICT* fst_dictionary, fst::SymbolTable* symbol_table){ 
-        dictionary_ptr_ = std::unique_ptr<FSTDICT>(fst_dictionary);
-        matcher_ptr_ = std::make_unique<FSTMATCH>(fst_dictionary, fst::MATCH_INPUT);
-        input_symbol_table_ = std::unique_ptr<SymbolTable>(symbol_table);
+    // the caller keeps all three alive while the thread decodes with them
+    static void bind_fst(const FSTDICT* fst_dictionary, FSTMATCH* matcher, const SymbolTable* symbol_table){
+        dictionary_ptr_     = fst_dictionary;
+        matcher_ptr_        = matcher;
+        input_symbol_table_ = symbol_table;
     }
 
 
+    static const FSTDICT* get_fst(){return dictionary_ptr_;}
+    static dictState get_start_state(){return dictionary_ptr_ ? dictionary_ptr_->Start() : 0;}
+    static const SymbolTable* get_input_symbols(){return input_symbol_table_;}
+
     dictState get_dict_state(){return dictionary_state_;}
 
+    // word history
+    void push_word(int32_t word_id){word_ids_.push_back(word_id);}
+    const std::vector<int32_t>& get_word_ids() const {return word_ids_;}
+    lm::ngram::State* get_lm_state(){return &lm_state_;}
+
     ctcBeam* get_new_beam(char symbol);
     
     double get_score() const {return score;}
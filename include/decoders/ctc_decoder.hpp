@@ -1,14 +1,23 @@
+#ifndef _ASR_REALTIME_CTC_DECODER
+#define _ASR_REALTIME_CTC_DECODER
+
 #include <vector>
 #include <string>
+#include <algorithm>
 #include <torch/script.h>
 #include <unordered_map>
 #include <tuple>
 #include <queue>
 #include "beam.hpp"
 #include "decoders/beams_map.hpp"
+#include "decoders/decoder_policies.hpp"
+#include "decoders/decoder_resources.hpp"
 #include "decoders/lexicon_fst.hpp"
+#include "decoders/word_map.hpp"
 #include "models/ngrams_model.hpp"
 #include "utils/my_utils.hpp"
+#include "utils/emission_cache.hpp"
+#include "utils/sparse_emissions.hpp"
 
 using namespace asr;
 
@@ -28,6 +37,8 @@ struct DecodingInfo{
     char word_delimiter = '|';  
     char blank_token    = '-';
     int lm_order = 3; // 
+    double cutoff_prob  = 0.95; // vocabulary pruning per frame
+    size_t cutoff_top_n = 5;
     std::string sentence_start_token = "<s>";
 
     // getters 
@@ -37,6 +48,11 @@ struct DecodingInfo{
 
     // setters
     void set_alpha(float new_alpha){alpha = new_alpha;}
+    void set_beta(float new_beta){beta = new_beta;}
+    void set_pruning(double new_cutoff_prob, size_t new_cutoff_top_n){
+        cutoff_prob  = new_cutoff_prob;
+        cutoff_top_n = new_cutoff_top_n;
+    }
     void set_word_delimiter(char new_word_delimiter){word_delimiter = new_word_delimiter;}
     void set_lm_order(int new_lm_order){lm_order = new_lm_order;}
     void set_sentence_start_token(std::string new_sentence_start_token){sentence_start_token = new_sentence_start_token;}
@@ -50,10 +66,29 @@ private:
     beam::BeamPtrMap _beams_map;
     std::vector<beam::ctcBeam*> _top_beams;
     DecodingInfo _decoding_info;
-    ngrams::nGramsModelWrapper _ngrams_model; // this need the path to the model to be set
-    bool _use_lm_model_flag = false; // FUTURE: I don't like the idea of having to repeatedly check a use
-                                // condition that is static throughout the application lifetime
-                                // I might use a strategy patten or a warpper function 
+    size_t _step_counter = 1; // frame of the current utterance (logging)
+
+    // lexicon, lm and word map (empty: the lexicon fst has no word labels, words are scored by string).
+    // pinned for the whole utterance: an attached registry's swaps are only taken in reset()
+    std::shared_ptr<const beam::decoderResources> _resources = std::make_shared<beam::decoderResources>();
+    const beam::resourceRegistry* _registry = nullptr;
+    std::unique_ptr<beam::FSTMATCH> _matcher; // per decoder: the matcher keeps its search state
+
+    // word completions of the current frame, scored in one batch before the beams are ranked
+    struct pendingWord{
+        beam::ctcBeam* child;
+        double log_p;  // the ctc part of the child's new p_nb
+        int query;     // index in _lm_queries, -1: the word is not in the lm
+    };
+    std::vector<pendingWord> _pending_words;
+    std::vector<ngrams::lmQuery> _lm_queries;
+    bool _use_lm_model_flag = false; // per utterance only (initial lm state, warm-up)
+
+    // the search of the pinned resources (decoders/decoder_policies.hpp): the lexicon and lm checks
+    // are compiled into the instantiation instead of being tested for every token
+    typedef void (ctcDecoder::*expandBeamFn)(beam::ctcBeam*, const std::vector<std::pair<size_t, double>>&);
+    expandBeamFn _expand_beam = &ctcDecoder::expand_beam_with<beam::policy::noLm, beam::policy::noLexicon>;
+    std::string _search_variant = "no lexicon + no lm";
 
 
 public:
@@ -78,17 +113,47 @@ public:
 
     // top level 
     void decode_step(torch::Tensor& emmission);
+    void decode_step(const float* log_probs); // one frame of num_tokens log-probs
     std::vector<beam::ctcBeam*> decode_sequence(torch::Tensor& emmissions);
+    std::vector<beam::ctcBeam*> decode_chunk(torch::Tensor& emmissions); // continues from the current beams
+    std::vector<beam::ctcBeam*> decode_log_probs(const float* log_probs, size_t num_frames);
+    std::vector<beam::ctcBeam*> decode_cache(const emissions::emissionCache& emission_cache);
+    std::vector<beam::ctcBeam*> decode_sparse(const emissions::sparseEmissions& sparse_emissions);
+    void reset(); // start a new utterance (with the latest resources of the attached registry)
+
+    // shared, hot-swappable lexicon and lm (decoders/decoder_resources.hpp). the registry must
+    // outlive the decoder. starts a new utterance
+    void attach(const beam::resourceRegistry& registry);
+
+    // warm-up: touch the shared resources once so the first utterance does not pay for page faults
+    size_t prefault_lexicon(); // walks every state and arc of the dictionary fst. returns the num of arcs
+    size_t prefault_lm();      // returns the num of lm lookups (0 if no lm is used)
 
     // main steps
     void expand_beam(beam::ctcBeam* beam, 
         torch::Tensor& emmission);
+    void expand_beam(beam::ctcBeam* beam, 
+        const std::vector<std::pair<size_t, double>>& pruned_tokens_prob);
     void update_top_beams();
     std::vector<beam::ctcBeam*> get_top_beams();
     void clear_top_beams();
   
     // control decocding settings
     void set_lm_weight(float new_alpha){_decoding_info.alpha = new_alpha;}
+    void set_word_bonus(float new_beta){_decoding_info.beta = new_beta;}
+    void set_beam_width(size_t num_beams){_max_num_beams = num_beams;}
+    void set_pruning(double cutoff_prob, size_t cutoff_top_n){_decoding_info.set_pruning(cutoff_prob, cutoff_top_n);}
+
+    // getters
+    size_t get_num_tokens() const {return _decoding_info.num_tokens;}
+    int get_blank_index() const { // position of blank_token in the tokens file. -1: not in it
+        const auto& tokens = _decoding_info.idx_2_token;
+        auto blank = std::find(tokens.begin(), tokens.end(), _decoding_info.blank_token);
+        return blank == tokens.end() ? -1 : static_cast<int>(blank - tokens.begin());
+    }
+    const beam::wordMap& get_word_map() const {return _resources->word_map;}
+    uint64_t get_resources_version() const {return _resources->version;}
+    const std::string& get_search_variant() const {return _search_variant;} // e.g. "fst lexicon + kenlm (word ids)"
 
     // internal 
 private:
@@ -96,17 +161,32 @@ private:
     void read_tokens_file(const std::string& path_to_tokens);
     bool set_beams_dictionary(const fs::path& path_to_fst);
     bool set_lm(const fs::path& path_to_ngram_model);
+    void use_resources(std::shared_ptr<const beam::decoderResources> resources);
+    void bind_resources(); // the beams of this thread expand in the pinned lexicon
+    void select_search();  // picks the expand_beam_with instantiation for the pinned resources
+    template <class lmPolicy, class lexiconPolicy>
+    void use_search();
     
     // functional (beams)
     void init_beams();
+    std::vector<std::pair<size_t, double>> get_pruned_tokens(const float* log_probs);
+    void decode_pruned_step(const std::vector<std::pair<size_t, double>>& pruned_tokens_prob);
+    template <class lmPolicy, class lexiconPolicy>
+    void expand_beam_with(beam::ctcBeam* beam, 
+        const std::vector<std::pair<size_t, double>>& pruned_tokens_prob);
 
     // functional (lm)
     float compute_lm_score(const std::vector<std::string>& ngram);
+    void queue_word_score(beam::ctcBeam* parent, beam::ctcBeam* child, double log_p);
+    void score_pending_words(); // adds the lm score and word bonus of the queued words to their beams
     inline float get_weighted_score(const float& ctc_score, const float& lm_score);
     inline void to_capital(std::string& sequence){stringmanip::upper_case(sequence);}
     // getters 
-    ngrams::nGramsModelWrapper& get_lm_model(){return _ngrams_model;}  //FUTURE: I should create a base lm class 
+    const ngrams::nGramsModelWrapper& get_lm_model() const {return *_resources->lm_model;}  //FUTURE: I should create a base lm class 
 
 
 
 };
+
+
+#endif // _ASR_REALTIME_CTC_DECODER
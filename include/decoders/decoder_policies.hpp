@@ -0,0 +1,68 @@
+#ifndef _ASR_REALTIME_DECODER_POLICIES
+#define _ASR_REALTIME_DECODER_POLICIES
+
+#include "decoders/beam.hpp"
+
+
+/*
+Compile-time search policies for ctcDecoder::expand_beam_with<lmPolicy, lexiconPolicy>. The
+configuration is fixed for a resources version (decoders/decoder_resources.hpp), so instead of
+testing it for every candidate token the decoder picks one instantiation when it takes a version
+(use_resources) and the inner loop only contains the code of that configuration:
+
+    lm          noLm          no word scoring: no end-of-word test, no lm code at all
+                kenLmStrings  completed words scored from their n-gram strings (fsts without word labels)
+                kenLm         completed words scored by id, batched per frame (decoders/word_map.hpp)
+    lexicon     noLexicon     every prefix is valid (ctcBeam::get_new_beam with no fst bound)
+                fstLexicon    children are checked against the mapped lexicon fst (ctcBeam::get_new_beam).
+                              LexiconFst tries and lexiconCompiler's minimal automata are the same
+                              ConstFst artifact
+
+kenLm needs a lexicon (the word ids come from the fst's output labels).
+*/
+
+namespace beam{
+    namespace policy{
+
+
+struct noLm{
+    static constexpr bool scores_words = false;
+    static constexpr bool word_ids     = false;
+    static constexpr const char* name  = "no lm";
+};
+
+struct kenLmStrings{
+    static constexpr bool scores_words = true;
+    static constexpr bool word_ids     = false;
+    static constexpr const char* name  = "kenlm (strings)";
+};
+
+struct kenLm{
+    static constexpr bool scores_words = true;
+    static constexpr bool word_ids     = true;
+    static constexpr const char* name  = "kenlm (word ids)";
+};
+
+
+struct noLexicon{
+    static constexpr const char* name = "no lexicon";
+
+    static ctcBeam* extend(ctcBeam* parent, char symbol){
+        return parent->get_new_beam(symbol); // same child (and word window) as with a lexicon, unchecked
+    }
+};
+
+struct fstLexicon{
+    static constexpr const char* name = "fst lexicon";
+
+    static ctcBeam* extend(ctcBeam* parent, char symbol){
+        return parent->get_new_beam(symbol); // nullptr: the prefix is not in the lexicon
+    }
+};
+
+
+    } // namespace policy
+} // namespace beam
+
+
+#endif // _ASR_REALTIME_DECODER_POLICIES
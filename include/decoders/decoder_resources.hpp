@@ -0,0 +1,85 @@
+#ifndef _ASR_REALTIME_DECODER_RESOURCES
+#define _ASR_REALTIME_DECODER_RESOURCES
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include "decoders/beam.hpp"
+#include "decoders/word_map.hpp"
+#include "models/ngrams_model.hpp"
+
+
+/*
+Versioned lexicon + lm for the decoders, swapped RCU style:
+
+    decoderResources   one immutable version: the mapped lexicon fst and its symbol tables, the
+                       lm, and the word map between the two. shared_ptr<const>, never modified
+                       once published
+    resourceRegistry   holds the current version. a swap loads the new lexicon or lm next to the
+                       running decoders, then publishes it with std::atomic_store; readers take it
+                       with std::atomic_load and never wait for a swap to load. (libstdc++ guards
+                       the shared_ptr with a small pool of mutexes, so a load and a store can still
+                       contend for a few instructions)
+
+A ctcDecoder attached to a registry pins the current version for a whole utterance and takes
+the latest one in reset(), so new sessions see a swap immediately, in-flight ones finish on the
+version they started with, and an old version is freed when the last decoder using it resets.
+Swapping only the lexicon keeps the loaded lm (and the other way around).
+*/
+
+namespace fs = std::filesystem;
+
+namespace beam{
+
+
+struct decoderResources{
+    uint64_t version = 0; // 0: not published
+    std::shared_ptr<const FSTDICT> dictionary;                        // nullptr: no lexicon
+    std::shared_ptr<const SymbolTable> input_symbols;
+    std::shared_ptr<const SymbolTable> output_symbols;                // lexicon words
+    std::shared_ptr<const asr::ngrams::nGramsModelWrapper> lm_model; // nullptr: no lm
+    wordMap word_map;                                                 // for this lexicon and lm
+
+    bool load_lexicon(const fs::path& path_to_fst); // the artifact of utils/fst_artifact.hpp, or an older fst
+    bool load_lm(const fs::path& path_to_lm_model);
+    void map_words(); // after the lexicon or the lm changed. empty map: words are scored by string
+
+    // getters
+    bool has_lexicon() const {return dictionary != nullptr;}
+    bool has_lm() const {return lm_model != nullptr;}
+};
+
+
+class resourceRegistry{
+private:
+    std::shared_ptr<const decoderResources> _current; // std::atomic_load / std::atomic_store only
+    std::mutex _swap_mutex;                           // writers only
+    uint64_t _last_version = 0;
+
+
+public:
+    resourceRegistry();
+    resourceRegistry(const resourceRegistry&) = delete;
+    resourceRegistry& operator=(const resourceRegistry&) = delete;
+
+    // readers (decode threads)
+    std::shared_ptr<const decoderResources> acquire() const {return std::atomic_load(&_current);}
+    uint64_t get_version() const {return acquire()->version;}
+
+    // writers. false: the new resource did not load, the current version stays
+    bool swap_lexicon(const fs::path& path_to_fst);
+    bool swap_lm(const fs::path& path_to_lm_model);
+    bool swap(const fs::path& path_to_fst, const fs::path& path_to_lm_model);
+    uint64_t publish(std::shared_ptr<decoderResources> resources); // returns the version it got
+
+
+private:
+    uint64_t publish_locked(std::shared_ptr<decoderResources> resources);
+};
+
+
+} // namespace beam
+
+
+#endif // _ASR_REALTIME_DECODER_RESOURCES
@@ -2,11 +2,31 @@
 #define _LEXICON_BUILDER_HPP
 
 
+#include <algorithm>
+#include <cstdint>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <fstream>
 
+
+/*
+Corpus -> lexicon (generate_lexicon). The corpus is mmapped and split into num_threads chunks
+at line boundaries. Every thread lower cases and counts the words of its chunk into its own hash
+maps, one per merge shard (hash of the word), so the shards are merged in parallel without
+locks. The counts are then filtered (min_count, top_n) and the lexicon is written sorted by
+byte order, the order lexiconCompiler sorts in.
+*/
+struct lexiconBuilderConfig{
+    size_t num_threads   = std::max(1u, std::thread::hardware_concurrency());
+    size_t min_count     = 1;   // words seen fewer times are dropped
+    size_t top_n         = 0;   // keep the top_n most frequent words (0: all)
+    size_t max_word_size = 100; // longer tokens are skipped
+    bool first_word_only = false; // true: the first word of every line (word lists), false: every word
+};
+
+
 class GraphemeLexiconBuilder{ // TODO: chnage the name of this to dictionary builder
     private:
         std::string _lexicon_read_path;   // file containing dictionary 
@@ -14,7 +34,7 @@ class GraphemeLexiconBuilder{ // TODO: chnage the name of this to dictionary bui
         std::ifstream _lexicon_read_file;
         std::ofstream _lexicon_write_file;
         std::unordered_map<std::string,std::string> _lexicon;
-        std::unordered_map<std::string,int> _word_count;
+        std::unordered_map<std::string,size_t> _word_count;
         std::unordered_set<std::string> _dictionary;
     
        
@@ -25,13 +45,15 @@ class GraphemeLexiconBuilder{ // TODO: chnage the name of this to dictionary bui
         ~GraphemeLexiconBuilder();
     
         void set_lexicon_path(std::string path_to_lexicon);
-        void generate_lexicon(const std::string path_to_write_file);
+        void generate_lexicon(const std::string path_to_write_file); // one word per line, as before
+        void generate_lexicon(const std::string path_to_write_file, const lexiconBuilderConfig& config);
         std::unordered_map<std::string, std::string>  get_lexicon();
         std::unordered_set<std::string> get_dictionary();
     
     private:
         std::string get_word_spelling(const std::string& word);
         void convert_line_lowercase(std::string& line);
+        bool count_words(const lexiconBuilderConfig& config); // fills _word_count from the mapped corpus
     
     };
     
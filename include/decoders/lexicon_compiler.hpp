@@ -0,0 +1,150 @@
+#ifndef _ASR_REALTIME_LEXICON_COMPILER
+#define _ASR_REALTIME_LEXICON_COMPILER
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "utils/fst_glog_safe_log.hpp"
+
+
+/*
+Compiles a lexicon (word \t spelling lines) into the decoder's dictionary fst for
+million-word vocabularies. LexiconFst builds a trie of shared_ptr nodes and copies it into the
+fst recursively, which takes minutes and several GB at that size. Here:
+
+    read    every word and spelling go into one character arena (no string per word)
+    sort    the spellings are sorted in num_threads chunks, then merged pairwise in parallel
+    build   the minimal automaton is built in one pass over the sorted list (Daciuk et al.,
+            "Incremental construction of minimal acyclic finite-state automata"): only the
+            path of the previous word is open, every state that leaves it is either merged
+            with an equivalent registered state (shared suffixes) or registered. iterative,
+            so the word length does not bound the stack
+    write   the flat states and arcs go straight into a StdVectorFst, written as the mappable
+            ConstFst artifact (utils/fst_artifact.hpp)
+
+Word ids: a minimal automaton shares the final states between words, so the id cannot sit on
+the arc that enters them (LexiconFst's trie layout). The automaton is numbered instead: the
+output label of an arc is the number of words that sort before every word passing through it,
+so the id of a word is the sum of the output labels along its path, its rank + 1. The output
+symbol table lists the words in that order. For the trie layout the same sum gives the label
+of the last arc, so beam::wordMap reads both.
+*/
+
+namespace fs = std::filesystem;
+
+namespace asr{
+    namespace lexicon{
+
+
+struct lexiconCompilerConfig{
+    size_t num_threads = std::max(1u, std::thread::hardware_concurrency()); // sorting
+};
+
+
+struct lexiconCompileStats{
+    size_t num_words      = 0; // in the automaton
+    size_t num_duplicates = 0; // spellings seen before (the first word keeps them)
+    size_t num_states     = 0;
+    size_t num_arcs       = 0;
+    double read_seconds   = 0;
+    double sort_seconds   = 0;
+    double build_seconds  = 0;
+    double write_seconds  = 0;
+
+    std::string summary() const;
+};
+
+
+class lexiconCompiler{
+private:
+    struct entry{
+        uint32_t word_begin;
+        uint32_t spelling_begin;
+        uint16_t word_size;
+        uint16_t spelling_size;
+    };
+
+    struct compiledState{
+        uint32_t arcs_begin = 0;
+        uint32_t num_words  = 0; // in the right language (words from here to a final state)
+        uint16_t num_arcs   = 0;
+        bool is_final       = false;
+    };
+
+    struct compiledArc{
+        uint32_t target;
+        uint32_t offset; // output label: words that sort before the ones through this arc
+        unsigned char symbol;
+    };
+
+    // a state on the path of the last word: its last arc leads to the next open state
+    struct openState{
+        bool is_final = false;
+        std::vector<std::pair<unsigned char, uint32_t>> arcs;
+    };
+
+    static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+
+    lexiconCompilerConfig _config;
+
+    // input
+    std::vector<char> _arena;
+    std::vector<entry> _entries; // sorted by spelling after compile()
+
+    // automaton
+    std::vector<compiledState> _states;
+    std::vector<compiledArc> _arcs;
+    uint32_t _start_state = 0;
+    bool _compiled = false;
+
+    // register of the equivalence classes: open addressing over (hash, state id)
+    std::vector<std::pair<uint32_t, uint32_t>> _register;
+    size_t _register_size = 0;
+
+    lexiconCompileStats _stats;
+
+
+public:
+    lexiconCompiler(lexiconCompilerConfig config = {});
+
+    // input
+    bool read_lexicon(const fs::path& path_to_lexicon); // word \t spelling (spaces between symbols are dropped)
+    void add_word(std::string_view word, std::string_view spelling);
+
+    // sorts and builds the minimal automaton. false when there are no words
+    bool compile();
+
+    // output (after compile)
+    fst::StdVectorFst* make_fst() const;                // the caller owns it. arcs are input label sorted
+    fst::SymbolTable* make_input_symbols() const;       // <eps> and the spelling symbols, in byte order
+    fst::SymbolTable* make_output_symbols() const;      // <eps> and the words, id = rank + 1
+    bool write(const fs::path& path_to_fst);            // the ConstFst artifact, also isymbols.sym and osymbols.sym next to it
+
+    // getters
+    int32_t get_word_id(std::string_view spelling) const; // walks the automaton. 0: not in the lexicon
+    std::string_view get_word(int32_t word_id) const;
+    const lexiconCompileStats& get_stats() const {return _stats;}
+
+
+private:
+    std::string_view get_spelling(const entry& word_entry) const {
+        return std::string_view(_arena.data() + word_entry.spelling_begin, word_entry.spelling_size);
+    }
+    void sort_entries();
+    void build_automaton();
+    uint32_t replace_or_register(const openState& state, bool is_start);
+    uint64_t hash_state(bool is_final, const std::pair<unsigned char, uint32_t>* arcs, size_t num_arcs) const;
+    bool same_state(uint32_t state_id, const openState& state) const;
+    void grow_register();
+};
+
+
+    } // namespace lexicon
+} // namespace asr
+
+
+#endif // _ASR_REALTIME_LEXICON_COMPILER
@@ -16,6 +16,7 @@ namespace fs = std::filesystem;
 struct LexFstTrieNode{
     std::unordered_map<char,std::shared_ptr<LexFstTrieNode>> children;
     bool is_end_word = false;
+    int64_t word_id = 0; // output label of the word ending here (0: <eps>)
 };
 
 
@@ -24,7 +25,7 @@ class LexiconFst{
 private:
     // symbol table
     fst::SymbolTable* _input_symbol_table;
-    fst::SymbolTable* _output_symbol_table; // FUTURE: This will be used in the future 
+    fst::SymbolTable* _output_symbol_table; // the lexicon words, emitted when a word ends
     bool _flag_output_word_symbol; // FUTURE: This will be used in the future
 
     // files 
@@ -53,14 +54,14 @@ public:
     void print_output_symbol_table();
 
     // lexicon trie 
-    void update_trie_with_word(const std::string& word);
+    void update_trie_with_word(const std::string& word, int64_t word_id = 0);
     void populate_fst_from_trie(std::shared_ptr<LexFstTrieNode> node,
                                 fst::StdVectorFst* lex_fst,
                                 fst::StdArc::StateId& current_state);
     void construct_fst_from_trie(std::shared_ptr<LexFstTrieNode> root_trie_node, fst::StdVectorFst* lex_fst);
     fst::StdVectorFst* construct_fst_from_trie(std::shared_ptr<LexFstTrieNode> root_trie_node);
     void construct_fst_from_lex_file(); // FUTURE: I can enable users to pass a different file
-    void write_fst(fs::path fst_save_path); // TODO: change the return type to bool
+    void write_fst(fs::path fst_save_path); // ConstFst artifact of the trie, not minimized (utils/fst_artifact.hpp). TODO: change the return type to bool
     void write_fst(fs::path fst_svae_path, bool sort);
     bool load_fst(fs::path path_to_fst); // TODO: implement this method
 
@@ -0,0 +1,79 @@
+#ifndef _ASR_REALTIME_WORD_MAP
+#define _ASR_REALTIME_WORD_MAP
+
+#include <cstdint>
+#include <vector>
+#include "decoders/beam.hpp"
+#include "models/ngrams_model.hpp"
+
+
+/*
+Word ids for the decoder's word-completion path. The id of a word is the sum of the output
+labels along its path in the lexicon fst. LexiconFst puts the whole id on the arc that enters the
+word's final state (populate_fst_from_trie), lexiconCompiler numbers a minimal automaton so that
+the labels add up to it (decoders/lexicon_compiler.hpp). Both lookups are built once when the
+decoder loads the lexicon and the lm:
+
+    dictionary state -> lexicon word id   (0: no word ends in the state)
+    lexicon word id  -> lm WordIndex      (0: <unk>, the word is not in the lm vocabulary)
+
+The first table only exists when the fst is a tree (one path into every state). A minimal
+automaton shares its final states between words, so there the word's spelling is walked again
+from the start state when it completes (walk mode), a few arcs per completed word.
+
+The case normalization the decoder used to do per completed word (lexicon words are lower
+case, the librispeech lm is upper case) happens here, once per lexicon word.
+
+Fsts built before the lexicon had output labels carry <eps> everywhere; build() returns false
+for them and the decoder keeps scoring words by string.
+*/
+
+namespace beam{
+
+
+class wordMap{
+private:
+    std::vector<int32_t> _state_word_ids;          // dictionary state -> lexicon word id (tree fsts)
+    const FSTDICT* _dictionary = nullptr;          // walk mode: the fst is not a tree
+    std::vector<int64_t> _char_labels;             // walk mode: char -> input label (-1: not a symbol)
+    std::vector<asr::ngrams::WordIndex> _lm_word_ids; // lexicon word id -> lm word index
+    asr::ngrams::WordIndex _sentence_start = 0;    // <s>
+    size_t _num_words = 0;
+    size_t _num_oov   = 0;                         // lexicon words missing from the lm
+
+
+public:
+    // upper_case: look the words up in upper case (the lexicon builder writes lower case)
+    // the dictionary must outlive the map (it is walked in walk mode)
+    bool build(const FSTDICT& dictionary,
+               const SymbolTable& input_symbols,
+               const SymbolTable& output_symbols,
+               const asr::ngrams::nGramsModelWrapper& lm_model,
+               bool upper_case = true);
+    void clear();
+
+    // getters
+    bool empty() const {return _lm_word_ids.empty();}
+    bool is_walk_mode() const {return _dictionary != nullptr;}
+    // the word ending in state, spelled by the symbols after the last separator of sequence
+    int32_t get_word_id(dictState state, const std::vector<char>& sequence, char separator) const {
+        if (_dictionary) return walk_word_id(sequence, separator);
+        return (state >= 0 && static_cast<size_t>(state) < _state_word_ids.size()) ? _state_word_ids[state] : 0;
+    }
+    asr::ngrams::WordIndex get_lm_index(int32_t word_id) const {
+        return (word_id > 0 && static_cast<size_t>(word_id) < _lm_word_ids.size()) ? _lm_word_ids[word_id] : 0;
+    }
+    asr::ngrams::WordIndex get_sentence_start() const {return _sentence_start;}
+    size_t get_num_words() const {return _num_words;}
+    size_t get_num_oov() const {return _num_oov;}
+
+
+private:
+    int32_t walk_word_id(const std::vector<char>& sequence, char separator) const;
+};
+
+
+} // namespace beam
+
+
+#endif // _ASR_REALTIME_WORD_MAP
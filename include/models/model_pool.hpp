@@ -0,0 +1,110 @@
+#ifndef TORCH_MODEL_POOL
+#define TORCH_MODEL_POOL
+
+#include <torch/script.h>
+#include <glog/logging.h>
+#include <optional>
+#include <future>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include "models/torch_script_model.hpp"
+
+/*
+The pool loads the script module once and serves N inference workers. Every worker holds
+a shallow copy of the module (the weights are shared) and runs its forward passes on its own
+thread, (optionally) pinned to a set of cores.
+
+libtorch keeps a single intra-op and a single inter-op thread count per process, so both are
+set once, by the first pool that loads a model, and apply to every worker (and every other
+torch user in the process). Size them together: num_workers * intra_op_threads cores.
+
+load_model() loads the new module next to the running one and only swaps the workers over once
+it has loaded, so a failed (re)load leaves the pool serving the previous model.
+*/
+
+
+struct modelPoolConfig{
+    size_t num_workers   = 1;
+    int intra_op_threads = 1; // process wide, set once by the first loaded pool (< 1 keeps the default)
+    int inter_op_threads = 1; // process wide. libtorch only allows setting this once (-1 keeps the default)
+    std::vector<std::vector<int>> core_sets; // worker i is pinned to core_sets[i % core_sets.size()]. empty: no pinning
+
+    // getters
+    std::vector<int> get_core_set(size_t worker_index) const {
+        if (core_sets.empty()) return {};
+        return core_sets[worker_index % core_sets.size()];
+    }
+};
+
+
+struct modelPoolStats{
+    size_t queue_depth     = 0;
+    size_t max_queue_depth = 0;
+    size_t completed       = 0;
+    double mean_wait_ms    = 0; // time a request spent in the queue
+    double mean_forward_ms = 0; // time a request spent in the model
+};
+
+
+class torchModelPool{
+private:
+    typedef std::optional<torch::Tensor> forwardResult;
+    typedef std::chrono::steady_clock clock;
+
+    struct inferenceRequest{
+        std::vector<float> audio_data;
+        std::promise<forwardResult> result;
+        clock::time_point enqueue_time;
+    };
+
+    // model
+    torchScriptModel _shared_model; // owns the weights. workers hold shallow copies
+    modelPoolConfig _config;
+
+    // workers
+    std::vector<std::thread> _workers;
+    std::deque<inferenceRequest> _requests;
+    std::mutex _requests_mutex;
+    std::condition_variable _requests_cv;
+    bool _shutdown = false;
+
+    // metrics
+    std::atomic<size_t> _queue_depth{0};
+    std::atomic<size_t> _max_queue_depth{0};
+    std::atomic<size_t> _completed{0};
+    std::atomic<uint64_t> _total_wait_us{0};
+    std::atomic<uint64_t> _total_forward_us{0};
+
+
+public:
+    torchModelPool(modelPoolConfig config);
+    ~torchModelPool();
+
+    bool load_model(const std::string& path_to_model);
+
+    // inference
+    std::future<forwardResult> submit(std::vector<float> audio_data);
+    forwardResult pass_forward(std::vector<float> audio_data); // blocks until a worker is done
+
+    // getters
+    size_t get_queue_depth() const {return _queue_depth.load(std::memory_order_relaxed);}
+    size_t get_num_workers() const {return _workers.size();}
+    bool is_loaded() const {return _shared_model.is_loaded();}
+    modelPoolStats get_stats() const;
+
+
+private:
+    void start_workers();
+    void stop_workers();
+    void worker_loop(size_t worker_index);
+    bool pin_current_thread(const std::vector<int>& core_set);
+    void set_torch_threads();
+};
+
+
+#endif
@@ -10,6 +10,22 @@ What is the beahvior I am trying to achieve?
 - Since the score represents on an internal state (check the lm::ngrams::Model source code) I want to 
 be able to reset the internal state
 - 
+
+Loading: KenLM binary files (built from the arpa with lm_compile) are mmapped instead of
+parsed, which takes a fraction of a second instead of tens of seconds. With any of the mmap
+load methods (LAZY, POPULATE_OR_LAZY, POPULATE_OR_READ) the tables are clean page cache pages,
+so every decoder process on the host shares one copy of the LM. READ copies it into the heap.
+ARPA files are always parsed.
+
+Any KenLM data structure can be loaded: probing (fastest, largest), trie, quantized trie and
+the array (bhiksha) variants, which cut the memory several times over for 4/5-gram models. The
+type is read from the binary header (lm::ngram::LoadVirtual) and every model is scored through
+the lm::base::Model interface; arpa files are loaded as probing.
+
+Threading: a loaded model is read only. score(), the state helpers, get_word_index and
+score_sentence are const and keep nothing in the wrapper (the caller owns the States), so one
+wrapper serves every concurrent decode session without locks. score_word / start_new_sentence
+walk the wrapper's own internal state and are for single threaded use only.
 */
 
 
@@ -69,9 +85,33 @@ typedef lm::ngram::State State;
 typedef lm::WordIndex WordIndex;
 
 
+// one lookup of a batch (nGramsModelWrapper::score_batch): log10 p(word_id | *in_state) goes to
+// score and the context after the word to *out_state
+struct lmQuery{
+    const State* in_state = nullptr;
+    WordIndex word_id     = 0;
+    State* out_state      = nullptr;
+    float score           = 0;
+};
+
+
+// arpa -> kenlm binary of the given data structure (loads with mmap). quantization_bits is
+// used by the quantized tries (probabilities and backoffs). false on failure
+bool compile_arpa_to_binary(const fs::path& path_to_arpa,
+                            const fs::path& path_to_binary,
+                            lm::ngram::ModelType model_type = lm::ngram::PROBING,
+                            uint8_t quantization_bits = 8);
+
+const char* model_type_name(lm::ngram::ModelType model_type);
+bool parse_model_type(const std::string& name, lm::ngram::ModelType& model_type); // probing, trie, qtrie, atrie, qatrie
+
+// the binary next to an arpa file (same stem, .bin) when it exists, the arpa path otherwise
+fs::path prefer_binary_model(const fs::path& path_to_arpa);
+
+
 class nGramsModelWrapper{
 private:    
-    typedef std::unique_ptr<lm::ngram::Model> ModelPtr;
+    typedef std::unique_ptr<lm::base::Model> ModelPtr; // any data structure, picked by the file header
 
 
 public:
@@ -81,22 +121,40 @@ public:
     ~nGramsModelWrapper();
     // getters 
     fs::path get_model_path() const {return path_to_ngrams_model_;}
+    double get_load_seconds() const {return load_seconds_;}
+    bool is_binary() const {return is_binary_;}
+    lm::ngram::ModelType get_model_type() const {return model_type_;}
+    unsigned char get_order() const {return ngram_model_ptr_ ? ngram_model_ptr_->Order() : 0;}
+    WordIndex get_vocab_size() const {return vocab_ptr_ ? vocab_ptr_->Bound() : 0;}
     // 
-    bool setup_model_from(fs::path path_to_model);
-    // functionality
+    bool setup_model_from(fs::path path_to_model, util::LoadMethod load_method = util::POPULATE_OR_READ);
+    // stateless, re-entrant scoring: log10 p(word_id | in_state), the context after it goes to out_state.
+    // word_id 0 is <unk> and gets the model's unknown word probability
+    float score(const State& in_state, WordIndex word_id, State* out_state) const {
+        return ngram_model_ptr_->BaseScore(&in_state, word_id, out_state);
+    }
+    void begin_sentence_state(State* state) const {ngram_model_ptr_->BeginSentenceWrite(state);} // <s>
+    void null_context_state(State* state) const {ngram_model_ptr_->NullContextWrite(state);}     // no context
+    WordIndex get_word_index(const std::string& word) const; // 0 when out of vocabulary
+    float score_sentence(const std::vector<std::string>& sentence) const;
+    float score_sentence(const std::vector<std::string>& sentence, scoreType score_type) const;
+    // score_sentence on word ids (no string lookups). 0 is out of vocabulary
+    float score_ngram(const std::vector<WordIndex>& ngram, scoreType score_type) const;
+    // all the word completions of a decoding frame at once. identical (context, word) queries
+    // share one lookup. returns the number of lookups made
+    size_t score_batch(lmQuery* queries, size_t num_queries) const;
+    // sequential scoring on the wrapper's internal state (not thread safe)
     float score_word(const std::string& word);
-    float score_sentence(std::vector<std::string> sentence);
-    float score_sentence(std::vector<std::string> sentence, scoreType score_type); 
     void start_new_sentence(); 
+    size_t prefault() const; // touch the unigram table and the <s> bigrams. returns the number of lookups
 
 private:
-    bool load_model(fs::path path_to_ngrams_model);
+    bool load_model(fs::path path_to_ngrams_model, util::LoadMethod load_method = util::POPULATE_OR_READ);
     void init_vocab();
     void set_internal_state(const lm::ngram::State& state);
     void set_model_path(const fs::path& path_to_model){path_to_ngrams_model_ = path_to_model;}
     void reset_internal_state();
     inline float map_score(float val) const; 
-    WordIndex get_word_index(const std::string& word) const;
     void initialize_model();
     State get_internal_state(){return internal_state_;}
     float convert_to_prob(float score) const {return exp(score);};
@@ -106,9 +164,12 @@ private:
     ModelPtr ngram_model_ptr_;
     fs::path path_to_ngrams_model_;
     State internal_state_;
-    const lm::ngram::ProbingVocabulary* vocab_ptr_;
+    const lm::base::Vocabulary* vocab_ptr_ = nullptr;
     lmScoringConfig scoring_config;
     float OOV_PENALTY_ = 1000;
+    double load_seconds_ = 0;
+    bool is_binary_ = false;
+    lm::ngram::ModelType model_type_ = lm::ngram::PROBING;
 
 };
 
@@ -4,21 +4,28 @@
 #include <torch/script.h>
 #include <glog/logging.h>
 #include <optional>
+#include "utils/sparse_emissions.hpp"
 
 class torchScriptModel{
 private:
-    torch::TensorOptions _tensor_options; 
+    torch::TensorOptions _tensor_options;
     torch::jit::script::Module _model;
     std::string _model_path;
-    
+    bool _is_loaded = false;
+
 
 public:
     torchScriptModel();
     ~torchScriptModel();
     bool load_model(const std::string& _file_path);
+    bool share_weights_from(const torchScriptModel& other); // shallow copy of the module (no weight duplication)
+    bool is_loaded() const {return _is_loaded;}
+    std::string get_model_path() const {return _model_path;}
     std::optional<torch::Tensor> pass_forward(std::vector<float>& audio_data);
+    std::optional<asr::emissions::sparseEmissions> pass_forward_sparse(std::vector<float>& audio_data,
+                                                   const asr::emissions::sparseEmissionsConfig& sparse_config);
 
 };
 
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,58 @@
+#ifndef ASR_REALTIME_CAPTURE_DRIVER
+#define ASR_REALTIME_CAPTURE_DRIVER
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "utils/capture_sink.hpp"
+#include "pipeline/overlapped_pipeline.hpp"
+
+
+/*
+Consumer side of the live capture path:
+
+    portaudio callback -> captureSink (lock-free ring) -> captureDriver thread -> overlappedPipeline
+
+The driver thread waits for chunk_frames captured frames, moves them out of the ring and
+pushes them into the pipeline (it is the pipeline's single producer). stop() drains what is
+left in the ring and flushes the pipeline.
+*/
+
+namespace asr{
+    namespace pipeline{
+
+
+class captureDriver{
+private:
+    audio::captureSink& _capture_sink;
+    overlappedPipeline& _pipeline;
+    size_t _chunk_frames;
+
+    std::thread _thread;
+    std::atomic<bool> _running{false};
+    std::atomic<size_t> _chunks_pushed{0};
+
+
+public:
+    captureDriver(audio::captureSink& capture_sink, overlappedPipeline& pipeline, size_t chunk_frames);
+    ~captureDriver();
+
+    void start();
+    std::vector<beam::ctcBeam*> stop(); // returns the final top beams
+
+    // getters
+    bool is_running() const {return _running.load();}
+    size_t get_chunks_pushed() const {return _chunks_pushed.load();}
+
+
+private:
+    void consume_loop();
+    void push_available(size_t max_frames);
+};
+
+
+    } // namespace pipeline
+} // namespace asr
+
+
+#endif // ASR_REALTIME_CAPTURE_DRIVER
@@ -0,0 +1,101 @@
+#ifndef ASR_REALTIME_CHANNEL_SESSIONS
+#define ASR_REALTIME_CHANNEL_SESSIONS
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "models/model_pool.hpp"
+#include "decoders/ctc_decoder.hpp"
+#include "utils/capture_sink.hpp"
+
+
+/*
+Independent recognition per capture channel:
+
+    multiChannelCaptureSink -> channel c ring -> session c thread -> torchModelPool -> decoder c
+
+Every channel has its own session thread and decoder (its own beams), while the forward passes
+go through one shared torchModelPool. Decoders attached to one beam::resourceRegistry share its
+lexicon and lm, and a swap reaches a channel at its next reset. The channels decode in
+parallel (as the load generator's workers do, see pipeline/load_generator.hpp).
+
+An exception in a channel's forward pass or decode stops that channel only: its error shows in
+get_stats() and stop() returns an empty transcript for it.
+*/
+
+namespace asr{
+    namespace pipeline{
+
+
+struct channelSessionConfig{
+    size_t chunk_frames     = 16000; // frames per forward pass and channel
+    bool serialize_decoding = false; // one decode call at a time across the channels
+};
+
+
+struct channelSessionStats{
+    size_t num_chunks  = 0;
+    size_t num_frames  = 0;
+    double forward_ms  = 0; // waiting on the pool included
+    double decode_ms   = 0;
+    std::string error; // not empty: the session stopped on this exception
+};
+
+
+class channelSessions{
+public:
+    typedef std::function<std::unique_ptr<ctcDecoder>(size_t channel_index)> decoderFactory;
+
+
+private:
+    struct channelSession{
+        std::unique_ptr<ctcDecoder> decoder;
+        std::thread thread;
+        std::atomic<size_t> num_chunks{0};
+        std::atomic<size_t> num_frames{0};
+        std::atomic<uint64_t> forward_us{0};
+        std::atomic<uint64_t> decode_us{0};
+        std::atomic<bool> failed{false}; // error is written before it is set
+        std::string error;
+    };
+
+    audio::multiChannelCaptureSink& _capture_sink;
+    torchModelPool& _model_pool;
+    channelSessionConfig _config;
+    std::vector<std::unique_ptr<channelSession>> _sessions;
+    std::atomic<bool> _running{false};
+    std::mutex _decoding_mutex;
+
+
+public:
+    channelSessions(audio::multiChannelCaptureSink& capture_sink,
+                    torchModelPool& model_pool,
+                    decoderFactory make_decoder,
+                    channelSessionConfig config = {});
+    ~channelSessions();
+
+    void start();
+    std::vector<std::string> stop(); // drains the rings and returns the best transcript of every channel
+
+    // getters
+    size_t get_num_channels() const {return _sessions.size();}
+    bool is_running() const {return _running.load();}
+    std::vector<channelSessionStats> get_stats() const;
+
+
+private:
+    void session_loop(size_t channel_index);
+    void process(size_t channel_index, size_t max_frames);
+    bool try_process(size_t channel_index, size_t max_frames); // false: the session failed (now or before)
+};
+
+
+    } // namespace pipeline
+} // namespace asr
+
+
+#endif // ASR_REALTIME_CHANNEL_SESSIONS
@@ -0,0 +1,141 @@
+#ifndef ASR_REALTIME_LOAD_GENERATOR
+#define ASR_REALTIME_LOAD_GENERATOR
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <functional>
+#include <mutex>
+#include "models/torch_script_model.hpp"
+#include "decoders/ctc_decoder.hpp"
+#include "utils/capture_sink.hpp"
+#include "utils/stream_player.hpp"
+
+
+/*
+Capacity planning: plays num_streams simulated streams through the whole path
+
+    multiStreamPlayer -> captureSink (one per stream) -> worker threads -> model -> decoder (one per stream)
+
+Streams are spread over num_workers compute threads (stream i runs on worker i % num_workers).
+A worker takes chunk_frames from a stream's sink as soon as they are there, runs the forward
+pass on its own shallow copy of the model and continues that stream's decoder.
+
+Chunk latency is measured from the moment the last frame of the chunk was (scheduled to be)
+captured to the end of its decode. At speed 0 (as fast as possible) there is no capture clock,
+so the latency is the time the chunk took. busy_seconds is compute only: the time spent waiting
+for the decoding lock (serialize_decoding) is reported apart, as lock_wait_seconds.
+
+An exception in a stream's forward pass or decode stops that stream (its error is reported and
+the run is not sustained); the other streams go on.
+
+max_streams_per_core = seconds of audio / seconds of compute: how many real-time streams one
+core could carry if it did nothing else. A run is "sustained" when nothing was dropped and the
+p99 latency stays within the latency budget (one chunk of audio by default).
+
+The decoders only share read-only state, the mapped lexicon fst and the lm (ctcBeam keeps its
+per-decoder state per thread, see decoders/beam.hpp), so the workers decode in parallel.
+serialize_decoding = true runs one decode call at a time instead, to compare against.
+*/
+
+namespace asr{
+    namespace pipeline{
+
+
+struct loadGeneratorConfig{
+    size_t num_streams  = 1;
+    size_t num_workers  = 1;     // compute threads. one core each
+    size_t chunk_frames = 16000; // frames per forward pass
+    double sink_seconds = 2.0;   // capture ring per stream
+    double latency_budget_ms = 0; // 0: one chunk of audio (at the playback speed)
+    bool serialize_decoding = false; // one decode call at a time across the workers
+    audio::streamPlayerConfig player_config{};
+};
+
+
+struct streamLoadReport{
+    size_t num_chunks     = 0;
+    size_t dropped_chunks = 0; // frames dropped by the sink (in chunks) + chunks the model rejected
+    size_t frames_dropped = 0;
+    double audio_seconds  = 0;
+    double busy_seconds   = 0; // model + decoder
+    double lock_wait_seconds = 0; // waiting for the decoding lock (serialize_decoding), not in busy_seconds
+    double p50_ms = 0, p95_ms = 0, p99_ms = 0, max_ms = 0;
+    std::string error; // not empty: the stream stopped on this exception
+};
+
+
+struct loadReport{
+    std::vector<streamLoadReport> streams;
+    size_t num_workers    = 0;
+    size_t num_chunks     = 0;
+    size_t dropped_chunks = 0;
+    size_t late_callbacks = 0; // the player could not keep its own schedule
+    size_t failed_streams = 0; // stopped by an exception in the model or the decoder
+    double audio_seconds  = 0;
+    double busy_seconds   = 0;
+    double lock_wait_seconds = 0;
+    double wall_seconds   = 0;
+    double p50_ms = 0, p95_ms = 0, p99_ms = 0, max_ms = 0; // over every chunk of every stream
+    double max_streams_per_core = 0;
+    bool sustained = false;
+
+    std::string summary() const;
+};
+
+
+class loadGenerator{
+public:
+    typedef std::function<std::unique_ptr<ctcDecoder>()> decoderFactory;
+
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    struct loadStream{
+        std::unique_ptr<audio::captureSink> sink;
+        std::unique_ptr<ctcDecoder> decoder;
+        size_t frames_read = 0;
+        size_t model_failures = 0;
+        double busy_seconds = 0;
+        double lock_wait_seconds = 0;
+        bool done = false;
+        std::string error;
+        std::vector<double> latencies_ms;
+    };
+
+    torchScriptModel& _model;
+    decoderFactory _make_decoder;
+    loadGeneratorConfig _config;
+    std::mutex _decoding_mutex;
+
+
+public:
+    // the model must be loaded. make_decoder is called once per stream (decoders keep the beams of their stream)
+    loadGenerator(torchScriptModel& model, decoderFactory make_decoder, loadGeneratorConfig config);
+
+    // stream i plays audio_files[i % audio_files.size()] (mono, at the model sample rate)
+    loadReport run(const std::vector<std::vector<float>>& audio_files, double sample_rate = 16000);
+
+
+private:
+    void worker_loop(size_t worker_index,
+                     std::vector<loadStream>& streams,
+                     const audio::multiStreamPlayer& player);
+    void process_chunk(torchScriptModel& model,
+                       loadStream& stream,
+                       size_t stream_index,
+                       size_t max_frames,
+                       const audio::multiStreamPlayer& player);
+    loadReport make_report(std::vector<loadStream>& streams,
+                           const audio::multiStreamPlayer& player,
+                           double sample_rate,
+                           double wall_seconds) const;
+};
+
+
+    } // namespace pipeline
+} // namespace asr
+
+
+#endif // ASR_REALTIME_LOAD_GENERATOR
@@ -0,0 +1,164 @@
+#ifndef ASR_REALTIME_OVERLAPPED_PIPELINE
+#define ASR_REALTIME_OVERLAPPED_PIPELINE
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <exception>
+#include <torch/script.h>
+#include "models/torch_script_model.hpp"
+#include "decoders/ctc_decoder.hpp"
+#include "utils/spsc_queue.hpp"
+#include "utils/sparse_emissions.hpp"
+#include "utils/resampler.hpp"
+#include "utils/vad.hpp"
+
+
+/*
+Two-stage pipeline: the acoustic model runs on one thread and the ctc decoder on another.
+Emission chunks move between them through a bounded lock-free queue, so the model can run
+on chunk N+1 while chunk N is being decoded. End-to-end time approaches max(stage) instead
+of sum(stage).
+
+    push_audio() -> (resampler) -> [audio queue] -> model thread -> [emission queue] -> decoder thread
+
+When the input rate differs from the model rate, push_audio() resamples on the producer thread
+(the resampler keeps its state across pushes and is flushed by finish()).
+
+With use_vad, an energyVad gate after the resampler drops silence before it reaches the model.
+The chunk that closes a speech segment is marked end_of_segment: the decoder thread stores the
+segment's best transcript (get_segments) and resets for the next one.
+
+An exception in either stage is caught on its thread and stops the pipeline: both stages and
+the producer stop waiting on the queues, and finish() rethrows the first error after joining.
+*/
+
+namespace asr{
+    namespace pipeline{
+
+
+struct pipelineConfig{
+    size_t chunk_size     = 16000; // input samples per acoustic chunk (run() splits the audio with it)
+    size_t queue_capacity = 8;     // chunks in flight between two stages
+    uint32_t input_sample_rate = 16000; // rate of the pushed audio (capture device / wav file)
+    uint32_t model_sample_rate = 16000; // rate the acoustic model expects
+    bool use_sparse_emissions = false; // pass per-frame top-k instead of the dense [time, num_tokens] tensor
+    emissions::sparseEmissionsConfig sparse_config{};
+    bool use_vad = false; // only forward speech to the model
+    audio::vadConfig vad_config{}; // its sample_rate is set to model_sample_rate
+};
+
+
+struct audioChunk{
+    std::vector<float> samples; // may be empty on a segment marker
+    size_t chunk_index  = 0;
+    bool end_of_segment = false; // vad: the speech segment ends with this chunk
+    bool end_of_stream  = false;
+};
+
+
+struct emissionChunk{
+    torch::Tensor emissions; // [time, num_tokens] raw model output (dense mode)
+    emissions::sparseEmissions sparse_emissions; // top-k log-probs (sparse mode)
+    size_t chunk_index  = 0;
+    bool end_of_segment = false;
+    bool end_of_stream  = false;
+};
+
+
+struct pipelineStats{
+    size_t num_chunks       = 0;
+    double model_busy_ms    = 0; // time spent in pass_forward
+    double decoder_busy_ms  = 0; // time spent in decode_chunk
+    double wall_ms          = 0; // start() to finish()
+    size_t producer_stalls  = 0; // pushes that found the audio queue full
+    size_t model_stalls     = 0; // pushes that found the emission queue full (decoder is the bottleneck)
+    size_t decoder_stalls   = 0; // pops that found the emission queue empty (model is the bottleneck)
+    size_t samples_in        = 0; // at the model rate
+    size_t samples_forwarded = 0; // sent to the model (all of them without vad)
+    size_t num_segments      = 0; // finalized by the decoder (vad)
+
+    double get_compute_saved() const {
+        return samples_in ? 1.0 - static_cast<double>(samples_forwarded) / samples_in : 0;
+    }
+};
+
+
+class overlappedPipeline{
+private:
+    typedef std::chrono::steady_clock clock;
+
+    torchScriptModel& _model;
+    ctcDecoder& _decoder;
+    pipelineConfig _config;
+
+    // stages
+    spscQueue<audioChunk> _audio_queue;
+    spscQueue<emissionChunk> _emission_queue;
+    std::unique_ptr<audio::polyphaseResampler> _resampler; // null when the rates match
+    std::unique_ptr<audio::energyVad> _vad; // null without use_vad
+    std::vector<audio::vadChunk> _vad_output;
+    std::vector<std::string> _segments; // written by the decoder thread
+    size_t _segment_chunks = 0; // decoded since the last finalized segment (decoder thread)
+    std::thread _model_thread;
+    std::thread _decoder_thread;
+    bool _running = false;
+    size_t _next_chunk_index = 0;
+
+    // first exception thrown by a stage. _failed makes every blocking push / pop give up
+    std::atomic<bool> _failed{false};
+    std::mutex _error_mutex;
+    std::exception_ptr _error;
+
+    // metrics
+    clock::time_point _start_time;
+    std::atomic<uint64_t> _model_busy_us{0};
+    std::atomic<uint64_t> _decoder_busy_us{0};
+    std::atomic<size_t> _num_chunks{0};
+    std::atomic<size_t> _producer_stalls{0};
+    std::atomic<size_t> _model_stalls{0};
+    std::atomic<size_t> _decoder_stalls{0};
+    std::atomic<size_t> _samples_in{0};
+    std::atomic<size_t> _samples_forwarded{0};
+    std::atomic<size_t> _num_segments{0};
+    double _wall_ms = 0;
+
+
+public:
+    overlappedPipeline(torchScriptModel& model, ctcDecoder& decoder, pipelineConfig config);
+    ~overlappedPipeline();
+
+    // streaming interface (push_audio and finish must be called from a single producer thread)
+    void start();
+    void push_audio(std::vector<float> samples);
+    std::vector<beam::ctcBeam*> finish(); // flushes both stages and returns the top beams. rethrows a stage's exception
+
+    // offline convenience: splits the audio into chunk_size pieces
+    std::vector<beam::ctcBeam*> run(const std::vector<float>& audio_data);
+
+    // getters
+    pipelineStats get_stats() const;
+    bool is_running() const {return _running;}
+    bool has_failed() const {return _failed.load(std::memory_order_acquire);} // a stage threw, finish() rethrows it
+    const std::vector<std::string>& get_segments() const {return _segments;} // best transcript per vad segment. read after finish()
+
+
+private:
+    void model_loop();
+    void decoder_loop();
+    void forward(std::vector<float> samples); // vad gate (if any), then push_chunk
+    void push_chunk(std::vector<float> samples, bool end_of_segment);
+    void finalize_segment(bool reset_decoder);
+    void fail(const char* stage, std::exception_ptr error); // records the first error and stops the stages
+};
+
+
+    } // namespace pipeline
+} // namespace asr
+
+
+#endif // ASR_REALTIME_OVERLAPPED_PIPELINE
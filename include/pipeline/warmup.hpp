@@ -0,0 +1,57 @@
+#ifndef ASR_REALTIME_WARMUP
+#define ASR_REALTIME_WARMUP
+
+#include <vector>
+#include <string>
+#include "models/torch_script_model.hpp"
+#include "decoders/ctc_decoder.hpp"
+
+
+/*
+Warm-up phase run before the service reports ready. The first utterance after a restart is
+slow because the JIT profiling executor specializes on its first runs and the LM / lexicon
+pages are faulted in lazily. warm_up() pays those costs upfront:
+    1- pass_forward on synthetic audio for each configured chunk size
+    2- prefault the lexicon fst and the lm
+    3- decode a synthetic emission (the decoder is reset afterwards)
+and reports how long each step took.
+*/
+
+namespace asr{
+    namespace pipeline{
+
+
+struct warmupConfig{
+    std::vector<size_t> chunk_sizes{16000}; // samples, one entry per chunk size used at runtime
+    size_t forward_runs   = 3;   // the profiling executor specializes after a couple of runs
+    size_t decode_frames  = 200; // frames of the synthetic emission
+    bool prefault_lexicon = true;
+    bool prefault_lm      = true;
+};
+
+
+struct warmupStep{
+    std::string name;
+    double ms   = 0;
+    size_t work = 0; // forward runs, arcs, lm lookups or frames depending on the step
+    bool ok     = true;
+};
+
+
+struct warmupReport{
+    std::vector<warmupStep> steps;
+    double total_ms = 0;
+
+    bool ok() const;
+    std::string summary() const;
+};
+
+
+warmupReport warm_up(torchScriptModel& model, ctcDecoder& decoder, const warmupConfig& config = {});
+
+
+    } // namespace pipeline
+} // namespace asr
+
+
+#endif // ASR_REALTIME_WARMUP
@@ -0,0 +1,228 @@
+#ifndef ASR_REALTIME_AUDIO_SOURCE
+#define ASR_REALTIME_AUDIO_SOURCE
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "utils/capture_sink.hpp"
+#include "utils/wav_reader.hpp"
+
+
+/*
+Where captured audio comes from. Every backend honours the same contract as the portaudio
+callback: a single producer thread writes frames into a captureSink (get_capture_sink), and the
+consumer side (captureDriver, a pipeline, a test) only ever sees the sink.
+
+    portAudioSource  the default input device (stream_handler.hpp)
+    fileSource       replays a wav or raw PCM file in real time (speed 1), faster, or as fast
+                     as the consumer keeps up (speed 0: back-pressure instead of drops)
+    fdSource         raw PCM from a file descriptor (pipe, socket, fifo). readv() goes straight
+                     into the ring segments, so another process' audio lands in the sink
+                     without an intermediate copy. the writer sets the pace
+    syntheticSource  a tone plus seeded noise, for deterministic headless tests and benchmarks
+
+Sources are mono; multi-channel wav files are averaged by wavReader.
+*/
+
+namespace asr{
+    namespace audio{
+
+
+struct sourceConfig{
+    double speed             = 1.0; // 0: as fast as the sink drains
+    size_t frames_per_buffer = 160; // frames per "callback"
+    double buffer_seconds    = 2.0; // sink capacity
+};
+
+
+class audioSource{
+public:
+    virtual ~audioSource() = default;
+
+    virtual bool start() = 0;
+    virtual void stop() = 0;
+
+    // getters
+    virtual bool is_running() const = 0;
+    virtual bool at_end() const {return false;} // no more frames will arrive (end of file, writer closed the fd)
+    virtual double get_sample_rate() const = 0;
+    virtual captureSink* get_capture_sink() = 0;
+    virtual std::string get_name() const = 0;
+};
+
+
+// a producer thread that delivers frames_per_buffer frames every buffer period (or as fast
+// as the sink drains with speed 0). the backends only implement deliver()
+class pacedSource : public audioSource{
+protected:
+    typedef std::chrono::steady_clock clock;
+
+    sourceConfig _config;
+    std::unique_ptr<captureSink> _capture_sink;
+    std::thread _thread;
+    std::atomic<bool> _running{false};
+    std::atomic<bool> _at_end{false};
+    clock::time_point _start_time;
+    size_t _frames_delivered = 0;
+
+
+public:
+    pacedSource(sourceConfig config);
+    ~pacedSource() override;
+
+    bool start() override;
+    void stop() override;
+
+    // getters
+    bool is_running() const override {return _running.load();}
+    bool at_end() const override {return _at_end.load(std::memory_order_acquire);}
+    captureSink* get_capture_sink() override {return _capture_sink.get();}
+    size_t get_frames_delivered() const {return _frames_delivered;} // after stop() or at_end()
+
+
+protected:
+    // writes up to max_frames into the sink and returns how many (0: the source is exhausted)
+    virtual size_t deliver(size_t max_frames, double adc_time, double callback_time) = 0;
+    virtual bool rewind() = 0; // called by start()
+    void make_sink(double sample_rate, captureSampleFormat format);
+
+
+private:
+    void paced_loop();
+    void as_fast_as_possible_loop();
+    double get_elapsed() const;
+};
+
+
+struct rawPcmFormat{
+    double sample_rate         = 16000;
+    captureSampleFormat format = CAPTURE_INT16; // little endian, mono
+};
+
+
+class fileSource : public pacedSource{
+private:
+    fs::path _path;
+    bool _is_wav;
+    wavReader _wav_reader;
+    std::vector<float> _buffer; // wav frames converted for one callback
+
+    // raw PCM: the whole file is mapped
+    const uint8_t* _mapped = nullptr;
+    size_t _mapped_size    = 0;
+    size_t _num_frames     = 0;
+    size_t _position       = 0;
+    rawPcmFormat _raw_format;
+
+
+public:
+    // .wav files are parsed, anything else is raw PCM in raw_format
+    fileSource(const fs::path& path, sourceConfig config = {}, rawPcmFormat raw_format = {});
+    ~fileSource() override;
+
+    bool is_open() const {return _capture_sink != nullptr;}
+    double get_sample_rate() const override;
+    size_t get_num_frames() const {return _is_wav ? _wav_reader.get_info().num_frames : _num_frames;}
+    std::string get_name() const override {return "file:" + _path.string();}
+
+
+protected:
+    size_t deliver(size_t max_frames, double adc_time, double callback_time) override;
+    bool rewind() override;
+
+
+private:
+    bool map_raw();
+};
+
+
+struct syntheticConfig{
+    double sample_rate      = 16000;
+    float frequency         = 440.0f;
+    float amplitude         = 0.5f;
+    float noise_amplitude   = 0.0f;  // uniform noise on top of the tone
+    double duration_seconds = 0;     // 0: endless
+    uint32_t seed           = 1234;
+};
+
+
+class syntheticSource : public pacedSource{
+private:
+    syntheticConfig _synthetic_config;
+    std::vector<float> _buffer;
+    std::mt19937 _generator;
+    size_t _position = 0;
+    size_t _num_frames; // 0: endless
+
+
+public:
+    syntheticSource(syntheticConfig synthetic_config = {}, sourceConfig config = {});
+    ~syntheticSource() override;
+
+    double get_sample_rate() const override {return _synthetic_config.sample_rate;}
+    std::string get_name() const override {return "synthetic";}
+
+    // the samples the source delivers from frame on (reference for tests)
+    void generate(float* out, size_t frame, size_t num_frames);
+
+
+protected:
+    size_t deliver(size_t max_frames, double adc_time, double callback_time) override;
+    bool rewind() override;
+};
+
+
+class fdSource : public audioSource{
+private:
+    int _fd;
+    bool _own_fd;
+    double _sample_rate;
+    sourceConfig _config;
+    std::unique_ptr<captureSink> _capture_sink;
+    std::thread _thread;
+    std::atomic<bool> _running{false};
+    std::atomic<bool> _at_end{false};
+    std::chrono::steady_clock::time_point _start_time;
+
+    // bytes of a sample split across two reads, kept in front of the next write position
+    size_t _partial_bytes = 0;
+    size_t _frames_read   = 0;
+
+
+public:
+    // own_fd: close the descriptor on destruction
+    fdSource(int fd, double sample_rate, captureSampleFormat format = CAPTURE_INT16,
+             sourceConfig config = {}, bool own_fd = false);
+    ~fdSource() override;
+
+    bool start() override;
+    void stop() override; // returns within POLL_TIMEOUT_MS even when the writer is silent
+
+    // getters
+    bool is_running() const override {return _running.load();}
+    bool at_end() const override {return _at_end.load(std::memory_order_acquire);}
+    double get_sample_rate() const override {return _sample_rate;}
+    captureSink* get_capture_sink() override {return _capture_sink.get();}
+    std::string get_name() const override {return "fd:" + std::to_string(_fd);}
+    size_t get_frames_read() const {return _frames_read;} // after stop() or at_end()
+
+
+private:
+    static constexpr int POLL_TIMEOUT_MS = 50;
+    void read_loop();
+    bool read_once(); // false on end of stream / error
+};
+
+
+    } // namespace audio
+} // namespace asr
+
+
+#endif // ASR_REALTIME_AUDIO_SOURCE
@@ -0,0 +1,172 @@
+#ifndef ASR_REALTIME_CAPTURE_SINK
+#define ASR_REALTIME_CAPTURE_SINK
+
+#include <atomic>
+#include <vector>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "utils/ring_buffer.hpp"
+
+
+/*
+Destination of the capture callback. The real-time side (on_audio, called from the portaudio
+callback through userData) only copies the frames into a preallocated spscRingBuffer and
+updates a few atomics: no allocation, no lock, no logging. A consumer thread reads the
+frames back (read / wait_for) and feeds the recognizer.
+
+xruns are counted from two sources: the driver flags (input overflow / underflow) and
+samples dropped because the consumer did not keep up with the ring.
+
+With CAPTURE_INT16 the ring holds the raw 16-bit frames the device delivered (half the bytes
+through the callback and the ring) and read() converts them to float in one simd pass on the
+consumer thread.
+
+multiChannelCaptureSink takes the interleaved frames of an N-channel stream, de-interleaves
+them (simd) on the stack and hands every channel to its own captureSink, so each channel can be
+consumed and recognized independently (e.g. agent / customer sides of a stereo call).
+*/
+
+namespace asr{
+    namespace audio{
+
+
+enum captureSampleFormat : uint8_t {
+    CAPTURE_FLOAT32 = 0,
+    CAPTURE_INT16   = 1
+};
+
+
+struct captureStats{
+    size_t num_callbacks    = 0;
+    size_t frames_captured  = 0; // written to the ring
+    size_t frames_dropped   = 0; // the ring was full (consumer too slow)
+    size_t input_overflows  = 0; // reported by the driver
+    size_t input_underflows = 0;
+    size_t discontinuities  = 0; // adc timestamps jumped by more than one buffer
+    double first_adc_time   = 0; // stream time (s) of the first captured frame
+    double last_adc_time    = 0;
+    double max_callback_latency = 0; // callback time - adc time of its first frame (s)
+};
+
+
+class captureSink{
+private:
+    captureSampleFormat _format;
+    std::unique_ptr<spscRingBuffer<float>> _float_ring;   // CAPTURE_FLOAT32
+    std::unique_ptr<spscRingBuffer<int16_t>> _int16_ring; // CAPTURE_INT16
+    double _sample_rate;
+
+    // written by the callback thread only
+    std::atomic<size_t> _num_callbacks{0};
+    std::atomic<size_t> _frames_captured{0};
+    std::atomic<size_t> _input_overflows{0};
+    std::atomic<size_t> _input_underflows{0};
+    std::atomic<size_t> _discontinuities{0};
+    std::atomic<double> _first_adc_time{0};
+    std::atomic<double> _last_adc_time{0};
+    std::atomic<double> _max_callback_latency{0};
+    double _expected_adc_time = -1; // adc time the next buffer should start at
+
+
+public:
+    captureSink(double sample_rate, size_t capacity_frames, captureSampleFormat format = CAPTURE_FLOAT32);
+    captureSink(const captureSink&) = delete;
+    captureSink& operator=(const captureSink&) = delete;
+
+    // real-time side (a single callback thread). either overload works with either format
+    void on_audio(const float* input,
+                  size_t num_frames,
+                  double adc_time,
+                  double callback_time,
+                  bool input_overflow,
+                  bool input_underflow);
+    void on_audio(const int16_t* input,
+                  size_t num_frames,
+                  double adc_time,
+                  double callback_time,
+                  bool input_overflow,
+                  bool input_underflow);
+
+    // zero-copy producer side (e.g. read(2) straight into the ring). the views are empty when
+    // the sink holds the other format. commit() publishes the frames and records one "callback"
+    ringView<float> prepare_write_float(size_t max_frames);
+    ringView<int16_t> prepare_write_int16(size_t max_frames);
+    void commit(size_t num_frames, double adc_time, double callback_time);
+
+    // consumer side (a single thread). int16 frames are converted to [-1, 1) floats
+    size_t read(float* out, size_t max_frames);
+    size_t read(std::vector<float>& out, size_t max_frames); // resizes out to the frames read
+    bool wait_for(size_t min_frames, std::chrono::milliseconds timeout) const;
+
+    // getters
+    size_t get_available() const;
+    size_t get_capacity() const;
+    double get_sample_rate() const {return _sample_rate;}
+    captureSampleFormat get_format() const {return _format;}
+    size_t get_bytes_per_frame() const {return _format == CAPTURE_INT16 ? sizeof(int16_t) : sizeof(float);}
+    captureStats get_stats() const;
+
+
+private:
+    void record_timing(size_t num_frames, double adc_time, double callback_time,
+                       bool input_overflow, bool input_underflow);
+    size_t write_converted(const float* input, size_t num_frames);
+    size_t write_converted(const int16_t* input, size_t num_frames);
+};
+
+
+class multiChannelCaptureSink{
+public:
+    static constexpr size_t MAX_CHANNELS  = 8;
+    static constexpr size_t SPLIT_FRAMES  = 1024; // frames de-interleaved per block (on the callback's stack)
+
+
+private:
+    std::vector<std::unique_ptr<captureSink>> _channels;
+    captureSampleFormat _format;
+    double _sample_rate;
+
+
+public:
+    multiChannelCaptureSink(double sample_rate,
+                            size_t capacity_frames,
+                            size_t num_channels,
+                            captureSampleFormat format = CAPTURE_FLOAT32);
+    multiChannelCaptureSink(const multiChannelCaptureSink&) = delete;
+    multiChannelCaptureSink& operator=(const multiChannelCaptureSink&) = delete;
+
+    // real-time side. input is interleaved [num_frames, num_channels]. callbacks longer than
+    // SPLIT_FRAMES reach the channel sinks as several blocks
+    void on_audio(const float* input,
+                  size_t num_frames,
+                  double adc_time,
+                  double callback_time,
+                  bool input_overflow,
+                  bool input_underflow);
+    void on_audio(const int16_t* input,
+                  size_t num_frames,
+                  double adc_time,
+                  double callback_time,
+                  bool input_overflow,
+                  bool input_underflow);
+
+    // getters (consumers read each channel from its own thread)
+    captureSink& get_channel(size_t channel_index){return *_channels[channel_index];}
+    size_t get_num_channels() const {return _channels.size();}
+    captureSampleFormat get_format() const {return _format;}
+
+
+private:
+    template <typename T>
+    void split(const T* input, size_t num_frames, double adc_time, double callback_time,
+               bool input_overflow, bool input_underflow);
+};
+
+
+    } // namespace audio
+} // namespace asr
+
+
+#endif // ASR_REALTIME_CAPTURE_SINK
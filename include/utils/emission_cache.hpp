@@ -0,0 +1,100 @@
+#ifndef ASR_REALTIME_EMISSION_CACHE
+#define ASR_REALTIME_EMISSION_CACHE
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <filesystem>
+
+
+/*
+On-disk emission cache. Written once per audio file after the acoustic model, then
+memory-mapped by decoder-only runs (alpha/beta/beam sweeps) without re-running the model.
+
+layout:
+    emissionCacheHeader (padded to data_offset)
+    num_frames x vocab_size log-probs, row major, fp32 or fp16
+*/
+
+namespace fs = std::filesystem;
+
+namespace asr{
+    namespace emissions{
+
+
+enum emissionDtype : uint16_t {
+    FP32 = 0,
+    FP16 = 1
+};
+
+
+#pragma pack(push, 1)
+struct emissionCacheHeader{
+    char magic[4];          // "EMIS"
+    uint16_t version;
+    uint16_t dtype;         // emissionDtype
+    uint32_t num_frames;
+    uint32_t vocab_size;
+    float frame_rate;       // frames per second of audio
+    uint32_t data_offset;   // bytes from the start of the file (aligned for simd loads)
+};
+#pragma pack(pop)
+
+constexpr uint16_t EMISSION_CACHE_VERSION   = 1;
+constexpr uint32_t EMISSION_CACHE_ALIGNMENT = 64;
+
+
+// fp16 helpers (IEEE 754 half precision)
+uint16_t float_to_half(float value);
+float half_to_float(uint16_t value);
+
+
+bool write_emission_cache(const fs::path& path_to_cache,
+                          const float* log_probs,
+                          size_t num_frames,
+                          size_t vocab_size,
+                          float frame_rate,
+                          emissionDtype dtype = FP32);
+
+
+class emissionCache{
+private:
+    const uint8_t* _mapped = nullptr;
+    size_t _mapped_size = 0;
+    const emissionCacheHeader* _header = nullptr;
+    const void* _data = nullptr;
+    fs::path _path;
+
+
+public:
+    emissionCache(){};
+    emissionCache(const fs::path& path_to_cache);
+    ~emissionCache();
+    emissionCache(const emissionCache&) = delete;
+    emissionCache& operator=(const emissionCache&) = delete;
+
+    bool open(const fs::path& path_to_cache);
+    void close();
+
+    // getters
+    bool is_open() const {return _mapped != nullptr;}
+    size_t get_num_frames() const {return _header ? _header->num_frames : 0;}
+    size_t get_vocab_size() const {return _header ? _header->vocab_size : 0;}
+    float get_frame_rate() const {return _header ? _header->frame_rate : 0;}
+    emissionDtype get_dtype() const {return _header ? static_cast<emissionDtype>(_header->dtype) : FP32;}
+    fs::path get_path() const {return _path;}
+
+    // zero copy access to fp32 caches (nullptr for fp16)
+    const float* get_fp32_data() const;
+    const float* get_frame(size_t frame_index) const;
+
+    // works for every dtype. out must hold vocab_size floats
+    void read_frame(size_t frame_index, float* out) const;
+};
+
+
+    } // namespace emissions
+} // namespace asr
+
+
+#endif // ASR_REALTIME_EMISSION_CACHE
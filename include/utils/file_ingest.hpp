@@ -0,0 +1,132 @@
+#ifndef ASR_REALTIME_FILE_INGEST
+#define ASR_REALTIME_FILE_INGEST
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+/*
+Batch ingestion for offline transcription. Reading recordings one at a time leaves the disks
+idle while the cpus decode, so the reads are kept in flight ahead of the consumers:
+
+    io thread  --(up to queue_depth reads in flight)-->  pooled buffers  -->  ready queue
+    workers    <-- pop a whole file, parse + infer (consumer), give the buffer back
+
+The io backend is io_uring (raw syscalls, one submitting thread) when the kernel allows it, and
+a pool of pread() threads otherwise. Files are read whole into max_buffers reusable buffers,
+which bounds the memory and applies back-pressure: when the consumers fall behind, no new
+reads are submitted until a buffer is released.
+
+ingestStats::io_wait_seconds is the time the workers spent waiting for a file to arrive, i.e.
+what the storage still costs on top of the compute.
+*/
+
+namespace fs = std::filesystem;
+
+namespace asr{
+    namespace audio{
+
+
+enum ingestBackend : uint8_t {
+    INGEST_AUTO     = 0, // io_uring, falling back to pread
+    INGEST_IO_URING = 1,
+    INGEST_PREAD    = 2
+};
+
+
+struct ingestConfig{
+    ingestBackend backend = INGEST_AUTO;
+    size_t queue_depth    = 64;      // io_uring reads in flight
+    size_t max_buffers    = 32;      // files held in memory (being read + waiting for a worker)
+    size_t read_size      = 1 << 20; // bytes per read request
+    size_t num_io_threads = 8;       // pread backend
+    size_t num_workers    = 4;       // consumer threads
+};
+
+
+struct ingestedFile{
+    size_t index = 0;              // position in the input list
+    fs::path path;
+    const uint8_t* data = nullptr; // the whole file, valid during the consumer call
+    size_t size = 0;
+    bool ok = false;               // false: the file could not be opened or read
+};
+
+
+struct ingestStats{
+    ingestBackend backend   = INGEST_AUTO; // the one actually used
+    size_t num_files        = 0;
+    size_t failed_files     = 0;
+    size_t bytes_read       = 0;
+    double wall_seconds     = 0;
+    double io_wait_seconds  = 0; // summed over workers: waiting for the next file
+    double consumer_seconds = 0; // summed over workers: inside the consumer
+
+    double get_throughput_mb() const {return wall_seconds > 0 ? bytes_read / wall_seconds / (1 << 20) : 0;}
+    std::string summary() const;
+};
+
+
+class fileIngestor{
+public:
+    typedef std::function<void(const ingestedFile&)> consumerFn; // called from the worker threads
+
+
+private:
+    struct fileBuffer{
+        std::vector<uint8_t> bytes; // capacity is kept across files
+        ingestedFile file;
+    };
+
+    ingestConfig _config;
+
+    // buffer pool and ready queue
+    std::vector<fileBuffer> _buffers;
+    std::vector<fileBuffer*> _free_buffers;
+    std::deque<fileBuffer*> _ready;
+    std::mutex _mutex;
+    std::condition_variable _buffer_released;
+    std::condition_variable _file_ready;
+    bool _io_done = false;
+
+    std::atomic<size_t> _next_file{0}; // pread backend
+    std::atomic<size_t> _bytes_read{0};
+    std::atomic<size_t> _failed_files{0};
+
+
+public:
+    fileIngestor(ingestConfig config = {});
+    fileIngestor(const fileIngestor&) = delete;
+    fileIngestor& operator=(const fileIngestor&) = delete;
+
+    // reads every file and hands it to consumer on one of num_workers threads, in completion order
+    ingestStats run(const std::vector<fs::path>& paths, const consumerFn& consumer);
+
+    static bool is_io_uring_available();
+
+
+private:
+    bool io_uring_loop(const std::vector<fs::path>& paths); // false: io_uring could not be set up
+    void pread_loop(const std::vector<fs::path>& paths);
+    void worker_loop(const consumerFn& consumer, double& io_wait_seconds, double& consumer_seconds);
+
+    fileBuffer* acquire_buffer(bool wait);
+    void release_buffer(fileBuffer* buffer);
+    void push_ready(fileBuffer* buffer);
+    bool open_file(const fs::path& path, size_t index, fileBuffer& buffer, int& fd); // sizes the buffer
+};
+
+
+    } // namespace audio
+} // namespace asr
+
+
+#endif // ASR_REALTIME_FILE_INGEST
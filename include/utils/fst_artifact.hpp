@@ -0,0 +1,83 @@
+#ifndef ASR_REALTIME_FST_ARTIFACT
+#define ASR_REALTIME_FST_ARTIFACT
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include "utils/fst_glog_safe_log.hpp"
+
+
+/*
+The lexicon fst as the decoder loads it. The builders (LexiconFst::write_fst, lexiconCompiler)
+hand write_const_fst their fst as built and it writes one file:
+
+    a ConstFst: states and arcs in two flat arrays, nothing to rebuild when reading
+    input label sorted, for the decoder's SortedMatcher
+    both symbol tables embedded in the header
+    aligned, so FstReadOptions::MAP can mmap the arrays instead of copying them
+
+The fst is not determinized or minimized here. LexiconFst's trie keeps one path into every
+state, which the decoder's state -> word id table needs (decoders/word_map.hpp), and
+lexiconCompiler's automaton is already minimal.
+
+read_lexicon_fst maps it read-only: startup does not depend on the lexicon size and every
+decoder process on the host shares the page cache copy. Fsts written before (StdVectorFst, with
+isymbols.sym / osymbols.sym next to them) are still read and converted on the heap.
+*/
+
+namespace fs = std::filesystem;
+
+namespace asr{
+    namespace myfst{
+
+
+inline const char* CONST_FST_TYPE = "const"; // FstHeader::FstType() of StdConstFst
+
+
+// sorts lexicon_fst by input label in place, then writes it as the aligned ConstFst artifact.
+// the symbol tables set on lexicon_fst are embedded
+inline bool write_const_fst(fst::StdVectorFst* lexicon_fst, const fs::path& path_to_fst){
+    if (!lexicon_fst) return false;
+    fst::ArcSort(lexicon_fst, fst::ILabelCompare<fst::StdArc>()); // the decoder's SortedMatcher needs it
+
+    fst::StdConstFst const_fst(*lexicon_fst);
+    std::ofstream fst_stream(path_to_fst, std::ios::binary);
+    fst::FstWriteOptions options(path_to_fst.string());
+    options.align = true;
+    if (!fst_stream.is_open() || !const_fst.Write(fst_stream, options)){
+        LOG(WARNING) << "[myfst/write_const_fst]: failed to write " << path_to_fst;
+        return false;
+    }
+    VLOG(2) << "[myfst/write_const_fst]: wrote " << const_fst.NumStates() << " states to " << path_to_fst;
+    return true;
+}
+
+
+// maps a ConstFst artifact read-only, converts a StdVectorFst. nullptr when neither reads
+inline fst::StdConstFst* read_lexicon_fst(const fs::path& path_to_fst){
+    std::ifstream fst_stream(path_to_fst, std::ios::binary);
+    fst::FstHeader header;
+    if (!fst_stream.is_open() || !header.Read(fst_stream, path_to_fst.string())){
+        LOG(WARNING) << "[myfst/read_lexicon_fst]: failed to read the fst header of " << path_to_fst;
+        return nullptr;
+    }
+    fst_stream.seekg(0);
+
+    fst::FstReadOptions options(path_to_fst.string());
+    if (header.FstType() == CONST_FST_TYPE){
+        options.mode = fst::FstReadOptions::MAP;
+        return fst::StdConstFst::Read(fst_stream, options);
+    }
+    LOG(WARNING) << "[myfst/read_lexicon_fst]: " << path_to_fst << " is a " << header.FstType()
+                 << " fst, converting it on the heap. rebuild it (setup) to map it";
+    std::unique_ptr<fst::StdVectorFst> vector_fst(fst::StdVectorFst::Read(fst_stream, options));
+    return vector_fst ? new fst::StdConstFst(*vector_fst) : nullptr;
+}
+
+
+    } // namespace myfst
+} // namespace asr
+
+
+#endif // ASR_REALTIME_FST_ARTIFACT
@@ -12,6 +12,7 @@
 #include <fst/fstlib.h>
 #include <filesystem>
 #include <limits>
+#include <cmath>
 #include "decoders/beam.hpp"
 
 
@@ -22,16 +23,7 @@ namespace fs = std::filesystem;
 
 const float NUM_FLT_MIN  = std::numeric_limits<float>::min();
 
-// For reading wav files
-#pragma pack(push, 1)
-struct RIFFHeader {
-    char riff[4];           
-    uint32_t fileSize;      
-    char wave[4];           
-};
-#pragma pack(pop)
-
-
+// For reading wav files (mono float32, see utils/wav_reader.hpp)
 std::vector<float> readwav(std::string path_to_wav_file);
 
 
@@ -186,6 +178,12 @@ namespace asr{
             double cutoff_prob,
             size_t cutoff_top_n,
             int log_input);
+        std::vector<std::pair<size_t, double>> get_pruned_log_probs(
+            const float* prob_step,
+            size_t num_tokens,
+            double cutoff_prob,
+            size_t cutoff_top_n,
+            int log_input);
 
         template <typename T>
         T log_sum_exp(const T &x, const T &y) {
@@ -196,6 +194,26 @@ namespace asr{
             return std::log(std::exp(x - xmax) + std::exp(y - xmax)) + xmax;
         }
 
+        // the num of tokens get_pruned_log_probs keeps from sorted_probs (best first): cutoff_prob
+        // of the mass, at most cutoff_top_n. shared with the sparse path so both prune the same way
+        template <typename pairT>
+        size_t get_cutoff_length(const std::vector<pairT>& sorted_probs,
+                                 double cutoff_prob,
+                                 size_t cutoff_top_n,
+                                 int log_input) {
+            if (std::log(cutoff_prob) >= 0.0) {
+                return std::min(sorted_probs.size(), cutoff_top_n);
+            }
+            double cum_prob = 0.0;
+            size_t cutoff_len = 0;
+            for (size_t i = 0; i < sorted_probs.size(); ++i) {
+                cum_prob = log_sum_exp(cum_prob, log_input ? sorted_probs[i].second : std::log(sorted_probs[i].second));
+                cutoff_len += 1;
+                if (cum_prob >= cutoff_prob || cutoff_len >= cutoff_top_n) break;
+            }
+            return cutoff_len;
+        }
+
         bool prefix_compare(const beam::ctcBeam* x, const beam::ctcBeam* y);
     } //namespace myutils 
     namespace stringmanip{
@@ -0,0 +1,81 @@
+#ifndef ASR_REALTIME_RESAMPLER
+#define ASR_REALTIME_RESAMPLER
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+
+/*
+Streaming polyphase resampler (rational L/M, L = output_rate / gcd, M = input_rate / gcd).
+The windowed-sinc prototype is split into L phase filters once at construction, each stored
+reversed so every output sample is a single contiguous dot product (simd::dot_product).
+State (history samples and the phase position) is kept across process() calls, so chunks of
+any size can be pushed. The filter delay is compensated: output sample 0 lines up with input
+sample 0, and flush() emits the tail.
+
+typical use: capture / wav at 44.1 or 48 kHz -> resampler -> torchScriptModel at 16 kHz
+*/
+
+namespace asr{
+    namespace audio{
+
+
+struct resamplerConfig{
+    size_t zero_crossings = 16;    // sinc lobes per side (in units of the lower of the two rates)
+    float rolloff         = 0.92f; // cutoff as a fraction of the lower nyquist
+    float kaiser_beta     = 8.0f;  // ~80 dB stopband
+};
+
+
+class polyphaseResampler{
+private:
+    uint32_t _input_rate;
+    uint32_t _output_rate;
+    size_t _up;   // L
+    size_t _down; // M
+    size_t _taps_per_phase = 0;
+    std::vector<float> _filter_bank; // [L, taps_per_phase], each phase reversed
+
+    // streaming state
+    std::vector<float> _buffer;  // history (taps_per_phase - 1 samples) followed by the pending input
+    size_t _time = 0;            // current output position in the upsampled domain, relative to _buffer[0]
+    size_t _initial_time = 0;
+    uint64_t _total_in  = 0;
+    uint64_t _total_out = 0;
+
+
+public:
+    polyphaseResampler(uint32_t input_rate, uint32_t output_rate, resamplerConfig config = {});
+
+    // appends the produced samples to output and returns their number
+    size_t process(const float* input, size_t num_samples, std::vector<float>& output);
+    std::vector<float> process(const std::vector<float>& input);
+    size_t flush(std::vector<float>& output); // end of stream: emits the samples held back by the filter delay
+    void reset();
+
+    // one shot convenience for whole buffers (e.g. a wav file)
+    static std::vector<float> resample(const std::vector<float>& input,
+                                       uint32_t input_rate,
+                                       uint32_t output_rate,
+                                       resamplerConfig config = {});
+
+    // getters
+    uint32_t get_input_rate() const {return _input_rate;}
+    uint32_t get_output_rate() const {return _output_rate;}
+    size_t get_num_phases() const {return _up;}
+    size_t get_taps_per_phase() const {return _taps_per_phase;}
+    bool is_passthrough() const {return _up == 1 && _down == 1;}
+
+
+private:
+    void build_filter_bank(const resamplerConfig& config);
+    size_t run(std::vector<float>& output, size_t max_output);
+};
+
+
+    } // namespace audio
+} // namespace asr
+
+
+#endif // ASR_REALTIME_RESAMPLER
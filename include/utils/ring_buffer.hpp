@@ -1,4 +1,13 @@
+#ifndef ASR_REALTIME_RING_BUFFER
+#define ASR_REALTIME_RING_BUFFER
 
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include "utils/spsc_queue.hpp" // CACHE_LINE_SIZE
 
 
 template<typename T>
@@ -58,3 +67,140 @@ template<typename T>
 size_t ringBuffer<T>::size() const {
     return count;
 }
+
+
+/*
+Lock-free single-producer / single-consumer ring for sample streams (e.g. the portaudio
+callback -> the model thread). Unlike ringBuffer above:
+    - no lock: the producer only writes _tail, the consumer only writes _head, each on its
+      own cache line, and each side caches the other's index to avoid touching its line
+    - bulk write()/read() of whole blocks (two memcpy-like copies at most)
+    - zero copy access through two-segment views: peek()/consume() on the consumer side,
+      prepare_write()/commit() on the producer side
+    - never overwrites unread data: samples that do not fit are dropped and counted
+      (get_overflow_count), reading an empty ring returns 0 instead of throwing
+The capacity is rounded up to a power of two, the indices run freely and are masked.
+*/
+
+namespace asr{
+
+
+template <typename T>
+struct ringSegment{
+    T* data     = nullptr;
+    size_t size = 0;
+};
+
+
+// a contiguous range of the ring that may wrap around: first, then second
+template <typename T>
+struct ringView{
+    ringSegment<T> first;
+    ringSegment<T> second;
+
+    size_t size() const {return first.size + second.size;}
+    bool empty() const {return size() == 0;}
+};
+
+
+template <typename T>
+class spscRingBuffer{
+private:
+    std::vector<T> _buffer;
+    size_t _mask;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> _head{0}; // consumer position
+    size_t _cached_tail = 0;                               // consumer's copy of _tail
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> _tail{0}; // producer position
+    size_t _cached_head = 0;                               // producer's copy of _head
+    std::atomic<size_t> _overflow_count{0};                // elements dropped because the ring was full
+
+
+public:
+    explicit spscRingBuffer(size_t min_capacity) : _buffer(round_up_pow2(min_capacity)), _mask(_buffer.size() - 1){}
+    spscRingBuffer(const spscRingBuffer&) = delete;
+    spscRingBuffer& operator=(const spscRingBuffer&) = delete;
+
+    // producer side
+    size_t write(const T* data, size_t count){
+        ringView<T> view = prepare_write(count);
+        std::copy(data, data + view.first.size, view.first.data);
+        std::copy(data + view.first.size, data + view.size(), view.second.data);
+        commit(view.size());
+        if (view.size() < count){
+            _overflow_count.fetch_add(count - view.size(), std::memory_order_relaxed);
+        }
+        return view.size();
+    }
+
+    ringView<T> prepare_write(size_t max_count){
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (capacity() - (tail - _cached_head) < max_count){
+            _cached_head = _head.load(std::memory_order_acquire);
+        }
+        return make_view(tail, std::min(max_count, capacity() - (tail - _cached_head)));
+    }
+
+    void commit(size_t count){
+        _tail.store(_tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // consumer side
+    size_t read(T* out, size_t count){
+        ringView<const T> view = peek(count);
+        std::copy(view.first.data, view.first.data + view.first.size, out);
+        std::copy(view.second.data, view.second.data + view.second.size, out + view.first.size);
+        consume(view.size());
+        return view.size();
+    }
+
+    ringView<const T> peek(size_t max_count = static_cast<size_t>(-1)){
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (_cached_tail - head < max_count){
+            _cached_tail = _tail.load(std::memory_order_acquire);
+        }
+        ringView<T> view = make_view(head, std::min(max_count, _cached_tail - head));
+        return {{view.first.data, view.first.size}, {view.second.data, view.second.size}};
+    }
+
+    void consume(size_t count){
+        _head.store(_head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // getters (approximate when called while the other side is running)
+    // exact on the producer and the consumer thread, a snapshot from any other. the head is read
+    // first: the tail read after it is never behind it, so the difference cannot underflow. both
+    // sides may move between the two loads, so it is clamped to the capacity
+    size_t size() const {
+        size_t head = _head.load(std::memory_order_acquire);
+        size_t tail = _tail.load(std::memory_order_acquire);
+        return std::min(tail - head, capacity());
+    }
+    bool empty() const {return size() == 0;}
+    size_t capacity() const {return _buffer.size();}
+    size_t get_overflow_count() const {return _overflow_count.load(std::memory_order_relaxed);}
+
+
+private:
+    static size_t round_up_pow2(size_t value){
+        size_t result = 1;
+        while (result < value) result <<= 1;
+        return result;
+    }
+
+    ringView<T> make_view(size_t position, size_t count){
+        size_t begin    = position & _mask;
+        size_t first    = std::min(count, capacity() - begin);
+        ringView<T> view;
+        view.first  = {_buffer.data() + begin, first};
+        view.second = {_buffer.data(), count - first};
+        return view;
+    }
+};
+
+
+} // namespace asr
+
+
+#endif // ASR_REALTIME_RING_BUFFER
@@ -0,0 +1,44 @@
+#ifndef ASR_REALTIME_SIMD_KERNELS
+#define ASR_REALTIME_SIMD_KERNELS
+
+#include <cstdint>
+#include <cstddef>
+
+
+/*
+Small vectorized kernels shared by the audio front-end. The AVX2 paths are compiled when the
+build enables them (ENABLE_AVX2 -> -mavx2 -mfma), every kernel has a scalar fallback that is
+also used for the tails. Inputs do not need to be aligned (mmapped wav data rarely is).
+*/
+
+namespace asr{
+    namespace simd{
+
+
+// integer / float pcm -> float32 in [-1, 1)
+void pcm16_to_float(const int16_t* input, float* output, size_t num_samples);
+void pcm24_to_float(const uint8_t* input, float* output, size_t num_samples); // packed little endian, 3 bytes per sample
+void pcm32_to_float(const int32_t* input, float* output, size_t num_samples);
+
+// interleaved [num_frames, num_channels] -> mono average. output may alias input
+void downmix_to_mono(const float* input, float* output, size_t num_frames, size_t num_channels);
+
+// interleaved [num_frames, num_channels] -> one planar buffer of num_frames per channel (stereo is vectorized)
+void deinterleave(const float* input, float* const* outputs, size_t num_frames, size_t num_channels);
+void deinterleave(const int16_t* input, int16_t* const* outputs, size_t num_frames, size_t num_channels);
+
+// sum_i x[i] * h[i] (fir filters)
+float dot_product(const float* x, const float* h, size_t size);
+
+// frame features (vad)
+float sum_of_squares(const float* x, size_t size);
+size_t zero_crossings(const float* x, size_t size); // sign changes between neighbours (0 counts as positive)
+
+bool has_avx2(); // true if the kernels were compiled with avx2
+
+
+    } // namespace simd
+} // namespace asr
+
+
+#endif // ASR_REALTIME_SIMD_KERNELS
@@ -0,0 +1,84 @@
+#ifndef ASR_REALTIME_SPARSE_EMISSIONS
+#define ASR_REALTIME_SPARSE_EMISSIONS
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <utility>
+
+
+/*
+Sparse emission exchange format between the acoustic model and the decoder. The decoder only
+expands the top few tokens of each frame, so instead of the dense [T, vocab] tensor every frame
+keeps its top-k (token index, log-prob) pairs (sorted, best first) and the blank log-prob.
+Log-probs can optionally be quantized to 16 or 8 bits over [min_log_prob, 0].
+*/
+
+namespace asr{
+    namespace emissions{
+
+
+enum sparseQuantization : uint8_t {
+    NO_QUANTIZATION = 0,
+    QUANTIZE_8      = 8,
+    QUANTIZE_16     = 16
+};
+
+
+struct sparseEmissionsConfig{
+    size_t top_k      = 5;
+    size_t blank_index = 0;
+    sparseQuantization quantization = NO_QUANTIZATION;
+    float min_log_prob = -40.0f; // quantized values are clamped to [min_log_prob, 0]
+};
+
+
+class sparseEmissions{
+private:
+    size_t _num_frames = 0;
+    size_t _vocab_size = 0;
+    sparseEmissionsConfig _config;
+    float _scale = 0; // log-prob step of one quantization level
+
+    std::vector<uint8_t> _indices;        // [num_frames, top_k]
+    std::vector<float> _values;           // [num_frames, top_k] when not quantized
+    std::vector<uint16_t> _values_q16;    // [num_frames, top_k] when quantized to 16 bits
+    std::vector<uint8_t> _values_q8;      // [num_frames, top_k] when quantized to 8 bits
+    std::vector<float> _blank_log_probs;  // [num_frames]
+
+
+public:
+    sparseEmissions(){};
+    sparseEmissions(size_t vocab_size, sparseEmissionsConfig config);
+
+    // log_probs: [num_frames, vocab_size] row major log-probabilities
+    static sparseEmissions from_log_probs(const float* log_probs,
+                                          size_t num_frames,
+                                          size_t vocab_size,
+                                          sparseEmissionsConfig config);
+    void append_frame(const float* log_probs);
+    void append(const sparseEmissions& other);
+
+    // frame access (dequantized). out is sorted best first
+    void get_frame(size_t frame_index, std::vector<std::pair<size_t, double>>& out) const;
+    float get_blank_log_prob(size_t frame_index) const {return _blank_log_probs[frame_index];}
+
+    // getters
+    size_t get_num_frames() const {return _num_frames;}
+    size_t get_vocab_size() const {return _vocab_size;}
+    size_t get_top_k() const {return _config.top_k;}
+    size_t get_size_bytes() const;
+    bool empty() const {return _num_frames == 0;}
+
+
+private:
+    float dequantize(size_t value_index) const;
+    void store(float log_prob);
+};
+
+
+    } // namespace emissions
+} // namespace asr
+
+
+#endif // ASR_REALTIME_SPARSE_EMISSIONS
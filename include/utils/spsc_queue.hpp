@@ -0,0 +1,79 @@
+#ifndef ASR_REALTIME_SPSC_QUEUE
+#define ASR_REALTIME_SPSC_QUEUE
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <utility>
+
+
+/*
+Bounded lock-free queue for exactly one producer thread and one consumer thread.
+The producer only writes _tail and the consumer only writes _head, each on its own
+cache line, so the two sides never contend on the same lock or line.
+*/
+
+namespace asr{
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+
+template <typename T>
+class spscQueue{
+private:
+    std::vector<T> _slots;
+    size_t _capacity; // one slot is kept empty to tell full from empty
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> _head{0}; // next slot to read (consumer)
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> _tail{0}; // next slot to write (producer)
+
+
+public:
+    explicit spscQueue(size_t capacity) : _slots(capacity + 1), _capacity(capacity + 1){}
+    spscQueue(const spscQueue&) = delete;
+    spscQueue& operator=(const spscQueue&) = delete;
+
+    // producer side
+    bool try_push(T&& value){
+        size_t tail      = _tail.load(std::memory_order_relaxed);
+        size_t next_tail = increment(tail);
+        if (next_tail == _head.load(std::memory_order_acquire)){ // full
+            return false;
+        }
+        _slots[tail] = std::move(value);
+        _tail.store(next_tail, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side
+    bool try_pop(T& value){
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)){ // empty
+            return false;
+        }
+        value = std::move(_slots[head]);
+        _head.store(increment(head), std::memory_order_release);
+        return true;
+    }
+
+    // getters (approximate when called while the other side is running)
+    size_t size() const {
+        size_t head = _head.load(std::memory_order_acquire);
+        size_t tail = _tail.load(std::memory_order_acquire);
+        return (tail >= head) ? (tail - head) : (_capacity - head + tail);
+    }
+    bool empty() const {return size() == 0;}
+    size_t capacity() const {return _capacity - 1;}
+
+
+private:
+    size_t increment(size_t index) const {
+        return (index + 1 == _capacity) ? 0 : index + 1;
+    }
+};
+
+
+} // namespace asr
+
+
+#endif // ASR_REALTIME_SPSC_QUEUE
@@ -1,18 +1,30 @@
+#ifndef ASR_REALTIME_STREAM_HANDLER
+#define ASR_REALTIME_STREAM_HANDLER
+
 #include <portaudio.h>
 #include <tuple>
 #include <string>
+#include <memory>
+#include "utils/capture_sink.hpp"
+#include "utils/audio_source.hpp"
 
 class streamHandler{
 
 private:
     PaError _err;
-    PaStream* _stream;
+    PaStream* _stream = nullptr; // null until open_stream, and again after close_stream
     int _num_in_channels;
     int _num_out_channels;
     unsigned long _sample_rate;
     unsigned long _frames_per_buffer;
+    PaSampleFormat _sample_format = paFloat32;
     const std::string __CLASS__ = "streamHandler";
 
+    // capture path: the built-in callback gets the sink as userData
+    std::unique_ptr<asr::audio::captureSink> _capture_sink;                    // mono
+    std::unique_ptr<asr::audio::multiChannelCaptureSink> _multi_channel_sink; // more than one input channel
+    double _capture_buffer_seconds = 2.0;
+
 
 
 public:
@@ -28,16 +40,20 @@ public:
                                         const PaStreamCallbackTimeInfo *timeInfo, 
                                         PaStreamCallbackFlags statusFlags, 
                                         void *userData
-                                    )
+                                    ),
+                    void* user_data = nullptr
                     );
+    int open_stream(); // captures into the owned sink (get_capture_sink, or get_multi_channel_sink for N channels). -1 while a stream is open
     int close_stream();
     int start_stream();
     int stop_stream();
 
     // mutators
-    void set_sample_rate(unsigned long& _sample_rate);
+    bool set_sample_rate(unsigned long& _sample_rate); // false if the device does not support it (resample instead)
     void set_framed_per_buffer(unsigned long _frames_per_buffer);
     void set_number_of_channles(int num_input_channels, int num_output_channels);
+    void set_capture_buffer_seconds(double capture_buffer_seconds){_capture_buffer_seconds = capture_buffer_seconds;}
+    bool set_sample_format(PaSampleFormat sample_format); // paFloat32 or paInt16 (raw 16-bit frames into the sink)
 
     // getters 
     const unsigned long get_sample_rate();
@@ -46,8 +62,56 @@ public:
     const PaDeviceIndex get_device_index();   
     const PaDeviceInfo* get_device_info();
     const PaSampleFormat get_sample_format();
+    asr::audio::captureSink* get_capture_sink(){return _capture_sink.get();} // null before open_stream() (or with N channels)
+    asr::audio::multiChannelCaptureSink* get_multi_channel_sink(){return _multi_channel_sink.get();} // null unless N > 1 channels
 
     // checkers 
     bool is_sample_rate_supported(double sample_rate);
 
-};
\ No newline at end of file
+private:
+    // real-time: copies into the sink, no allocation / lock / logging
+    static int capture_callback(const void *input, 
+                                void *output,
+                                unsigned long frameCount, 
+                                const PaStreamCallbackTimeInfo *timeInfo, 
+                                PaStreamCallbackFlags statusFlags, 
+                                void *userData);
+    static int multi_channel_capture_callback(const void *input, 
+                                              void *output,
+                                              unsigned long frameCount, 
+                                              const PaStreamCallbackTimeInfo *timeInfo, 
+                                              PaStreamCallbackFlags statusFlags, 
+                                              void *userData);
+
+};
+
+
+// the default input device behind the audioSource interface (mono, owned sink)
+class portAudioSource : public asr::audio::audioSource{
+private:
+    streamHandler _stream_handler;
+    double _sample_rate;
+    bool _initialized = false;
+    bool _running     = false;
+
+
+public:
+    portAudioSource(unsigned long sample_rate,
+                    unsigned long frames_per_buffer,
+                    PaSampleFormat sample_format = paFloat32,
+                    double buffer_seconds = 2.0);
+    ~portAudioSource() override;
+
+    bool start() override; // initializes portaudio and opens the stream on the first call
+    void stop() override;
+
+    // getters
+    bool is_running() const override {return _running;}
+    double get_sample_rate() const override {return _sample_rate;}
+    asr::audio::captureSink* get_capture_sink() override {return _stream_handler.get_capture_sink();}
+    std::string get_name() const override {return "portaudio";}
+    streamHandler& get_stream_handler() {return _stream_handler;}
+};
+
+
+#endif // ASR_REALTIME_STREAM_HANDLER
@@ -0,0 +1,94 @@
+#ifndef ASR_REALTIME_STREAM_PLAYER
+#define ASR_REALTIME_STREAM_PLAYER
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include "utils/capture_sink.hpp"
+
+
+/*
+Replays many audio buffers into their capture sinks from a single thread, the way the portaudio
+callback would (one on_audio call per frames_per_buffer frames). It is the multi-stream version
+of audioPlayerSim: instead of one thread sleeping a fixed period per stream, the player keeps
+every stream's next deadline in a heap and sleeps until the earliest one, so hundreds of
+streams cost one thread and the pacing does not drift.
+
+    speed = 1   real time
+    speed = N   N times faster than real time (deadlines are compressed)
+    speed = 0   as fast as possible. buffers are delivered whenever the sink has room, so no
+                frames are dropped and the consumer sets the pace
+
+The adc time passed to on_audio is the scheduled time of the buffer (seconds since start()),
+get_capture_time() gives the same value for any frame so consumers can measure latency.
+*/
+
+namespace asr{
+    namespace audio{
+
+
+struct streamPlayerConfig{
+    double speed             = 1.0; // 0: as fast as possible
+    size_t frames_per_buffer = 160; // frames per simulated callback
+    double stagger_seconds   = 0;   // stream i starts i * stagger_seconds (audio time) after start()
+};
+
+
+class multiStreamPlayer{
+private:
+    typedef std::chrono::steady_clock clock;
+
+    struct playerStream{
+        const std::vector<float>* audio;
+        captureSink* sink;
+        size_t position = 0;
+        double start_offset = 0; // audio seconds
+        std::atomic<bool> finished{false};
+    };
+
+    streamPlayerConfig _config;
+    std::vector<std::unique_ptr<playerStream>> _streams;
+    std::thread _thread;
+    std::atomic<bool> _running{false};
+    std::atomic<size_t> _num_finished{0};
+    std::atomic<size_t> _late_callbacks{0}; // paced mode: buffers delivered more than a buffer period late
+    clock::time_point _start_time;
+
+
+public:
+    multiStreamPlayer(streamPlayerConfig config);
+    ~multiStreamPlayer();
+    multiStreamPlayer(const multiStreamPlayer&) = delete;
+    multiStreamPlayer& operator=(const multiStreamPlayer&) = delete;
+
+    // audio and sink are not owned and must outlive the player. returns the stream index
+    size_t add_stream(const std::vector<float>& audio, captureSink& sink);
+
+    void start();
+    void stop(); // joins the player thread (streams that did not finish are left as they are)
+
+    // getters
+    bool is_finished(size_t stream_index) const {return _streams[stream_index]->finished.load(std::memory_order_acquire);}
+    bool all_finished() const {return _num_finished.load(std::memory_order_acquire) == _streams.size();}
+    size_t get_num_streams() const {return _streams.size();}
+    size_t get_late_callbacks() const {return _late_callbacks.load(std::memory_order_relaxed);}
+    double get_speed() const {return _config.speed;}
+    double get_capture_time(size_t stream_index, size_t frame) const; // seconds since start() (paced mode)
+    double get_elapsed() const; // seconds since start()
+
+
+private:
+    void paced_loop();
+    void as_fast_as_possible_loop();
+    bool deliver(playerStream& stream, double adc_time); // returns true once the stream is done
+};
+
+
+    } // namespace audio
+} // namespace asr
+
+
+#endif // ASR_REALTIME_STREAM_PLAYER
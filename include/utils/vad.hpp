@@ -0,0 +1,108 @@
+#ifndef ASR_REALTIME_VAD
+#define ASR_REALTIME_VAD
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+
+/*
+Streaming energy / zero-crossing voice activity gate. Audio is cut in frame_ms frames; a frame
+is speech when its energy is speech_margin_db above a running noise floor, or a few dB below
+that with a high zero-crossing rate (weak fricatives like /s/ and /f/). Both features are
+computed with simd kernels, so the gate costs a tiny fraction of a forward pass.
+
+    silence --(min_speech_ms of speech)--> speech --(hangover_ms of silence)--> silence
+
+Only speech is forwarded: a segment starts with up to preroll_ms of the audio before the onset
+and keeps hangover_ms after the last speech frame. When a segment closes, the chunk carrying
+its last samples is marked end_of_segment so the decoder can finalize it.
+*/
+
+namespace asr{
+    namespace audio{
+
+
+struct vadConfig{
+    uint32_t sample_rate     = 16000;
+    size_t frame_ms          = 10;
+    float speech_margin_db   = 9.0f;   // energy above the noise floor that counts as speech
+    float fricative_margin_db = 6.0f;  // below the speech threshold, still speech if the zcr is high
+    float fricative_zcr      = 0.3f;   // zero crossings per sample
+    float min_energy_db      = -55.0f; // nothing quieter is speech, whatever the noise floor
+    float initial_noise_db   = -60.0f;
+    float noise_adapt_rate   = 0.05f;  // per frame, towards louder frames while in silence
+    size_t min_speech_ms     = 30;     // consecutive speech needed to open a segment
+    size_t hangover_ms       = 300;
+    size_t preroll_ms        = 200;
+};
+
+
+struct vadChunk{
+    std::vector<float> samples;
+    bool end_of_segment = false;
+};
+
+
+struct vadStats{
+    size_t samples_in        = 0;
+    size_t samples_speech    = 0; // in frames classified as speech
+    size_t samples_forwarded = 0; // speech + pre-roll + hangover
+    size_t num_segments      = 0; // closed segments
+
+    double get_saved_fraction() const {
+        return samples_in ? 1.0 - static_cast<double>(samples_forwarded) / samples_in : 0;
+    }
+};
+
+
+class energyVad{
+private:
+    vadConfig _config;
+    size_t _frame_size;
+    size_t _min_speech_frames;
+    size_t _hangover_frames;
+    size_t _preroll_size; // samples kept while in silence (pre-roll + the onset frames)
+
+    // streaming state
+    std::vector<float> _pending; // samples of the incomplete frame
+    std::vector<float> _preroll; // most recent silence, oldest first
+    bool _in_speech = false;
+    size_t _onset_frames = 0;
+    size_t _hangover_left = 0;
+    float _noise_db;
+    vadStats _stats;
+
+
+public:
+    energyVad(vadConfig config = {});
+
+    // appends the forwarded audio to output. a new chunk is started after every closed segment
+    void process(const float* input, size_t num_samples, std::vector<vadChunk>& output);
+    void flush(std::vector<vadChunk>& output); // end of stream: closes an open segment
+    void reset();
+
+    // frame classification (exposed for tuning)
+    bool is_speech_frame(const float* frame, size_t frame_size) const;
+
+    // getters
+    bool in_speech() const {return _in_speech;}
+    float get_noise_db() const {return _noise_db;}
+    size_t get_frame_size() const {return _frame_size;}
+    const vadStats& get_stats() const {return _stats;}
+
+
+private:
+    bool classify(const float* frame, size_t frame_size, float& energy_db) const;
+    void process_frame(const float* frame, std::vector<vadChunk>& output);
+    void emit(const float* samples, size_t num_samples, std::vector<vadChunk>& output);
+    void close_segment(std::vector<vadChunk>& output);
+    void update_noise_floor(float energy_db);
+};
+
+
+    } // namespace audio
+} // namespace asr
+
+
+#endif // ASR_REALTIME_VAD
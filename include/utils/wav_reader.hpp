@@ -0,0 +1,102 @@
+#ifndef ASR_REALTIME_WAV_READER
+#define ASR_REALTIME_WAV_READER
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <filesystem>
+
+
+/*
+Memory-mapped wav reader. The RIFF chunks are walked (unknown chunks such as LIST or fact are
+skipped), and the samples are exposed as a stream that is converted to mono float32 chunk by
+chunk on read(). Already consumed pages are released, so multi-hour recordings never have to
+be fully resident.
+
+open_memory() parses a file that was already read into memory (e.g. by the batch fileIngestor)
+the same way, without copying it.
+
+supported: PCM 16/24/32 bits, IEEE float 32 bits (plain or WAVE_FORMAT_EXTENSIBLE), any number
+of channels (averaged to mono).
+*/
+
+namespace fs = std::filesystem;
+
+namespace asr{
+    namespace audio{
+
+
+enum wavSampleFormat : uint8_t {
+    WAV_UNSUPPORTED = 0,
+    WAV_PCM_16,
+    WAV_PCM_24,
+    WAV_PCM_32,
+    WAV_FLOAT_32
+};
+
+
+struct wavInfo{
+    wavSampleFormat format = WAV_UNSUPPORTED;
+    uint32_t sample_rate     = 0;
+    uint16_t num_channels    = 0;
+    uint16_t bits_per_sample = 0;
+    uint16_t block_align     = 0; // bytes per frame (all channels)
+    size_t num_frames        = 0;
+
+    double get_duration() const {return sample_rate ? static_cast<double>(num_frames) / sample_rate : 0;}
+};
+
+
+class wavReader{
+private:
+    const uint8_t* _mapped = nullptr;
+    size_t _mapped_size = 0;
+    bool _owns_mapping  = false; // false for open_memory(): the bytes belong to the caller
+    const uint8_t* _data = nullptr; // first byte of the data chunk
+    wavInfo _info;
+    fs::path _path;
+
+    size_t _position = 0;       // next frame to read
+    size_t _released_until = 0; // byte offset (from the mapping start) up to which pages were dropped
+    std::vector<float> _interleaved; // conversion scratch for multi-channel files
+
+
+public:
+    wavReader(){};
+    wavReader(const fs::path& path_to_wav);
+    ~wavReader();
+    wavReader(const wavReader&) = delete;
+    wavReader& operator=(const wavReader&) = delete;
+
+    bool open(const fs::path& path_to_wav);
+    bool open_memory(const uint8_t* data, size_t size); // a whole wav file already in memory. not copied
+    void close();
+
+    // stream interface. read() converts up to max_frames mono float32 samples into out and
+    // returns the num of frames written (0 at the end of the data)
+    size_t read(float* out, size_t max_frames);
+    size_t read(std::vector<float>& out, size_t max_frames); // resizes out to the frames read
+    std::vector<float> read_all(); // from the current position to the end
+    bool seek(size_t frame_index);
+
+    // getters
+    bool is_open() const {return _mapped != nullptr;}
+    const wavInfo& get_info() const {return _info;}
+    size_t tell() const {return _position;}
+    size_t get_remaining() const {return _info.num_frames - _position;}
+    bool eof() const {return _position >= _info.num_frames;}
+    fs::path get_path() const {return _path;}
+
+
+private:
+    bool parse_chunks();
+    void convert(const uint8_t* input, float* output, size_t num_frames);
+    void release_consumed();
+};
+
+
+    } // namespace audio
+} // namespace asr
+
+
+#endif // ASR_REALTIME_WAV_READER
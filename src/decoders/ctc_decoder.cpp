@@ -5,6 +5,7 @@
 #include "utils/fst_glog_safe_log.hpp"
 #include <sstream>
 #include <algorithm>
+#include <type_traits>
 
 // convenience log warning at certain verbosity level 
 #define VLOG_WARNING(verboselevel) if (VLOG_IS_ON(verboselevel)) LOG(WARNING)
@@ -58,23 +59,16 @@ bool ctcDecoder::set_beams_dictionary(const fs::path& path_to_fst){
     /*
     path_to_fst: this is path to the fst representing the dictionary 
                 the implementation relies on this fst being sorted (FUTURE: can I add a check on this condition)
+    a private version: the lm (if any) is kept, the fst is mapped read only
     */
-    // load the dictionary fst
-    auto dictionary_ptr = fst::StdVectorFst::Read(path_to_fst.string());
-    if (!dictionary_ptr){
-        LOG(WARNING) << "[LexiconFst/load_fst]: loaded fst is empty";
-        return false;
-    }
-
-    // load the input symbol table 
-    fs::path parent_directory = path_to_fst.parent_path();
-    auto [input_symbol_table_ptr, _] = myfst::load_symbol_tables(parent_directory);
-    if (!input_symbol_table_ptr){
+    auto resources = std::make_shared<beam::decoderResources>(*_resources);
+    resources->version = 0; // not published
+    if (!resources->load_lexicon(path_to_fst)){
         return false;
     }
-
-    // set the shared dictionary and symbol table  
-    beam::ctcBeam::set_fst(dictionary_ptr, input_symbol_table_ptr);
+    resources->map_words();
+    use_resources(std::move(resources));
+    reset(); // the initial beam starts at the start state of the new lexicon
     return true;
 }
 
@@ -83,18 +77,75 @@ bool ctcDecoder::set_beams_dictionary(const fs::path& path_to_fst){
 
 bool ctcDecoder::set_lm(const fs::path& path_to_lm_model){
     LOG(INFO) << "[ctcDecoder/set_lm]: setting lm model at " << path_to_lm_model;
-    bool loading_sucess  = get_lm_model().setup_model_from(path_to_lm_model);
-    if (!loading_sucess){
+    auto resources = std::make_shared<beam::decoderResources>(*_resources);
+    resources->version = 0;
+    if (!resources->load_lm(path_to_lm_model)){
         LOG(WARNING) << "[ctcDecoder/set_lm]: failed to load the lm model from " << path_to_lm_model;
         return false;
     }
-    _use_lm_model_flag = true;
+
+    // lexicon word ids -> lm word indices, once (falls back to strings for unlabeled fsts)
+    resources->map_words();
+    use_resources(std::move(resources));
+    reset(); // the initial beam starts from <s>
     return true;
 }   
 
+
+void ctcDecoder::use_resources(std::shared_ptr<const beam::decoderResources> resources){
+    _resources = std::move(resources);
+    _matcher.reset(_resources->has_lexicon()
+                   ? new beam::FSTMATCH(_resources->dictionary.get(), fst::MATCH_INPUT)
+                   : nullptr);
+    _use_lm_model_flag = _resources->has_lm();
+    select_search();
+    bind_resources();
+}
+
+
+void ctcDecoder::select_search(){
+    /*
+    the configuration is fixed for a resources version, so it is resolved here once instead of
+    for every (beam, token) pair of every frame
+    */
+    using namespace beam::policy;
+    if (!_resources->has_lexicon()){
+        if (_resources->has_lm()) use_search<kenLmStrings, noLexicon>();
+        else                      use_search<noLm, noLexicon>();
+    }
+    else if (!_resources->has_lm())        use_search<noLm, fstLexicon>();
+    else if (_resources->word_map.empty()) use_search<kenLmStrings, fstLexicon>(); // fst without word labels
+    else                                   use_search<kenLm, fstLexicon>();
+    VLOG(1) << "[ctcDecoder/select_search]: search: " << _search_variant;
+}
+
+
+template <class lmPolicy, class lexiconPolicy>
+void ctcDecoder::use_search(){
+    static_assert(!lmPolicy::word_ids || std::is_same_v<lexiconPolicy, beam::policy::fstLexicon>,
+                  "word ids come from the lexicon fst");
+    _expand_beam    = &ctcDecoder::expand_beam_with<lmPolicy, lexiconPolicy>;
+    _search_variant = std::string(lexiconPolicy::name) + " + " + lmPolicy::name;
+}
+
+
+void ctcDecoder::bind_resources(){
+    beam::ctcBeam::bind_fst(_resources->dictionary.get(), _matcher.get(), _resources->input_symbols.get());
+}
+
+
+void ctcDecoder::attach(const beam::resourceRegistry& registry){
+    _registry = &registry;
+    reset();
+}
+
+
 void ctcDecoder::init_beams(){
     auto initial_beam = new beam::ctcBeam();
     initial_beam->score = initial_beam->prob_b_prev = 0;
+    if (_use_lm_model_flag){
+        get_lm_model().begin_sentence_state(initial_beam->get_lm_state());
+    }
     _top_beams.push_back(initial_beam); // sequence is empty be default 
 }
 
@@ -138,10 +189,29 @@ void ctcDecoder::expand_beam(beam::ctcBeam* beam,
         throw std::runtime_error("incompatible emission size");
     }
 
-    // convert tensor to std::vector 
     emission = emission.contiguous();
-    auto num_elements = emission.numel();
-    std::vector<float> emission_vec(emission.data_ptr<float>(), emission.data_ptr<float>() + num_elements);
+    expand_beam(beam, get_pruned_tokens(emission.data_ptr<float>()));
+}
+
+
+std::vector<std::pair<size_t, double>> ctcDecoder::get_pruned_tokens(const float* log_probs){
+    return myutils::get_pruned_log_probs(log_probs, 
+                                         _decoding_info.num_tokens, 
+                                         _decoding_info.cutoff_prob, 
+                                         _decoding_info.cutoff_top_n, 
+                                         1);
+}
+
+
+void ctcDecoder::expand_beam(beam::ctcBeam* beam, 
+        const std::vector<std::pair<size_t, double>>& pruned_tokens_prob){
+    (this->*_expand_beam)(beam, pruned_tokens_prob);
+}
+
+
+template <class lmPolicy, class lexiconPolicy>
+void ctcDecoder::expand_beam_with(beam::ctcBeam* beam, 
+        const std::vector<std::pair<size_t, double>>& pruned_tokens_prob){
 
     // get the parent sequence prob 
     auto [prob_b_parent, prob_nb_parent] = beam->get_parent_probs(); 
@@ -149,9 +219,6 @@ void ctcDecoder::expand_beam(beam::ctcBeam* beam,
     auto parent_sequence = beam->get_sequence();
 
     // loop over pruned prob
-    auto pruned_tokens_prob = myutils::get_pruned_log_probs(emission_vec, 0.95, 5, 1);
-
-
     for (const auto& [i, prob_i] : pruned_tokens_prob){
         
         double prob_b_child = -INF_DOUBLE;
@@ -240,7 +307,7 @@ void ctcDecoder::expand_beam(beam::ctcBeam* beam,
             child_beam = existing_beam;
         }
         else{ 
-            child_beam = beam->get_new_beam(_decoding_info.idx_2_token[i]);
+            child_beam = lexiconPolicy::extend(beam, current_char);
             child_is_new_beam = true;
         }
 
@@ -266,56 +333,73 @@ void ctcDecoder::expand_beam(beam::ctcBeam* beam,
             log_p = 2 * prob_i + score_parent; 
         }
 
-        if (child_beam->is_full_word_fromed() &&
-            _use_lm_model_flag){ 
-            /*
-            Note:decode_sequence
-            With the new modifications to beam, adding a dictionary to the beam, it is not 
-            required to check the validity of a word when it is formed. This is doen 
-            by the beam now. If the fst is not set in the ctc decoder as it is own memebr
-            i.e. not part of the beam, I will get a segmenation fault as I will be trying to
-            access something that does not exist.
+        bool lm_score_queued = false;
+        if constexpr (lmPolicy::scores_words){
+            if (child_beam->is_full_word_fromed()){
+                /*
+                Note:decode_sequence
+                With the new modifications to beam, adding a dictionary to the beam, it is not 
+                required to check the validity of a word when it is formed. This is doen 
+                by the beam now. If the fst is not set in the ctc decoder as it is own memebr
+                i.e. not part of the beam, I will get a segmenation fault as I will be trying to
+                access something that does not exist.
             
-            For now (deugging), I will leave this functionality as it is. I will 
-            have to set the the fst explicilty first. 
-            */
-            auto last_word = child_beam->get_last_word();
-            VLOG(5) << "[ctcDecoder/expand_beam]: word is formed: " << last_word
-                    << ", last word window: " << std::get<0>(child_beam->last_word_window.get_window())
-                    << ", " << std::get<1>(child_beam->last_word_window.get_window());
-            auto sentence = child_beam->get_sequence();                  
-            // convert to upper case for compatibaility with lm model in FUTURE:
-            // this has to be controlled by the decoding or scoring information 
-            to_capital(sentence); 
-
-            // get ngram and score 
-            auto [_, sentence_end] = child_beam->last_word_window.get_window();
-            auto ngram = child_beam->generate_ngrams(
-                sentence, 
-                _decoding_info.lm_order,
-                _decoding_info.word_delimiter,
-                _decoding_info.sentence_start_token, 
-                sentence_end - 1 
-            ); 
-
-
-            auto lm_score = compute_lm_score(ngram);   
-            VLOG(5) << "[ctcDecoder/expand_beam]: sentence: " << sentence
-                    << ", lm score: "  << lm_score;
-
-            // update log_p 
-            log_p += lm_score * _decoding_info.alpha;
-            /*
-            in Awni's paper, the term |W|^beta is used, which in log space
-            would be beta * log(|W|). For now, I will follow parlance implementation 
-            */
-            log_p += _decoding_info.beta;   
+                For now (deugging), I will leave this functionality as it is. I will 
+                have to set the the fst explicilty first. 
+                */
+                if constexpr (lmPolicy::word_ids){
+                    // the word that just ended is the one of the parent's dictionary state. a child found
+                    // in the map was created from the same prefix and already has it
+                    if (child_is_new_beam){
+                        child_beam->push_word(_resources->word_map.get_word_id(beam->get_dict_state(), beam->sequence,
+                                                                               beam->separator_token));
+                    }
+                    // scored with the other word completions of the frame (score_pending_words)
+                    queue_word_score(beam, child_beam, log_p);
+                    lm_score_queued = true;
+                }
+                else{
+                    auto last_word = child_beam->get_last_word();
+                    VLOG(5) << "[ctcDecoder/expand_beam]: word is formed: " << last_word
+                            << ", last word window: " << std::get<0>(child_beam->last_word_window.get_window())
+                            << ", " << std::get<1>(child_beam->last_word_window.get_window());
+                    auto sentence = child_beam->get_sequence();                  
+                    // convert to upper case for compatibaility with lm model in FUTURE:
+                    // this has to be controlled by the decoding or scoring information 
+                    to_capital(sentence); 
+
+                    // get ngram and score 
+                    auto [_, sentence_end] = child_beam->last_word_window.get_window();
+                    auto ngram = child_beam->generate_ngrams(
+                        sentence, 
+                        _decoding_info.lm_order,
+                        _decoding_info.word_delimiter,
+                        _decoding_info.sentence_start_token, 
+                        sentence_end - 1 
+                    ); 
+
+
+                    auto lm_score = compute_lm_score(ngram);
+                    VLOG(5) << "[ctcDecoder/expand_beam]: sentence: " << sentence
+                            << ", lm score: "  << lm_score;
+
+                    // update log_p 
+                    log_p += lm_score * _decoding_info.alpha;
+                    /*
+                    in Awni's paper, the term |W|^beta is used, which in log space
+                    would be beta * log(|W|). For now, I will follow parlance implementation 
+                    */
+                    log_p += _decoding_info.beta;   
+                }
+            }
         }
 
 
 
-        prob_nb_child = myutils::log_sum_exp(prob_nb_child, 
-            log_p);
+        if (!lm_score_queued){ // queued words get their log_p once the lm scores are in
+            prob_nb_child = myutils::log_sum_exp(prob_nb_child, 
+                log_p);
+        }
         
         child_beam->prob_nb_cur = prob_nb_child;
       
@@ -339,6 +423,42 @@ float ctcDecoder::compute_lm_score(const std::vector<std::string>& ngram){
 }
 
 
+void ctcDecoder::queue_word_score(beam::ctcBeam* parent, beam::ctcBeam* child, double log_p){
+    ngrams::WordIndex lm_index = _resources->word_map.get_lm_index(child->get_word_ids().back());
+    if (lm_index == 0){ // not in the lm: no lookup, the child keeps the parent's context
+        _pending_words.push_back({child, log_p, -1});
+        return;
+    }
+    ngrams::lmQuery query;
+    query.in_state  = parent->get_lm_state();
+    query.word_id   = lm_index;
+    query.out_state = child->get_lm_state();
+    _lm_queries.push_back(query);
+    _pending_words.push_back({child, log_p, static_cast<int>(_lm_queries.size()) - 1});
+}
+
+
+void ctcDecoder::score_pending_words(){
+    /*
+    the beams carry their lm context, so a completed word is a single lookup. the lookups of
+    every beam that completed a word in this frame are made together (score_batch)
+    */
+    if (_pending_words.empty()){
+        return;
+    }
+    constexpr float LOG10_E = 0.4342944819; // kenlm scores are log10
+    get_lm_model().score_batch(_lm_queries.data(), _lm_queries.size());
+    for (const auto& pending : _pending_words){
+        float lm_score = (pending.query < 0) ? -OOV_PENALTY : _lm_queries[pending.query].score / LOG10_E;
+        double log_p   = pending.log_p + lm_score * _decoding_info.alpha + _decoding_info.beta;
+        pending.child->prob_nb_cur = myutils::log_sum_exp(pending.child->prob_nb_cur, log_p);
+    }
+    VLOG(5) << "[ctcDecoder/score_pending_words]: scored " << _pending_words.size() << " words";
+    _pending_words.clear();
+    _lm_queries.clear();
+}
+
+
 inline float ctcDecoder::get_weighted_score(const float& ctc_score, const float& lm_score){
     return (ctc_score + _decoding_info.alpha * lm_score);
 }
@@ -356,6 +476,7 @@ void ctcDecoder::clear_top_beams(){
 void ctcDecoder::update_top_beams(){
 
     std::vector<beam::ctcBeam*> new_beams;
+    score_pending_words(); // before any beam is deleted
     _beams_map.clean_garbage();
 
     // convert beams map to vector 
@@ -412,25 +533,43 @@ std::vector<beam::ctcBeam*> ctcDecoder::get_top_beams(){
 
 // decoding interface 
 void ctcDecoder::decode_step(torch::Tensor& emission){
+    emission = emission.contiguous();
+    if (emission.numel() != _decoding_info.num_tokens){
+        DLOG(WARNING) << "[ctcDecoder/decode_step]: emission has incompaitble shape: " << emission.sizes()
+                      << ". Number of tokens is: " << _decoding_info.num_tokens << "\n"
+                      << "Throwing exception";
+        throw std::runtime_error("incompatible emission size");
+    }
+    decode_step(emission.data_ptr<float>());
+}
+
+
+void ctcDecoder::decode_step(const float* log_probs){
+    // the pruned tokens only depend on the frame, so they are shared by all beams
+    decode_pruned_step(get_pruned_tokens(log_probs));
+}
+
+
+void ctcDecoder::decode_pruned_step(const std::vector<std::pair<size_t, double>>& pruned_tokens_prob){
+    bind_resources(); // another decoder may have run on this thread since the last step
     if (_top_beams.empty()){
         VLOG_WARNING(5) << "[ctcDecoder/decode_step]: top beams are empty. "
                         << "This could be the result of not initializing _top_beams"; 
     }
 
-    std::vector<beam::ctcBeam*> new_beams;
-    static size_t step_counter = 1;
-    VLOG(4) << "[ctcDecoder/decode_step]: Step " << step_counter << "\n" << "-----------------------------------------";
+    const auto expand_beam_fn = _expand_beam; // one indirect call per beam, none per token
+    VLOG(4) << "[ctcDecoder/decode_step]: Step " << _step_counter << "\n" << "-----------------------------------------";
     for (beam::ctcBeam* beam : _top_beams){
         VLOG(4) <<  "[ctcDecoder/decode_step]: beam in consideration: " << beam->get_sequence()
                 << ", address: " << beam
                 << ", score: " << beam->get_score() 
                 << ", sequence size: " << beam->sequence.size()
                 << ", last_word: " << beam->last_word_window.word_begin << beam->last_word_window.word_end;
-        expand_beam(beam, emission);
+        (this->*expand_beam_fn)(beam, pruned_tokens_prob);
     }
 
     update_top_beams(); 
-    ++step_counter;
+    ++_step_counter;
 
     // print updated top beams
     VLOG(5) << "[ctcDecoder/decode_step]: top beams are: \n";
@@ -447,20 +586,31 @@ void ctcDecoder::decode_step(torch::Tensor& emission){
 std::vector<beam::ctcBeam*> ctcDecoder::decode_sequence(torch::Tensor& emissions){
     // ensure compaitble shape. I expect [time, features] input.
     auto emissions_squeezed = torch::squeeze(emissions); // remove redundant axis
-    if (emissions_squeezed.sizes()[1] != _decoding_info.num_tokens){
-        DLOG(WARNING) << "[ctcDecoder/decode_chars]: input tensor has incompatible shape: "
-                      << emissions_squeezed.sizes() << " while the num of tokens is: " 
+    VLOG(4) << "[ctcDecoder/decode_sequence]: emissions of size " << emissions_squeezed.sizes();
+    return decode_chunk(emissions_squeezed);
+}
+
+
+
+std::vector<beam::ctcBeam*> ctcDecoder::decode_chunk(torch::Tensor& emissions){
+    /*
+    decodes [time, features] emissions starting from the current top beams. Consecutive calls
+    continue the same hypotheses, so a long utterance can be fed chunk by chunk.
+    */
+    if (emissions.numel() % _decoding_info.num_tokens != 0){
+        DLOG(WARNING) << "[ctcDecoder/decode_chunk]: input tensor has incompatible shape: "
+                      << emissions.sizes() << " while the num of tokens is: " 
                       << _decoding_info.num_tokens;
+        throw std::runtime_error("incompatible emissions shape");
     }
+    auto emissions_2d = emissions.reshape({-1, _decoding_info.num_tokens}); // chunks can be a single frame
 
     // convert raw emissions to to log prob 
-    auto emissions_score    = torch::nn::functional::log_softmax(emissions_squeezed,
+    auto emissions_score    = torch::nn::functional::log_softmax(emissions_2d,
                                 torch::nn::functional::LogSoftmaxFuncOptions(1));
 
     // loop over time
-    auto emissions_shape = emissions_score.sizes(); 
-    std::cout << emissions_shape << std::endl;
-    size_t num_time_steps = emissions_shape[0];
+    size_t num_time_steps = emissions_score.sizes()[0];
     for (size_t t = 0; t < num_time_steps; ++t){
         auto score_at_t =  emissions_score[t];
         decode_step(score_at_t);
@@ -471,3 +621,123 @@ std::vector<beam::ctcBeam*> ctcDecoder::decode_sequence(torch::Tensor& emissions
 
 
 
+std::vector<beam::ctcBeam*> ctcDecoder::decode_log_probs(const float* log_probs, size_t num_frames){
+    /*
+    log_probs: [num_frames, num_tokens] row major log-probabilities (already normalized, e.g. read
+    from an emission cache). no copy and no log_softmax is done here.
+    */
+    for (size_t t = 0; t < num_frames; ++t){
+        decode_step(log_probs + t * _decoding_info.num_tokens);
+    }
+    return _top_beams;
+}
+
+
+
+std::vector<beam::ctcBeam*> ctcDecoder::decode_cache(const emissions::emissionCache& emission_cache){
+    if (!emission_cache.is_open()){
+        LOG(WARNING) << "[ctcDecoder/decode_cache]: emission cache is not open";
+        return _top_beams;
+    }
+    if (emission_cache.get_vocab_size() != static_cast<size_t>(_decoding_info.num_tokens)){
+        DLOG(WARNING) << "[ctcDecoder/decode_cache]: cache has " << emission_cache.get_vocab_size()
+                      << " tokens while the num of tokens is: " << _decoding_info.num_tokens
+                      << "\n" << "Throwing exception";
+        throw std::runtime_error("incompatible emission cache vocab size");
+    }
+
+    // fp32 caches are decoded straight from the mapped pages
+    const float* fp32_data = emission_cache.get_fp32_data();
+    if (fp32_data){
+        return decode_log_probs(fp32_data, emission_cache.get_num_frames());
+    }
+
+    // fp16 caches are widened one frame at a time
+    std::vector<float> frame(_decoding_info.num_tokens);
+    for (size_t t = 0; t < emission_cache.get_num_frames(); ++t){
+        emission_cache.read_frame(t, frame.data());
+        decode_step(frame.data());
+    }
+    return _top_beams;
+}
+
+
+std::vector<beam::ctcBeam*> ctcDecoder::decode_sparse(const emissions::sparseEmissions& sparse_emissions){
+    /*
+    consumes the per-frame top-k directly. the frames are already sorted best first, so
+    pruning is a truncation, to the same length get_pruned_tokens keeps (cutoff_prob and
+    cutoff_top_n). the blank log-prob stored next to the top-k is not added back: the dense
+    path only expands blank when it is within the cutoff too
+    */
+    if (sparse_emissions.get_vocab_size() != static_cast<size_t>(_decoding_info.num_tokens)){
+        DLOG(WARNING) << "[ctcDecoder/decode_sparse]: emissions have " << sparse_emissions.get_vocab_size()
+                      << " tokens while the num of tokens is: " << _decoding_info.num_tokens
+                      << "\n" << "Throwing exception";
+        throw std::runtime_error("incompatible sparse emissions vocab size");
+    }
+
+    std::vector<std::pair<size_t, double>> pruned_tokens_prob;
+    for (size_t t = 0; t < sparse_emissions.get_num_frames(); ++t){
+        sparse_emissions.get_frame(t, pruned_tokens_prob);
+        pruned_tokens_prob.resize(myutils::get_cutoff_length(pruned_tokens_prob,
+                                                            _decoding_info.cutoff_prob,
+                                                            _decoding_info.cutoff_top_n,
+                                                            1));
+        decode_pruned_step(pruned_tokens_prob);
+    }
+    return _top_beams;
+}
+
+
+void ctcDecoder::reset(){
+    /*
+    drops the current hypotheses and starts a new utterance (e.g. the next file of a sweep)
+    */
+    _pending_words.clear();
+    _lm_queries.clear();
+    _step_counter = 1;
+    _beams_map.clean_garbage();
+    _beams_map.clear();
+    for (auto beam : _top_beams){
+        delete beam;
+    }
+    clear_top_beams();
+
+    // no beam refers to the pinned version anymore: take the latest one
+    if (_registry){
+        auto latest_resources = _registry->acquire();
+        if (latest_resources != _resources){
+            VLOG(1) << "[ctcDecoder/reset]: resources version " << _resources->version
+                    << " -> " << latest_resources->version;
+            use_resources(std::move(latest_resources));
+        }
+    }
+    init_beams();
+}
+
+
+size_t ctcDecoder::prefault_lexicon(){
+    auto dictionary_ptr = _resources->dictionary.get();
+    if (!dictionary_ptr){
+        LOG(WARNING) << "[ctcDecoder/prefault_lexicon]: no dictionary fst is set";
+        return 0;
+    }
+    size_t num_arcs = 0;
+    volatile int label_sink = 0; // keeps the walk from being optimized away
+    for (fst::StateIterator<beam::FSTDICT> state_iter(*dictionary_ptr); !state_iter.Done(); state_iter.Next()){
+        for (fst::ArcIterator<beam::FSTDICT> arc_iter(*dictionary_ptr, state_iter.Value()); !arc_iter.Done(); arc_iter.Next()){
+            label_sink = label_sink + arc_iter.Value().ilabel;
+            ++num_arcs;
+        }
+    }
+    VLOG(2) << "[ctcDecoder/prefault_lexicon]: touched " << num_arcs << " arcs";
+    return num_arcs;
+}
+
+
+size_t ctcDecoder::prefault_lm(){
+    if (!_use_lm_model_flag){
+        return 0;
+    }
+    return get_lm_model().prefault();
+}
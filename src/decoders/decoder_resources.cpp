@@ -0,0 +1,112 @@
+#include <tuple>
+#include "decoders/decoder_resources.hpp"
+#include "utils/my_utils.hpp"
+#include "utils/fst_artifact.hpp"
+#include "utils/fst_glog_safe_log.hpp"
+
+
+namespace beam{
+
+
+bool decoderResources::load_lexicon(const fs::path& path_to_fst){
+    std::shared_ptr<const FSTDICT> loaded_dictionary(asr::myfst::read_lexicon_fst(path_to_fst));
+    if (!loaded_dictionary){
+        LOG(WARNING) << "[decoderResources/load_lexicon]: failed to load the dictionary fst " << path_to_fst;
+        return false;
+    }
+
+    // the symbol tables: embedded in the artifact, or next to older fsts
+    SymbolTable* loaded_input_symbols  = nullptr;
+    SymbolTable* loaded_output_symbols = nullptr;
+    if (loaded_dictionary->InputSymbols() && loaded_dictionary->OutputSymbols()){
+        loaded_input_symbols  = loaded_dictionary->InputSymbols()->Copy();
+        loaded_output_symbols = loaded_dictionary->OutputSymbols()->Copy();
+    }
+    else{
+        std::tie(loaded_input_symbols, loaded_output_symbols) = asr::myfst::load_symbol_tables(path_to_fst.parent_path());
+    }
+    if (!loaded_input_symbols){
+        LOG(WARNING) << "[decoderResources/load_lexicon]: no symbol tables for " << path_to_fst;
+        return false;
+    }
+
+    dictionary = std::move(loaded_dictionary);
+    input_symbols.reset(loaded_input_symbols);
+    output_symbols.reset(loaded_output_symbols);
+    return true;
+}
+
+
+bool decoderResources::load_lm(const fs::path& path_to_lm_model){
+    auto loaded_lm = std::make_shared<asr::ngrams::nGramsModelWrapper>();
+    if (!loaded_lm->setup_model_from(path_to_lm_model)){
+        LOG(WARNING) << "[decoderResources/load_lm]: failed to load the lm model from " << path_to_lm_model;
+        return false;
+    }
+    lm_model = std::move(loaded_lm);
+    return true;
+}
+
+
+void decoderResources::map_words(){
+    word_map.clear();
+    if (has_lexicon() && has_lm() && output_symbols){
+        word_map.build(*dictionary, *input_symbols, *output_symbols, *lm_model);
+    }
+}
+
+
+resourceRegistry::resourceRegistry() : _current(std::make_shared<decoderResources>()){}
+
+
+bool resourceRegistry::swap_lexicon(const fs::path& path_to_fst){
+    std::lock_guard<std::mutex> lock(_swap_mutex);
+    auto next = std::make_shared<decoderResources>();
+    next->lm_model = acquire()->lm_model; // the lm stays loaded
+    if (!next->load_lexicon(path_to_fst)) return false;
+    next->map_words();
+    publish_locked(std::move(next));
+    return true;
+}
+
+
+bool resourceRegistry::swap_lm(const fs::path& path_to_lm_model){
+    std::lock_guard<std::mutex> lock(_swap_mutex);
+    auto current = acquire();
+    auto next = std::make_shared<decoderResources>();
+    next->dictionary     = current->dictionary; // the lexicon stays mapped
+    next->input_symbols  = current->input_symbols;
+    next->output_symbols = current->output_symbols;
+    if (!next->load_lm(path_to_lm_model)) return false;
+    next->map_words();
+    publish_locked(std::move(next));
+    return true;
+}
+
+
+bool resourceRegistry::swap(const fs::path& path_to_fst, const fs::path& path_to_lm_model){
+    std::lock_guard<std::mutex> lock(_swap_mutex);
+    auto next = std::make_shared<decoderResources>();
+    if (!next->load_lexicon(path_to_fst) || !next->load_lm(path_to_lm_model)) return false;
+    next->map_words();
+    publish_locked(std::move(next));
+    return true;
+}
+
+
+uint64_t resourceRegistry::publish(std::shared_ptr<decoderResources> resources){
+    std::lock_guard<std::mutex> lock(_swap_mutex);
+    return publish_locked(std::move(resources));
+}
+
+
+uint64_t resourceRegistry::publish_locked(std::shared_ptr<decoderResources> resources){
+    resources->version = ++_last_version;
+    uint64_t version = resources->version;
+    std::atomic_store(&_current, std::shared_ptr<const decoderResources>(std::move(resources)));
+    LOG(INFO) << "[resourceRegistry/publish]: resources version " << version << " published";
+    return version;
+}
+
+
+} // namespace beam
@@ -1,9 +1,18 @@
 
+#include <array>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "decoders/lexicon.hpp"
+#include "utils/fst_artifact.hpp"
 #include "utils/fst_glog_safe_log.hpp"
 
 
@@ -66,6 +75,7 @@ void GraphemeLexiconBuilder::set_lexicon_path(std::string path_to_lexicon){
     }
 
     _lexicon_read_file.open(path_to_lexicon);
+    _lexicon_read_path = path_to_lexicon;
 
     // check that the new source file is opened 
     if (!_lexicon_read_file.is_open()){
@@ -111,7 +121,15 @@ std::unordered_map<std::string, std::string> GraphemeLexiconBuilder::get_lexicon
 
 // Generate lexicon 
 void GraphemeLexiconBuilder::generate_lexicon(const std::string path_to_write_file) {
+    lexiconBuilderConfig config;
+    config.first_word_only = true; // the source is a word list
+    generate_lexicon(path_to_write_file, config);
+}
+
+
+void GraphemeLexiconBuilder::generate_lexicon(const std::string path_to_write_file, const lexiconBuilderConfig& config) {
     DLOG(INFO) << "[GraphemeLexiconBuilder/generate_lexicon]: Generating lexicon";
+    auto start_time = std::chrono::steady_clock::now();
 
     // Open the file to which the lexicon is going to be written
     _lexicon_write_path = path_to_write_file;
@@ -125,6 +143,8 @@ void GraphemeLexiconBuilder::generate_lexicon(const std::string path_to_write_fi
 
     // Clear existing lexicon
     _lexicon.clear();
+    _dictionary.clear();
+    _word_count.clear();
 
     // Check if _lexicon_read_file is open
     if (!_lexicon_read_file.is_open()) {
@@ -134,64 +154,163 @@ void GraphemeLexiconBuilder::generate_lexicon(const std::string path_to_write_fi
         throw std::runtime_error("No lexicon file open");
     }
 
-    // reading the file content
-    VLOG(3) << "[GraphemeLexiconBuilder/generate_lexicon]: Reading " << _lexicon_read_path;
-    std::string line;
-
-    while (std::getline(_lexicon_read_file, line)) {
-        VLOG(3) << "[GraphemeLexiconBuilder/generate_lexicon]: Processing line: " << line;
-
-        if (line.empty()) { // Skip empty lines
-            DLOG(WARNING) << "[GraphemeLexiconBuilder/generate_lexicon]: Skipping empty line.";
-            continue;
-        }
-
-        convert_line_lowercase(line);
-
-        // Get the word
-        std::string word;
-        std::stringstream ss(line);
-        ss >> word;
+    // count every word of the corpus (in parallel)
+    if (!count_words(config)) {
+        DLOG(WARNING) << "[GraphemeLexiconBuilder/generate_lexicon]: No words read from " << _lexicon_read_path;
+        return;
+    }
+    double count_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
 
-        // Validate word size
-        const size_t MAX_WORD_SIZE = 100;
-        if (word.empty() || word.size() > MAX_WORD_SIZE) {
-            DLOG(WARNING) << "[GraphemeLexiconBuilder/generate_lexicon]: Skipping invalid word: " << word;
-            continue;
-        }
-        VLOG(4) << "[GraphemeLexiconBuilder/generate_lexicon]: Word: " << word << ", Size: " << word.size();
+    // filter: min_count, then the top_n most frequent (ties broken by the word, so runs are reproducible)
+    std::vector<std::pair<std::string, size_t>> words;
+    words.reserve(_word_count.size());
+    for (const auto& [word, count] : _word_count) {
+        if (count >= config.min_count) words.emplace_back(word, count);
+    }
+    if (config.top_n > 0 && words.size() > config.top_n) {
+        auto more_frequent = [](const auto& x, const auto& y){
+            return x.second != y.second ? x.second > y.second : x.first < y.first;
+        };
+        std::nth_element(words.begin(), words.begin() + config.top_n, words.end(), more_frequent);
+        words.resize(config.top_n);
+    }
+    std::sort(words.begin(), words.end(), [](const auto& x, const auto& y){return x.first < y.first;});
 
-        // Get the word spelling
+    // write in byte order, in large blocks
+    std::string block;
+    block.reserve(1 << 20);
+    for (const auto& [word, count] : words) {
         std::string word_spelling = get_word_spelling(word);
-        VLOG(4) << "[GraphemeLexiconBuilder/generate_lexicon]: Word Spelling: " << word_spelling << ", Size: " << word_spelling.size();
-    
-        _dictionary.insert(word);
-        _lexicon[word] = word_spelling;
-
-        // Update the word count
-        _word_count[word] += 1;
-
-        // Write to the file (once)
-        if (_word_count[word] <= 1){
-            VLOG(4) << "[GraphemeLexiconBuilder/generate_lexicon]: adding " << word << " to lexicon.";
-            _lexicon_write_file << word << "\t" << word_spelling << "\n";
+        block.append(word).append(1, '\t').append(word_spelling).append(1, '\n');
+        if (block.size() >= (1 << 20) - 512) {
+            _lexicon_write_file.write(block.data(), block.size());
+            block.clear();
         }
+        _dictionary.insert(word);
+        _lexicon[word] = std::move(word_spelling);
     }
+    _lexicon_write_file.write(block.data(), block.size());
 
     // update file content 
     DLOG(INFO) << "[GraphemeLexiconBuilder/generate_lexicon]: flushing file.";
     _lexicon_write_file.flush();
     DLOG(INFO) << "[GraphemeLexiconBuilder/generate_lexicon]: file flushed.";
 
-
+    LOG(INFO) << "[GraphemeLexiconBuilder/generate_lexicon]: " << _word_count.size() << " distinct words counted in "
+              << count_seconds << " s on " << config.num_threads << " threads, " << words.size() << " written to "
+              << _lexicon_write_path << " in "
+              << std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count() << " s";
 }   
 
 
+bool GraphemeLexiconBuilder::count_words(const lexiconBuilderConfig& config) {
+    /*
+    maps the corpus and counts its words in num_threads chunks. a chunk starts after the first
+    line break of its byte range (the first one at 0) and ends where the next chunk starts, so
+    every line is counted once
+    */
+    int fd = ::open(_lexicon_read_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LOG(WARNING) << "[GraphemeLexiconBuilder/count_words]: failed to open " << _lexicon_read_path;
+        return false;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    size_t file_size = static_cast<size_t>(file_stat.st_size);
+    void* mapped = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        LOG(WARNING) << "[GraphemeLexiconBuilder/count_words]: failed to map " << _lexicon_read_path;
+        return false;
+    }
+    madvise(mapped, file_size, MADV_SEQUENTIAL);
+    const char* corpus = static_cast<const char*>(mapped);
+
+    // no more chunks than bytes, and every chunk but the first starts at 1 or later (the look back below)
+    const size_t num_threads = std::min<size_t>(std::max<size_t>(1, config.num_threads), file_size);
+    std::vector<size_t> chunk_begins(num_threads + 1, file_size);
+    chunk_begins[0] = 0;
+    for (size_t t = 1; t < num_threads; ++t) {
+        size_t position = std::max({chunk_begins[t - 1], file_size / num_threads * t, size_t{1}});
+        while (position < file_size && corpus[position - 1] != '\n') ++position;
+        chunk_begins[t] = position;
+    }
+
+    // lower case table (the C locale, as convert_line_lowercase) and the separators
+    std::array<char, 256> lower_case;
+    std::array<bool, 256> is_separator;
+    for (int c = 0; c < 256; ++c) {
+        lower_case[c]   = static_cast<char>(std::tolower(c));
+        is_separator[c] = std::isspace(c) != 0;
+    }
+
+    // counts[thread][shard]
+    typedef std::unordered_map<std::string, size_t> wordCounts;
+    std::vector<std::vector<wordCounts>> counts(num_threads, std::vector<wordCounts>(num_threads));
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t]{
+            std::hash<std::string_view> hasher;
+            std::string word;
+            bool line_start = true;
+            const char* end = corpus + chunk_begins[t + 1];
+            for (const char* current = corpus + chunk_begins[t]; current < end;) {
+                unsigned char symbol = static_cast<unsigned char>(*current);
+                if (is_separator[symbol]) {
+                    line_start = line_start || symbol == '\n';
+                    ++current;
+                    continue;
+                }
+                // one word
+                word.clear();
+                while (current < end && !is_separator[static_cast<unsigned char>(*current)]) {
+                    word.push_back(lower_case[static_cast<unsigned char>(*current)]);
+                    ++current;
+                }
+                bool counted_line = !config.first_word_only || line_start;
+                line_start = false;
+                if (!counted_line || word.size() > config.max_word_size) continue;
+                ++counts[t][hasher(word) % num_threads][word];
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    threads.clear();
+    munmap(mapped, file_size);
+
+    // merge: shard s of every thread into counts[0][s], the shards in parallel
+    for (size_t s = 0; s < num_threads; ++s) {
+        threads.emplace_back([&, s]{
+            for (size_t t = 1; t < num_threads; ++t) {
+                for (auto& [word, count] : counts[t][s]) counts[0][s][word] += count;
+                wordCounts().swap(counts[t][s]);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    size_t num_words = 0;
+    for (const auto& shard : counts[0]) num_words += shard.size();
+    _word_count.reserve(num_words);
+    for (auto& shard : counts[0]) {
+        for (auto& [word, count] : shard) _word_count.emplace(word, count);
+        wordCounts().swap(shard);
+    }
+    return !_word_count.empty();
+}
+
+
 
 // ---------------------------------------------- Lexicon FST Builder ---------------------------------------------- //
 
 
-LexiconFst::LexiconFst() : _root_trie_node(std::make_shared<LexFstTrieNode>()){ 
+LexiconFst::LexiconFst() : 
+    _input_symbol_table(new fst::SymbolTable("isymbols")),
+    _output_symbol_table(new fst::SymbolTable("osymbols")),
+    _root_trie_node(std::make_shared<LexFstTrieNode>()){ 
     DLOG(INFO) << "[LexiconFst/constuctor]: Instance created (default constructor).";
     _output_symbol_table->AddSymbol("<eps>", 0);
     DLOG(INFO) << "[LexiconFst/constuctor/temp]: Created an output symbol table with just eps symbol";
@@ -199,6 +318,8 @@ LexiconFst::LexiconFst() : _root_trie_node(std::make_shared<LexFstTrieNode>()){
 
 
 LexiconFst::LexiconFst(const std::string lexicon_file_path) : 
+    _input_symbol_table(new fst::SymbolTable("isymbols")),
+    _output_symbol_table(new fst::SymbolTable("osymbols")),
     _lexicon_path(lexicon_file_path), 
     _root_trie_node(std::make_shared<LexFstTrieNode>()),
     _flag_output_word_symbol(false){
@@ -300,7 +421,7 @@ void LexiconFst::print_output_symbol_table(){
 
 
 
-void LexiconFst::update_trie_with_word(const std::string& new_word){
+void LexiconFst::update_trie_with_word(const std::string& new_word, int64_t word_id){
     
     if (!_root_trie_node) {
         DLOG(WARNING) << "[LexiconFst::update_trie_with_word]: root trie node was not initialized. Thworing exception.";
@@ -338,6 +459,7 @@ void LexiconFst::update_trie_with_word(const std::string& new_word){
     }
     VLOG(5) << "[LexiconFst/update_trie_with_word]: Setting end of word flag.";
     current_node->is_end_word = true;
+    current_node->word_id     = word_id;
 }
 
 
@@ -353,15 +475,18 @@ void LexiconFst::populate_fst_from_trie(std::shared_ptr<LexFstTrieNode> trie_nod
                 << " to the fst";
         fst::StdArc::StateId next_state = lex_fst->NumStates();
 
-        // add an arc for each child
+        // add an arc for each child. the arc into the final state of a word carries the word id
+        // as its output label, every other arc <eps>
         VLOG(5) << "[LexiconFst/populate_fst_from_trie]: Connecting state " 
                 << current_state
                 << " to state "
                 << next_state;            
+        int64_t output_label = (child_trie_node->is_end_word && child_trie_node->word_id != 0) ?
+                                child_trie_node->word_id : _output_symbol_table->Find("<eps>");
         lex_fst->AddArc(current_state,
                        fst::StdArc(
                         _input_symbol_table->Find(std::string(1, letter)),
-                        _output_symbol_table->Find("<eps>"),
+                        output_label,
                         1,
                         next_state)
                        );
@@ -487,6 +612,7 @@ void LexiconFst::construct_fst_from_lex_file(){
 
     // helper variables
     std::string line; 
+    std::string word;
     std::string word_components;
     
   
@@ -497,6 +623,7 @@ void LexiconFst::construct_fst_from_lex_file(){
 
         // split into word and its components 
         size_t split_pos = line.find('\t');
+        word            = line.substr(0, split_pos);
         word_components = line.substr(split_pos +1 ); 
 
         VLOG(4) << "[LexiconFst/construct_fst_from_lex_file]: splitting line at position " << split_pos;
@@ -508,18 +635,21 @@ void LexiconFst::construct_fst_from_lex_file(){
         VLOG(4) << "[LexiconFst/construct_fst_from_lex_file]: updating symbol table";
         update_symbol_table_from_word(word_components);
 
+        // the word gets the next output label (an existing word keeps its label)
+        int64_t word_id = _output_symbol_table->AddSymbol(word);
+
         // updat trie
         VLOG(4) << "[LexiconFst/construct_fst_from_lex_file]: updating trie with " << word_components << " which has "
                 << word_components.size() << " symbols. "
                 << "If you see this line only once, something is wrong. The lexicon file was not read.";
-        update_trie_with_word(word_components);
+        update_trie_with_word(word_components, word_id);
     }
 
     VLOG(4) << "[LexiconFst/construct_fst_from_lex_file]: trie has been created. Size of children is" 
             << _root_trie_node->children.size();
 
-    // convert trie to fst
-    construct_fst_from_trie(_root_trie_node, _lex_fst);
+    // convert trie to fst (the returning overload allocates _lex_fst)
+    construct_fst_from_trie(_root_trie_node);
 
 }
 
@@ -569,7 +699,7 @@ void LexiconFst::write_fst(fs::path fst_file_name){
                 return;
             }
             else{ // the passed directory exists 
-                _lex_fst->Write(fst_file_name);
+                asr::myfst::write_const_fst(_lex_fst, fst_file_name); // a tree: word ids by state
                 fs::path parent_path = fst_file_name.parent_path();
                 save_symbol_tables(parent_path);
             }
@@ -592,7 +722,7 @@ void LexiconFst::write_fst(fs::path fst_file_name){
                 return;
             }
             auto target_file = target_dir / fst_file_name.filename();
-            _lex_fst->Write(target_file);
+            asr::myfst::write_const_fst(_lex_fst, target_file);
             save_symbol_tables(target_dir);
         }
         
@@ -718,7 +848,8 @@ bool LexiconFst::load_symbol_tables(const fs::path& parent_directory){
 
 bool LexiconFst::load_fst(fs::path path_to_fst){
     // the function assumes that the symbol table is also in the same folder
-    _lex_fst = fst::StdVectorFst::Read(path_to_fst.string());
+    std::unique_ptr<fst::StdConstFst> loaded_fst(asr::myfst::read_lexicon_fst(path_to_fst));
+    _lex_fst = loaded_fst ? new fst::StdVectorFst(*loaded_fst) : nullptr;
     if (!_lex_fst){
         LOG(WARNING) << "[LexiconFst/load_fst]: loaded fst is empty";
         return false;
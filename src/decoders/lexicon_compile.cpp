@@ -0,0 +1,50 @@
+#include <iostream>
+#include <filesystem>
+#include <glog/logging.h>
+#include "decoders/lexicon_compiler.hpp"
+
+/*
+Compiles a lexicon (word \t spelling lines) into the decoder's dictionary fst with
+lexiconCompiler: parallel sort, minimal automaton, numbered word ids. isymbols.sym and
+osymbols.sym are written next to the fst, where ctcDecoder::set_beams_dictionary looks for them.
+For small lexicons setup (LexiconFst) writes the same interface as a trie.
+
+usage: lexicon_compile log_verbosity path_to_lexicon path_to_fst [num_threads]
+*/
+
+namespace fs = std::filesystem;
+using namespace asr;
+
+
+int main(int argc, char* argv[]){
+
+    if (argc < 4){
+        std::cout << "[main]: pass all arguments: log_verbosity, path_to_lexicon, path_to_fst [, num_threads]" << std::endl;
+        return 1;
+    }
+
+    google::InitGoogleLogging(argv[0]);
+    FLAGS_logtostderr = false;
+    FLAGS_v = std::stoi(argv[1]);
+
+    fs::path lexicon_path = argv[2];
+    fs::path fst_path     = argv[3];
+    lexicon::lexiconCompilerConfig config;
+    if (argc > 4) config.num_threads = std::max(1, std::stoi(argv[4]));
+
+    lexicon::lexiconCompiler compiler(config);
+    if (!compiler.read_lexicon(lexicon_path)){
+        std::cerr << "[main]: failed to read " << lexicon_path << std::endl;
+        return 1;
+    }
+    if (!compiler.compile()){
+        std::cerr << "[main]: no words in " << lexicon_path << std::endl;
+        return 1;
+    }
+    if (!compiler.write(fst_path)){
+        std::cerr << "[main]: failed to write " << fst_path << std::endl;
+        return 1;
+    }
+    std::cout << "[main]: " << compiler.get_stats().summary() << std::endl;
+    return 0;
+}
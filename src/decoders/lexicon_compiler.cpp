@@ -0,0 +1,389 @@
+#include "decoders/lexicon_compiler.hpp"
+#include "utils/fst_artifact.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+
+namespace asr{
+    namespace lexicon{
+
+
+namespace {
+    typedef std::chrono::steady_clock clock_type;
+
+    double seconds_since(clock_type::time_point start){
+        return std::chrono::duration<double>(clock_type::now() - start).count();
+    }
+
+    uint64_t mix(uint64_t hash, uint64_t value){
+        hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+        return hash;
+    }
+} // namespace
+
+
+std::string lexiconCompileStats::summary() const {
+    std::ostringstream oss;
+    oss << num_words << " words (" << num_duplicates << " duplicate spellings), "
+        << num_states << " states, " << num_arcs << " arcs. read " << read_seconds
+        << " s, sort " << sort_seconds << " s, build " << build_seconds
+        << " s, write " << write_seconds << " s";
+    return oss.str();
+}
+
+
+lexiconCompiler::lexiconCompiler(lexiconCompilerConfig config) : _config(config){
+    if (_config.num_threads == 0) _config.num_threads = 1;
+}
+
+
+bool lexiconCompiler::read_lexicon(const fs::path& path_to_lexicon){
+    auto start_time = clock_type::now();
+    std::ifstream lexicon_file(path_to_lexicon);
+    if (!lexicon_file.is_open()){
+        LOG(WARNING) << "[lexiconCompiler/read_lexicon]: failed to open " << path_to_lexicon;
+        return false;
+    }
+
+    // one reservation for the whole file: the arena holds every word and spelling once
+    std::error_code error;
+    auto file_size = fs::file_size(path_to_lexicon, error);
+    if (!error) _arena.reserve(_arena.size() + file_size);
+
+    std::string line;
+    while (std::getline(lexicon_file, line)){
+        if (line.empty()) continue;
+        size_t split_pos = line.find('\t');
+        if (split_pos == std::string::npos){
+            VLOG(4) << "[lexiconCompiler/read_lexicon]: skipping line without a tab: " << line;
+            continue;
+        }
+        add_word(std::string_view(line).substr(0, split_pos), std::string_view(line).substr(split_pos + 1));
+    }
+    _stats.read_seconds += seconds_since(start_time);
+    LOG(INFO) << "[lexiconCompiler/read_lexicon]: read " << _entries.size() << " words from " << path_to_lexicon;
+    return true;
+}
+
+
+void lexiconCompiler::add_word(std::string_view word, std::string_view spelling){
+    entry new_entry;
+    new_entry.word_begin = _arena.size();
+    new_entry.word_size  = std::min<size_t>(word.size(), UINT16_MAX);
+    _arena.insert(_arena.end(), word.begin(), word.begin() + new_entry.word_size);
+
+    new_entry.spelling_begin = _arena.size();
+    for (char symbol : spelling){
+        if (symbol != ' ') _arena.push_back(symbol); // spellings are space separated symbols
+    }
+    new_entry.spelling_size = std::min<size_t>(_arena.size() - new_entry.spelling_begin, UINT16_MAX);
+    if (new_entry.spelling_size == 0){
+        _arena.resize(new_entry.word_begin);
+        return;
+    }
+    _entries.push_back(new_entry);
+    _compiled = false;
+}
+
+
+bool lexiconCompiler::compile(){
+    if (_entries.empty()){
+        LOG(WARNING) << "[lexiconCompiler/compile]: no words to compile";
+        return false;
+    }
+    auto start_time = clock_type::now();
+    sort_entries();
+    _stats.sort_seconds = seconds_since(start_time);
+
+    start_time = clock_type::now();
+    build_automaton();
+    _stats.build_seconds = seconds_since(start_time);
+    _compiled = true;
+
+    LOG(INFO) << "[lexiconCompiler/compile]: " << _stats.summary();
+    return true;
+}
+
+
+void lexiconCompiler::sort_entries(){
+    /*
+    num_threads chunks are sorted concurrently, then neighbouring runs are merged pairwise, in
+    parallel within a round, until one run is left. ties keep the input order (stable), so the
+    first word of a duplicate spelling wins
+    */
+    auto less = [this](const entry& left, const entry& right){
+        return get_spelling(left) < get_spelling(right); // char_traits compares as unsigned char
+    };
+    size_t num_chunks = std::min(_config.num_threads, std::max<size_t>(1, _entries.size() / 4096));
+    std::vector<size_t> bounds;
+    for (size_t chunk = 0; chunk <= num_chunks; ++chunk){
+        bounds.push_back(_entries.size() * chunk / num_chunks);
+    }
+
+    auto run_parallel = [](std::vector<std::thread>& threads){
+        for (auto& thread : threads) thread.join();
+        threads.clear();
+    };
+    std::vector<std::thread> threads;
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk){
+        threads.emplace_back([&, chunk]{
+            std::stable_sort(_entries.begin() + bounds[chunk], _entries.begin() + bounds[chunk + 1], less);
+        });
+    }
+    run_parallel(threads);
+
+    while (bounds.size() > 2){
+        std::vector<size_t> merged_bounds;
+        for (size_t run = 0; run + 2 < bounds.size(); run += 2){
+            threads.emplace_back([&, run]{
+                std::inplace_merge(_entries.begin() + bounds[run], _entries.begin() + bounds[run + 1],
+                                   _entries.begin() + bounds[run + 2], less);
+            });
+            merged_bounds.push_back(bounds[run]);
+        }
+        if (bounds.size() % 2 == 0) merged_bounds.push_back(bounds[bounds.size() - 2]); // odd run out
+        merged_bounds.push_back(bounds.back());
+        run_parallel(threads);
+        bounds.swap(merged_bounds);
+    }
+
+    // duplicate spellings are adjacent now
+    size_t num_unique = 0;
+    for (size_t i = 0; i < _entries.size(); ++i){
+        if (num_unique > 0 && get_spelling(_entries[i]) == get_spelling(_entries[num_unique - 1])){
+            VLOG(4) << "[lexiconCompiler/sort_entries]: duplicate spelling " << get_spelling(_entries[i]);
+            continue;
+        }
+        _entries[num_unique++] = _entries[i];
+    }
+    _stats.num_duplicates = _entries.size() - num_unique;
+    _entries.resize(num_unique);
+}
+
+
+void lexiconCompiler::build_automaton(){
+    _states.clear();
+    _arcs.clear();
+    _register.assign(1024, {0, EMPTY_SLOT});
+    _register_size = 0;
+
+    // path[i]: the open state after i symbols of the previous word
+    std::vector<openState> path(1);
+    std::string_view previous;
+
+    // registers (or merges) the open states deeper than depth, deepest first
+    auto close_path = [&](size_t depth){
+        while (path.size() > depth + 1){
+            uint32_t state_id = replace_or_register(path.back(), false);
+            path.pop_back();
+            path.back().arcs.back().second = state_id;
+        }
+    };
+
+    for (const auto& word_entry : _entries){
+        std::string_view spelling = get_spelling(word_entry);
+        size_t common_prefix = 0;
+        size_t max_prefix = std::min(previous.size(), spelling.size());
+        while (common_prefix < max_prefix && previous[common_prefix] == spelling[common_prefix]) ++common_prefix;
+
+        close_path(common_prefix);
+        for (size_t i = common_prefix; i < spelling.size(); ++i){
+            path.back().arcs.emplace_back(static_cast<unsigned char>(spelling[i]), EMPTY_SLOT);
+            path.emplace_back();
+        }
+        path.back().is_final = true;
+        previous = spelling;
+    }
+    close_path(0);
+    _start_state = replace_or_register(path[0], true);
+
+    _stats.num_words  = _entries.size();
+    _stats.num_states = _states.size();
+    _stats.num_arcs   = _arcs.size();
+    _register.clear();
+    _register.shrink_to_fit();
+}
+
+
+uint64_t lexiconCompiler::hash_state(bool is_final, const std::pair<unsigned char, uint32_t>* arcs, size_t num_arcs) const {
+    uint64_t hash = is_final ? 1 : 2;
+    for (size_t i = 0; i < num_arcs; ++i){
+        hash = mix(hash, (static_cast<uint64_t>(arcs[i].first) << 32) | arcs[i].second);
+    }
+    return hash;
+}
+
+
+bool lexiconCompiler::same_state(uint32_t state_id, const openState& state) const {
+    const auto& candidate = _states[state_id];
+    if (candidate.is_final != state.is_final || candidate.num_arcs != state.arcs.size()) return false;
+    for (size_t i = 0; i < state.arcs.size(); ++i){
+        const auto& arc = _arcs[candidate.arcs_begin + i];
+        if (arc.symbol != state.arcs[i].first || arc.target != state.arcs[i].second) return false;
+    }
+    return true;
+}
+
+
+uint32_t lexiconCompiler::replace_or_register(const openState& state, bool is_start){
+    // every child is registered at this point, so equivalence is equality of (final, arcs)
+    uint32_t hash = static_cast<uint32_t>(hash_state(state.is_final, state.arcs.data(), state.arcs.size()));
+    size_t mask   = _register.size() - 1;
+    size_t slot   = hash & mask;
+    if (!is_start){ // the start state has no incoming arcs, there is nothing to merge it with
+        for (; _register[slot].second != EMPTY_SLOT; slot = (slot + 1) & mask){
+            if (_register[slot].first == hash && same_state(_register[slot].second, state)){
+                return _register[slot].second;
+            }
+        }
+    }
+
+    // a new equivalence class. the offsets follow from the children's word counts, so
+    // equivalent states get equal offsets and merging them keeps the numbering
+    compiledState new_state;
+    new_state.arcs_begin = _arcs.size();
+    new_state.num_arcs   = state.arcs.size();
+    new_state.is_final   = state.is_final;
+    uint32_t words_before = (state.is_final ? 1 : 0) + (is_start ? 1 : 0); // ids start at 1
+    for (const auto& [symbol, target] : state.arcs){
+        _arcs.push_back({target, words_before, symbol});
+        words_before += _states[target].num_words;
+    }
+    new_state.num_words = words_before - (is_start ? 1 : 0);
+    uint32_t state_id = _states.size();
+    _states.push_back(new_state);
+
+    if (!is_start){
+        _register[slot] = {hash, state_id};
+        if (++_register_size * 2 > _register.size()) grow_register();
+    }
+    return state_id;
+}
+
+
+void lexiconCompiler::grow_register(){
+    std::vector<std::pair<uint32_t, uint32_t>> old_register(_register.size() * 2, {0, EMPTY_SLOT});
+    old_register.swap(_register);
+    size_t mask = _register.size() - 1;
+    for (const auto& [hash, state_id] : old_register){
+        if (state_id == EMPTY_SLOT) continue;
+        size_t slot = hash & mask;
+        while (_register[slot].second != EMPTY_SLOT) slot = (slot + 1) & mask;
+        _register[slot] = {hash, state_id};
+    }
+}
+
+
+int32_t lexiconCompiler::get_word_id(std::string_view spelling) const {
+    if (!_compiled) return 0;
+    uint32_t state_id = _start_state;
+    int64_t word_id   = 0;
+    for (char symbol : spelling){
+        const auto& state = _states[state_id];
+        auto arcs_begin = _arcs.begin() + state.arcs_begin;
+        auto arcs_end   = arcs_begin + state.num_arcs;
+        auto arc = std::lower_bound(arcs_begin, arcs_end, static_cast<unsigned char>(symbol),
+                                    [](const compiledArc& arc, unsigned char value){return arc.symbol < value;});
+        if (arc == arcs_end || arc->symbol != static_cast<unsigned char>(symbol)) return 0;
+        word_id += arc->offset;
+        state_id = arc->target;
+    }
+    return _states[state_id].is_final ? static_cast<int32_t>(word_id) : 0;
+}
+
+
+std::string_view lexiconCompiler::get_word(int32_t word_id) const {
+    if (word_id < 1 || static_cast<size_t>(word_id) > _entries.size()) return {};
+    const auto& word_entry = _entries[word_id - 1];
+    return std::string_view(_arena.data() + word_entry.word_begin, word_entry.word_size);
+}
+
+
+fst::SymbolTable* lexiconCompiler::make_input_symbols() const {
+    std::array<bool, 256> used{};
+    for (const auto& arc : _arcs) used[arc.symbol] = true;
+    auto input_symbols = new fst::SymbolTable("isymbols");
+    input_symbols->AddSymbol("<eps>", 0);
+    for (size_t symbol = 0; symbol < used.size(); ++symbol){
+        if (used[symbol]) input_symbols->AddSymbol(std::string(1, static_cast<char>(symbol)));
+    }
+    return input_symbols;
+}
+
+
+fst::SymbolTable* lexiconCompiler::make_output_symbols() const {
+    auto output_symbols = new fst::SymbolTable("osymbols");
+    output_symbols->AddSymbol("<eps>", 0);
+    for (size_t i = 0; i < _entries.size(); ++i){
+        output_symbols->AddSymbol(std::string(get_word(i + 1)), i + 1);
+    }
+    return output_symbols;
+}
+
+
+fst::StdVectorFst* lexiconCompiler::make_fst() const {
+    if (!_compiled){
+        LOG(WARNING) << "[lexiconCompiler/make_fst]: compile() first";
+        return nullptr;
+    }
+    // symbols are numbered in byte order, so the arcs (sorted by symbol) come out label sorted
+    std::array<int64_t, 256> labels{};
+    std::unique_ptr<fst::SymbolTable> input_symbols(make_input_symbols());
+    for (size_t symbol = 0; symbol < labels.size(); ++symbol){
+        labels[symbol] = input_symbols->Find(std::string(1, static_cast<char>(symbol)));
+    }
+
+    // states are registered children first, so the start state is the last one. the fst numbers them
+    // in reverse: the start state is 0 (as in LexiconFst's trie) and parents come before their children
+    const uint32_t last_state = _states.size() - 1;
+    auto fst_state = [last_state](uint32_t state_id){return static_cast<fst::StdArc::StateId>(last_state - state_id);};
+
+    auto lex_fst = new fst::StdVectorFst();
+    lex_fst->ReserveStates(_states.size());
+    for (size_t state_id = 0; state_id < _states.size(); ++state_id) lex_fst->AddState();
+    lex_fst->SetStart(fst_state(_start_state));
+    for (uint32_t state_id = 0; state_id < _states.size(); ++state_id){
+        const auto& state = _states[state_id];
+        auto fst_state_id = fst_state(state_id);
+        lex_fst->ReserveArcs(fst_state_id, state.num_arcs);
+        if (state.is_final) lex_fst->SetFinal(fst_state_id, fst::TropicalWeight::One());
+        for (size_t i = 0; i < state.num_arcs; ++i){
+            const auto& arc = _arcs[state.arcs_begin + i];
+            lex_fst->AddArc(fst_state_id, fst::StdArc(labels[arc.symbol], arc.offset, 1, fst_state(arc.target)));
+        }
+    }
+    lex_fst->SetProperties(fst::kILabelSorted, fst::kILabelSorted);
+    return lex_fst;
+}
+
+
+bool lexiconCompiler::write(const fs::path& path_to_fst){
+    auto start_time = clock_type::now();
+    std::unique_ptr<fst::StdVectorFst> lex_fst(make_fst());
+    if (!lex_fst) return false;
+    std::unique_ptr<fst::SymbolTable> input_symbols(make_input_symbols());
+    std::unique_ptr<fst::SymbolTable> output_symbols(make_output_symbols());
+    lex_fst->SetInputSymbols(input_symbols.get());
+    lex_fst->SetOutputSymbols(output_symbols.get());
+
+    // already minimal: the artifact only needs the ConstFst layout. the symbol files next to it are for
+    // older readers (myfst::load_symbol_tables), the decoder takes the embedded tables
+    fs::path directory = path_to_fst.parent_path().empty() ? fs::path(".") : path_to_fst.parent_path();
+    bool written = myfst::write_const_fst(lex_fst.get(), path_to_fst) &&
+                   input_symbols->Write((directory / "isymbols.sym").string()) &&
+                   output_symbols->Write((directory / "osymbols.sym").string());
+    _stats.write_seconds = seconds_since(start_time);
+    if (!written){
+        LOG(WARNING) << "[lexiconCompiler/write]: failed to write " << path_to_fst;
+        return false;
+    }
+    LOG(INFO) << "[lexiconCompiler/write]: wrote " << path_to_fst << " in " << _stats.write_seconds << " s";
+    return true;
+}
+
+
+    } // namespace lexicon
+} // namespace asr
@@ -0,0 +1,137 @@
+#include <iostream>
+#include <filesystem>
+#include <cstdlib>
+#include <chrono>
+#include <torch/nn/functional.h>
+#include "models/torch_script_model.hpp"
+#include "decoders/ctc_decoder.hpp"
+#include "utils/my_utils.hpp"
+#include "utils/emission_cache.hpp"
+#include "utils/file_ingest.hpp"
+#include "utils/wav_reader.hpp"
+
+/*
+Decoder-only parameter sweep. The acoustic model runs once per audio file and its log-probs
+are written to data/emissions/<file>.emis. Every (alpha, beta) configuration then decodes
+the memory-mapped caches, so a sweep runs at disk and decoder speed.
+
+The missing caches are filled through the batch fileIngestor: the next recordings are read
+(io_uring when available) while the model runs on the current one.
+*/
+
+namespace fs = std::filesystem;
+using namespace asr;
+
+bool cache_emissions(torchScriptModel& torch_model, const audio::ingestedFile& file, const fs::path& cache_path){
+    const float model_sample_rate = 16000;
+    audio::wavReader wav_reader;
+    if (!file.ok || !wav_reader.open_memory(file.data, file.size)){
+        LOG(WARNING) << "[sweep/cache_emissions]: failed to read " << file.path;
+        return false;
+    }
+    std::vector<float> audio_data = wav_reader.read_all();
+    if (audio_data.empty()){ // no duration to derive the frame rate from
+        LOG(WARNING) << "[sweep/cache_emissions]: " << file.path << " has no audio. skipping it";
+        return false;
+    }
+    auto emissions = torch_model.pass_forward(audio_data);
+    if (!emissions.has_value()){
+        LOG(WARNING) << "[sweep/cache_emissions]: model returned no emissions for " << file.path;
+        return false;
+    }
+
+    auto log_probs = torch::nn::functional::log_softmax(emissions.value().reshape({-1, emissions.value().size(-1)}),
+                        torch::nn::functional::LogSoftmaxFuncOptions(1)).contiguous();
+    size_t num_frames = log_probs.size(0);
+    float frame_rate  = num_frames / (audio_data.size() / model_sample_rate); // audio_data is not empty
+    return emissions::write_emission_cache(cache_path, log_probs.data_ptr<float>(),
+                                           num_frames, log_probs.size(1), frame_rate);
+}
+
+
+int main(int argc, char* argv[]){
+
+    if (argc < 3){
+        std::cout << "[main]: pass all arguments: log_verbosity, beta, alpha_1 [, alpha_2, ...]" << std::endl;
+        return 1;
+    }
+
+    google::InitGoogleLogging(argv[0]);
+    FLAGS_logtostderr = false;
+    FLAGS_v = std::stoi(argv[1]);
+
+    auto project_root_ptr = std::getenv("PROJECT_ROOT");
+    if (!project_root_ptr){
+        std::cerr << "[main]: PROJECT_ROOT environement variable not set.";
+        return 1;
+    }
+    fs::path project_root = fs::path(project_root_ptr);
+
+    // set paths for reading files
+    fs::path data_folder  = project_root / "data";
+    fs::path tokens_path  = data_folder  / "dictionary" / "tokens.txt";
+    fs::path audio_dir    = data_folder  / "audio";
+    fs::path cache_dir    = data_folder  / "emissions";
+    fs::path model_path   = data_folder  / "models"     / "model.pt";
+    fs::path fst_path     = data_folder  / "lexicon"    / "lexicon_fst.fst";
+    fs::path lm_path      = ngrams::prefer_binary_model(data_folder / "models" / "3-gram.pruned.1e-7.arpa"); // `make lm_binary`
+    fs::create_directories(cache_dir);
+
+    float beta = std::stof(argv[2]);
+    std::vector<float> alphas;
+    for (int i = 3; i < argc; ++i){
+        alphas.push_back(std::stof(argv[i]));
+    }
+
+    // write the missing caches (the model is only loaded if needed)
+    std::vector<fs::path> cache_paths, missing_audio;
+    for (const auto& entry : fs::directory_iterator(audio_dir)){
+        if (entry.path().extension() != ".wav") continue;
+        fs::path cache_path = cache_dir / entry.path().filename().replace_extension(".emis");
+        if (fs::exists(cache_path)){
+            cache_paths.push_back(cache_path);
+        }
+        else{
+            missing_audio.push_back(entry.path());
+        }
+    }
+    if (!missing_audio.empty()){
+        torchScriptModel torch_model;
+        if (!torch_model.load_model(model_path)){
+            std::cerr << "[main]: failed to load the model" << std::endl;
+            return 1;
+        }
+        audio::ingestConfig ingest_config;
+        ingest_config.num_workers = 1; // one model: the reads overlap the forward passes
+        audio::fileIngestor ingestor(ingest_config);
+        auto ingest_stats = ingestor.run(missing_audio, [&](const audio::ingestedFile& file){
+            fs::path cache_path = cache_dir / file.path.filename().replace_extension(".emis");
+            std::cout << "[main]: caching emissions of " << file.path << std::endl;
+            if (cache_emissions(torch_model, file, cache_path)) cache_paths.push_back(cache_path);
+        });
+        std::cout << "[main]: " << ingest_stats.summary() << std::endl;
+    }
+
+    // decoder-only sweep
+    ctcDecoder decoder(tokens_path, 15, fst_path, lm_path);
+    decoder.set_word_bonus(beta);
+    for (const auto& alpha : alphas){
+        decoder.set_lm_weight(alpha);
+        auto start_time = std::chrono::steady_clock::now();
+        std::cout << "alpha: " << alpha << ", beta: " << beta << std::endl;
+        std::cout << "------------------------------------" << std::endl;
+        for (const auto& cache_path : cache_paths){
+            emissions::emissionCache emission_cache;
+            if (!emission_cache.open(cache_path)) continue;
+            decoder.reset();
+            auto top_beams = decoder.decode_cache(emission_cache);
+            if (!top_beams.empty()){
+                std::cout << cache_path.stem().string() << ": " << top_beams[0]->get_sequence()
+                          << " (score: " << top_beams[0]->get_score() << ")" << std::endl;
+            }
+        }
+        auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            std::chrono::steady_clock::now() - start_time).count();
+        std::cout << "decoded " << cache_paths.size() << " files in " << elapsed_ms << " ms" << std::endl;
+    }
+}
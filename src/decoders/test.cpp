@@ -6,21 +6,20 @@
 #include "decoders/ctc_decoder.hpp"
 #include "utils/my_utils.hpp"
 #include "decoders/lexicon.hpp"
+#include "pipeline/overlapped_pipeline.hpp"
+#include "pipeline/warmup.hpp"
+#include "utils/wav_reader.hpp"
+#include "utils/resampler.hpp"
 
 
 namespace fs = std::filesystem;
 
 void other_function();
 
-std::unique_ptr<beam::SymbolTable> beam::ctcBeam::input_symbol_table_;
-std::unique_ptr<beam::FSTDICT>  beam::ctcBeam::dictionary_ptr_;
-std::unique_ptr<beam::FSTMATCH> beam::ctcBeam::matcher_ptr_;
-
-
 int main(int argc, char* argv[]){
 
     if (argc < 4){
-        std::cout << "[main]: pass all arguments: cut_ratio, log_verbosity, lm_weight" << std::endl;
+        std::cout << "[main]: pass all arguments: cut_ratio, log_verbosity, lm_weight [, chunk_seconds, vad]" << std::endl;
         return 1;
     }
 
@@ -61,7 +60,7 @@ int main(int argc, char* argv[]){
     fs::path model_path   = data_folder  / "models"     / "model.pt"; 
     fs::path lexicon_path = data_folder  / "lexicon"    / "lexicon.txt"; 
     fs::path fst_path     = data_folder  / "lexicon"    / "lexicon_fst.fst";
-    fs::path lm_path      = data_folder  / "models"     / "3-gram.pruned.1e-7.arpa";
+    fs::path lm_path      = asr::ngrams::prefer_binary_model(data_folder / "models" / "3-gram.pruned.1e-7.arpa"); // `make lm_binary`
 
 
     // set the torch model
@@ -71,31 +70,67 @@ int main(int argc, char* argv[]){
     }
 
     // read the audio data
-    std::vector<float> audio_data  = readwav(audio_path); 
+    const uint32_t model_sample_rate = 16000;
+    asr::audio::wavReader wav_reader(audio_path);
+    std::vector<float> audio_data = wav_reader.read_all();
+    if (wav_reader.get_info().sample_rate != model_sample_rate){
+        audio_data = asr::audio::polyphaseResampler::resample(audio_data, wav_reader.get_info().sample_rate, model_sample_rate);
+    }
     float cut_ratio = 1 / std::stof(argv[1]);
     int cut_idx     = static_cast<int>(cut_ratio * audio_data.size());
     std::vector<float> short_audio;
     std::copy(audio_data.begin(), audio_data.begin() + cut_idx, std::back_inserter(short_audio));
 
-    // get the emissions
     std::cout << "[main]: audio data size : " << audio_data.size() << std::endl; 
     std::cout << "[main]: cutIdx is : " << cut_idx << std::endl; 
     std::cout << "[main]: short audio size: " << short_audio.size() << std::endl;;
-    auto emissions = torch_model.pass_forward(short_audio);
 
-
-    
     ctcDecoder decoder(tokens_path, 15, fst_path, lm_path);
     float alpha = std::stof(argv[3]); // set alpha 
     decoder.set_lm_weight(alpha);
     std::vector<beam::ctcBeam*> decoding_result;
     bool result_set = false;
-    if (emissions.has_value()){
-        decoding_result = decoder.decode_sequence(emissions.value());
+
+    float chunk_seconds = (argc > 4) ? std::stof(argv[4]) : 0;
+
+    // warm up on the sizes that will actually run, so the timings below are steady state
+    asr::pipeline::warmupConfig warmup_config;
+    warmup_config.chunk_sizes = {chunk_seconds > 0 ? static_cast<size_t>(chunk_seconds * model_sample_rate)
+                                                   : short_audio.size()};
+    auto warmup_report = asr::pipeline::warm_up(torch_model, decoder, warmup_config);
+    std::cout << "[main]: warm-up\n" << warmup_report.summary() << std::endl;
+
+    if (chunk_seconds > 0){ // overlap the model and the decoder chunk by chunk
+        asr::pipeline::pipelineConfig pipeline_config;
+        pipeline_config.chunk_size = static_cast<size_t>(chunk_seconds * model_sample_rate);
+        pipeline_config.use_vad    = (argc > 5) && std::string(argv[5]) == "vad";
+        asr::pipeline::overlappedPipeline pipeline(torch_model, decoder, pipeline_config);
+        decoding_result = pipeline.run(short_audio);
         result_set = true;
+
+        auto stats = pipeline.get_stats();
+        std::cout << "[main]: chunks: " << stats.num_chunks 
+                  << ", model busy (ms): " << stats.model_busy_ms
+                  << ", decoder busy (ms): " << stats.decoder_busy_ms
+                  << ", wall (ms): " << stats.wall_ms << std::endl;
+        if (pipeline_config.use_vad){
+            std::cout << "[main]: vad segments: " << stats.num_segments
+                      << ", compute saved: " << 100 * stats.get_compute_saved() << "%" << std::endl;
+            for (const auto& segment : pipeline.get_segments()){
+                std::cout << "segment: " << segment << std::endl;
+            }
+        }
     }
     else{
-        DLOG(WARNING) << "[main]: torch script model not returning predictions";
+        // get the emissions
+        auto emissions = torch_model.pass_forward(short_audio);
+        if (emissions.has_value()){
+            decoding_result = decoder.decode_sequence(emissions.value());
+            result_set = true;
+        }
+        else{
+            DLOG(WARNING) << "[main]: torch script model not returning predictions";
+        }
     }
 
     if (result_set){
@@ -0,0 +1,122 @@
+#include <algorithm>
+#include "decoders/word_map.hpp"
+#include "utils/my_utils.hpp"
+#include "utils/fst_glog_safe_log.hpp"
+
+
+namespace beam{
+
+
+bool wordMap::build(const FSTDICT& dictionary,
+                    const SymbolTable& input_symbols,
+                    const SymbolTable& output_symbols,
+                    const asr::ngrams::nGramsModelWrapper& lm_model,
+                    bool upper_case){
+    clear();
+
+    // the fst has word labels, and is a tree when no state is entered twice
+    std::vector<bool> entered(dictionary.NumStates(), false);
+    bool has_labels = false, is_tree = true;
+    for (fst::StateIterator<FSTDICT> siter(dictionary); !siter.Done(); siter.Next()){
+        for (fst::ArcIterator<FSTDICT> aiter(dictionary, siter.Value()); !aiter.Done(); aiter.Next()){
+            const auto& arc = aiter.Value();
+            has_labels = has_labels || arc.olabel != 0;
+            if (entered[arc.nextstate]) is_tree = false;
+            entered[arc.nextstate] = true;
+        }
+    }
+    if (!has_labels){
+        LOG(WARNING) << "[wordMap/build]: the lexicon fst has no word output labels. "
+                     << "rebuild it (setup) to score words by id";
+        return false;
+    }
+
+    if (is_tree){
+        // dictionary state -> lexicon word id: the label sums of the paths into the final states
+        std::vector<int64_t> path_sums(dictionary.NumStates(), 0);
+        std::vector<dictState> queue{dictionary.Start()};
+        _state_word_ids.assign(dictionary.NumStates(), 0);
+        for (size_t i = 0; i < queue.size(); ++i){
+            dictState state = queue[i];
+            if (dictionary.Final(state) != fst::TropicalWeight::Zero()){
+                _state_word_ids[state] = static_cast<int32_t>(path_sums[state]);
+            }
+            for (fst::ArcIterator<FSTDICT> aiter(dictionary, state); !aiter.Done(); aiter.Next()){
+                const auto& arc = aiter.Value();
+                path_sums[arc.nextstate] = path_sums[state] + arc.olabel;
+                queue.push_back(arc.nextstate);
+            }
+        }
+    }
+    else{
+        // shared states: the completed word is walked again (walk_word_id)
+        _dictionary = &dictionary;
+        _char_labels.assign(256, -1);
+        for (auto it = input_symbols.begin(); it != input_symbols.end(); ++it){
+            const std::string& symbol = it->Symbol();
+            if (symbol.size() == 1 && it->Label() > 0){
+                _char_labels[static_cast<unsigned char>(symbol[0])] = it->Label();
+            }
+        }
+    }
+    int64_t max_word_id = 0;
+    for (auto it = output_symbols.begin(); it != output_symbols.end(); ++it){
+        max_word_id = std::max<int64_t>(max_word_id, it->Label());
+    }
+
+    // lexicon word id -> lm word index, case normalized once here
+    _lm_word_ids.assign(max_word_id + 1, 0);
+    for (auto it = output_symbols.begin(); it != output_symbols.end(); ++it){
+        int64_t word_id = it->Label();
+        if (word_id <= 0 || word_id > max_word_id) continue;
+        std::string word = it->Symbol();
+        if (upper_case) asr::stringmanip::upper_case(word);
+        _lm_word_ids[word_id] = lm_model.get_word_index(word);
+        ++_num_words;
+        if (_lm_word_ids[word_id] == 0) ++_num_oov;
+    }
+    _sentence_start = lm_model.get_word_index("<s>");
+
+    LOG(INFO) << "[wordMap/build]: mapped " << _num_words << " lexicon words to the lm ("
+              << _num_oov << " not in the lm vocabulary)" << (_dictionary ? ", walk mode" : "");
+    return true;
+}
+
+
+int32_t wordMap::walk_word_id(const std::vector<char>& sequence, char separator) const {
+    auto word_begin = std::find(sequence.rbegin(), sequence.rend(), separator).base();
+    dictState state = _dictionary->Start();
+    int64_t word_id = 0;
+    for (auto it = word_begin; it != sequence.end(); ++it){
+        int64_t label = _char_labels[static_cast<unsigned char>(*it)];
+        if (label < 0) return 0;
+        // arcs are input label sorted (the decoder's matcher relies on it too)
+        bool found = false;
+        for (fst::ArcIterator<FSTDICT> aiter(*_dictionary, state); !aiter.Done(); aiter.Next()){
+            const auto& arc = aiter.Value();
+            if (arc.ilabel < label) continue;
+            if (arc.ilabel == label){
+                word_id += arc.olabel;
+                state    = arc.nextstate;
+                found    = true;
+            }
+            break;
+        }
+        if (!found) return 0;
+    }
+    return _dictionary->Final(state) != fst::TropicalWeight::Zero() ? static_cast<int32_t>(word_id) : 0;
+}
+
+
+void wordMap::clear(){
+    _state_word_ids.clear();
+    _dictionary = nullptr;
+    _char_labels.clear();
+    _lm_word_ids.clear();
+    _sentence_start = 0;
+    _num_words = 0;
+    _num_oov   = 0;
+}
+
+
+} // namespace beam
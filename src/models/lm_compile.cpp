@@ -0,0 +1,74 @@
+#include <iostream>
+#include <filesystem>
+#include <chrono>
+#include <glog/logging.h>
+#include "models/ngrams_model.hpp"
+
+/*
+Converts an ARPA language model into a KenLM binary (probing hash tables by default, or one
+of the trie structures: trie, qtrie (quantized), atrie (array), qatrie) and reports the
+startup time of the decoder's LM before (parsing the arpa) and after (mapping the binary, for
+every load method). The decoders pick the binary up automatically when it sits next to the
+arpa with a .bin extension (ngrams::prefer_binary_model).
+
+usage: lm_compile log_verbosity path_to_arpa [path_to_binary [model_type [quantization_bits]]]
+*/
+
+namespace fs = std::filesystem;
+using namespace asr;
+
+
+int main(int argc, char* argv[]){
+
+    if (argc < 3){
+        std::cout << "[main]: pass all arguments: log_verbosity, path_to_arpa "
+                  << "[, path_to_binary, model_type (probing|trie|qtrie|atrie|qatrie), quantization_bits]" << std::endl;
+        return 1;
+    }
+
+    google::InitGoogleLogging(argv[0]);
+    FLAGS_logtostderr = false;
+    FLAGS_v = std::stoi(argv[1]);
+
+    fs::path arpa_path   = argv[2];
+    fs::path binary_path = (argc > 3) ? fs::path(argv[3]) : fs::path(arpa_path).replace_extension(".bin");
+    lm::ngram::ModelType model_type = lm::ngram::PROBING;
+    if (argc > 4 && !ngrams::parse_model_type(argv[4], model_type)){
+        std::cerr << "[main]: unknown model type " << argv[4] << std::endl;
+        return 1;
+    }
+    uint8_t quantization_bits = (argc > 5) ? static_cast<uint8_t>(std::stoi(argv[5])) : 8;
+
+    // before: what every decoder process paid at startup
+    ngrams::nGramsModelWrapper arpa_model;
+    if (!arpa_model.setup_model_from(arpa_path)){
+        std::cerr << "[main]: failed to load " << arpa_path << std::endl;
+        return 1;
+    }
+    std::cout << "[main]: arpa load: " << arpa_model.get_load_seconds() << " s" << std::endl;
+
+    auto start_time = std::chrono::steady_clock::now();
+    if (!ngrams::compile_arpa_to_binary(arpa_path, binary_path, model_type, quantization_bits)){
+        std::cerr << "[main]: failed to write " << binary_path << std::endl;
+        return 1;
+    }
+    std::cout << "[main]: wrote " << ngrams::model_type_name(model_type) << " binary " << binary_path
+              << " (" << fs::file_size(binary_path) / double(1 << 20) << " MB) in "
+              << std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count() << " s" << std::endl;
+
+    // after: the page cache is warm from the write, which is what a second decoder process on the host sees
+    const std::pair<util::LoadMethod, const char*> load_methods[] = {
+        {util::LAZY,             "lazy mmap"},
+        {util::POPULATE_OR_LAZY, "populate or lazy"},
+        {util::POPULATE_OR_READ, "populate or read"},
+        {util::READ,             "read (private copy)"}};
+    for (const auto& [load_method, name] : load_methods){
+        ngrams::nGramsModelWrapper binary_model;
+        if (!binary_model.setup_model_from(binary_path, load_method)){
+            std::cerr << "[main]: failed to load " << binary_path << std::endl;
+            return 1;
+        }
+        std::cout << "[main]: binary load (" << name << "): " << binary_model.get_load_seconds() << " s" << std::endl;
+    }
+    return 0;
+}
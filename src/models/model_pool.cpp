@@ -0,0 +1,199 @@
+#include "models/model_pool.hpp"
+#include <ATen/Parallel.h>
+#include <glog/logging.h>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+
+
+torchModelPool::torchModelPool(modelPoolConfig config) : _config(std::move(config)){
+    if (_config.num_workers == 0){
+        LOG(WARNING) << "[torchModelPool/constructor]: num_workers is 0. using a single worker";
+        _config.num_workers = 1;
+    }
+    DLOG(INFO) << "[torchModelPool/constructor]: instance created with " << _config.num_workers << " workers";
+}
+
+
+torchModelPool::~torchModelPool(){
+    stop_workers();
+    DLOG(INFO) << "[torchModelPool/destructor]: instance destroyed";
+}
+
+
+bool torchModelPool::load_model(const std::string& path_to_model){
+    // the new weights load next to the running ones: the workers keep serving until they are in
+    torchScriptModel candidate_model;
+    bool loaded = false;
+    try{
+        loaded = candidate_model.load_model(path_to_model);
+    }
+    catch (const std::exception& e){
+        LOG(WARNING) << "[torchModelPool/load_model]: " << e.what();
+    }
+    if (!loaded){
+        LOG(WARNING) << "[torchModelPool/load_model]: failed to load the model from " << path_to_model
+                     << (is_loaded() ? ". keeping the previous model" : "");
+        return false;
+    }
+
+    // the running workers drain the queued requests on the previous model before they stop
+    stop_workers();
+    _shared_model.share_weights_from(candidate_model);
+    set_torch_threads();
+    start_workers();
+    LOG(INFO) << "[torchModelPool/load_model]: loaded " << path_to_model << " and started "
+              << get_num_workers() << " workers (" << _config.intra_op_threads << " intra-op threads)";
+    return true;
+}
+
+
+void torchModelPool::set_torch_threads(){
+    // both counts are process wide in libtorch, so the first loaded pool sets them for everyone
+    static std::once_flag threads_flag;
+    std::call_once(threads_flag, [this](){
+        if (_config.intra_op_threads > 0){
+            at::set_num_threads(_config.intra_op_threads);
+        }
+        if (_config.inter_op_threads < 1) return;
+        try{
+            at::set_num_interop_threads(_config.inter_op_threads);
+        }
+        catch (const c10::Error& e){ // the inter-op pool was already started by a previous inference
+            LOG(WARNING) << "[torchModelPool/set_torch_threads]: could not set inter-op threads. "
+                         << e.what_without_backtrace();
+        }
+    });
+}
+
+
+void torchModelPool::start_workers(){
+    {
+        std::lock_guard<std::mutex> lock(_requests_mutex);
+        _shutdown = false;
+    }
+    for (size_t i = 0; i < _config.num_workers; ++i){
+        _workers.emplace_back(&torchModelPool::worker_loop, this, i);
+    }
+}
+
+
+void torchModelPool::stop_workers(){
+    {
+        std::lock_guard<std::mutex> lock(_requests_mutex);
+        _shutdown = true;
+    }
+    _requests_cv.notify_all();
+    for (auto& worker : _workers){
+        if (worker.joinable()) worker.join();
+    }
+    _workers.clear();
+}
+
+
+bool torchModelPool::pin_current_thread(const std::vector<int>& core_set){
+#ifdef __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (const auto& core : core_set){
+        CPU_SET(core, &cpu_set);
+    }
+    int result = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set);
+    if (result != 0){
+        LOG(WARNING) << "[torchModelPool/pin_current_thread]: failed to set the thread affinity (error " << result << ")";
+        return false;
+    }
+    return true;
+#else
+    LOG(WARNING) << "[torchModelPool/pin_current_thread]: thread pinning is only supported on linux";
+    return false;
+#endif
+}
+
+
+void torchModelPool::worker_loop(size_t worker_index){
+    auto core_set = _config.get_core_set(worker_index);
+    if (!core_set.empty()){
+        pin_current_thread(core_set);
+    }
+    torchScriptModel worker_model;
+    worker_model.share_weights_from(_shared_model);
+    VLOG(3) << "[torchModelPool/worker_loop]: worker " << worker_index << " started";
+
+    while (true){
+        inferenceRequest request;
+        {
+            std::unique_lock<std::mutex> lock(_requests_mutex);
+            _requests_cv.wait(lock, [this](){return _shutdown || !_requests.empty();});
+            if (_shutdown && _requests.empty()){
+                break;
+            }
+            request = std::move(_requests.front());
+            _requests.pop_front();
+            _queue_depth.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        auto start_time = clock::now();
+        try{
+            c10::InferenceMode inference_guard;
+            request.result.set_value(worker_model.pass_forward(request.audio_data));
+        }
+        catch (...){
+            request.result.set_exception(std::current_exception());
+        }
+        auto end_time = clock::now();
+
+        // update metrics
+        auto wait_us    = std::chrono::duration_cast<std::chrono::microseconds>(start_time - request.enqueue_time).count();
+        auto forward_us = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+        _total_wait_us.fetch_add(wait_us, std::memory_order_relaxed);
+        _total_forward_us.fetch_add(forward_us, std::memory_order_relaxed);
+        _completed.fetch_add(1, std::memory_order_relaxed);
+    }
+    VLOG(3) << "[torchModelPool/worker_loop]: worker " << worker_index << " stopped";
+}
+
+
+std::future<torchModelPool::forwardResult> torchModelPool::submit(std::vector<float> audio_data){
+    inferenceRequest request;
+    request.audio_data   = std::move(audio_data);
+    request.enqueue_time = clock::now();
+    auto result = request.result.get_future();
+
+    if (!is_loaded()){
+        LOG(WARNING) << "[torchModelPool/submit]: no model is loaded";
+        request.result.set_value(std::nullopt);
+        return result;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_requests_mutex);
+        _requests.push_back(std::move(request));
+        size_t depth = _queue_depth.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (depth > _max_queue_depth.load(std::memory_order_relaxed)){
+            _max_queue_depth.store(depth, std::memory_order_relaxed);
+        }
+    }
+    _requests_cv.notify_one();
+    return result;
+}
+
+
+torchModelPool::forwardResult torchModelPool::pass_forward(std::vector<float> audio_data){
+    return submit(std::move(audio_data)).get();
+}
+
+
+modelPoolStats torchModelPool::get_stats() const {
+    modelPoolStats stats;
+    stats.queue_depth     = _queue_depth.load(std::memory_order_relaxed);
+    stats.max_queue_depth = _max_queue_depth.load(std::memory_order_relaxed);
+    stats.completed       = _completed.load(std::memory_order_relaxed);
+    if (stats.completed > 0){
+        stats.mean_wait_ms    = _total_wait_us.load(std::memory_order_relaxed) / 1000.0 / stats.completed;
+        stats.mean_forward_ms = _total_forward_us.load(std::memory_order_relaxed) / 1000.0 / stats.completed;
+    }
+    return stats;
+}
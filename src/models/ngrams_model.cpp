@@ -1,5 +1,8 @@
 #include "models/ngrams_model.hpp"
 #include <glog/logging.h>
+#include <algorithm>
+#include <chrono>
+#include <utility>
 
 
 namespace asr{
@@ -22,14 +25,105 @@ nGramsModelWrapper::~nGramsModelWrapper() noexcept {
 }
 
 
-bool nGramsModelWrapper::load_model(fs::path path_to_ngrams_model){
+namespace {
+    // building the model with write_mmap set writes the binary
+    template <typename ModelT>
+    void build_binary(const fs::path& path_to_arpa, const lm::ngram::Config& config){
+        ModelT model(path_to_arpa.string().c_str(), config);
+    }
+} // namespace
+
+
+bool compile_arpa_to_binary(const fs::path& path_to_arpa,
+                            const fs::path& path_to_binary,
+                            lm::ngram::ModelType model_type,
+                            uint8_t quantization_bits){
+    if (!fs::exists(path_to_arpa)){
+        LOG(WARNING) << "[ngrams/compile_arpa_to_binary]: path " << path_to_arpa << " does not exist";
+        return false;
+    }
+    std::string binary_path = path_to_binary.string(); // config keeps the pointer
+    lm::ngram::Config config;
+    config.write_mmap   = binary_path.c_str();
+    config.write_method = lm::ngram::Config::WRITE_AFTER; // the file only appears once it is complete
+    config.prob_bits    = quantization_bits;
+    config.backoff_bits = quantization_bits;
+    try{
+        switch (model_type){
+            case lm::ngram::PROBING:          build_binary<lm::ngram::ProbingModel>(path_to_arpa, config); break;
+            case lm::ngram::REST_PROBING:     build_binary<lm::ngram::RestProbingModel>(path_to_arpa, config); break;
+            case lm::ngram::TRIE:             build_binary<lm::ngram::TrieModel>(path_to_arpa, config); break;
+            case lm::ngram::QUANT_TRIE:       build_binary<lm::ngram::QuantTrieModel>(path_to_arpa, config); break;
+            case lm::ngram::ARRAY_TRIE:       build_binary<lm::ngram::ArrayTrieModel>(path_to_arpa, config); break;
+            case lm::ngram::QUANT_ARRAY_TRIE: build_binary<lm::ngram::QuantArrayTrieModel>(path_to_arpa, config); break;
+            default:
+                LOG(WARNING) << "[ngrams/compile_arpa_to_binary]: unknown model type " << model_type;
+                return false;
+        }
+    }
+    catch (const util::Exception& e){
+        LOG(WARNING) << "[ngrams/compile_arpa_to_binary]: failed to compile " << path_to_arpa << ": " << e.what();
+        return false;
+    }
+    return true;
+}
+
+
+const char* model_type_name(lm::ngram::ModelType model_type){
+    switch (model_type){
+        case lm::ngram::PROBING:          return "probing";
+        case lm::ngram::REST_PROBING:     return "rest probing";
+        case lm::ngram::TRIE:             return "trie";
+        case lm::ngram::QUANT_TRIE:       return "quantized trie";
+        case lm::ngram::ARRAY_TRIE:       return "array trie";
+        case lm::ngram::QUANT_ARRAY_TRIE: return "quantized array trie";
+        default:                          return "unknown";
+    }
+}
+
+
+bool parse_model_type(const std::string& name, lm::ngram::ModelType& model_type){
+    if      (name == "probing") model_type = lm::ngram::PROBING;
+    else if (name == "trie")    model_type = lm::ngram::TRIE;
+    else if (name == "qtrie")   model_type = lm::ngram::QUANT_TRIE;
+    else if (name == "atrie")   model_type = lm::ngram::ARRAY_TRIE;
+    else if (name == "qatrie")  model_type = lm::ngram::QUANT_ARRAY_TRIE;
+    else return false;
+    return true;
+}
+
+
+fs::path prefer_binary_model(const fs::path& path_to_arpa){
+    fs::path path_to_binary = fs::path(path_to_arpa).replace_extension(".bin");
+    return fs::exists(path_to_binary) ? path_to_binary : path_to_arpa;
+}
+
+
+bool nGramsModelWrapper::load_model(fs::path path_to_ngrams_model, util::LoadMethod load_method){
     if (!fs::exists(path_to_ngrams_model)){
         LOG(WARNING) << "nGramsModelWrapper/load_model: path " << path_to_ngrams_model << " does not exist";
         return false;
     }
     set_model_path(path_to_ngrams_model);
-    ngram_model_ptr_ = std::make_unique<lm::ngram::Model>(get_model_path().string().c_str());
-    LOG(INFO) << "[nGramsModelWrapper/load_model]: loaded model from " << get_model_path().string().c_str();
+    // binary models are mmapped with load_method (POPULATE_OR_READ: MAP_POPULATE so the first
+    // decode does not page fault). arpa files are parsed whatever the method
+    auto start_time = std::chrono::steady_clock::now();
+    model_type_ = lm::ngram::PROBING; // arpa files are loaded as probing
+    is_binary_  = lm::ngram::RecognizeBinary(get_model_path().string().c_str(), model_type_);
+    lm::ngram::Config config;
+    config.load_method = load_method;
+    try{
+        ngram_model_ptr_.reset(lm::ngram::LoadVirtual(get_model_path().string().c_str(), config, lm::ngram::PROBING));
+    }
+    catch (const util::Exception& e){
+        LOG(WARNING) << "[nGramsModelWrapper/load_model]: failed to load " << get_model_path() << ": " << e.what();
+        ngram_model_ptr_.reset();
+        return false;
+    }
+    load_seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    LOG(INFO) << "[nGramsModelWrapper/load_model]: loaded " << (is_binary_ ? "binary " : "arpa ")
+              << model_type_name(model_type_) << " model from " << get_model_path().string().c_str()
+              << " in " << load_seconds_ << " s";
     return true;
 }
 
@@ -44,7 +138,7 @@ void nGramsModelWrapper::reset_internal_state(){
         LOG(WARNING) << "[nGramsModelWrapper/set_init_intenral_state]: no model is loaded";
         return;
     }
-    set_internal_state(ngram_model_ptr_->BeginSentenceState());
+    ngram_model_ptr_->BeginSentenceWrite(&internal_state_);
 }
 
 
@@ -53,7 +147,7 @@ void nGramsModelWrapper::init_vocab(){
         LOG(WARNING) << "[nGramsModelWrapper/set_vocab]: no model is loaded";
         return;
     }
-    vocab_ptr_ = &(ngram_model_ptr_->GetVocabulary()); // FIXME: what happens of the ngrams_model_ptr_ get out of scope
+    vocab_ptr_ = &(ngram_model_ptr_->BaseVocabulary()); // FIXME: what happens of the ngrams_model_ptr_ get out of scope
     return;
 }
 
@@ -75,21 +169,47 @@ WordIndex nGramsModelWrapper::get_word_index(const std::string& word) const {
 
 
 float nGramsModelWrapper::score_word(const std::string& word){
-    static State out_state;
-    float score;
     WordIndex word_index = get_word_index(word);
-    if (word_index == 0) { // word not found. FIXME: I remeber reading that 0 indicates word not found in the source code (I have to check again)
+    if (word_index == 0) { // word not found: 0 is <unk> in every kenlm vocabulary
         LOG(WARNING) << "[nGramsModelWrapper/score_word]: word: " << word << " was not found in the vocab";
         return NF_NINF_SCORE; // lowest possible vlaue (probability of 0)
     }
-    score = ngram_model_ptr_->Score(get_internal_state(), word_index, out_state);
+    State out_state;
+    float word_score = score(internal_state_, word_index, &out_state);
     set_internal_state(out_state); // update the internal state 
-    return score;
+    return word_score;
 }
 
 
-bool nGramsModelWrapper::setup_model_from(fs::path path_to_ngrams_model){
-    if(!load_model(path_to_ngrams_model)){
+size_t nGramsModelWrapper::prefault() const {
+    /*
+    ARPA models are parsed into memory at load time, but the pages of the probing tables are
+    only hit once words get scored. scoring every unigram after <s> walks the unigram array and
+    probes the bigram table, so the first utterance runs at steady state speed.
+    */
+    if (!ngram_model_ptr_.get()){
+        LOG(WARNING) << "[nGramsModelWrapper/prefault]: no model is loaded";
+        return 0;
+    }
+    State begin_state, out_state;
+    ngram_model_ptr_->BeginSentenceWrite(&begin_state);
+    WordIndex vocab_bound = ngram_model_ptr_->BaseVocabulary().Bound();
+    volatile float score_sink = 0; // keeps the lookups from being optimized away
+    for (WordIndex word_index = 1; word_index < vocab_bound; ++word_index){
+        score_sink = score_sink + ngram_model_ptr_->BaseScore(&begin_state, word_index, &out_state);
+    }
+    VLOG(2) << "[nGramsModelWrapper/prefault]: scored " << vocab_bound - 1 << " words";
+    return vocab_bound - 1;
+}
+
+
+void nGramsModelWrapper::start_new_sentence(){
+    reset_internal_state();
+}
+
+
+bool nGramsModelWrapper::setup_model_from(fs::path path_to_ngrams_model, util::LoadMethod load_method){
+    if(!load_model(path_to_ngrams_model, load_method)){
         LOG(WARNING) << "[nGramsModelWrapper/load_model_from]: failed to load model form " << path_to_ngrams_model;
         return false;
     };
@@ -105,27 +225,33 @@ inline float nGramsModelWrapper:: map_score(float val) const {
 
 
 
-float nGramsModelWrapper::score_sentence(std::vector<std::string> sentence, scoreType score_type){
-
-    double cond_prob;
-    lm::ngram::State state, tmp_state, out_state;
-    // avoid to inserting <s> in begin
-    ngram_model_ptr_->NullContextWrite(&state);
+float nGramsModelWrapper::score_sentence(const std::vector<std::string>& sentence, scoreType score_type) const {
+    std::vector<WordIndex> ngram(sentence.size());
     for (size_t i = 0; i < sentence.size(); ++i) {
-      lm::WordIndex word_index = ngram_model_ptr_->BaseVocabulary().Index(sentence[i]);
+      ngram[i] = vocab_ptr_->Index(sentence[i]);
       // encounter OOV
-      if (word_index == 0) {
+      if (ngram[i] == 0) {
         VLOG(5) << "[nGramsModelWrapper/score_sentence]: "
                 << "index not found for " <<  sentence[i];
         return -OOV_PENALTY_;
       }
-      cond_prob = ngram_model_ptr_->BaseScore(&state, word_index, &out_state);
-      /*
-      I don't get why saving the outstate 
-      */
-      tmp_state = state;
-      state = out_state;
-      out_state = tmp_state;
+    }
+    return score_ngram(ngram, score_type);
+}
+
+
+float nGramsModelWrapper::score_ngram(const std::vector<WordIndex>& ngram, scoreType score_type) const {
+
+    double cond_prob = 0;
+    State state, out_state;
+    // avoid to inserting <s> in begin
+    null_context_state(&state);
+    for (WordIndex word_index : ngram) {
+      if (word_index == 0) {
+        return -OOV_PENALTY_;
+      }
+      cond_prob = score(state, word_index, &out_state);
+      std::swap(state, out_state);
     }
     // return  loge prob
     auto log_prob = cond_prob / 0.4342944819; // Question: this number was found in paralnce implementation (whaty does it represent)
@@ -146,7 +272,40 @@ float nGramsModelWrapper::score_sentence(std::vector<std::string> sentence, scor
 }
 
 
-float nGramsModelWrapper::score_sentence(std::vector<std::string> sentence){
+size_t nGramsModelWrapper::score_batch(lmQuery* queries, size_t num_queries) const {
+    /*
+    beams that complete the same word after the same context (they differ only in blanks and
+    repeats) share one lookup: the queries are ordered by (context, word) so duplicates are
+    adjacent. that deduplication is all the batch saves: every distinct query is still one
+    score() whose probes into kenlm's hash tables miss the cache as they would one by one (the
+    virtual model does not expose its tables to prefetch them)
+    */
+    thread_local std::vector<std::pair<uint64_t, uint32_t>> order;
+    order.resize(num_queries);
+    for (size_t i = 0; i < num_queries; ++i){
+        order[i] = {lm::ngram::hash_value(*queries[i].in_state, queries[i].word_id), static_cast<uint32_t>(i)};
+    }
+    std::sort(order.begin(), order.end());
+
+    size_t num_lookups = 0;
+    const lmQuery* previous = nullptr;
+    for (size_t i = 0; i < num_queries; ++i){
+        lmQuery& query = queries[order[i].second];
+        if (previous && previous->word_id == query.word_id && *previous->in_state == *query.in_state){
+            query.score = previous->score;
+            if (query.out_state != previous->out_state) *query.out_state = *previous->out_state;
+        }
+        else{
+            query.score = score(*query.in_state, query.word_id, query.out_state);
+            ++num_lookups;
+        }
+        previous = &query;
+    }
+    return num_lookups;
+}
+
+
+float nGramsModelWrapper::score_sentence(const std::vector<std::string>& sentence) const {
     return score_sentence(sentence, scoring_config.score_type);
 } 
 
@@ -1,4 +1,5 @@
 #include "models/torch_script_model.hpp"
+#include <torch/nn/functional.h>
 #include <glog/logging.h>
 
 
@@ -21,7 +22,9 @@ torchScriptModel::~torchScriptModel(){
 bool torchScriptModel::load_model(const std::string& _file_path){
     try{
         _model = torch::jit::load(_file_path);
+        _model.eval();
         _model_path = _file_path;
+        _is_loaded  = true;
     }
     catch (const c10::Error& e){ 
         DLOG(WARNING) << "[torchScriptoModel/load_model]: Error loading the model from "
@@ -33,6 +36,22 @@ bool torchScriptModel::load_model(const std::string& _file_path){
 }
 
 
+bool torchScriptModel::share_weights_from(const torchScriptModel& other){
+    /*
+    torch::jit::script::Module is a handle to the underlying script object, so copying it
+    shares the parameters and buffers instead of duplicating them.
+    */
+    if (!other.is_loaded()){
+        DLOG(WARNING) << "[torchScriptModel/share_weights_from]: source model is not loaded";
+        return false;
+    }
+    _model      = other._model;
+    _model_path = other._model_path;
+    _is_loaded  = true;
+    return true;
+}
+
+
 std::optional<torch::Tensor> torchScriptModel::pass_forward(std::vector<float>& audio_data){
     
     // chech input data validity 
@@ -66,3 +85,22 @@ std::optional<torch::Tensor> torchScriptModel::pass_forward(std::vector<float>&
 }
 
 
+std::optional<asr::emissions::sparseEmissions> torchScriptModel::pass_forward_sparse(std::vector<float>& audio_data,
+                                                            const asr::emissions::sparseEmissionsConfig& sparse_config){
+    /*
+    runs the model and keeps the top-k log-probs of every frame, so only the sparse
+    representation leaves this stage
+    */
+    auto output = pass_forward(audio_data);
+    if (!output.has_value()){
+        return std::nullopt;
+    }
+
+    auto logits    = output.value();
+    auto log_probs = torch::nn::functional::log_softmax(logits.reshape({-1, logits.size(-1)}),
+                        torch::nn::functional::LogSoftmaxFuncOptions(1)).contiguous();
+    return asr::emissions::sparseEmissions::from_log_probs(log_probs.data_ptr<float>(),
+                                                           log_probs.size(0),
+                                                           log_probs.size(1),
+                                                           sparse_config);
+}
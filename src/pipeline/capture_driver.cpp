@@ -0,0 +1,69 @@
+#include "pipeline/capture_driver.hpp"
+#include <glog/logging.h>
+
+
+namespace asr{
+    namespace pipeline{
+
+
+captureDriver::captureDriver(audio::captureSink& capture_sink, overlappedPipeline& pipeline, size_t chunk_frames) :
+    _capture_sink(capture_sink), _pipeline(pipeline), _chunk_frames(chunk_frames){
+    DLOG(INFO) << "[captureDriver/constructor]: instance created. chunk frames: " << _chunk_frames;
+}
+
+
+captureDriver::~captureDriver(){
+    if (_running){
+        stop();
+    }
+}
+
+
+void captureDriver::start(){
+    if (_running){
+        LOG(WARNING) << "[captureDriver/start]: driver is already running";
+        return;
+    }
+    _pipeline.start();
+    _running = true;
+    _thread  = std::thread(&captureDriver::consume_loop, this);
+}
+
+
+std::vector<beam::ctcBeam*> captureDriver::stop(){
+    if (!_running){
+        return _pipeline.finish();
+    }
+    _running = false;
+    _thread.join();
+
+    // whatever the callback wrote before the stream was stopped
+    push_available(_capture_sink.get_available());
+
+    auto capture_stats = _capture_sink.get_stats();
+    VLOG(2) << "[captureDriver/stop]: pushed " << _chunks_pushed.load() << " chunks. captured "
+            << capture_stats.frames_captured << " frames, dropped " << capture_stats.frames_dropped
+            << ", input overflows " << capture_stats.input_overflows;
+    return _pipeline.finish();
+}
+
+
+void captureDriver::consume_loop(){
+    while (_running.load(std::memory_order_relaxed)){
+        if (_capture_sink.wait_for(_chunk_frames, std::chrono::milliseconds(50))){
+            push_available(_chunk_frames);
+        }
+    }
+}
+
+
+void captureDriver::push_available(size_t max_frames){
+    std::vector<float> chunk;
+    if (_capture_sink.read(chunk, max_frames) == 0) return;
+    _pipeline.push_audio(std::move(chunk));
+    _chunks_pushed.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+    } // namespace pipeline
+} // namespace asr
@@ -0,0 +1,150 @@
+#include "pipeline/channel_sessions.hpp"
+#include <glog/logging.h>
+#include <chrono>
+
+
+namespace asr{
+    namespace pipeline{
+
+
+namespace {
+    typedef std::chrono::steady_clock clock_type;
+
+    uint64_t elapsed_us(clock_type::time_point start){
+        return std::chrono::duration_cast<std::chrono::microseconds>(clock_type::now() - start).count();
+    }
+} // namespace
+
+
+
+channelSessions::channelSessions(audio::multiChannelCaptureSink& capture_sink,
+                                 torchModelPool& model_pool,
+                                 decoderFactory make_decoder,
+                                 channelSessionConfig config) :
+    _capture_sink(capture_sink), _model_pool(model_pool), _config(config){
+    for (size_t c = 0; c < _capture_sink.get_num_channels(); ++c){
+        auto session     = std::make_unique<channelSession>();
+        session->decoder = make_decoder(c);
+        _sessions.push_back(std::move(session));
+    }
+    DLOG(INFO) << "[channelSessions/constructor]: instance created with " << _sessions.size() << " channels";
+}
+
+
+channelSessions::~channelSessions(){
+    if (_running){
+        stop();
+    }
+}
+
+
+void channelSessions::start(){
+    if (_running){
+        LOG(WARNING) << "[channelSessions/start]: sessions are already running";
+        return;
+    }
+    _running = true;
+    for (size_t c = 0; c < _sessions.size(); ++c){
+        _sessions[c]->failed = false;
+        _sessions[c]->error.clear();
+        _sessions[c]->decoder->reset();
+        _sessions[c]->thread = std::thread(&channelSessions::session_loop, this, c);
+    }
+}
+
+
+std::vector<std::string> channelSessions::stop(){
+    _running = false;
+    for (auto& session : _sessions){
+        if (session->thread.joinable()) session->thread.join();
+    }
+
+    std::vector<std::string> transcripts;
+    for (size_t c = 0; c < _sessions.size(); ++c){
+        // whatever the callback wrote before the stream was stopped
+        size_t remaining = _capture_sink.get_channel(c).get_available();
+        if (remaining > 0) try_process(c, remaining);
+        if (_sessions[c]->failed){ // see get_stats() for the error
+            transcripts.push_back("");
+            continue;
+        }
+
+        auto top_beams = _sessions[c]->decoder->get_top_beams();
+        transcripts.push_back(top_beams.empty() ? "" : top_beams.front()->get_sequence());
+        VLOG(2) << "[channelSessions/stop]: channel " << c << ": " << transcripts.back();
+    }
+    return transcripts;
+}
+
+
+void channelSessions::session_loop(size_t channel_index){
+    auto& channel = _capture_sink.get_channel(channel_index);
+    while (_running.load(std::memory_order_relaxed)){
+        if (channel.wait_for(_config.chunk_frames, std::chrono::milliseconds(50))){
+            if (!try_process(channel_index, _config.chunk_frames)) break;
+        }
+    }
+}
+
+
+bool channelSessions::try_process(size_t channel_index, size_t max_frames){
+    auto& session = *_sessions[channel_index];
+    if (session.failed.load(std::memory_order_acquire)) return false;
+    try{
+        process(channel_index, max_frames);
+        return true;
+    }
+    catch (const std::exception& e){
+        session.error = e.what();
+    }
+    catch (...){
+        session.error = "unknown exception";
+    }
+    session.failed.store(true, std::memory_order_release);
+    LOG(ERROR) << "[channelSessions/try_process]: channel " << channel_index << " stopped: " << session.error;
+    return false;
+}
+
+
+void channelSessions::process(size_t channel_index, size_t max_frames){
+    auto& session = *_sessions[channel_index];
+    std::vector<float> chunk;
+    if (_capture_sink.get_channel(channel_index).read(chunk, max_frames) == 0) return;
+    session.num_frames.fetch_add(chunk.size(), std::memory_order_relaxed);
+
+    auto start_time = clock_type::now();
+    auto emissions  = _model_pool.pass_forward(std::move(chunk));
+    session.forward_us.fetch_add(elapsed_us(start_time), std::memory_order_relaxed);
+    if (!emissions.has_value()){
+        LOG(WARNING) << "[channelSessions/process]: model returned no emissions for channel " << channel_index;
+        return;
+    }
+
+    start_time = clock_type::now();
+    {
+        std::unique_lock<std::mutex> lock(_decoding_mutex, std::defer_lock);
+        if (_config.serialize_decoding) lock.lock();
+        session.decoder->decode_chunk(emissions.value());
+    }
+    session.decode_us.fetch_add(elapsed_us(start_time), std::memory_order_relaxed);
+    session.num_chunks.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+std::vector<channelSessionStats> channelSessions::get_stats() const {
+    std::vector<channelSessionStats> stats;
+    for (const auto& session : _sessions){
+        channelSessionStats channel_stats;
+        channel_stats.num_chunks = session->num_chunks.load(std::memory_order_relaxed);
+        channel_stats.num_frames = session->num_frames.load(std::memory_order_relaxed);
+        channel_stats.forward_ms = session->forward_us.load(std::memory_order_relaxed) / 1000.0;
+        channel_stats.decode_ms  = session->decode_us.load(std::memory_order_relaxed) / 1000.0;
+        if (session->failed.load(std::memory_order_acquire)) channel_stats.error = session->error;
+        stats.push_back(channel_stats);
+    }
+    return stats;
+}
+
+
+    } // namespace pipeline
+} // namespace asr
@@ -0,0 +1,233 @@
+#include "pipeline/load_generator.hpp"
+#include <glog/logging.h>
+#include <algorithm>
+#include <sstream>
+#include <thread>
+#include <cmath>
+
+
+namespace asr{
+    namespace pipeline{
+
+
+namespace {
+    // nearest rank. values is sorted
+    double percentile(const std::vector<double>& values, double p){
+        if (values.empty()) return 0;
+        size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * values.size()));
+        return values[std::min(values.size(), std::max<size_t>(rank, 1)) - 1];
+    }
+
+    double seconds_since(std::chrono::steady_clock::time_point start){
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+} // namespace
+
+
+
+std::string loadReport::summary() const {
+    std::ostringstream out;
+    out << "streams: " << streams.size() << ", workers: " << num_workers
+        << ", audio (s): " << audio_seconds << ", wall (s): " << wall_seconds << "\n"
+        << "chunks: " << num_chunks << ", dropped: " << dropped_chunks
+        << ", late player callbacks: " << late_callbacks << ", failed streams: " << failed_streams << "\n"
+        << "latency (ms) p50: " << p50_ms << ", p95: " << p95_ms << ", p99: " << p99_ms << ", max: " << max_ms << "\n"
+        << "compute (s): " << busy_seconds << ", decoding lock wait (s): " << lock_wait_seconds
+        << ", max streams per core: " << max_streams_per_core
+        << ", sustained: " << (sustained ? "yes" : "no");
+    return out.str();
+}
+
+
+
+loadGenerator::loadGenerator(torchScriptModel& model, decoderFactory make_decoder, loadGeneratorConfig config) :
+    _model(model), _make_decoder(std::move(make_decoder)), _config(config){
+    if (_config.num_workers == 0){
+        LOG(WARNING) << "[loadGenerator/constructor]: num_workers is 0. using a single worker";
+        _config.num_workers = 1;
+    }
+    if (_config.chunk_frames == 0){
+        LOG(WARNING) << "[loadGenerator/constructor]: chunk_frames is 0. using 16000";
+        _config.chunk_frames = 16000;
+    }
+    DLOG(INFO) << "[loadGenerator/constructor]: instance created. streams: " << _config.num_streams
+               << ", workers: " << _config.num_workers << ", speed: " << _config.player_config.speed;
+}
+
+
+loadReport loadGenerator::run(const std::vector<std::vector<float>>& audio_files, double sample_rate){
+    if (audio_files.empty() || !_model.is_loaded()){
+        LOG(WARNING) << "[loadGenerator/run]: needs a loaded model and at least one audio file";
+        return loadReport{};
+    }
+
+    // everything is allocated before the clock starts
+    size_t sink_frames = std::max(static_cast<size_t>(_config.sink_seconds * sample_rate), _config.chunk_frames);
+    std::vector<loadStream> streams(_config.num_streams);
+    audio::multiStreamPlayer player(_config.player_config);
+    for (size_t i = 0; i < streams.size(); ++i){
+        const auto& audio = audio_files[i % audio_files.size()];
+        streams[i].sink    = std::make_unique<audio::captureSink>(sample_rate, sink_frames);
+        streams[i].decoder = _make_decoder();
+        streams[i].latencies_ms.reserve(audio.size() / _config.chunk_frames + 2);
+        player.add_stream(audio, *streams[i].sink);
+    }
+
+    auto start_time = clock::now();
+    player.start();
+    std::vector<std::thread> workers;
+    for (size_t w = 0; w < _config.num_workers; ++w){
+        workers.emplace_back(&loadGenerator::worker_loop, this, w, std::ref(streams), std::cref(player));
+    }
+    for (auto& worker : workers){
+        worker.join();
+    }
+    player.stop();
+    double wall_seconds = std::chrono::duration<double>(clock::now() - start_time).count();
+
+    return make_report(streams, player, sample_rate, wall_seconds);
+}
+
+
+void loadGenerator::worker_loop(size_t worker_index,
+                                std::vector<loadStream>& streams,
+                                const audio::multiStreamPlayer& player){
+    torchScriptModel model;
+    model.share_weights_from(_model);
+
+    while (true){
+        bool all_done = true;
+        bool worked   = false;
+        for (size_t i = worker_index; i < streams.size(); i += _config.num_workers){
+            auto& stream = streams[i];
+            if (stream.done) continue;
+
+            // read the flag first: frames written before the stream finished are visible after it
+            bool finished    = player.is_finished(i);
+            size_t available = stream.sink->get_available();
+            if (available >= _config.chunk_frames || (finished && available > 0)){
+                process_chunk(model, stream, i, _config.chunk_frames, player);
+                worked = true;
+                if (!stream.error.empty()){
+                    stream.done = true;
+                    continue;
+                }
+            }
+            else if (finished){
+                stream.done = true;
+                continue;
+            }
+            all_done = false;
+        }
+        if (all_done) break;
+        if (!worked){
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+}
+
+
+void loadGenerator::process_chunk(torchScriptModel& model,
+                                  loadStream& stream,
+                                  size_t stream_index,
+                                  size_t max_frames,
+                                  const audio::multiStreamPlayer& player){
+    std::vector<float> chunk;
+    stream.sink->read(chunk, max_frames);
+    stream.frames_read += chunk.size();
+
+    auto start_time = clock::now();
+    double lock_wait_seconds = 0;
+    try{
+        auto emissions = model.pass_forward(chunk);
+        if (emissions.has_value()){
+            std::unique_lock<std::mutex> lock(_decoding_mutex, std::defer_lock);
+            if (_config.serialize_decoding){
+                auto wait_start = clock::now();
+                lock.lock();
+                lock_wait_seconds = seconds_since(wait_start);
+            }
+            stream.decoder->decode_chunk(emissions.value());
+        }
+        else{
+            ++stream.model_failures;
+        }
+    }
+    catch (const std::exception& e){
+        stream.error = e.what();
+        LOG(ERROR) << "[loadGenerator/process_chunk]: stream " << stream_index << " stopped: " << e.what();
+    }
+    double chunk_seconds = seconds_since(start_time);
+    stream.busy_seconds      += chunk_seconds - lock_wait_seconds;
+    stream.lock_wait_seconds += lock_wait_seconds;
+    if (!stream.error.empty()) return; // the chunk never finished
+
+    if (player.get_speed() > 0){
+        double captured_at = player.get_capture_time(stream_index, stream.frames_read);
+        stream.latencies_ms.push_back((player.get_elapsed() - captured_at) * 1000.0);
+    }
+    else{
+        stream.latencies_ms.push_back(chunk_seconds * 1000.0);
+    }
+}
+
+
+loadReport loadGenerator::make_report(std::vector<loadStream>& streams,
+                                      const audio::multiStreamPlayer& player,
+                                      double sample_rate,
+                                      double wall_seconds) const {
+    loadReport report;
+    report.num_workers    = _config.num_workers;
+    report.late_callbacks = player.get_late_callbacks();
+    report.wall_seconds   = wall_seconds;
+
+    std::vector<double> all_latencies;
+    for (auto& stream : streams){
+        streamLoadReport stream_report;
+        auto capture_stats = stream.sink->get_stats();
+        stream_report.num_chunks     = stream.latencies_ms.size();
+        stream_report.frames_dropped = capture_stats.frames_dropped;
+        stream_report.dropped_chunks = stream.model_failures +
+            (capture_stats.frames_dropped + _config.chunk_frames - 1) / _config.chunk_frames;
+        stream_report.audio_seconds  = stream.frames_read / sample_rate;
+        stream_report.busy_seconds   = stream.busy_seconds;
+        stream_report.lock_wait_seconds = stream.lock_wait_seconds;
+        stream_report.error          = stream.error;
+
+        std::sort(stream.latencies_ms.begin(), stream.latencies_ms.end());
+        stream_report.p50_ms = percentile(stream.latencies_ms, 50);
+        stream_report.p95_ms = percentile(stream.latencies_ms, 95);
+        stream_report.p99_ms = percentile(stream.latencies_ms, 99);
+        stream_report.max_ms = stream.latencies_ms.empty() ? 0 : stream.latencies_ms.back();
+        all_latencies.insert(all_latencies.end(), stream.latencies_ms.begin(), stream.latencies_ms.end());
+
+        report.num_chunks     += stream_report.num_chunks;
+        report.dropped_chunks += stream_report.dropped_chunks;
+        report.audio_seconds  += stream_report.audio_seconds;
+        report.busy_seconds   += stream_report.busy_seconds;
+        report.lock_wait_seconds += stream_report.lock_wait_seconds;
+        report.failed_streams += stream_report.error.empty() ? 0 : 1;
+        report.streams.push_back(stream_report);
+    }
+
+    std::sort(all_latencies.begin(), all_latencies.end());
+    report.p50_ms = percentile(all_latencies, 50);
+    report.p95_ms = percentile(all_latencies, 95);
+    report.p99_ms = percentile(all_latencies, 99);
+    report.max_ms = all_latencies.empty() ? 0 : all_latencies.back();
+    report.max_streams_per_core = report.busy_seconds > 0 ? report.audio_seconds / report.busy_seconds : 0;
+
+    double budget_ms = _config.latency_budget_ms;
+    if (budget_ms <= 0){
+        double speed = player.get_speed() > 0 ? player.get_speed() : 1.0;
+        budget_ms = _config.chunk_frames / sample_rate / speed * 1000.0;
+    }
+    report.sustained = report.dropped_chunks == 0 && report.failed_streams == 0 && report.p99_ms <= budget_ms;
+
+    VLOG(1) << "[loadGenerator/make_report]: " << report.summary();
+    return report;
+}
+
+
+    } // namespace pipeline
+} // namespace asr
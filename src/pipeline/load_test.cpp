@@ -0,0 +1,115 @@
+#include <iostream>
+#include <filesystem>
+#include <cstdlib>
+#include <ATen/Parallel.h>
+#include "models/torch_script_model.hpp"
+#include "decoders/ctc_decoder.hpp"
+#include "pipeline/load_generator.hpp"
+#include "pipeline/warmup.hpp"
+#include "utils/wav_reader.hpp"
+#include "utils/resampler.hpp"
+
+/*
+Load test: plays num_streams copies of the wav files in data/audio through capture, model and
+decoder at the given speed (0: as fast as possible) and prints latency percentiles, dropped
+chunks and the number of real-time streams a core can carry.
+
+With "ramp" the stream count doubles from 1 up to num_streams and stops at the first run
+that is not sustained.
+*/
+
+namespace fs = std::filesystem;
+using namespace asr;
+
+int main(int argc, char* argv[]){
+
+    if (argc < 5){
+        std::cout << "[main]: pass all arguments: log_verbosity, num_streams, speed, num_workers "
+                  << "[, chunk_seconds, ramp]" << std::endl;
+        return 1;
+    }
+
+    google::InitGoogleLogging(argv[0]);
+    FLAGS_logtostderr = false;
+    FLAGS_v = std::stoi(argv[1]);
+
+    auto project_root_ptr = std::getenv("PROJECT_ROOT");
+    if (!project_root_ptr){
+        std::cerr << "[main]: PROJECT_ROOT environement variable not set.";
+        return 1;
+    }
+    fs::path project_root = fs::path(project_root_ptr);
+    fs::path data_folder  = project_root / "data";
+    fs::path tokens_path  = data_folder  / "dictionary" / "tokens.txt";
+    fs::path model_path   = data_folder  / "models"     / "model.pt";
+    fs::path fst_path     = data_folder  / "lexicon"    / "lexicon_fst.fst";
+
+    pipeline::loadGeneratorConfig config;
+    config.num_streams  = std::stoul(argv[2]);
+    config.player_config.speed = std::stod(argv[3]);
+    config.num_workers  = std::stoul(argv[4]);
+    const uint32_t model_sample_rate = 16000;
+    float chunk_seconds = (argc > 5) ? std::stof(argv[5]) : 1.0f;
+    config.chunk_frames = static_cast<size_t>(chunk_seconds * model_sample_rate);
+    bool ramp = (argc > 6) && std::string(argv[6]) == "ramp";
+
+    // one intra-op thread per forward pass: a worker is a core
+    at::set_num_threads(1);
+
+    torchScriptModel torch_model;
+    if (!torch_model.load_model(model_path)){
+        std::cerr << "[main]: failed to load the model" << std::endl;
+        return 1;
+    }
+
+    // every stream plays one of the files in data/audio
+    std::vector<std::vector<float>> audio_files;
+    for (const auto& entry : fs::directory_iterator(data_folder / "audio")){
+        if (entry.path().extension() != ".wav") continue;
+        audio::wavReader wav_reader(entry.path());
+        if (!wav_reader.is_open()) continue;
+        auto audio_data = wav_reader.read_all();
+        if (wav_reader.get_info().sample_rate != model_sample_rate){
+            audio_data = audio::polyphaseResampler::resample(audio_data, wav_reader.get_info().sample_rate, model_sample_rate);
+        }
+        audio_files.push_back(std::move(audio_data));
+    }
+    std::cout << "[main]: " << audio_files.size() << " audio files" << std::endl;
+
+    // the lexicon is loaded once into the registry, every stream's decoder shares that version
+    beam::resourceRegistry resource_registry;
+    if (!resource_registry.swap_lexicon(fst_path)){
+        std::cerr << "[main]: failed to load the lexicon fst " << fst_path << std::endl;
+        return 1;
+    }
+    ctcDecoder lexicon_owner(tokens_path, 10);
+    lexicon_owner.attach(resource_registry);
+    auto make_decoder = [&tokens_path, &resource_registry](){
+        auto decoder = std::make_unique<ctcDecoder>(tokens_path, 10);
+        decoder->attach(resource_registry);
+        return decoder;
+    };
+
+    pipeline::warmupConfig warmup_config;
+    warmup_config.chunk_sizes = {config.chunk_frames};
+    std::cout << "[main]: warm-up\n" << pipeline::warm_up(torch_model, lexicon_owner, warmup_config).summary() << std::endl;
+
+    size_t max_streams      = config.num_streams;
+    size_t num_streams      = ramp ? 1 : max_streams;
+    size_t last_sustained   = 0;
+    while (num_streams <= max_streams){
+        config.num_streams = num_streams;
+        pipeline::loadGenerator load_generator(torch_model, make_decoder, config);
+        auto report = load_generator.run(audio_files, model_sample_rate);
+        std::cout << "------------------------------------\n" << report.summary() << std::endl;
+
+        if (!ramp) break;
+        if (!report.sustained) break;
+        last_sustained = num_streams;
+        num_streams   *= 2;
+    }
+    if (ramp){
+        std::cout << "[main]: largest sustained run: " << last_sustained << " streams on "
+                  << config.num_workers << " workers" << std::endl;
+    }
+}
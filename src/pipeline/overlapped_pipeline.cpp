@@ -0,0 +1,323 @@
+#include "pipeline/overlapped_pipeline.hpp"
+#include <glog/logging.h>
+
+
+namespace asr{
+    namespace pipeline{
+
+
+namespace {
+    // yield the core for the first tries, then sleep. stages stay lock-free, waiting only costs latency
+    void backoff(size_t& spins){
+        if (++spins < 64){
+            std::this_thread::yield();
+        }
+        else{
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+
+    // false when the pipeline failed before the item went in (the item is dropped)
+    template <typename T>
+    bool push_blocking(spscQueue<T>& queue, T&& item, std::atomic<size_t>& stalls, const std::atomic<bool>& failed){
+        if (queue.try_push(std::move(item))) return true; // item is only moved on success
+        stalls.fetch_add(1, std::memory_order_relaxed);
+        size_t spins = 0;
+        while (!queue.try_push(std::move(item))){
+            if (failed.load(std::memory_order_acquire)) return false;
+            backoff(spins);
+        }
+        return true;
+    }
+
+    // false when the pipeline failed while the queue was empty
+    template <typename T>
+    bool pop_blocking(spscQueue<T>& queue, T& item, std::atomic<size_t>* stalls, const std::atomic<bool>& failed){
+        if (queue.try_pop(item)) return true;
+        if (stalls) stalls->fetch_add(1, std::memory_order_relaxed);
+        size_t spins = 0;
+        while (!queue.try_pop(item)){
+            if (failed.load(std::memory_order_acquire)) return false;
+            backoff(spins);
+        }
+        return true;
+    }
+
+    uint64_t elapsed_us(std::chrono::steady_clock::time_point start){
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+} // namespace
+
+
+
+overlappedPipeline::overlappedPipeline(torchScriptModel& model, ctcDecoder& decoder, pipelineConfig config) :
+    _model(model), _decoder(decoder), _config(config),
+    _audio_queue(config.queue_capacity), _emission_queue(config.queue_capacity){
+    if (_config.input_sample_rate != _config.model_sample_rate){
+        _resampler = std::make_unique<audio::polyphaseResampler>(_config.input_sample_rate, _config.model_sample_rate);
+    }
+    if (_config.use_vad){
+        _config.vad_config.sample_rate = _config.model_sample_rate;
+        _vad = std::make_unique<audio::energyVad>(_config.vad_config);
+    }
+    DLOG(INFO) << "[overlappedPipeline/constructor]: instance created. chunk size: " << _config.chunk_size
+               << ", queue capacity: " << _config.queue_capacity;
+}
+
+
+overlappedPipeline::~overlappedPipeline(){
+    if (_running){
+        try{
+            finish();
+        }
+        catch (const std::exception& e){
+            LOG(ERROR) << "[overlappedPipeline/destructor]: pipeline failed: " << e.what();
+        }
+    }
+    DLOG(INFO) << "[overlappedPipeline/destructor]: instance destroyed";
+}
+
+
+void overlappedPipeline::start(){
+    if (_running){
+        LOG(WARNING) << "[overlappedPipeline/start]: pipeline is already running";
+        return;
+    }
+    _next_chunk_index = 0;
+    if (_resampler) _resampler->reset();
+    if (_vad) _vad->reset();
+    _segments.clear();
+    _segment_chunks   = 0;
+    _error            = nullptr;
+    _failed.store(false, std::memory_order_release);
+    _start_time       = clock::now();
+    _running          = true;
+    _model_thread     = std::thread(&overlappedPipeline::model_loop, this);
+    _decoder_thread   = std::thread(&overlappedPipeline::decoder_loop, this);
+}
+
+
+void overlappedPipeline::push_audio(std::vector<float> samples){
+    if (!_running){
+        LOG(WARNING) << "[overlappedPipeline/push_audio]: pipeline is not running. dropping "
+                     << samples.size() << " samples";
+        return;
+    }
+    if (_resampler){
+        samples = _resampler->process(samples);
+    }
+    forward(std::move(samples));
+}
+
+
+void overlappedPipeline::forward(std::vector<float> samples){
+    if (samples.empty()) return;
+    _samples_in.fetch_add(samples.size(), std::memory_order_relaxed);
+    if (!_vad){
+        push_chunk(std::move(samples), false);
+        return;
+    }
+
+    // only speech goes on. a chunk can be a bare end-of-segment marker
+    _vad_output.clear();
+    _vad->process(samples.data(), samples.size(), _vad_output);
+    for (auto& vad_chunk : _vad_output){
+        push_chunk(std::move(vad_chunk.samples), vad_chunk.end_of_segment);
+    }
+}
+
+
+void overlappedPipeline::push_chunk(std::vector<float> samples, bool end_of_segment){
+    if (samples.empty() && !end_of_segment) return;
+    _samples_forwarded.fetch_add(samples.size(), std::memory_order_relaxed);
+
+    audioChunk chunk;
+    chunk.samples        = std::move(samples);
+    chunk.chunk_index    = _next_chunk_index++;
+    chunk.end_of_segment = end_of_segment;
+    if (!push_blocking(_audio_queue, std::move(chunk), _producer_stalls, _failed)){
+        DLOG(WARNING) << "[overlappedPipeline/push_chunk]: pipeline failed. dropping chunk " << chunk.chunk_index;
+    }
+}
+
+
+std::vector<beam::ctcBeam*> overlappedPipeline::finish(){
+    if (!_running){
+        return _decoder.get_top_beams();
+    }
+
+    // the samples held back by the resampler filter go out as the last chunk
+    if (_resampler){
+        std::vector<float> tail;
+        _resampler->flush(tail);
+        forward(std::move(tail));
+    }
+
+    // an open vad segment is closed by the end marker below, so its beams stay in the decoder
+    if (_vad){
+        _vad_output.clear();
+        _vad->flush(_vad_output);
+        if (!_vad_output.empty()) _vad_output.back().end_of_segment = false;
+        for (auto& vad_chunk : _vad_output){
+            push_chunk(std::move(vad_chunk.samples), vad_chunk.end_of_segment);
+        }
+    }
+
+    // the end marker flows through both stages, so every chunk before it gets decoded
+    audioChunk end_chunk;
+    end_chunk.chunk_index   = _next_chunk_index;
+    end_chunk.end_of_stream = true;
+    push_blocking(_audio_queue, std::move(end_chunk), _producer_stalls, _failed);
+
+    _model_thread.join();
+    _decoder_thread.join();
+    _running = false;
+    _wall_ms = elapsed_us(_start_time) / 1000.0;
+
+    if (_error){
+        std::exception_ptr error = std::move(_error);
+        _error = nullptr;
+        std::rethrow_exception(error);
+    }
+
+    VLOG(2) << "[overlappedPipeline/finish]: decoded " << _num_chunks.load() << " chunks in " << _wall_ms << " ms";
+    return _decoder.get_top_beams();
+}
+
+
+std::vector<beam::ctcBeam*> overlappedPipeline::run(const std::vector<float>& audio_data){
+    start();
+    for (size_t begin = 0; begin < audio_data.size(); begin += _config.chunk_size){
+        size_t end = std::min(begin + _config.chunk_size, audio_data.size());
+        push_audio(std::vector<float>(audio_data.begin() + begin, audio_data.begin() + end));
+    }
+    return finish();
+}
+
+
+void overlappedPipeline::model_loop(){
+    try{
+        while (true){
+            audioChunk chunk;
+            if (!pop_blocking(_audio_queue, chunk, nullptr, _failed)) break;
+
+            emissionChunk output;
+            output.chunk_index    = chunk.chunk_index;
+            output.end_of_segment = chunk.end_of_segment;
+            output.end_of_stream  = chunk.end_of_stream;
+            if (!chunk.end_of_stream && !chunk.samples.empty()){
+                auto start_time = clock::now();
+                bool has_emissions = false;
+                if (_config.use_sparse_emissions){
+                    auto sparse_emissions = _model.pass_forward_sparse(chunk.samples, _config.sparse_config);
+                    if ((has_emissions = sparse_emissions.has_value())) output.sparse_emissions = std::move(sparse_emissions.value());
+                }
+                else{
+                    auto emissions = _model.pass_forward(chunk.samples);
+                    if ((has_emissions = emissions.has_value())) output.emissions = emissions.value();
+                }
+                _model_busy_us.fetch_add(elapsed_us(start_time), std::memory_order_relaxed);
+                if (!has_emissions){
+                    LOG(WARNING) << "[overlappedPipeline/model_loop]: model returned no emissions for chunk "
+                                 << chunk.chunk_index << ". skipping it";
+                    if (!chunk.end_of_segment) continue; // the segment marker still has to reach the decoder
+                }
+            }
+
+            if (!push_blocking(_emission_queue, std::move(output), _model_stalls, _failed)) break;
+            if (chunk.end_of_stream) break;
+        }
+    }
+    catch (...){
+        fail("model_loop", std::current_exception());
+    }
+}
+
+
+void overlappedPipeline::decoder_loop(){
+    try{
+        while (true){
+            emissionChunk chunk;
+            if (!pop_blocking(_emission_queue, chunk, &_decoder_stalls, _failed)) break;
+            if (chunk.end_of_stream){
+                if (_vad) finalize_segment(false); // finish() returns its beams
+                break;
+            }
+
+            bool has_emissions = _config.use_sparse_emissions ? !chunk.sparse_emissions.empty()
+                                                              : chunk.emissions.defined();
+            if (has_emissions){
+                auto start_time = clock::now();
+                if (_config.use_sparse_emissions){
+                    _decoder.decode_sparse(chunk.sparse_emissions);
+                }
+                else{
+                    _decoder.decode_chunk(chunk.emissions);
+                }
+                _decoder_busy_us.fetch_add(elapsed_us(start_time), std::memory_order_relaxed);
+                _num_chunks.fetch_add(1, std::memory_order_relaxed);
+                ++_segment_chunks;
+                VLOG(3) << "[overlappedPipeline/decoder_loop]: decoded chunk " << chunk.chunk_index;
+            }
+            if (chunk.end_of_segment){
+                finalize_segment(true);
+            }
+        }
+    }
+    catch (...){
+        fail("decoder_loop", std::current_exception());
+    }
+}
+
+
+void overlappedPipeline::finalize_segment(bool reset_decoder){
+    if (_segment_chunks == 0) return;
+    auto top_beams = _decoder.get_top_beams();
+    if (!top_beams.empty()){
+        _segments.push_back(top_beams.front()->get_sequence());
+    }
+    _num_segments.fetch_add(1, std::memory_order_relaxed);
+    _segment_chunks = 0;
+    VLOG(2) << "[overlappedPipeline/finalize_segment]: segment " << _segments.size() << ": "
+            << (_segments.empty() ? "" : _segments.back());
+    if (reset_decoder) _decoder.reset();
+}
+
+
+void overlappedPipeline::fail(const char* stage, std::exception_ptr error){
+    {
+        std::lock_guard<std::mutex> lock(_error_mutex);
+        if (!_error) _error = error;
+    }
+    _failed.store(true, std::memory_order_release);
+    try{
+        std::rethrow_exception(error);
+    }
+    catch (const std::exception& e){
+        LOG(ERROR) << "[overlappedPipeline/" << stage << "]: " << e.what() << ". stopping the pipeline";
+    }
+    catch (...){
+        LOG(ERROR) << "[overlappedPipeline/" << stage << "]: unknown exception. stopping the pipeline";
+    }
+}
+
+
+pipelineStats overlappedPipeline::get_stats() const {
+    pipelineStats stats;
+    stats.num_chunks      = _num_chunks.load(std::memory_order_relaxed);
+    stats.model_busy_ms   = _model_busy_us.load(std::memory_order_relaxed) / 1000.0;
+    stats.decoder_busy_ms = _decoder_busy_us.load(std::memory_order_relaxed) / 1000.0;
+    stats.wall_ms         = _running ? elapsed_us(_start_time) / 1000.0 : _wall_ms;
+    stats.producer_stalls = _producer_stalls.load(std::memory_order_relaxed);
+    stats.model_stalls    = _model_stalls.load(std::memory_order_relaxed);
+    stats.decoder_stalls  = _decoder_stalls.load(std::memory_order_relaxed);
+    stats.samples_in        = _samples_in.load(std::memory_order_relaxed);
+    stats.samples_forwarded = _samples_forwarded.load(std::memory_order_relaxed);
+    stats.num_segments      = _num_segments.load(std::memory_order_relaxed);
+    return stats;
+}
+
+
+    } // namespace pipeline
+} // namespace asr
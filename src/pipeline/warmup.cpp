@@ -0,0 +1,126 @@
+#include "pipeline/warmup.hpp"
+#include <glog/logging.h>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+
+
+namespace asr{
+    namespace pipeline{
+
+
+namespace {
+    typedef std::chrono::steady_clock clock;
+
+    double elapsed_ms(clock::time_point start){
+        return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    }
+
+    // low level noise rather than silence, so the model does not take a degenerate path
+    std::vector<float> synthetic_audio(size_t num_samples){
+        std::vector<float> audio(num_samples);
+        for (size_t i = 0; i < num_samples; ++i){
+            audio[i] = 0.01f * std::sin(0.05f * i) + 0.005f * std::sin(0.31f * i);
+        }
+        return audio;
+    }
+
+    // blank dominated frames that cycle through every other token, so all the expansion paths run
+    std::vector<float> synthetic_emissions(size_t num_frames, size_t num_tokens, size_t blank_index){
+        std::vector<float> log_probs(num_frames * num_tokens, -8.0f);
+        for (size_t t = 0; t < num_frames; ++t){
+            float* frame = log_probs.data() + t * num_tokens;
+            size_t token = t % (num_tokens - 1);
+            frame[blank_index] = -0.3f;
+            frame[token < blank_index ? token : token + 1] = -1.5f; // skips the blank
+        }
+        return log_probs;
+    }
+} // namespace
+
+
+
+bool warmupReport::ok() const {
+    for (const auto& step : steps){
+        if (!step.ok) return false;
+    }
+    return true;
+}
+
+
+std::string warmupReport::summary() const {
+    std::ostringstream oss;
+    for (const auto& step : steps){
+        oss << step.name << ": " << step.ms << " ms (" << step.work << ")"
+            << (step.ok ? "" : " FAILED") << "\n";
+    }
+    oss << "total: " << total_ms << " ms";
+    return oss.str();
+}
+
+
+warmupReport warm_up(torchScriptModel& model, ctcDecoder& decoder, const warmupConfig& config){
+    warmupReport report;
+    auto warmup_start = clock::now();
+
+    // 1- acoustic model, once per chunk size (the jit specializes on input shapes)
+    for (size_t chunk_size : config.chunk_sizes){
+        warmupStep step;
+        step.name = "forward_" + std::to_string(chunk_size);
+        auto audio = synthetic_audio(chunk_size);
+        auto start_time = clock::now();
+        for (size_t run = 0; run < config.forward_runs && step.ok; ++run){
+            step.ok = model.pass_forward(audio).has_value();
+            step.work += step.ok;
+        }
+        step.ms = elapsed_ms(start_time);
+        report.steps.push_back(step);
+    }
+
+    // 2- shared decoding resources
+    if (config.prefault_lexicon){
+        warmupStep step;
+        step.name = "prefault_lexicon";
+        auto start_time = clock::now();
+        step.work = decoder.prefault_lexicon();
+        step.ms   = elapsed_ms(start_time);
+        step.ok   = step.work > 0;
+        report.steps.push_back(step);
+    }
+    if (config.prefault_lm){
+        warmupStep step;
+        step.name = "prefault_lm";
+        auto start_time = clock::now();
+        step.work = decoder.prefault_lm();
+        step.ms   = elapsed_ms(start_time);
+        report.steps.push_back(step);
+    }
+
+    // 3- a synthetic decode, then back to a clean state
+    int blank_index = decoder.get_blank_index();
+    if (config.decode_frames > 0 && blank_index < 0){
+        LOG(WARNING) << "[pipeline/warm_up]: the blank token is not in the decoder's tokens. skipping the synthetic decode";
+    }
+    else if (config.decode_frames > 0 && decoder.get_num_tokens() > 1){
+        warmupStep step;
+        step.name = "synthetic_decode";
+        auto log_probs  = synthetic_emissions(config.decode_frames, decoder.get_num_tokens(), blank_index);
+        auto start_time = clock::now();
+        decoder.decode_log_probs(log_probs.data(), config.decode_frames);
+        decoder.reset();
+        step.ms   = elapsed_ms(start_time);
+        step.work = config.decode_frames;
+        report.steps.push_back(step);
+    }
+
+    report.total_ms = elapsed_ms(warmup_start);
+    LOG(INFO) << "[pipeline/warm_up]: warm-up done in " << report.total_ms << " ms\n" << report.summary();
+    if (!report.ok()){
+        LOG(WARNING) << "[pipeline/warm_up]: some warm-up steps failed";
+    }
+    return report;
+}
+
+
+    } // namespace pipeline
+} // namespace asr
@@ -0,0 +1,384 @@
+#include "utils/audio_source.hpp"
+#include <glog/logging.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+
+namespace asr{
+    namespace audio{
+
+
+namespace {
+    constexpr double PI = 3.14159265358979323846;
+
+    template <typename T>
+    int to_iovec(ringView<T> view, size_t skip_bytes, iovec* iov){
+        int count = 0;
+        if (view.first.size > 0){
+            iov[count].iov_base = reinterpret_cast<uint8_t*>(view.first.data) + skip_bytes;
+            iov[count].iov_len  = view.first.size * sizeof(T) - skip_bytes;
+            ++count;
+        }
+        if (view.second.size > 0){
+            iov[count].iov_base = view.second.data;
+            iov[count].iov_len  = view.second.size * sizeof(T);
+            ++count;
+        }
+        return count;
+    }
+} // namespace
+
+
+
+/* pacedSource */
+
+pacedSource::pacedSource(sourceConfig config) : _config(config){
+    if (_config.frames_per_buffer == 0){
+        LOG(WARNING) << "[pacedSource/constructor]: frames_per_buffer is 0. using 160";
+        _config.frames_per_buffer = 160;
+    }
+    if (_config.speed < 0){
+        LOG(WARNING) << "[pacedSource/constructor]: negative speed. delivering as fast as possible";
+        _config.speed = 0;
+    }
+}
+
+
+pacedSource::~pacedSource(){
+    // the derived destructors stop the thread before their state goes away
+    stop();
+}
+
+
+void pacedSource::make_sink(double sample_rate, captureSampleFormat format){
+    size_t capacity = std::max(static_cast<size_t>(_config.buffer_seconds * sample_rate), _config.frames_per_buffer);
+    _capture_sink   = std::make_unique<captureSink>(sample_rate, capacity, format);
+}
+
+
+bool pacedSource::start(){
+    if (_running){
+        LOG(WARNING) << "[pacedSource/start]: " << get_name() << " is already running";
+        return false;
+    }
+    if (!_capture_sink || !rewind()){
+        LOG(WARNING) << "[pacedSource/start]: " << get_name() << " can not be started";
+        return false;
+    }
+    _frames_delivered = 0;
+    _at_end     = false;
+    _start_time = clock::now();
+    _running    = true;
+    if (_config.speed > 0){
+        _thread = std::thread(&pacedSource::paced_loop, this);
+    }
+    else{
+        _thread = std::thread(&pacedSource::as_fast_as_possible_loop, this);
+    }
+    return true;
+}
+
+
+void pacedSource::stop(){
+    _running = false;
+    if (_thread.joinable()) _thread.join();
+}
+
+
+double pacedSource::get_elapsed() const {
+    return std::chrono::duration<double>(clock::now() - _start_time).count();
+}
+
+
+void pacedSource::paced_loop(){
+    double sample_rate = _capture_sink->get_sample_rate();
+    while (_running.load(std::memory_order_relaxed)){
+        // a callback fires once its whole buffer has been "recorded"
+        double due = (_frames_delivered + _config.frames_per_buffer) / sample_rate / _config.speed;
+        std::this_thread::sleep_until(_start_time + std::chrono::duration_cast<clock::duration>(
+                                                     std::chrono::duration<double>(due)));
+        size_t num_frames = deliver(_config.frames_per_buffer, _frames_delivered / sample_rate,
+                                    get_elapsed() * _config.speed);
+        _frames_delivered += num_frames;
+        if (num_frames < _config.frames_per_buffer) break;
+    }
+    _at_end.store(_running.load(), std::memory_order_release);
+    VLOG(2) << "[pacedSource/paced_loop]: " << get_name() << ": " << _frames_delivered << " frames delivered";
+}
+
+
+void pacedSource::as_fast_as_possible_loop(){
+    double sample_rate = _capture_sink->get_sample_rate();
+    double buffer_period = _config.frames_per_buffer / sample_rate;
+    while (_running.load(std::memory_order_relaxed)){
+        // back-pressure instead of drops: only write when the whole buffer fits
+        if (_capture_sink->get_capacity() - _capture_sink->get_available() < _config.frames_per_buffer){
+            std::this_thread::yield();
+            continue;
+        }
+        double adc_time   = _frames_delivered / sample_rate;
+        size_t num_frames = deliver(_config.frames_per_buffer, adc_time, adc_time + buffer_period);
+        _frames_delivered += num_frames;
+        if (num_frames < _config.frames_per_buffer) break;
+    }
+    _at_end.store(_running.load(), std::memory_order_release);
+    VLOG(2) << "[pacedSource/as_fast_as_possible_loop]: " << get_name() << ": " << _frames_delivered << " frames delivered";
+}
+
+
+
+/* fileSource */
+
+fileSource::fileSource(const fs::path& path, sourceConfig config, rawPcmFormat raw_format) :
+    pacedSource(config), _path(path), _raw_format(raw_format){
+    _is_wav = path.extension() == ".wav" || path.extension() == ".WAV";
+    if (_is_wav){
+        if (!_wav_reader.open(path)) return;
+        _buffer.resize(_config.frames_per_buffer);
+        make_sink(_wav_reader.get_info().sample_rate, CAPTURE_FLOAT32);
+    }
+    else{
+        if (!map_raw()) return;
+        // raw frames reach the ring in their own format, as a device callback would deliver them
+        make_sink(_raw_format.sample_rate, _raw_format.format);
+    }
+    DLOG(INFO) << "[fileSource/constructor]: " << path << ": " << get_num_frames() << " frames at "
+               << get_sample_rate() << " Hz";
+}
+
+
+fileSource::~fileSource(){
+    stop();
+    if (_mapped){
+        munmap(const_cast<uint8_t*>(_mapped), _mapped_size);
+    }
+}
+
+
+double fileSource::get_sample_rate() const {
+    return _is_wav ? _wav_reader.get_info().sample_rate : _raw_format.sample_rate;
+}
+
+
+bool fileSource::map_raw(){
+    int fd = ::open(_path.c_str(), O_RDONLY);
+    if (fd < 0){
+        LOG(WARNING) << "[fileSource/map_raw]: failed to open " << _path;
+        return false;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0){
+        LOG(WARNING) << "[fileSource/map_raw]: " << _path << " is empty";
+        ::close(fd);
+        return false;
+    }
+    size_t file_size = static_cast<size_t>(file_stat.st_size);
+    void* mapped = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED){
+        LOG(WARNING) << "[fileSource/map_raw]: failed to map " << _path;
+        return false;
+    }
+    madvise(mapped, file_size, MADV_SEQUENTIAL);
+
+    size_t bytes_per_frame = _raw_format.format == CAPTURE_INT16 ? sizeof(int16_t) : sizeof(float);
+    if (file_size % bytes_per_frame != 0){
+        LOG(WARNING) << "[fileSource/map_raw]: " << _path << " ends with a partial sample, ignored";
+    }
+    _mapped      = static_cast<const uint8_t*>(mapped);
+    _mapped_size = file_size;
+    _num_frames  = file_size / bytes_per_frame;
+    return true;
+}
+
+
+bool fileSource::rewind(){
+    _position = 0;
+    return _is_wav ? _wav_reader.seek(0) : _mapped != nullptr;
+}
+
+
+size_t fileSource::deliver(size_t max_frames, double adc_time, double callback_time){
+    if (_is_wav){
+        size_t num_frames = _wav_reader.read(_buffer.data(), std::min(max_frames, _buffer.size()));
+        if (num_frames > 0){
+            _capture_sink->on_audio(_buffer.data(), num_frames, adc_time, callback_time, false, false);
+        }
+        return num_frames;
+    }
+
+    // the mapping is page aligned, so the samples can be handed over in place
+    size_t num_frames = std::min(max_frames, _num_frames - _position);
+    if (num_frames > 0){
+        if (_raw_format.format == CAPTURE_INT16){
+            _capture_sink->on_audio(reinterpret_cast<const int16_t*>(_mapped) + _position, num_frames,
+                                    adc_time, callback_time, false, false);
+        }
+        else{
+            _capture_sink->on_audio(reinterpret_cast<const float*>(_mapped) + _position, num_frames,
+                                    adc_time, callback_time, false, false);
+        }
+        _position += num_frames;
+    }
+    return num_frames;
+}
+
+
+
+/* syntheticSource */
+
+syntheticSource::syntheticSource(syntheticConfig synthetic_config, sourceConfig config) :
+    pacedSource(config), _synthetic_config(synthetic_config), _generator(synthetic_config.seed){
+    _num_frames = static_cast<size_t>(_synthetic_config.duration_seconds * _synthetic_config.sample_rate);
+    _buffer.resize(_config.frames_per_buffer);
+    make_sink(_synthetic_config.sample_rate, CAPTURE_FLOAT32);
+}
+
+
+syntheticSource::~syntheticSource(){
+    stop();
+}
+
+
+bool syntheticSource::rewind(){
+    _position = 0;
+    _generator.seed(_synthetic_config.seed);
+    return true;
+}
+
+
+void syntheticSource::generate(float* out, size_t frame, size_t num_frames){
+    double step = 2.0 * PI * _synthetic_config.frequency / _synthetic_config.sample_rate;
+    std::uniform_real_distribution<float> noise(-_synthetic_config.noise_amplitude, _synthetic_config.noise_amplitude);
+    for (size_t i = 0; i < num_frames; ++i){
+        // the phase is computed from the frame index, so long runs do not drift
+        out[i] = _synthetic_config.amplitude * static_cast<float>(std::sin(step * (frame + i)));
+        if (_synthetic_config.noise_amplitude > 0) out[i] += noise(_generator);
+    }
+}
+
+
+size_t syntheticSource::deliver(size_t max_frames, double adc_time, double callback_time){
+    size_t num_frames = std::min(max_frames, _buffer.size());
+    if (_num_frames > 0) num_frames = std::min(num_frames, _num_frames - _position);
+    if (num_frames == 0) return 0;
+
+    generate(_buffer.data(), _position, num_frames);
+    _capture_sink->on_audio(_buffer.data(), num_frames, adc_time, callback_time, false, false);
+    _position += num_frames;
+    return num_frames;
+}
+
+
+
+/* fdSource */
+
+fdSource::fdSource(int fd, double sample_rate, captureSampleFormat format, sourceConfig config, bool own_fd) :
+    _fd(fd), _own_fd(own_fd), _sample_rate(sample_rate), _config(config){
+    size_t capacity = std::max(static_cast<size_t>(_config.buffer_seconds * sample_rate), _config.frames_per_buffer);
+    _capture_sink   = std::make_unique<captureSink>(sample_rate, capacity, format);
+    DLOG(INFO) << "[fdSource/constructor]: instance created for fd " << fd;
+}
+
+
+fdSource::~fdSource(){
+    stop();
+    if (_own_fd && _fd >= 0){
+        ::close(_fd);
+    }
+}
+
+
+bool fdSource::start(){
+    if (_running){
+        LOG(WARNING) << "[fdSource/start]: " << get_name() << " is already running";
+        return false;
+    }
+    if (_fd < 0 || _at_end){
+        LOG(WARNING) << "[fdSource/start]: " << get_name() << " is closed";
+        return false;
+    }
+    _start_time = std::chrono::steady_clock::now();
+    _running    = true;
+    _thread     = std::thread(&fdSource::read_loop, this);
+    return true;
+}
+
+
+void fdSource::stop(){
+    _running = false;
+    if (_thread.joinable()) _thread.join();
+}
+
+
+void fdSource::read_loop(){
+    while (_running.load(std::memory_order_relaxed)){
+        if (!read_once()){
+            _at_end.store(true, std::memory_order_release);
+            break;
+        }
+    }
+    VLOG(2) << "[fdSource/read_loop]: " << get_name() << ": " << _frames_read << " frames read";
+}
+
+
+bool fdSource::read_once(){
+    // poll first, so stop() is noticed even when the writer is silent
+    pollfd poll_fd{_fd, POLLIN, 0};
+    int ready = poll(&poll_fd, 1, POLL_TIMEOUT_MS);
+    if (ready < 0) return errno == EINTR;
+    if (ready == 0) return true;
+
+    // the bytes go straight into the free part of the ring. a sample split across two reads
+    // stays in front of the write position until its remaining bytes arrive
+    iovec iov[2];
+    int iov_count = 0;
+    size_t free_frames = _capture_sink->get_capacity();
+    if (_capture_sink->get_format() == CAPTURE_INT16){
+        iov_count = to_iovec(_capture_sink->prepare_write_int16(free_frames), _partial_bytes, iov);
+    }
+    else{
+        iov_count = to_iovec(_capture_sink->prepare_write_float(free_frames), _partial_bytes, iov);
+    }
+    if (iov_count == 0){
+        // back-pressure: the writer blocks on the full pipe instead of losing audio here
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return true;
+    }
+
+    ssize_t bytes_read = readv(_fd, iov, iov_count);
+    if (bytes_read == 0){
+        if (_partial_bytes > 0){
+            LOG(WARNING) << "[fdSource/read_once]: " << get_name() << " closed in the middle of a sample";
+        }
+        return false;
+    }
+    if (bytes_read < 0){
+        if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) return true;
+        LOG(WARNING) << "[fdSource/read_once]: " << get_name() << ": " << std::strerror(errno);
+        return false;
+    }
+
+    size_t bytes_per_frame = _capture_sink->get_bytes_per_frame();
+    size_t total_bytes = _partial_bytes + static_cast<size_t>(bytes_read);
+    size_t num_frames  = total_bytes / bytes_per_frame;
+    _partial_bytes     = total_bytes % bytes_per_frame;
+    if (num_frames > 0){
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start_time).count();
+        _capture_sink->commit(num_frames, _frames_read / _sample_rate, elapsed);
+        _frames_read += num_frames;
+    }
+    return true;
+}
+
+
+    } // namespace audio
+} // namespace asr
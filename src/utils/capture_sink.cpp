@@ -0,0 +1,250 @@
+#include "utils/capture_sink.hpp"
+#include "utils/simd_kernels.hpp"
+#include <thread>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+
+namespace asr{
+    namespace audio{
+
+
+namespace {
+    constexpr size_t CONVERSION_BLOCK = 256; // frames converted on the stack when the formats differ
+}
+
+
+captureSink::captureSink(double sample_rate, size_t capacity_frames, captureSampleFormat format) :
+    _format(format), _sample_rate(sample_rate){
+    if (_format == CAPTURE_INT16){
+        _int16_ring = std::make_unique<spscRingBuffer<int16_t>>(capacity_frames);
+    }
+    else{
+        _float_ring = std::make_unique<spscRingBuffer<float>>(capacity_frames);
+    }
+}
+
+
+void captureSink::on_audio(const float* input,
+                           size_t num_frames,
+                           double adc_time,
+                           double callback_time,
+                           bool input_overflow,
+                           bool input_underflow){
+    // runs on the audio thread: keep it to copies and relaxed atomics
+    record_timing(num_frames, adc_time, callback_time, input_overflow, input_underflow);
+    if (!input) return; // output-only stream, nothing to capture
+    size_t written = _float_ring ? _float_ring->write(input, num_frames) : write_converted(input, num_frames);
+    _frames_captured.fetch_add(written, std::memory_order_relaxed);
+}
+
+
+void captureSink::on_audio(const int16_t* input,
+                           size_t num_frames,
+                           double adc_time,
+                           double callback_time,
+                           bool input_overflow,
+                           bool input_underflow){
+    record_timing(num_frames, adc_time, callback_time, input_overflow, input_underflow);
+    if (!input) return;
+    size_t written = _int16_ring ? _int16_ring->write(input, num_frames) : write_converted(input, num_frames);
+    _frames_captured.fetch_add(written, std::memory_order_relaxed);
+}
+
+
+ringView<float> captureSink::prepare_write_float(size_t max_frames){
+    return _float_ring ? _float_ring->prepare_write(max_frames) : ringView<float>{};
+}
+
+
+ringView<int16_t> captureSink::prepare_write_int16(size_t max_frames){
+    return _int16_ring ? _int16_ring->prepare_write(max_frames) : ringView<int16_t>{};
+}
+
+
+void captureSink::commit(size_t num_frames, double adc_time, double callback_time){
+    record_timing(num_frames, adc_time, callback_time, false, false);
+    if (_float_ring) _float_ring->commit(num_frames);
+    else _int16_ring->commit(num_frames);
+    _frames_captured.fetch_add(num_frames, std::memory_order_relaxed);
+}
+
+
+size_t captureSink::write_converted(const float* input, size_t num_frames){
+    int16_t block[CONVERSION_BLOCK];
+    size_t written = 0;
+    for (size_t begin = 0; begin < num_frames; begin += CONVERSION_BLOCK){
+        size_t size = std::min(CONVERSION_BLOCK, num_frames - begin);
+        for (size_t i = 0; i < size; ++i){
+            float sample = std::min(1.0f, std::max(-1.0f, input[begin + i]));
+            block[i] = static_cast<int16_t>(std::lrint(sample * 32767.0f));
+        }
+        written += _int16_ring->write(block, size);
+    }
+    return written;
+}
+
+
+size_t captureSink::write_converted(const int16_t* input, size_t num_frames){
+    float block[CONVERSION_BLOCK];
+    size_t written = 0;
+    for (size_t begin = 0; begin < num_frames; begin += CONVERSION_BLOCK){
+        size_t size = std::min(CONVERSION_BLOCK, num_frames - begin);
+        simd::pcm16_to_float(input + begin, block, size);
+        written += _float_ring->write(block, size);
+    }
+    return written;
+}
+
+
+void captureSink::record_timing(size_t num_frames,
+                                double adc_time,
+                                double callback_time,
+                                bool input_overflow,
+                                bool input_underflow){
+    _num_callbacks.fetch_add(1, std::memory_order_relaxed);
+    if (input_overflow)  _input_overflows.fetch_add(1, std::memory_order_relaxed);
+    if (input_underflow) _input_underflows.fetch_add(1, std::memory_order_relaxed);
+
+    if (_expected_adc_time < 0){
+        _first_adc_time.store(adc_time, std::memory_order_relaxed);
+    }
+    else if (std::abs(adc_time - _expected_adc_time) * _sample_rate > num_frames){
+        _discontinuities.fetch_add(1, std::memory_order_relaxed);
+    }
+    _expected_adc_time = adc_time + num_frames / _sample_rate;
+    _last_adc_time.store(adc_time, std::memory_order_relaxed);
+
+    double latency = callback_time - adc_time;
+    if (latency > _max_callback_latency.load(std::memory_order_relaxed)){
+        _max_callback_latency.store(latency, std::memory_order_relaxed);
+    }
+}
+
+
+size_t captureSink::read(float* out, size_t max_frames){
+    if (_float_ring) return _float_ring->read(out, max_frames);
+
+    // convert straight out of the ring (both segments of the wrap), no staging copy
+    auto view = _int16_ring->peek(max_frames);
+    simd::pcm16_to_float(view.first.data, out, view.first.size);
+    simd::pcm16_to_float(view.second.data, out + view.first.size, view.second.size);
+    _int16_ring->consume(view.size());
+    return view.size();
+}
+
+
+size_t captureSink::read(std::vector<float>& out, size_t max_frames){
+    out.resize(max_frames);
+    out.resize(read(out.data(), max_frames));
+    return out.size();
+}
+
+
+bool captureSink::wait_for(size_t min_frames, std::chrono::milliseconds timeout) const {
+    // the callback never signals (that would need a lock or a syscall), the consumer polls
+    auto deadline    = std::chrono::steady_clock::now() + timeout;
+    auto poll_period = std::chrono::microseconds(static_cast<int64_t>(std::max<double>(100, 0.25e6 * min_frames / _sample_rate)));
+    while (get_available() < min_frames){
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(poll_period);
+    }
+    return true;
+}
+
+
+size_t captureSink::get_available() const {
+    return _float_ring ? _float_ring->size() : _int16_ring->size();
+}
+
+
+size_t captureSink::get_capacity() const {
+    return _float_ring ? _float_ring->capacity() : _int16_ring->capacity();
+}
+
+
+captureStats captureSink::get_stats() const {
+    captureStats stats;
+    stats.num_callbacks        = _num_callbacks.load(std::memory_order_relaxed);
+    stats.frames_captured      = _frames_captured.load(std::memory_order_relaxed);
+    stats.frames_dropped       = _float_ring ? _float_ring->get_overflow_count() : _int16_ring->get_overflow_count();
+    stats.input_overflows      = _input_overflows.load(std::memory_order_relaxed);
+    stats.input_underflows     = _input_underflows.load(std::memory_order_relaxed);
+    stats.discontinuities      = _discontinuities.load(std::memory_order_relaxed);
+    stats.first_adc_time       = _first_adc_time.load(std::memory_order_relaxed);
+    stats.last_adc_time        = _last_adc_time.load(std::memory_order_relaxed);
+    stats.max_callback_latency = _max_callback_latency.load(std::memory_order_relaxed);
+    return stats;
+}
+
+
+multiChannelCaptureSink::multiChannelCaptureSink(double sample_rate,
+                                                 size_t capacity_frames,
+                                                 size_t num_channels,
+                                                 captureSampleFormat format) :
+    _format(format), _sample_rate(sample_rate){
+    if (num_channels == 0 || num_channels > MAX_CHANNELS){
+        throw std::runtime_error("multiChannelCaptureSink supports 1 to " + std::to_string(MAX_CHANNELS) + " channels");
+    }
+    for (size_t c = 0; c < num_channels; ++c){
+        _channels.push_back(std::make_unique<captureSink>(sample_rate, capacity_frames, format));
+    }
+}
+
+
+void multiChannelCaptureSink::on_audio(const float* input,
+                                       size_t num_frames,
+                                       double adc_time,
+                                       double callback_time,
+                                       bool input_overflow,
+                                       bool input_underflow){
+    split(input, num_frames, adc_time, callback_time, input_overflow, input_underflow);
+}
+
+
+void multiChannelCaptureSink::on_audio(const int16_t* input,
+                                       size_t num_frames,
+                                       double adc_time,
+                                       double callback_time,
+                                       bool input_overflow,
+                                       bool input_underflow){
+    split(input, num_frames, adc_time, callback_time, input_overflow, input_underflow);
+}
+
+
+template <typename T>
+void multiChannelCaptureSink::split(const T* input,
+                                    size_t num_frames,
+                                    double adc_time,
+                                    double callback_time,
+                                    bool input_overflow,
+                                    bool input_underflow){
+    size_t num_channels = _channels.size();
+    if (!input){
+        for (auto& channel : _channels){
+            channel->on_audio(input, num_frames, adc_time, callback_time, input_overflow, input_underflow);
+        }
+        return;
+    }
+
+    // planar copies live on the callback's stack: no allocation on the audio thread
+    T planar[MAX_CHANNELS][SPLIT_FRAMES];
+    T* outputs[MAX_CHANNELS];
+    for (size_t c = 0; c < num_channels; ++c) outputs[c] = planar[c];
+
+    for (size_t begin = 0; begin < num_frames; begin += SPLIT_FRAMES){
+        size_t size = std::min(SPLIT_FRAMES, num_frames - begin);
+        simd::deinterleave(input + begin * num_channels, outputs, size, num_channels);
+        bool first_block = (begin == 0);
+        for (size_t c = 0; c < num_channels; ++c){
+            _channels[c]->on_audio(outputs[c], size, adc_time + begin / _sample_rate, callback_time,
+                                   input_overflow && first_block, input_underflow && first_block);
+        }
+    }
+}
+
+
+    } // namespace audio
+} // namespace asr
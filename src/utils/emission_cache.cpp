@@ -0,0 +1,230 @@
+#include "utils/emission_cache.hpp"
+#include <glog/logging.h>
+#include <fstream>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace asr{
+    namespace emissions{
+
+
+uint16_t float_to_half(float value){
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign     = (bits >> 16) & 0x8000;
+    int32_t  exponent = static_cast<int32_t>((bits >> 23) & 0xff) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    if (((bits >> 23) & 0xff) == 0xff){ // inf / nan
+        return static_cast<uint16_t>(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+    }
+    if (exponent >= 0x1f){ // overflow -> inf (log-probs of -inf land here)
+        return static_cast<uint16_t>(sign | 0x7c00);
+    }
+    if (exponent <= 0){ // subnormal or zero
+        if (exponent < -10) return static_cast<uint16_t>(sign);
+        mantissa |= 0x800000;
+        uint32_t shift = static_cast<uint32_t>(14 - exponent);
+        uint32_t half_mantissa = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1) ++half_mantissa; // round half up
+        return static_cast<uint16_t>(sign | half_mantissa);
+    }
+    uint32_t half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000) ++half; // round half up (may carry into the exponent, which is the right result)
+    return static_cast<uint16_t>(half);
+}
+
+
+float half_to_float(uint16_t value){
+    uint32_t sign     = static_cast<uint32_t>(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1f;
+    uint32_t mantissa = value & 0x3ff;
+    uint32_t bits;
+
+    if (exponent == 0){
+        if (mantissa == 0){
+            bits = sign;
+        }
+        else{ // subnormal: normalize it
+            exponent = 127 - 15 + 1;
+            while (!(mantissa & 0x400)){
+                mantissa <<= 1;
+                --exponent;
+            }
+            mantissa &= 0x3ff;
+            bits = sign | (exponent << 23) | (mantissa << 13);
+        }
+    }
+    else if (exponent == 0x1f){
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    }
+    else{
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+
+bool write_emission_cache(const fs::path& path_to_cache,
+                          const float* log_probs,
+                          size_t num_frames,
+                          size_t vocab_size,
+                          float frame_rate,
+                          emissionDtype dtype){
+    if (!log_probs || num_frames == 0 || vocab_size == 0){
+        LOG(WARNING) << "[emissions/write_emission_cache]: nothing to write to " << path_to_cache;
+        return false;
+    }
+
+    std::ofstream cache_file(path_to_cache, std::ios::binary | std::ios::trunc);
+    if (!cache_file.is_open()){
+        LOG(WARNING) << "[emissions/write_emission_cache]: failed to open " << path_to_cache;
+        return false;
+    }
+
+    emissionCacheHeader header;
+    std::memcpy(header.magic, "EMIS", 4);
+    header.version     = EMISSION_CACHE_VERSION;
+    header.dtype       = dtype;
+    header.num_frames  = static_cast<uint32_t>(num_frames);
+    header.vocab_size  = static_cast<uint32_t>(vocab_size);
+    header.frame_rate  = frame_rate;
+    header.data_offset = EMISSION_CACHE_ALIGNMENT; // the header fits in the first aligned block
+
+    std::vector<char> header_block(header.data_offset, 0);
+    std::memcpy(header_block.data(), &header, sizeof(header));
+    cache_file.write(header_block.data(), header_block.size());
+
+    size_t num_values = num_frames * vocab_size;
+    if (dtype == FP32){
+        cache_file.write(reinterpret_cast<const char*>(log_probs), num_values * sizeof(float));
+    }
+    else{
+        std::vector<uint16_t> half_values(num_values);
+        for (size_t i = 0; i < num_values; ++i){
+            half_values[i] = float_to_half(log_probs[i]);
+        }
+        cache_file.write(reinterpret_cast<const char*>(half_values.data()), num_values * sizeof(uint16_t));
+    }
+
+    if (!cache_file.good()){
+        LOG(WARNING) << "[emissions/write_emission_cache]: failed while writing " << path_to_cache;
+        return false;
+    }
+    VLOG(2) << "[emissions/write_emission_cache]: wrote " << num_frames << " frames to " << path_to_cache;
+    return true;
+}
+
+
+
+emissionCache::emissionCache(const fs::path& path_to_cache){
+    if (!open(path_to_cache)){
+        throw std::runtime_error("failed to open the emission cache");
+    }
+}
+
+
+emissionCache::~emissionCache(){
+    close();
+}
+
+
+bool emissionCache::open(const fs::path& path_to_cache){
+    close();
+
+    int fd = ::open(path_to_cache.c_str(), O_RDONLY);
+    if (fd < 0){
+        LOG(WARNING) << "[emissionCache/open]: failed to open " << path_to_cache;
+        return false;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < sizeof(emissionCacheHeader)){
+        LOG(WARNING) << "[emissionCache/open]: " << path_to_cache << " is too small to be an emission cache";
+        ::close(fd);
+        return false;
+    }
+
+    size_t file_size = static_cast<size_t>(file_stat.st_size);
+    void* mapped = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping keeps the file alive
+    if (mapped == MAP_FAILED){
+        LOG(WARNING) << "[emissionCache/open]: failed to map " << path_to_cache;
+        return false;
+    }
+    madvise(mapped, file_size, MADV_SEQUENTIAL); // decoding walks the frames in order
+
+    _mapped      = static_cast<const uint8_t*>(mapped);
+    _mapped_size = file_size;
+    _header      = reinterpret_cast<const emissionCacheHeader*>(_mapped);
+
+    // validate
+    size_t value_size    = (_header->dtype == FP16) ? sizeof(uint16_t) : sizeof(float);
+    size_t expected_size = static_cast<size_t>(_header->data_offset) +
+                           static_cast<size_t>(_header->num_frames) * _header->vocab_size * value_size;
+    if (std::memcmp(_header->magic, "EMIS", 4) != 0 ||
+        _header->version != EMISSION_CACHE_VERSION ||
+        (_header->dtype != FP32 && _header->dtype != FP16) ||
+        _header->data_offset < sizeof(emissionCacheHeader) ||
+        expected_size > _mapped_size){
+        LOG(WARNING) << "[emissionCache/open]: " << path_to_cache << " is not a valid emission cache";
+        close();
+        return false;
+    }
+
+    _data = _mapped + _header->data_offset;
+    _path = path_to_cache;
+    VLOG(2) << "[emissionCache/open]: mapped " << path_to_cache << " (" << get_num_frames() << " frames, "
+            << get_vocab_size() << " tokens)";
+    return true;
+}
+
+
+void emissionCache::close(){
+    if (_mapped){
+        munmap(const_cast<uint8_t*>(_mapped), _mapped_size);
+    }
+    _mapped      = nullptr;
+    _mapped_size = 0;
+    _header      = nullptr;
+    _data        = nullptr;
+}
+
+
+const float* emissionCache::get_fp32_data() const {
+    if (!is_open() || get_dtype() != FP32) return nullptr;
+    return static_cast<const float*>(_data);
+}
+
+
+const float* emissionCache::get_frame(size_t frame_index) const {
+    const float* data = get_fp32_data();
+    if (!data || frame_index >= get_num_frames()) return nullptr;
+    return data + frame_index * get_vocab_size();
+}
+
+
+void emissionCache::read_frame(size_t frame_index, float* out) const {
+    if (!is_open() || frame_index >= get_num_frames()){
+        throw std::runtime_error("emission cache frame out of bound");
+    }
+    size_t vocab_size = get_vocab_size();
+    if (get_dtype() == FP32){
+        std::memcpy(out, get_frame(frame_index), vocab_size * sizeof(float));
+        return;
+    }
+    const uint16_t* frame = static_cast<const uint16_t*>(_data) + frame_index * vocab_size;
+    for (size_t i = 0; i < vocab_size; ++i){
+        out[i] = half_to_float(frame[i]);
+    }
+}
+
+
+    } // namespace emissions
+} // namespace asr
@@ -0,0 +1,484 @@
+#include "utils/file_ingest.hpp"
+#include <glog/logging.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+
+namespace asr{
+    namespace audio{
+
+
+namespace {
+    typedef std::chrono::steady_clock clock_type;
+
+    double seconds_since(clock_type::time_point start){
+        return std::chrono::duration<double>(clock_type::now() - start).count();
+    }
+
+    const char* to_string(ingestBackend backend){
+        switch (backend){
+            case INGEST_IO_URING: return "io_uring";
+            case INGEST_PREAD:    return "pread";
+            default:              return "auto";
+        }
+    }
+
+
+    // minimal io_uring over the raw syscalls (no liburing): one submitting / reaping thread
+    class ioUring{
+    private:
+        int _fd = -1;
+        void* _sq_ring = MAP_FAILED;
+        void* _cq_ring = MAP_FAILED;
+        size_t _sq_ring_size = 0;
+        size_t _cq_ring_size = 0;
+        io_uring_sqe* _sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+        size_t _sqes_size = 0;
+
+        unsigned* _sq_head;
+        unsigned* _sq_tail;
+        unsigned* _sq_mask;
+        unsigned* _sq_array;
+        unsigned* _cq_head;
+        unsigned* _cq_tail;
+        unsigned* _cq_mask;
+        io_uring_cqe* _cqes;
+        unsigned _entries = 0;
+
+
+    public:
+        ~ioUring(){close();}
+
+        bool init(unsigned entries){
+            io_uring_params params;
+            std::memset(&params, 0, sizeof(params));
+            _fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+            if (_fd < 0){
+                VLOG(1) << "[ioUring/init]: io_uring_setup failed: " << std::strerror(errno);
+                return false;
+            }
+            _entries      = params.sq_entries;
+            _sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            _cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+            if (single_mmap){
+                _sq_ring_size = _cq_ring_size = std::max(_sq_ring_size, _cq_ring_size);
+            }
+
+            _sq_ring = mmap(nullptr, _sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            _fd, IORING_OFF_SQ_RING);
+            _cq_ring = single_mmap ? _sq_ring
+                                   : mmap(nullptr, _cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                          _fd, IORING_OFF_CQ_RING);
+            _sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+            _sqes = static_cast<io_uring_sqe*>(mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE,
+                                                    MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES));
+            if (_sq_ring == MAP_FAILED || _cq_ring == MAP_FAILED || _sqes == MAP_FAILED){
+                VLOG(1) << "[ioUring/init]: failed to map the rings";
+                close();
+                return false;
+            }
+
+            uint8_t* sq = static_cast<uint8_t*>(_sq_ring);
+            uint8_t* cq = static_cast<uint8_t*>(_cq_ring);
+            _sq_head  = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+            _sq_tail  = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            _sq_mask  = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            _sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+            _cq_head  = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            _cq_tail  = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            _cq_mask  = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            _cqes     = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+            return true;
+        }
+
+        // closing the ring cancels (and waits for) the requests still in flight
+        void close(){
+            if (_sqes != MAP_FAILED) munmap(_sqes, _sqes_size);
+            if (_cq_ring != MAP_FAILED && _cq_ring != _sq_ring) munmap(_cq_ring, _cq_ring_size);
+            if (_sq_ring != MAP_FAILED) munmap(_sq_ring, _sq_ring_size);
+            if (_fd >= 0) ::close(_fd);
+            _sqes    = static_cast<io_uring_sqe*>(MAP_FAILED);
+            _sq_ring = _cq_ring = MAP_FAILED;
+            _fd      = -1;
+        }
+
+        unsigned get_entries() const {return _entries;}
+
+        // queues a read. the caller keeps at most get_entries() requests in flight
+        void prep_read(int fd, void* buffer, unsigned length, uint64_t offset, uint64_t user_data){
+            unsigned tail  = *_sq_tail; // only this thread writes the tail
+            unsigned index = tail & *_sq_mask;
+            io_uring_sqe& sqe = _sqes[index];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode    = IORING_OP_READ;
+            sqe.fd        = fd;
+            sqe.addr      = reinterpret_cast<uint64_t>(buffer);
+            sqe.len       = length;
+            sqe.off       = offset;
+            sqe.user_data = user_data;
+            _sq_array[index] = index;
+            __atomic_store_n(_sq_tail, tail + 1, __ATOMIC_RELEASE);
+        }
+
+        // submits the queued reads and blocks until min_complete completions are available
+        int enter(unsigned to_submit, unsigned min_complete){
+            int result;
+            do{
+                result = static_cast<int>(syscall(__NR_io_uring_enter, _fd, to_submit, min_complete,
+                                                  min_complete ? IORING_ENTER_GETEVENTS : 0, nullptr, 0));
+            } while (result < 0 && errno == EINTR);
+            return result;
+        }
+
+        template <typename Fn>
+        size_t reap(Fn&& on_completion){
+            unsigned head = *_cq_head;
+            unsigned tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+            size_t count = 0;
+            for (; head != tail; ++head, ++count){
+                const io_uring_cqe& cqe = _cqes[head & *_cq_mask];
+                on_completion(cqe.user_data, cqe.res);
+            }
+            __atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+            return count;
+        }
+    };
+} // namespace
+
+
+
+std::string ingestStats::summary() const {
+    std::ostringstream out;
+    out << "backend: " << to_string(backend) << ", files: " << num_files << ", failed: " << failed_files
+        << ", read (MB): " << bytes_read / double(1 << 20) << ", wall (s): " << wall_seconds
+        << ", throughput (MB/s): " << get_throughput_mb() << "\n"
+        << "worker io wait (s): " << io_wait_seconds << ", worker compute (s): " << consumer_seconds;
+    return out.str();
+}
+
+
+
+fileIngestor::fileIngestor(ingestConfig config) : _config(config){
+    if (_config.max_buffers == 0){
+        LOG(WARNING) << "[fileIngestor/constructor]: max_buffers is 0. using 1";
+        _config.max_buffers = 1;
+    }
+    if (_config.num_workers == 0){
+        LOG(WARNING) << "[fileIngestor/constructor]: num_workers is 0. using 1";
+        _config.num_workers = 1;
+    }
+    _config.queue_depth    = std::max<size_t>(_config.queue_depth, 1);
+    _config.read_size      = std::max<size_t>(_config.read_size, 4096);
+    _config.num_io_threads = std::max<size_t>(_config.num_io_threads, 1);
+}
+
+
+bool fileIngestor::is_io_uring_available(){
+    ioUring ring;
+    return ring.init(1);
+}
+
+
+ingestStats fileIngestor::run(const std::vector<fs::path>& paths, const consumerFn& consumer){
+    auto start_time = clock_type::now();
+    _buffers = std::vector<fileBuffer>(_config.max_buffers);
+    _free_buffers.clear();
+    for (auto& buffer : _buffers) _free_buffers.push_back(&buffer);
+    _ready.clear();
+    _io_done      = false;
+    _next_file    = 0;
+    _bytes_read   = 0;
+    _failed_files = 0;
+
+    std::vector<double> io_wait(_config.num_workers, 0), compute(_config.num_workers, 0);
+    std::vector<std::thread> workers;
+    for (size_t w = 0; w < _config.num_workers; ++w){
+        workers.emplace_back(&fileIngestor::worker_loop, this, std::cref(consumer), std::ref(io_wait[w]), std::ref(compute[w]));
+    }
+
+    ingestStats stats;
+    stats.backend = _config.backend;
+    if (stats.backend != INGEST_PREAD){
+        if (io_uring_loop(paths)){
+            stats.backend = INGEST_IO_URING;
+        }
+        else{
+            if (stats.backend == INGEST_IO_URING){
+                LOG(WARNING) << "[fileIngestor/run]: io_uring is not available. falling back to pread";
+            }
+            stats.backend = INGEST_PREAD;
+        }
+    }
+    if (stats.backend == INGEST_PREAD){
+        pread_loop(paths);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _io_done = true;
+    }
+    _file_ready.notify_all();
+    for (auto& worker : workers){
+        worker.join();
+    }
+
+    stats.num_files    = paths.size();
+    stats.failed_files = _failed_files.load();
+    stats.bytes_read   = _bytes_read.load();
+    stats.wall_seconds = seconds_since(start_time);
+    for (size_t w = 0; w < _config.num_workers; ++w){
+        stats.io_wait_seconds  += io_wait[w];
+        stats.consumer_seconds += compute[w];
+    }
+    VLOG(1) << "[fileIngestor/run]: " << stats.summary();
+    return stats;
+}
+
+
+bool fileIngestor::open_file(const fs::path& path, size_t index, fileBuffer& buffer, int& fd){
+    buffer.file       = ingestedFile{};
+    buffer.file.index = index;
+    buffer.file.path  = path;
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0){
+        LOG(WARNING) << "[fileIngestor/open_file]: failed to open " << path << ": " << std::strerror(errno);
+        return false;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0){
+        LOG(WARNING) << "[fileIngestor/open_file]: failed to stat " << path;
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    // the buffer only grows: no reallocation (or zero fill) once it fits the largest file
+    buffer.file.size = static_cast<size_t>(file_stat.st_size);
+    if (buffer.bytes.size() < buffer.file.size){
+        buffer.bytes.resize(buffer.file.size);
+    }
+    buffer.file.data = buffer.bytes.data();
+    return true;
+}
+
+
+bool fileIngestor::io_uring_loop(const std::vector<fs::path>& paths){
+    ioUring ring;
+    if (!ring.init(static_cast<unsigned>(std::min<size_t>(_config.queue_depth, 4096)))){
+        return false;
+    }
+    size_t queue_depth = std::min<size_t>(_config.queue_depth, ring.get_entries());
+
+    struct readRequest{
+        size_t buffer_index;
+        size_t offset;
+        size_t length;
+    };
+    struct openFile{
+        int fd = -1;
+        size_t outstanding = 0; // requests queued or in flight
+        bool failed = false;
+    };
+    std::vector<openFile> open_files(_buffers.size());
+    std::deque<readRequest> pending;
+    std::vector<readRequest> in_flight(queue_depth);
+    std::vector<size_t> free_slots;
+    for (size_t i = queue_depth; i > 0; --i) free_slots.push_back(i - 1);
+
+    size_t next_file = 0, num_open = 0;
+    auto finish = [&](size_t buffer_index){
+        auto& state = open_files[buffer_index];
+        ::close(state.fd);
+        state.fd = -1;
+        --num_open;
+        _buffers[buffer_index].file.ok = !state.failed;
+        push_ready(&_buffers[buffer_index]);
+    };
+
+    while (next_file < paths.size() || num_open > 0){
+        // open as many files as there are free buffers. with nothing in flight, wait for a worker
+        while (next_file < paths.size()){
+            fileBuffer* buffer = acquire_buffer(num_open == 0);
+            if (!buffer) break;
+            size_t buffer_index = buffer - _buffers.data();
+            auto& state = open_files[buffer_index];
+            state = openFile{};
+            if (!open_file(paths[next_file], next_file, *buffer, state.fd)){
+                ++next_file;
+                push_ready(buffer);
+                continue;
+            }
+            ++next_file;
+            ++num_open;
+            for (size_t offset = 0; offset < buffer->file.size; offset += _config.read_size){
+                pending.push_back({buffer_index, offset, std::min(_config.read_size, buffer->file.size - offset)});
+                ++state.outstanding;
+            }
+            if (state.outstanding == 0) finish(buffer_index); // empty file
+        }
+
+        // fill the submission queue
+        unsigned to_submit = 0;
+        while (!pending.empty() && !free_slots.empty()){
+            readRequest request = pending.front();
+            pending.pop_front();
+            auto& state = open_files[request.buffer_index];
+            if (state.failed){ // an earlier part of the file failed, skip the rest
+                if (--state.outstanding == 0) finish(request.buffer_index);
+                continue;
+            }
+            size_t slot = free_slots.back();
+            free_slots.pop_back();
+            in_flight[slot] = request;
+            ring.prep_read(state.fd, _buffers[request.buffer_index].bytes.data() + request.offset,
+                           static_cast<unsigned>(request.length), request.offset, slot);
+            ++to_submit;
+        }
+        if (free_slots.size() == queue_depth) continue; // nothing in flight
+
+        if (ring.enter(to_submit, 1) < 0 && errno != EAGAIN && errno != EBUSY){
+            LOG(ERROR) << "[fileIngestor/io_uring_loop]: io_uring_enter failed: " << std::strerror(errno);
+            ring.close(); // cancels what is in flight before the buffers are handed out
+            for (size_t i = 0; i < open_files.size(); ++i){
+                if (open_files[i].fd < 0) continue;
+                open_files[i].failed = true;
+                finish(i);
+            }
+            for (; next_file < paths.size(); ++next_file){
+                _failed_files.fetch_add(1, std::memory_order_relaxed);
+            }
+            return true;
+        }
+
+        ring.reap([&](uint64_t slot, int result){
+            readRequest request = in_flight[slot];
+            free_slots.push_back(slot);
+            auto& state = open_files[request.buffer_index];
+            if (result == -EINTR || result == -EAGAIN){
+                pending.push_front(request);
+                return;
+            }
+            if (result <= 0){ // an error, or the file shrank since fstat
+                LOG(WARNING) << "[fileIngestor/io_uring_loop]: failed to read " << _buffers[request.buffer_index].file.path
+                             << ": " << (result < 0 ? std::strerror(-result) : "unexpected end of file");
+                state.failed = true;
+            }
+            else{
+                _bytes_read.fetch_add(result, std::memory_order_relaxed);
+                if (static_cast<size_t>(result) < request.length){ // short read, queue the rest
+                    pending.push_front({request.buffer_index, request.offset + result, request.length - result});
+                    return;
+                }
+            }
+            if (--state.outstanding == 0) finish(request.buffer_index);
+        });
+    }
+    return true;
+}
+
+
+void fileIngestor::pread_loop(const std::vector<fs::path>& paths){
+    auto io_thread = [this, &paths](){
+        for (size_t index = _next_file++; index < paths.size(); index = _next_file++){
+            fileBuffer* buffer = acquire_buffer(true);
+            int fd = -1;
+            if (open_file(paths[index], index, *buffer, fd)){
+                size_t done = 0;
+                while (done < buffer->file.size){
+                    ssize_t result = pread(fd, buffer->bytes.data() + done,
+                                           std::min(_config.read_size, buffer->file.size - done), done);
+                    if (result < 0 && errno == EINTR) continue;
+                    if (result <= 0){
+                        LOG(WARNING) << "[fileIngestor/pread_loop]: failed to read " << paths[index];
+                        break;
+                    }
+                    done += result;
+                    _bytes_read.fetch_add(result, std::memory_order_relaxed);
+                }
+                buffer->file.ok = done == buffer->file.size;
+                ::close(fd);
+            }
+            push_ready(buffer);
+        }
+    };
+
+    std::vector<std::thread> io_threads;
+    for (size_t t = 0; t < _config.num_io_threads; ++t){
+        io_threads.emplace_back(io_thread);
+    }
+    for (auto& thread : io_threads){
+        thread.join();
+    }
+}
+
+
+void fileIngestor::worker_loop(const consumerFn& consumer, double& io_wait_seconds, double& consumer_seconds){
+    while (true){
+        auto wait_start = clock_type::now();
+        fileBuffer* buffer;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _file_ready.wait(lock, [this]{return !_ready.empty() || _io_done;});
+            if (_ready.empty()) break;
+            buffer = _ready.front();
+            _ready.pop_front();
+        }
+        io_wait_seconds += seconds_since(wait_start);
+
+        auto consumer_start = clock_type::now();
+        consumer(buffer->file);
+        consumer_seconds += seconds_since(consumer_start);
+        release_buffer(buffer);
+    }
+}
+
+
+fileIngestor::fileBuffer* fileIngestor::acquire_buffer(bool wait){
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (wait){
+        _buffer_released.wait(lock, [this]{return !_free_buffers.empty();});
+    }
+    else if (_free_buffers.empty()){
+        return nullptr;
+    }
+    fileBuffer* buffer = _free_buffers.back();
+    _free_buffers.pop_back();
+    return buffer;
+}
+
+
+void fileIngestor::release_buffer(fileBuffer* buffer){
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _free_buffers.push_back(buffer);
+    }
+    _buffer_released.notify_one();
+}
+
+
+void fileIngestor::push_ready(fileBuffer* buffer){
+    if (!buffer->file.ok){
+        _failed_files.fetch_add(1, std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _ready.push_back(buffer);
+    }
+    _file_ready.notify_one();
+}
+
+
+    } // namespace audio
+} // namespace asr
@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <vector>
 #include <utils/my_utils.hpp>
+#include "utils/wav_reader.hpp"
 #include <string.h>
 #include <iomanip>
 #include <memory>
@@ -12,120 +13,16 @@
 
 
 
-// Helper function to print bytes
-void printBytes(const char* data, size_t size) {
-    std::cout << "Bytes: ";
-    for (size_t i = 0; i < size; ++i) {
-        std::cout << std::hex << std::setw(2) << std::setfill('0') 
-                  << (static_cast<unsigned char>(data[i]) & 0xFF) << " ";
-    }
-    std::cout << std::dec << std::endl;  // Reset to decimal
-}
-
 std::vector<float> readwav(const std::string filename) {
-
-    std::ifstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
-        throw std::runtime_error("Could not open file: " + filename);
-    }
-
-    file.clear();
-    file.seekg(0);
-
-    // Read RIFF header
-    RIFFHeader header; // [FIXME:]
-    file.read(reinterpret_cast<char*>(&header), sizeof(RIFFHeader));
-    
-    std::cout << std::endl;
-    std::cout << "RIFF header: ";
-    std::cout << header.riff << std::endl;
-    printBytes(header.riff, 4);
-    std::cout << "WAVE header: ";
-    printBytes(header.wave, 4);
-
-    if (memcmp(header.riff, "RIFF", 4) != 0 || 
-        memcmp(header.wave, "WAVE", 4) != 0 ) {
-        throw std::runtime_error("Invalid RIFF/WAVE format");
-    }
-
-    uint16_t audioFormat = 0;
-    uint16_t numChannels = 0;
-    uint32_t sampleRate = 0;
-    uint16_t bitsPerSample = 0;
-    uint32_t dataSize = 0;
-
-    // Read fmt chunk
-    char fmtId[4];
-    uint32_t fmtSize;
-    
-    file.read(fmtId, 4);
-    file.read(reinterpret_cast<char*>(&fmtSize), 4);
-    
-    std::cout << "fmt chunk ID: ";
-    printBytes(fmtId, 4);
-    std::cout << "fmt size: " << fmtSize << std::endl;
-
-    if (std::string(fmtId, 4) != "fmt ") {
-        throw std::runtime_error("Expected fmt chunk");
-    }
-
-    // Read format data
-    file.read(reinterpret_cast<char*>(&audioFormat), 2);
-    file.read(reinterpret_cast<char*>(&numChannels), 2);
-    file.read(reinterpret_cast<char*>(&sampleRate), 4);
-    file.seekg(4, std::ios::cur);  // Skip byterate
-    file.seekg(2, std::ios::cur);  // Skip blockalign
-    file.read(reinterpret_cast<char*>(&bitsPerSample), 2);
-    
-    // Skip any extra fmt bytes
-    if (fmtSize > 16) {
-        file.seekg(fmtSize - 16, std::ios::cur);
-    }
-
-    std::cout << "Audio Format: " << audioFormat << std::endl;
-    std::cout << "Channels: " << numChannels << std::endl;
-    std::cout << "Bits per sample: " << bitsPerSample << std::endl;
-    std::cout << "Sample rate: " << sampleRate << std::endl;
-
-    // Read fact chunk
-    char factId[4];
-    uint32_t factSize;
-    
-    file.read(factId, 4);
-    file.read(reinterpret_cast<char*>(&factSize), 4);
-    
-    std::cout << "fact chunk ID: ";
-    printBytes(factId, 4);
-    std::cout << "fact size: " << factSize << std::endl;
-
-    if (std::string(factId, 4) == "fact") {
-        file.seekg(factSize, std::ios::cur);
-    } else {
-        file.seekg(-8, std::ios::cur);  // Go back if it wasn't fact
+    /*
+    whole file, mono float32. the conversion is done by the mmapped reader, use
+    asr::audio::wavReader directly to stream long recordings chunk by chunk
+    */
+    asr::audio::wavReader wav_reader;
+    if (!wav_reader.open(filename)) {
+        throw std::runtime_error("Could not read wav file: " + filename);
     }
-
-    // Read data chunk
-    char dataId[4];
-    
-    file.read(dataId, 4);
-    file.read(reinterpret_cast<char*>(&dataSize), 4);
-    
-    std::cout << "data chunk ID: ";
-    printBytes(dataId, 4);
-    std::cout << "data size: " << dataSize << std::endl;
-
-    if (std::string(dataId, 4) != "data") {
-        throw std::runtime_error("Expected data chunk");
-    }
-
-    // Read the actual audio data
-    int64_t numSamples = dataSize / (bitsPerSample / 8);
-    std::vector<float> audioData(numSamples);
-    
-    file.read(reinterpret_cast<char*>(audioData.data()), dataSize);
-    return audioData;
-
-
+    return wav_reader.read_all();
 }
 
 
@@ -143,27 +40,27 @@ namespace asr {
             double cutoff_prob,
             size_t cutoff_top_n,
             int log_input) {
+          return get_pruned_log_probs(prob_step.data(), prob_step.size(), cutoff_prob, cutoff_top_n, log_input);
+        }
+
+        std::vector<std::pair<size_t, double>> get_pruned_log_probs(
+            const float* prob_step,
+            size_t num_tokens,
+            double cutoff_prob,
+            size_t cutoff_top_n,
+            int log_input) {
           std::vector<std::pair<int, double>> prob_idx;
+          prob_idx.reserve(num_tokens);
           double log_cutoff_prob = log(cutoff_prob);
-          for (size_t i = 0; i < prob_step.size(); ++i) {
+          for (size_t i = 0; i < num_tokens; ++i) {
             prob_idx.push_back(std::pair<int, double>(i, prob_step[i]));
           }
           // pruning of vacobulary
-          size_t cutoff_len = prob_step.size();
+          size_t cutoff_len = num_tokens;
           if (log_cutoff_prob < 0.0 || cutoff_top_n < cutoff_len) {
             std::sort(
                 prob_idx.begin(), prob_idx.end(), pair_comp_second_rev<int, double>);
-            if (log_cutoff_prob < 0.0) {
-              double cum_prob = 0.0;
-              cutoff_len = 0;
-              for (size_t i = 0; i < prob_idx.size(); ++i) {
-                cum_prob = log_sum_exp(cum_prob, log_input ? prob_idx[i].second : log(prob_idx[i].second) );
-                cutoff_len += 1;
-                if (cum_prob >= cutoff_prob || cutoff_len >= cutoff_top_n) break;
-              }
-            }else{
-              cutoff_len = cutoff_top_n;
-            }
+            cutoff_len = get_cutoff_length(prob_idx, cutoff_prob, cutoff_top_n, log_input);
             prob_idx = std::vector<std::pair<int, double>>(
                 prob_idx.begin(), prob_idx.begin() + cutoff_len);
           }
@@ -0,0 +1,162 @@
+#include "utils/resampler.hpp"
+#include "utils/simd_kernels.hpp"
+#include <glog/logging.h>
+#include <numeric>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+
+namespace asr{
+    namespace audio{
+
+
+namespace {
+    constexpr double PI = 3.14159265358979323846;
+
+    // zeroth order modified bessel function of the first kind (kaiser window)
+    double bessel_i0(double x){
+        double sum = 1.0, term = 1.0, half_x = x / 2.0;
+        for (int k = 1; k < 64 && term > 1e-12 * sum; ++k){
+            term *= (half_x / k) * (half_x / k);
+            sum  += term;
+        }
+        return sum;
+    }
+} // namespace
+
+
+
+polyphaseResampler::polyphaseResampler(uint32_t input_rate, uint32_t output_rate, resamplerConfig config) :
+    _input_rate(input_rate), _output_rate(output_rate){
+    if (input_rate == 0 || output_rate == 0){
+        DLOG(WARNING) << "[polyphaseResampler/constructor]: invalid rates " << input_rate << " -> " << output_rate
+                      << ". Throwing exception";
+        throw std::runtime_error("resampler rates must be positive");
+    }
+    size_t divisor = std::gcd(input_rate, output_rate);
+    _up   = output_rate / divisor;
+    _down = input_rate / divisor;
+    if (!is_passthrough()){
+        build_filter_bank(config);
+    }
+    reset();
+    DLOG(INFO) << "[polyphaseResampler/constructor]: " << input_rate << " -> " << output_rate << " Hz ("
+               << _up << "/" << _down << ", " << _taps_per_phase << " taps per phase)";
+}
+
+
+void polyphaseResampler::build_filter_bank(const resamplerConfig& config){
+    // filter span in input samples: zero_crossings lobes per side of the lower rate
+    double ratio    = std::max(1.0, static_cast<double>(_down) / _up);
+    _taps_per_phase = static_cast<size_t>(std::ceil(2 * config.zero_crossings * ratio)) | 1; // odd, centered
+    size_t length   = _up * _taps_per_phase;
+    size_t center   = (length - 1) / 2; // integer, so the delay is a whole number of upsampled samples
+
+    // cutoff in cycles per sample of the upsampled stream
+    double cutoff = config.rolloff * 0.5 / std::max(_up, _down);
+    double window_norm = bessel_i0(config.kaiser_beta);
+
+    std::vector<double> prototype(length);
+    for (size_t n = 0; n < length; ++n){
+        double x     = static_cast<double>(n) - center;
+        double sinc  = (x == 0) ? 1.0 : std::sin(2 * PI * cutoff * x) / (2 * PI * cutoff * x);
+        double ratio_to_center = x / (center + 1);
+        double window = bessel_i0(config.kaiser_beta * std::sqrt(std::max(0.0, 1 - ratio_to_center * ratio_to_center))) / window_norm;
+        prototype[n] = 2 * cutoff * sinc * window;
+    }
+
+    // split into phases (reversed for the contiguous dot product), unit dc gain per phase
+    _filter_bank.assign(length, 0.0f);
+    for (size_t phase = 0; phase < _up; ++phase){
+        double phase_sum = 0;
+        for (size_t k = 0; k < _taps_per_phase; ++k){
+            phase_sum += prototype[phase + k * _up];
+        }
+        for (size_t k = 0; k < _taps_per_phase; ++k){
+            _filter_bank[phase * _taps_per_phase + (_taps_per_phase - 1 - k)] =
+                static_cast<float>(prototype[phase + k * _up] / phase_sum);
+        }
+    }
+
+    // first output is centered on the first input: input 0 sits after the zero history
+    _initial_time = (_taps_per_phase - 1) * _up + center;
+}
+
+
+void polyphaseResampler::reset(){
+    _buffer.assign(is_passthrough() ? 0 : _taps_per_phase - 1, 0.0f);
+    _time      = _initial_time;
+    _total_in  = 0;
+    _total_out = 0;
+}
+
+
+size_t polyphaseResampler::run(std::vector<float>& output, size_t max_output){
+    size_t produced = 0;
+    size_t base     = _time / _up;
+    while (base < _buffer.size() && produced < max_output){
+        size_t phase = _time % _up;
+        output.push_back(simd::dot_product(_buffer.data() + base + 1 - _taps_per_phase,
+                                           _filter_bank.data() + phase * _taps_per_phase,
+                                           _taps_per_phase));
+        ++produced;
+        _time += _down;
+        base   = _time / _up;
+    }
+
+    // keep only the history the next output needs
+    size_t first_needed = base + 1 - _taps_per_phase;
+    size_t dropped      = std::min(first_needed, _buffer.size());
+    _buffer.erase(_buffer.begin(), _buffer.begin() + dropped);
+    _time -= dropped * _up;
+
+    _total_out += produced;
+    return produced;
+}
+
+
+size_t polyphaseResampler::process(const float* input, size_t num_samples, std::vector<float>& output){
+    _total_in += num_samples;
+    if (is_passthrough()){
+        output.insert(output.end(), input, input + num_samples);
+        _total_out += num_samples;
+        return num_samples;
+    }
+    _buffer.insert(_buffer.end(), input, input + num_samples);
+    return run(output, std::numeric_limits<size_t>::max());
+}
+
+
+std::vector<float> polyphaseResampler::process(const std::vector<float>& input){
+    std::vector<float> output;
+    output.reserve(input.size() * _up / _down + 1);
+    process(input.data(), input.size(), output);
+    return output;
+}
+
+
+size_t polyphaseResampler::flush(std::vector<float>& output){
+    if (is_passthrough()) return 0;
+
+    // the last outputs look up to half a filter ahead: pad with silence, stop at the expected length
+    uint64_t expected = (_total_in * _up + _down - 1) / _down;
+    if (_total_out >= expected) return 0;
+    _buffer.resize(_buffer.size() + _taps_per_phase, 0.0f);
+    return run(output, expected - _total_out);
+}
+
+
+std::vector<float> polyphaseResampler::resample(const std::vector<float>& input,
+                                                uint32_t input_rate,
+                                                uint32_t output_rate,
+                                                resamplerConfig config){
+    polyphaseResampler resampler(input_rate, output_rate, config);
+    auto output = resampler.process(input);
+    resampler.flush(output);
+    return output;
+}
+
+
+    } // namespace audio
+} // namespace asr
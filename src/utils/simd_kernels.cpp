@@ -0,0 +1,251 @@
+#include "utils/simd_kernels.hpp"
+#include <cstring>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+
+namespace asr{
+    namespace simd{
+
+
+namespace {
+    constexpr float PCM16_SCALE = 1.0f / 32768.0f;
+    constexpr float PCM24_SCALE = 1.0f / 8388608.0f;
+    constexpr float PCM32_SCALE = 1.0f / 2147483648.0f;
+
+    inline int32_t load_pcm24(const uint8_t* sample){
+        // place the 3 bytes in the top of an int32, the arithmetic shift sign extends
+        uint32_t value = (uint32_t(sample[0]) << 8) | (uint32_t(sample[1]) << 16) | (uint32_t(sample[2]) << 24);
+        return static_cast<int32_t>(value) >> 8;
+    }
+
+#ifdef __AVX2__
+    inline float horizontal_sum(__m256 v){
+        __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+        return _mm_cvtss_f32(sum);
+    }
+#endif
+} // namespace
+
+
+
+bool has_avx2(){
+#ifdef __AVX2__
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+void pcm16_to_float(const int16_t* input, float* output, size_t num_samples){
+    size_t i = 0;
+#ifdef __AVX2__
+    const __m256 scale = _mm256_set1_ps(PCM16_SCALE);
+    for (; i + 16 <= num_samples; i += 16){
+        __m256i samples = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+        __m256i low     = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(samples));
+        __m256i high    = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(samples, 1));
+        _mm256_storeu_ps(output + i,     _mm256_mul_ps(_mm256_cvtepi32_ps(low), scale));
+        _mm256_storeu_ps(output + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(high), scale));
+    }
+#endif
+    for (; i < num_samples; ++i){
+        output[i] = input[i] * PCM16_SCALE;
+    }
+}
+
+
+void pcm24_to_float(const uint8_t* input, float* output, size_t num_samples){
+    size_t i = 0;
+#ifdef __AVX2__
+    // 8 samples = 24 bytes, loaded as two 16-byte halves (the upper one reads 4 bytes past the group,
+    // hence the bound). each 3-byte sample goes to the top of a 32-bit lane, the shift sign extends
+    const __m256i shuffle = _mm256_setr_epi8(
+        -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+        -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    const __m256 scale = _mm256_set1_ps(PCM24_SCALE);
+    for (; i + 8 <= num_samples && (num_samples - i) * 3 >= 28; i += 8){
+        const uint8_t* group = input + i * 3;
+        __m128i low  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));      // samples 0-3 (+ 4 bytes)
+        __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group + 12)); // samples 4-7 (+ 4 bytes)
+        __m256i bytes   = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+        __m256i samples = _mm256_srai_epi32(_mm256_shuffle_epi8(bytes, shuffle), 8);
+        _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_cvtepi32_ps(samples), scale));
+    }
+#endif
+    for (; i < num_samples; ++i){
+        output[i] = load_pcm24(input + i * 3) * PCM24_SCALE;
+    }
+}
+
+
+void pcm32_to_float(const int32_t* input, float* output, size_t num_samples){
+    size_t i = 0;
+#ifdef __AVX2__
+    const __m256 scale = _mm256_set1_ps(PCM32_SCALE);
+    for (; i + 8 <= num_samples; i += 8){
+        __m256i samples = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+        _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_cvtepi32_ps(samples), scale));
+    }
+#endif
+    for (; i < num_samples; ++i){
+        output[i] = input[i] * PCM32_SCALE;
+    }
+}
+
+
+void downmix_to_mono(const float* input, float* output, size_t num_frames, size_t num_channels){
+    if (num_channels == 1){
+        if (input != output) std::memmove(output, input, num_frames * sizeof(float));
+        return;
+    }
+
+    size_t i = 0;
+#ifdef __AVX2__
+    if (num_channels == 2){
+        // deinterleave 8 frames: even lanes are left, odd lanes are right
+        const __m256 half = _mm256_set1_ps(0.5f);
+        for (; i + 8 <= num_frames; i += 8){
+            __m256 first  = _mm256_loadu_ps(input + 2 * i);
+            __m256 second = _mm256_loadu_ps(input + 2 * i + 8);
+            __m256 sums   = _mm256_hadd_ps(first, second); // pairs, in 128-bit lane order
+            sums = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(sums), 0xD8));
+            _mm256_storeu_ps(output + i, _mm256_mul_ps(sums, half));
+        }
+    }
+#endif
+    const float scale = 1.0f / num_channels;
+    for (; i < num_frames; ++i){
+        float sum = 0;
+        for (size_t c = 0; c < num_channels; ++c){
+            sum += input[i * num_channels + c];
+        }
+        output[i] = sum * scale;
+    }
+}
+
+
+void deinterleave(const float* input, float* const* outputs, size_t num_frames, size_t num_channels){
+    size_t i = 0;
+#ifdef __AVX2__
+    if (num_channels == 2){
+        float* left  = outputs[0];
+        float* right = outputs[1];
+        for (; i + 8 <= num_frames; i += 8){
+            __m256 a = _mm256_loadu_ps(input + 2 * i);     // L0 R0 L1 R1 | L2 R2 L3 R3
+            __m256 b = _mm256_loadu_ps(input + 2 * i + 8); // L4 R4 L5 R5 | L6 R6 L7 R7
+            // per lane: L0 L1 L4 L5 | L2 L3 L6 L7, then fix the 64-bit quarters' order
+            __m256 l = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            __m256 r = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            l = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(l), _MM_SHUFFLE(3, 1, 2, 0)));
+            r = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(r), _MM_SHUFFLE(3, 1, 2, 0)));
+            _mm256_storeu_ps(left + i, l);
+            _mm256_storeu_ps(right + i, r);
+        }
+    }
+#endif
+    for (; i < num_frames; ++i){
+        for (size_t c = 0; c < num_channels; ++c){
+            outputs[c][i] = input[i * num_channels + c];
+        }
+    }
+}
+
+
+void deinterleave(const int16_t* input, int16_t* const* outputs, size_t num_frames, size_t num_channels){
+    size_t i = 0;
+#ifdef __AVX2__
+    if (num_channels == 2){
+        int16_t* left  = outputs[0];
+        int16_t* right = outputs[1];
+        // per 128-bit lane: L0 R0 L1 R1 L2 R2 L3 R3 -> L0 L1 L2 L3 R0 R1 R2 R3
+        const __m256i split = _mm256_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15,
+                                               0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15);
+        for (; i + 8 <= num_frames; i += 8){
+            __m256i frames = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + 2 * i));
+            frames = _mm256_shuffle_epi8(frames, split);
+            frames = _mm256_permute4x64_epi64(frames, _MM_SHUFFLE(3, 1, 2, 0)); // L L | R R
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(left + i),  _mm256_castsi256_si128(frames));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(right + i), _mm256_extracti128_si256(frames, 1));
+        }
+    }
+#endif
+    for (; i < num_frames; ++i){
+        for (size_t c = 0; c < num_channels; ++c){
+            outputs[c][i] = input[i * num_channels + c];
+        }
+    }
+}
+
+
+float dot_product(const float* x, const float* h, size_t size){
+    size_t i = 0;
+    float result = 0;
+#ifdef __AVX2__
+    // two accumulators hide the fma latency
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    for (; i + 16 <= size; i += 16){
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i),     _mm256_loadu_ps(h + i),     acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(h + i + 8), acc1);
+    }
+    if (i + 8 <= size){
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(h + i), acc0);
+        i += 8;
+    }
+    result = horizontal_sum(_mm256_add_ps(acc0, acc1));
+#endif
+    for (; i < size; ++i){
+        result += x[i] * h[i];
+    }
+    return result;
+}
+
+
+float sum_of_squares(const float* x, size_t size){
+    size_t i = 0;
+    float result = 0;
+#ifdef __AVX2__
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    for (; i + 16 <= size; i += 16){
+        __m256 x0 = _mm256_loadu_ps(x + i);
+        __m256 x1 = _mm256_loadu_ps(x + i + 8);
+        acc0 = _mm256_fmadd_ps(x0, x0, acc0);
+        acc1 = _mm256_fmadd_ps(x1, x1, acc1);
+    }
+    result = horizontal_sum(_mm256_add_ps(acc0, acc1));
+#endif
+    for (; i < size; ++i){
+        result += x[i] * x[i];
+    }
+    return result;
+}
+
+
+size_t zero_crossings(const float* x, size_t size){
+    if (size < 2) return 0;
+    size_t i = 0;
+    size_t count = 0;
+#ifdef __AVX2__
+    // compare the sign masks of x[i..i+8) and x[i+1..i+9)
+    const __m256 zero = _mm256_setzero_ps();
+    for (; i + 9 <= size; i += 8){
+        int current = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(x + i),     zero, _CMP_LT_OQ));
+        int next    = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(x + i + 1), zero, _CMP_LT_OQ));
+        count += __builtin_popcount(static_cast<unsigned>(current ^ next));
+    }
+#endif
+    for (; i + 1 < size; ++i){
+        count += (x[i] < 0) != (x[i + 1] < 0);
+    }
+    return count;
+}
+
+
+    } // namespace simd
+} // namespace asr
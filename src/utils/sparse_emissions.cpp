@@ -0,0 +1,126 @@
+#include "utils/sparse_emissions.hpp"
+#include <glog/logging.h>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+
+namespace asr{
+    namespace emissions{
+
+
+sparseEmissions::sparseEmissions(size_t vocab_size, sparseEmissionsConfig config) :
+    _vocab_size(vocab_size), _config(config){
+    if (_vocab_size > 256){ // token indices are stored in a byte
+        DLOG(WARNING) << "[sparseEmissions/constructor]: vocab size " << _vocab_size
+                      << " does not fit the sparse format (max 256). Throwing exception";
+        throw std::runtime_error("vocab too large for sparse emissions");
+    }
+    _config.top_k = std::min(_config.top_k, _vocab_size);
+    if (_config.quantization != NO_QUANTIZATION){
+        float num_levels = static_cast<float>((1u << _config.quantization) - 1);
+        _scale = -_config.min_log_prob / num_levels;
+    }
+}
+
+
+sparseEmissions sparseEmissions::from_log_probs(const float* log_probs,
+                                                size_t num_frames,
+                                                size_t vocab_size,
+                                                sparseEmissionsConfig config){
+    sparseEmissions result(vocab_size, config);
+    result._indices.reserve(num_frames * result._config.top_k);
+    result._blank_log_probs.reserve(num_frames);
+    for (size_t t = 0; t < num_frames; ++t){
+        result.append_frame(log_probs + t * vocab_size);
+    }
+    return result;
+}
+
+
+void sparseEmissions::append_frame(const float* log_probs){
+    // top-k by partial sort of the token indices (vocab is small)
+    uint8_t order[256];
+    for (size_t i = 0; i < _vocab_size; ++i) order[i] = static_cast<uint8_t>(i);
+    std::partial_sort(order, order + _config.top_k, order + _vocab_size,
+                      [log_probs](uint8_t a, uint8_t b){return log_probs[a] > log_probs[b];});
+
+    for (size_t i = 0; i < _config.top_k; ++i){
+        _indices.push_back(order[i]);
+        store(log_probs[order[i]]);
+    }
+    _blank_log_probs.push_back(log_probs[_config.blank_index]);
+    ++_num_frames;
+}
+
+
+void sparseEmissions::append(const sparseEmissions& other){
+    if (other.empty()) return;
+    if (empty() && _vocab_size == 0){
+        *this = other;
+        return;
+    }
+    if (other._vocab_size != _vocab_size || other._config.top_k != _config.top_k ||
+        other._config.quantization != _config.quantization || other._scale != _scale){
+        throw std::runtime_error("can not append sparse emissions with a different layout");
+    }
+    _indices.insert(_indices.end(), other._indices.begin(), other._indices.end());
+    _values.insert(_values.end(), other._values.begin(), other._values.end());
+    _values_q16.insert(_values_q16.end(), other._values_q16.begin(), other._values_q16.end());
+    _values_q8.insert(_values_q8.end(), other._values_q8.begin(), other._values_q8.end());
+    _blank_log_probs.insert(_blank_log_probs.end(), other._blank_log_probs.begin(), other._blank_log_probs.end());
+    _num_frames += other._num_frames;
+}
+
+
+void sparseEmissions::store(float log_prob){
+    if (_config.quantization == NO_QUANTIZATION){
+        _values.push_back(log_prob);
+        return;
+    }
+    float clamped = std::min(0.0f, std::max(_config.min_log_prob, log_prob));
+    uint32_t level = static_cast<uint32_t>(std::lround((clamped - _config.min_log_prob) / _scale));
+    if (_config.quantization == QUANTIZE_16){
+        _values_q16.push_back(static_cast<uint16_t>(level));
+    }
+    else{
+        _values_q8.push_back(static_cast<uint8_t>(level));
+    }
+}
+
+
+float sparseEmissions::dequantize(size_t value_index) const {
+    switch (_config.quantization){
+        case QUANTIZE_16:
+            return _config.min_log_prob + _values_q16[value_index] * _scale;
+        case QUANTIZE_8:
+            return _config.min_log_prob + _values_q8[value_index] * _scale;
+        default:
+            return _values[value_index];
+    }
+}
+
+
+void sparseEmissions::get_frame(size_t frame_index, std::vector<std::pair<size_t, double>>& out) const {
+    if (frame_index >= _num_frames){
+        throw std::runtime_error("sparse emissions frame out of bound");
+    }
+    out.clear();
+    size_t offset = frame_index * _config.top_k;
+    for (size_t i = 0; i < _config.top_k; ++i){
+        out.emplace_back(_indices[offset + i], dequantize(offset + i));
+    }
+}
+
+
+size_t sparseEmissions::get_size_bytes() const {
+    return _indices.size() * sizeof(uint8_t) +
+           _values.size() * sizeof(float) +
+           _values_q16.size() * sizeof(uint16_t) +
+           _values_q8.size() * sizeof(uint8_t) +
+           _blank_log_probs.size() * sizeof(float);
+}
+
+
+    } // namespace emissions
+} // namespace asr
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <utils/stream_handler.hpp>
 #include <glog/logging.h>
+#include <algorithm>
 
 
 
@@ -34,7 +35,7 @@ streamHandler::~streamHandler(){
 int streamHandler::init_portaudio(){
 
     _err = Pa_Initialize();
-    if (_err =! paNoError){
+    if (_err != paNoError){
         DLOG(WARNING) << "[streamHandler/inti_stream]:  Was not able to initialize portaudio.";
         DLOG(WARNING) << Pa_GetErrorText(_err);
         return -1;
@@ -51,18 +52,24 @@ int streamHandler::open_stream( int (*callback)(const void *input,
                                     const PaStreamCallbackTimeInfo *timeInfo, 
                                     PaStreamCallbackFlags statusFlags, 
                                     void *userData
-                                )
+                                ),
+                void* user_data
                 ){
+    if (_stream){ // the open one would leak
+        DLOG(WARNING) << "[streamHandler/open_stream]: a stream is already open. close_stream() first";
+        return -1;
+    }
     _err = Pa_OpenDefaultStream(&_stream,
                                 _num_in_channels,
                                 _num_out_channels,
-                                paFloat32,
+                                _sample_format,
                                 _sample_rate,
                                 _frames_per_buffer,
                                 callback,
-                                nullptr
+                                user_data
                                 );
     if (_err != paNoError){
+        _stream = nullptr;
         DLOG(WARNING) << "[streamHandler/open_stream]: " 
         << "There was an error opening the stream \n" 
         <<  Pa_GetErrorText(_err) << std::endl;
@@ -74,6 +81,74 @@ int streamHandler::open_stream( int (*callback)(const void *input,
 }
 
 
+int streamHandler::open_stream(){
+    // the running stream's callback holds the current sink as userData: never replace it under an open stream
+    if (_stream){
+        DLOG(WARNING) << "[streamHandler/open_stream]: a stream is already open. close_stream() first";
+        return -1;
+    }
+    // the rings are allocated here, never on the audio thread
+    size_t capacity_frames = std::max<size_t>(static_cast<size_t>(_capture_buffer_seconds * _sample_rate),
+                                              2 * _frames_per_buffer);
+    auto capture_format = (_sample_format == paInt16) ? asr::audio::CAPTURE_INT16 : asr::audio::CAPTURE_FLOAT32;
+    if (_num_in_channels > 1){
+        _capture_sink.reset();
+        _multi_channel_sink = std::make_unique<asr::audio::multiChannelCaptureSink>(static_cast<double>(_sample_rate),
+                                                                                    capacity_frames,
+                                                                                    _num_in_channels,
+                                                                                    capture_format);
+        return open_stream(&streamHandler::multi_channel_capture_callback, _multi_channel_sink.get());
+    }
+    _multi_channel_sink.reset();
+    _capture_sink = std::make_unique<asr::audio::captureSink>(static_cast<double>(_sample_rate),
+                                                              capacity_frames,
+                                                              capture_format);
+    return open_stream(&streamHandler::capture_callback, _capture_sink.get());
+}
+
+
+int streamHandler::capture_callback(const void *input, 
+                                    void *output,
+                                    unsigned long frameCount, 
+                                    const PaStreamCallbackTimeInfo *timeInfo, 
+                                    PaStreamCallbackFlags statusFlags, 
+                                    void *userData){
+    auto capture_sink = static_cast<asr::audio::captureSink*>(userData);
+    double adc_time      = timeInfo ? timeInfo->inputBufferAdcTime : 0;
+    double callback_time = timeInfo ? timeInfo->currentTime : 0;
+    if (capture_sink->get_format() == asr::audio::CAPTURE_INT16){ // raw frames, converted by the consumer
+        capture_sink->on_audio(static_cast<const int16_t*>(input), frameCount, adc_time, callback_time,
+                               statusFlags & paInputOverflow, statusFlags & paInputUnderflow);
+    }
+    else{
+        capture_sink->on_audio(static_cast<const float*>(input), frameCount, adc_time, callback_time,
+                               statusFlags & paInputOverflow, statusFlags & paInputUnderflow);
+    }
+    return paContinue;
+}
+
+
+int streamHandler::multi_channel_capture_callback(const void *input, 
+                                                  void *output,
+                                                  unsigned long frameCount, 
+                                                  const PaStreamCallbackTimeInfo *timeInfo, 
+                                                  PaStreamCallbackFlags statusFlags, 
+                                                  void *userData){
+    auto capture_sink = static_cast<asr::audio::multiChannelCaptureSink*>(userData);
+    double adc_time      = timeInfo ? timeInfo->inputBufferAdcTime : 0;
+    double callback_time = timeInfo ? timeInfo->currentTime : 0;
+    if (capture_sink->get_format() == asr::audio::CAPTURE_INT16){
+        capture_sink->on_audio(static_cast<const int16_t*>(input), frameCount, adc_time, callback_time,
+                               statusFlags & paInputOverflow, statusFlags & paInputUnderflow);
+    }
+    else{
+        capture_sink->on_audio(static_cast<const float*>(input), frameCount, adc_time, callback_time,
+                               statusFlags & paInputOverflow, statusFlags & paInputUnderflow);
+    }
+    return paContinue;
+}
+
+
 int streamHandler::start_stream(){
 
     _err = Pa_StartStream(_stream);
@@ -88,6 +163,7 @@ int streamHandler::start_stream(){
 
 
 int streamHandler::stop_stream(){
+    if (!_stream) return 0; // never opened, or closed already
     _err = Pa_StopStream(_stream);
     if (_err != paNoError){
         DLOG(WARNING) << "[streamHandler/stop_stream]: There was an error stopping the stream. " 
@@ -100,7 +176,9 @@ int streamHandler::stop_stream(){
 
 
 int streamHandler::close_stream(){
+    if (!_stream) return 0; // never opened, or closed already
     _err = Pa_CloseStream(_stream);
+    _stream = nullptr; // a failed close does not leave a stream to close again
     if (_err != paNoError){
         DLOG(WARNING) << "[streamHandler/close_stream]: There was an error closing the stream. " 
                       << Pa_GetErrorText(_err) << std::endl;
@@ -145,7 +223,19 @@ const unsigned long streamHandler::get_sample_rate(){return _sample_rate;}
 const unsigned long streamHandler::get_frames_per_buffer(){return _frames_per_buffer;}
 
 
-const PaSampleFormat streamHandler::get_sample_format(){return paFloat32;} // TODO: I  might enable other formats
+const PaSampleFormat streamHandler::get_sample_format(){return _sample_format;}
+
+
+bool streamHandler::set_sample_format(PaSampleFormat sample_format){
+    if (sample_format != paFloat32 && sample_format != paInt16){
+        LOG(WARNING) << "[streamHandler/set_sample_format]: only paFloat32 and paInt16 are supported. keeping "
+                     << (_sample_format == paInt16 ? "paInt16" : "paFloat32");
+        return false;
+    }
+    VLOG(3) << "[streamHandler/set_sample_format]: capturing " << (sample_format == paInt16 ? "paInt16" : "paFloat32");
+    _sample_format = sample_format;
+    return true;
+}
 
 
 const std::tuple<int, int> streamHandler::get_number_of_channels(){
@@ -153,7 +243,7 @@ const std::tuple<int, int> streamHandler::get_number_of_channels(){
 }
 
 
-void streamHandler::set_sample_rate(unsigned long& sample_rate){
+bool streamHandler::set_sample_rate(unsigned long& sample_rate){
     if (is_sample_rate_supported(sample_rate)){
         VLOG(3) << "[streamHandler/set_sample_rate]: setting sample rate to " << sample_rate;
         _sample_rate = sample_rate;
@@ -167,11 +257,13 @@ void streamHandler::set_sample_rate(unsigned long& sample_rate){
         else{
             DLOG(WARNING) << "[streamHandler/set_sample_rate]: was not able to retrieve the device info" ;
         }
-        VLOG(3) << "[streamHandler/set_sample_rate]: sample rate " << sample_rate 
-                << " is not suppported by device " << device_name;
+        LOG(WARNING) << "[streamHandler/set_sample_rate]: sample rate " << sample_rate 
+                     << " is not suppported by device " << device_name << ". keeping " << _sample_rate
+                     << " Hz (resample to the model rate with asr::audio::polyphaseResampler)";
+        return false;
     }
     
-    return;
+    return true;
 }
 
 
@@ -180,6 +272,17 @@ void streamHandler::set_framed_per_buffer(unsigned long frames_per_buffer){
 }
 
 
+void streamHandler::set_number_of_channles(int num_input_channels, int num_output_channels){
+    if (num_input_channels > static_cast<int>(asr::audio::multiChannelCaptureSink::MAX_CHANNELS)){
+        LOG(WARNING) << "[streamHandler/set_number_of_channles]: " << num_input_channels << " input channels requested. "
+                     << "the capture sink supports up to " << asr::audio::multiChannelCaptureSink::MAX_CHANNELS;
+        num_input_channels = asr::audio::multiChannelCaptureSink::MAX_CHANNELS;
+    }
+    _num_in_channels  = std::max(num_input_channels, 0);
+    _num_out_channels = std::max(num_output_channels, 0);
+}
+
+
 bool streamHandler::is_sample_rate_supported(double sample_rate){
     const PaDeviceInfo* device_info = get_device_info();
     int channel_count = 1;
@@ -208,4 +311,52 @@ bool streamHandler::is_sample_rate_supported(double sample_rate){
         return false;
     }
      
-}
\ No newline at end of file
+}
+
+
+portAudioSource::portAudioSource(unsigned long sample_rate,
+                                 unsigned long frames_per_buffer,
+                                 PaSampleFormat sample_format,
+                                 double buffer_seconds) :
+    _stream_handler(sample_rate, frames_per_buffer), _sample_rate(sample_rate){
+    _stream_handler.set_sample_format(sample_format);
+    _stream_handler.set_capture_buffer_seconds(buffer_seconds);
+}
+
+
+portAudioSource::~portAudioSource(){
+    stop();
+    if (_initialized){
+        _stream_handler.close_stream(); // the handler's destructor then has no stream left to touch
+        _stream_handler.terminate_portaudio();
+    }
+}
+
+
+bool portAudioSource::start(){
+    if (_running){
+        LOG(WARNING) << "[portAudioSource/start]: the stream is already running";
+        return false;
+    }
+    if (!_initialized){
+        if (_stream_handler.init_portaudio() < 0){
+            LOG(WARNING) << "[portAudioSource/start]: failed to initialize portaudio";
+            return false;
+        }
+        if (_stream_handler.open_stream() < 0){
+            LOG(WARNING) << "[portAudioSource/start]: failed to open the default input device";
+            _stream_handler.terminate_portaudio(); // every successful Pa_Initialize gets its Pa_Terminate
+            return false;
+        }
+        _initialized = true;
+    }
+    _running = _stream_handler.start_stream() > 0;
+    return _running;
+}
+
+
+void portAudioSource::stop(){
+    if (!_running) return;
+    _stream_handler.stop_stream();
+    _running = false;
+}
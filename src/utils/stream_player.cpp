@@ -0,0 +1,154 @@
+#include "utils/stream_player.hpp"
+#include <glog/logging.h>
+#include <algorithm>
+#include <queue>
+
+
+namespace asr{
+    namespace audio{
+
+
+multiStreamPlayer::multiStreamPlayer(streamPlayerConfig config) : _config(config){
+    if (_config.frames_per_buffer == 0){
+        LOG(WARNING) << "[multiStreamPlayer/constructor]: frames_per_buffer is 0. using 160";
+        _config.frames_per_buffer = 160;
+    }
+    if (_config.speed < 0){
+        LOG(WARNING) << "[multiStreamPlayer/constructor]: negative speed. playing as fast as possible";
+        _config.speed = 0;
+    }
+    DLOG(INFO) << "[multiStreamPlayer/constructor]: instance created. speed: " << _config.speed
+               << ", frames per buffer: " << _config.frames_per_buffer;
+}
+
+
+multiStreamPlayer::~multiStreamPlayer(){
+    stop();
+}
+
+
+size_t multiStreamPlayer::add_stream(const std::vector<float>& audio, captureSink& sink){
+    if (_running){
+        LOG(WARNING) << "[multiStreamPlayer/add_stream]: can not add a stream while playing";
+        return _streams.size();
+    }
+    if (sink.get_capacity() < _config.frames_per_buffer){
+        LOG(WARNING) << "[multiStreamPlayer/add_stream]: sink capacity " << sink.get_capacity()
+                     << " is smaller than one buffer (" << _config.frames_per_buffer << " frames)";
+    }
+    auto stream = std::make_unique<playerStream>();
+    stream->audio        = &audio;
+    stream->sink         = &sink;
+    stream->start_offset = _streams.size() * _config.stagger_seconds;
+    _streams.push_back(std::move(stream));
+    return _streams.size() - 1;
+}
+
+
+void multiStreamPlayer::start(){
+    if (_running){
+        LOG(WARNING) << "[multiStreamPlayer/start]: player is already running";
+        return;
+    }
+    _num_finished   = 0;
+    _late_callbacks = 0;
+    for (auto& stream : _streams){
+        stream->position = 0;
+        stream->finished = false;
+    }
+    _start_time = clock::now();
+    _running    = true;
+    if (_config.speed > 0){
+        _thread = std::thread(&multiStreamPlayer::paced_loop, this);
+    }
+    else{
+        _thread = std::thread(&multiStreamPlayer::as_fast_as_possible_loop, this);
+    }
+}
+
+
+void multiStreamPlayer::stop(){
+    _running = false;
+    if (_thread.joinable()) _thread.join();
+}
+
+
+double multiStreamPlayer::get_capture_time(size_t stream_index, size_t frame) const {
+    const auto& stream = *_streams[stream_index];
+    double audio_time  = stream.start_offset + frame / stream.sink->get_sample_rate();
+    return _config.speed > 0 ? audio_time / _config.speed : audio_time;
+}
+
+
+double multiStreamPlayer::get_elapsed() const {
+    return std::chrono::duration<double>(clock::now() - _start_time).count();
+}
+
+
+bool multiStreamPlayer::deliver(playerStream& stream, double adc_time){
+    size_t remaining = stream.audio->size() - stream.position;
+    size_t num_frames = std::min(_config.frames_per_buffer, remaining);
+    if (num_frames > 0){
+        stream.sink->on_audio(stream.audio->data() + stream.position, num_frames,
+                              adc_time, get_elapsed(), false, false);
+        stream.position += num_frames;
+    }
+    if (stream.position < stream.audio->size()) return false;
+
+    stream.finished.store(true, std::memory_order_release);
+    _num_finished.fetch_add(1, std::memory_order_acq_rel);
+    return true;
+}
+
+
+void multiStreamPlayer::paced_loop(){
+    // min-heap of (deadline in seconds since start, stream index)
+    typedef std::pair<double, size_t> deadline;
+    std::priority_queue<deadline, std::vector<deadline>, std::greater<deadline>> deadlines;
+    for (size_t i = 0; i < _streams.size(); ++i){
+        deadlines.emplace(get_capture_time(i, _config.frames_per_buffer), i);
+    }
+
+    while (_running.load(std::memory_order_relaxed) && !deadlines.empty()){
+        auto [due, stream_index] = deadlines.top();
+        deadlines.pop();
+        // a callback fires once its whole buffer has been "recorded"
+        std::this_thread::sleep_until(_start_time + std::chrono::duration_cast<clock::duration>(
+                                                     std::chrono::duration<double>(due)));
+        auto& stream = *_streams[stream_index];
+        double buffer_period = _config.frames_per_buffer / stream.sink->get_sample_rate() / _config.speed;
+        if (get_elapsed() > due + buffer_period){ // the player itself fell a buffer behind
+            _late_callbacks.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        double adc_time = get_capture_time(stream_index, stream.position);
+        if (!deliver(stream, adc_time)){
+            deadlines.emplace(get_capture_time(stream_index, stream.position + _config.frames_per_buffer), stream_index);
+        }
+    }
+    VLOG(2) << "[multiStreamPlayer/paced_loop]: " << _num_finished.load() << " of " << _streams.size()
+            << " streams finished. late callbacks: " << _late_callbacks.load();
+}
+
+
+void multiStreamPlayer::as_fast_as_possible_loop(){
+    while (_running.load(std::memory_order_relaxed) && !all_finished()){
+        bool delivered = false;
+        for (size_t i = 0; i < _streams.size(); ++i){
+            auto& stream = *_streams[i];
+            if (stream.finished.load(std::memory_order_relaxed)) continue;
+            // back-pressure instead of drops: only write when the whole buffer fits
+            size_t buffer_frames = std::min(_config.frames_per_buffer, stream.sink->get_capacity());
+            if (stream.sink->get_capacity() - stream.sink->get_available() < buffer_frames) continue;
+            deliver(stream, get_capture_time(i, stream.position));
+            delivered = true;
+        }
+        if (!delivered){
+            std::this_thread::yield();
+        }
+    }
+}
+
+
+    } // namespace audio
+} // namespace asr
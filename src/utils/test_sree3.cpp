@@ -12,9 +12,6 @@ void fill_ones(std::vector<T>& vec, int size){
     for (int i = 0; i < size; ++i) vec.push_back(static_cast<T>(1));
 }
 
-fst::SymbolTable beam::ctcBeam::input_symbol_table_;
-std::unique_ptr<beam::FSTDICT>  beam::ctcBeam::dictionary_ptr_;
-std::unique_ptr<beam::FSTMATCH> beam::ctcBeam::matcher_ptr_;
 
 int main(int argc, char** argv){
   
@@ -40,7 +37,9 @@ int main(int argc, char** argv){
     auto dict_fst  = lex_fst.get_lexicon_fst();
     std::cout << "ptr: "<< dict_fst << std::endl;
     auto symbol_table = lex_fst.get_input_symbol_table();
-    beam::ctcBeam::set_fst(dict_fst, symbol_table); // symbol_table 
+    beam::FSTDICT dictionary(*dict_fst);
+    beam::FSTMATCH matcher(&dictionary, fst::MATCH_INPUT);
+    beam::ctcBeam::bind_fst(&dictionary, &matcher, symbol_table); // symbol_table 
 
 
 
@@ -0,0 +1,157 @@
+#include "utils/vad.hpp"
+#include "utils/simd_kernels.hpp"
+#include <glog/logging.h>
+#include <algorithm>
+#include <cmath>
+
+
+namespace asr{
+    namespace audio{
+
+
+energyVad::energyVad(vadConfig config) : _config(config){
+    _frame_size = std::max<size_t>(1, _config.sample_rate * _config.frame_ms / 1000);
+    auto to_frames = [this](size_t ms){return (ms * _config.sample_rate / 1000 + _frame_size - 1) / _frame_size;};
+    _min_speech_frames = std::max<size_t>(1, to_frames(_config.min_speech_ms));
+    _hangover_frames   = std::max<size_t>(1, to_frames(_config.hangover_ms));
+    _preroll_size      = (to_frames(_config.preroll_ms) + _min_speech_frames) * _frame_size;
+    _pending.reserve(_frame_size);
+    _preroll.reserve(_preroll_size + _frame_size);
+    _noise_db = _config.initial_noise_db;
+    DLOG(INFO) << "[energyVad/constructor]: instance created. frame size: " << _frame_size
+               << ", onset frames: " << _min_speech_frames << ", hangover frames: " << _hangover_frames;
+}
+
+
+void energyVad::reset(){
+    _pending.clear();
+    _preroll.clear();
+    _in_speech     = false;
+    _onset_frames  = 0;
+    _hangover_left = 0;
+    _noise_db      = _config.initial_noise_db;
+    _stats         = vadStats{};
+}
+
+
+bool energyVad::classify(const float* frame, size_t frame_size, float& energy_db) const {
+    float mean_square = simd::sum_of_squares(frame, frame_size) / frame_size;
+    energy_db = 10.0f * std::log10(mean_square + 1e-10f);
+
+    float threshold = std::max(_noise_db + _config.speech_margin_db, _config.min_energy_db);
+    if (energy_db > threshold) return true;
+    if (energy_db > threshold - _config.fricative_margin_db){
+        float zcr = static_cast<float>(simd::zero_crossings(frame, frame_size)) / frame_size;
+        return zcr > _config.fricative_zcr;
+    }
+    return false;
+}
+
+
+bool energyVad::is_speech_frame(const float* frame, size_t frame_size) const {
+    float energy_db;
+    return classify(frame, frame_size, energy_db);
+}
+
+
+void energyVad::update_noise_floor(float energy_db){
+    // drops immediately to quieter frames, rises slowly (and much slower inside a segment, so
+    // speech does not raise its own threshold)
+    if (energy_db < _noise_db){
+        _noise_db = energy_db;
+        return;
+    }
+    float rate = _in_speech ? _config.noise_adapt_rate * 0.1f : _config.noise_adapt_rate;
+    _noise_db += rate * (energy_db - _noise_db);
+}
+
+
+void energyVad::process(const float* input, size_t num_samples, std::vector<vadChunk>& output){
+    _stats.samples_in += num_samples;
+    size_t position = 0;
+
+    // complete the frame left over by the previous call
+    if (!_pending.empty()){
+        size_t needed = std::min(_frame_size - _pending.size(), num_samples);
+        _pending.insert(_pending.end(), input, input + needed);
+        position = needed;
+        if (_pending.size() < _frame_size) return;
+        process_frame(_pending.data(), output);
+        _pending.clear();
+    }
+    for (; position + _frame_size <= num_samples; position += _frame_size){
+        process_frame(input + position, output);
+    }
+    _pending.insert(_pending.end(), input + position, input + num_samples);
+}
+
+
+void energyVad::process_frame(const float* frame, std::vector<vadChunk>& output){
+    float energy_db;
+    bool is_speech = classify(frame, _frame_size, energy_db);
+    update_noise_floor(energy_db);
+    if (is_speech) _stats.samples_speech += _frame_size;
+
+    if (_in_speech){
+        emit(frame, _frame_size, output);
+        if (is_speech){
+            _hangover_left = _hangover_frames;
+        }
+        else if (--_hangover_left == 0){
+            close_segment(output);
+        }
+        return;
+    }
+
+    // silence: keep the recent audio for the pre-roll, open a segment after a sustained onset
+    _preroll.insert(_preroll.end(), frame, frame + _frame_size);
+    if (_preroll.size() > _preroll_size){
+        _preroll.erase(_preroll.begin(), _preroll.begin() + (_preroll.size() - _preroll_size));
+    }
+    _onset_frames = is_speech ? _onset_frames + 1 : 0;
+    if (_onset_frames >= _min_speech_frames){
+        _in_speech     = true;
+        _hangover_left = _hangover_frames;
+        _onset_frames  = 0;
+        emit(_preroll.data(), _preroll.size(), output);
+        _preroll.clear();
+    }
+}
+
+
+void energyVad::emit(const float* samples, size_t num_samples, std::vector<vadChunk>& output){
+    if (output.empty() || output.back().end_of_segment){
+        output.emplace_back();
+    }
+    output.back().samples.insert(output.back().samples.end(), samples, samples + num_samples);
+    _stats.samples_forwarded += num_samples;
+}
+
+
+void energyVad::close_segment(std::vector<vadChunk>& output){
+    // the segment's samples may have been handed out by an earlier call: send the marker alone
+    if (output.empty() || output.back().end_of_segment){
+        output.emplace_back();
+    }
+    output.back().end_of_segment = true;
+    _in_speech = false;
+    _preroll.clear();
+    ++_stats.num_segments;
+    VLOG(3) << "[energyVad/close_segment]: segment " << _stats.num_segments << " closed. noise floor: "
+            << _noise_db << " dB";
+}
+
+
+void energyVad::flush(std::vector<vadChunk>& output){
+    if (_in_speech){
+        emit(_pending.data(), _pending.size(), output);
+        close_segment(output);
+    }
+    _pending.clear();
+    _preroll.clear();
+    _onset_frames = 0;
+}
+
+
+    } // namespace audio
+} // namespace asr
@@ -0,0 +1,286 @@
+#include "utils/wav_reader.hpp"
+#include "utils/simd_kernels.hpp"
+#include <glog/logging.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace asr{
+    namespace audio{
+
+
+namespace {
+    constexpr uint16_t WAVE_FORMAT_PCM        = 0x0001;
+    constexpr uint16_t WAVE_FORMAT_IEEE_FLOAT = 0x0003;
+    constexpr uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+    constexpr size_t CONVERSION_BLOCK_FRAMES = 4096;    // frames converted per pass (bounds the scratch)
+    constexpr size_t RELEASE_THRESHOLD_BYTES = 1 << 20; // drop consumed pages once this much was read
+
+    // the mapping is only byte aligned past the header, so every field is read with memcpy
+    template <typename T>
+    T read_le(const uint8_t* ptr){
+        T value;
+        std::memcpy(&value, ptr, sizeof(T));
+        return value;
+    }
+
+    wavSampleFormat to_sample_format(uint16_t format_tag, uint16_t bits_per_sample){
+        if (format_tag == WAVE_FORMAT_PCM){
+            switch (bits_per_sample){
+                case 16: return WAV_PCM_16;
+                case 24: return WAV_PCM_24;
+                case 32: return WAV_PCM_32;
+                default: return WAV_UNSUPPORTED;
+            }
+        }
+        if (format_tag == WAVE_FORMAT_IEEE_FLOAT && bits_per_sample == 32){
+            return WAV_FLOAT_32;
+        }
+        return WAV_UNSUPPORTED;
+    }
+} // namespace
+
+
+
+wavReader::wavReader(const fs::path& path_to_wav){
+    if (!open(path_to_wav)){
+        throw std::runtime_error("failed to open wav file: " + path_to_wav.string());
+    }
+}
+
+
+wavReader::~wavReader(){
+    close();
+}
+
+
+bool wavReader::open(const fs::path& path_to_wav){
+    close();
+
+    int fd = ::open(path_to_wav.c_str(), O_RDONLY);
+    if (fd < 0){
+        LOG(WARNING) << "[wavReader/open]: failed to open " << path_to_wav;
+        return false;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size < 12){
+        LOG(WARNING) << "[wavReader/open]: " << path_to_wav << " is too small to be a wav file";
+        ::close(fd);
+        return false;
+    }
+
+    size_t file_size = static_cast<size_t>(file_stat.st_size);
+    void* mapped = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping keeps the file alive
+    if (mapped == MAP_FAILED){
+        LOG(WARNING) << "[wavReader/open]: failed to map " << path_to_wav;
+        return false;
+    }
+    madvise(mapped, file_size, MADV_SEQUENTIAL); // read ahead, samples are consumed in order
+
+    _mapped       = static_cast<const uint8_t*>(mapped);
+    _mapped_size  = file_size;
+    _owns_mapping = true;
+    if (!parse_chunks()){
+        LOG(WARNING) << "[wavReader/open]: " << path_to_wav << " is not a supported wav file";
+        close();
+        return false;
+    }
+
+    _path = path_to_wav;
+    VLOG(2) << "[wavReader/open]: mapped " << path_to_wav << " (" << _info.num_frames << " frames, "
+            << _info.num_channels << " channels, " << _info.bits_per_sample << " bits, "
+            << _info.sample_rate << " Hz)";
+    return true;
+}
+
+
+bool wavReader::open_memory(const uint8_t* data, size_t size){
+    close();
+    if (!data || size < 12){
+        LOG(WARNING) << "[wavReader/open_memory]: buffer is too small to be a wav file";
+        return false;
+    }
+    _mapped      = data;
+    _mapped_size = size;
+    if (!parse_chunks()){
+        LOG(WARNING) << "[wavReader/open_memory]: buffer is not a supported wav file";
+        close();
+        return false;
+    }
+    return true;
+}
+
+
+void wavReader::close(){
+    if (_mapped && _owns_mapping){
+        munmap(const_cast<uint8_t*>(_mapped), _mapped_size);
+    }
+    _owns_mapping   = false;
+    _mapped         = nullptr;
+    _mapped_size    = 0;
+    _data           = nullptr;
+    _info           = wavInfo{};
+    _position       = 0;
+    _released_until = 0;
+}
+
+
+bool wavReader::parse_chunks(){
+    if (std::memcmp(_mapped, "RIFF", 4) != 0 || std::memcmp(_mapped + 8, "WAVE", 4) != 0){
+        VLOG(2) << "[wavReader/parse_chunks]: missing RIFF/WAVE header";
+        return false;
+    }
+
+    bool fmt_found = false;
+    size_t data_offset = 0, data_size = 0;
+    uint16_t format_tag = 0;
+
+    size_t offset = 12;
+    while (offset + 8 <= _mapped_size){
+        const uint8_t* chunk = _mapped + offset;
+        size_t chunk_size = read_le<uint32_t>(chunk + 4);
+        size_t available  = _mapped_size - offset - 8;
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0){
+            if (chunk_size < 16 || chunk_size > available) return false;
+            format_tag            = read_le<uint16_t>(chunk + 8);
+            _info.num_channels    = read_le<uint16_t>(chunk + 10);
+            _info.sample_rate     = read_le<uint32_t>(chunk + 12);
+            _info.block_align     = read_le<uint16_t>(chunk + 20);
+            _info.bits_per_sample = read_le<uint16_t>(chunk + 22);
+            if (format_tag == WAVE_FORMAT_EXTENSIBLE){
+                // the actual format is the first two bytes of the sub-format guid
+                if (chunk_size < 40) return false;
+                format_tag = read_le<uint16_t>(chunk + 32);
+            }
+            fmt_found = true;
+        }
+        else if (std::memcmp(chunk, "data", 4) == 0){
+            data_offset = offset + 8;
+            // recorders that were interrupted leave 0xFFFFFFFF or a stale size behind: clamp to the file
+            data_size = std::min(chunk_size, available);
+            if (fmt_found) break;
+        }
+        else{
+            VLOG(4) << "[wavReader/parse_chunks]: skipping chunk " << std::string(reinterpret_cast<const char*>(chunk), 4);
+        }
+        offset += 8 + chunk_size + (chunk_size & 1); // chunks are padded to an even size
+    }
+
+    if (!fmt_found || data_offset == 0){
+        VLOG(2) << "[wavReader/parse_chunks]: fmt or data chunk is missing";
+        return false;
+    }
+    _info.format = to_sample_format(format_tag, _info.bits_per_sample);
+    if (_info.format == WAV_UNSUPPORTED || _info.num_channels == 0 ||
+        _info.block_align != _info.num_channels * (_info.bits_per_sample / 8)){
+        VLOG(2) << "[wavReader/parse_chunks]: unsupported format tag " << format_tag
+                << " with " << _info.bits_per_sample << " bits per sample";
+        return false;
+    }
+
+    _data            = _mapped + data_offset;
+    _info.num_frames = data_size / _info.block_align;
+    return true;
+}
+
+
+void wavReader::convert(const uint8_t* input, float* output, size_t num_frames){
+    /*
+    converts num_frames interleaved frames to mono float32. mono files are converted straight
+    into output, multi-channel files go through the scratch buffer and are averaged
+    */
+    size_t num_samples = num_frames * _info.num_channels;
+    float* converted   = output;
+    if (_info.num_channels > 1){
+        _interleaved.resize(num_samples);
+        converted = _interleaved.data();
+    }
+
+    switch (_info.format){
+        case WAV_PCM_16:
+            simd::pcm16_to_float(reinterpret_cast<const int16_t*>(input), converted, num_samples);
+            break;
+        case WAV_PCM_24:
+            simd::pcm24_to_float(input, converted, num_samples);
+            break;
+        case WAV_PCM_32:
+            simd::pcm32_to_float(reinterpret_cast<const int32_t*>(input), converted, num_samples);
+            break;
+        case WAV_FLOAT_32:
+            std::memcpy(converted, input, num_samples * sizeof(float));
+            break;
+        default:
+            break;
+    }
+
+    if (_info.num_channels > 1){
+        simd::downmix_to_mono(converted, output, num_frames, _info.num_channels);
+    }
+}
+
+
+void wavReader::release_consumed(){
+    // consumed pages are clean file pages, dropping them only costs a refault if we seek back
+    if (!_owns_mapping) return;
+    static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t consumed_bytes = (_data - _mapped) + _position * _info.block_align;
+    size_t release_end    = consumed_bytes / page_size * page_size;
+    if (release_end < _released_until + RELEASE_THRESHOLD_BYTES) return;
+
+    madvise(const_cast<uint8_t*>(_mapped) + _released_until, release_end - _released_until, MADV_DONTNEED);
+    _released_until = release_end;
+}
+
+
+size_t wavReader::read(float* out, size_t max_frames){
+    if (!is_open()) return 0;
+
+    size_t num_frames = std::min(max_frames, get_remaining());
+    for (size_t done = 0; done < num_frames; ){
+        size_t block = std::min(CONVERSION_BLOCK_FRAMES, num_frames - done);
+        convert(_data + (_position + done) * _info.block_align, out + done, block);
+        done += block;
+    }
+    _position += num_frames;
+    release_consumed();
+    return num_frames;
+}
+
+
+size_t wavReader::read(std::vector<float>& out, size_t max_frames){
+    out.resize(std::min(max_frames, is_open() ? get_remaining() : 0));
+    size_t num_frames = read(out.data(), out.size());
+    out.resize(num_frames);
+    return num_frames;
+}
+
+
+std::vector<float> wavReader::read_all(){
+    std::vector<float> audio_data;
+    read(audio_data, is_open() ? get_remaining() : 0);
+    return audio_data;
+}
+
+
+bool wavReader::seek(size_t frame_index){
+    if (!is_open() || frame_index > _info.num_frames){
+        return false;
+    }
+    _position = frame_index;
+    if (_data - _mapped + _position * _info.block_align < _released_until){
+        _released_until = 0; // pages will refault on demand, restart the accounting
+    }
+    return true;
+}
+
+
+    } // namespace audio
+} // namespace asr
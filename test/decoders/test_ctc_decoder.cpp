@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "decoders/ctc_decoder.hpp"
+#include "decoders/decoder_resources.hpp"
+#include "decoders/lexicon_compiler.hpp"
+#include "utils/fst_artifact.hpp"
+
+namespace fs = std::filesystem;
+
+
+class ctcDecoderTest : public testing::Test{
+protected:
+    ctcDecoderTest(){
+        fs::create_directories(directory);
+        std::ofstream tokens_file(tokens_path);
+        for (char token : tokens) tokens_file << token << "\n";
+    };
+    ~ctcDecoderTest(){
+        fs::remove_all(directory);
+    }
+
+    // one frame per symbol of spelling (blank between repeats), each symbol at probability 0.9
+    std::vector<float> spell(const std::string& spelling){
+        std::vector<float> log_probs;
+        char previous = 0;
+        auto add_frame = [&](char symbol){
+            for (char token : tokens){
+                log_probs.push_back(token == symbol ? std::log(0.9f) : std::log(0.1f / (tokens.size() - 1)));
+            }
+        };
+        for (char symbol : spelling){
+            if (symbol == previous) add_frame('-');
+            add_frame(symbol);
+            previous = symbol;
+        }
+        add_frame('-');
+        return log_probs;
+    }
+
+    std::string best_sequence(const std::vector<beam::ctcBeam*>& beams){
+        auto best = std::max_element(beams.begin(), beams.end(),
+                                     [](const beam::ctcBeam* x, const beam::ctcBeam* y){return x->score < y->score;});
+        return best == beams.end() ? std::string() : (*best)->get_sequence();
+    }
+
+    fs::path compile_lexicon(const std::vector<std::string>& words, const std::string& name = "compiled_lexicon.fst"){
+        asr::lexicon::lexiconCompiler compiler;
+        for (const auto& word : words) compiler.add_word(word, word);
+        EXPECT_TRUE(compiler.compile());
+        fs::path fst_path = directory / name;
+        EXPECT_TRUE(compiler.write(fst_path));
+        return fst_path;
+    }
+
+    // the same automaton with <eps> output labels, as fsts built before the word labels were
+    fs::path compile_unlabeled_lexicon(const std::vector<std::string>& words){
+        asr::lexicon::lexiconCompiler compiler;
+        for (const auto& word : words) compiler.add_word(word, word);
+        EXPECT_TRUE(compiler.compile());
+        std::unique_ptr<fst::StdVectorFst> lex_fst(compiler.make_fst());
+        std::unique_ptr<fst::SymbolTable> input_symbols(compiler.make_input_symbols());
+        std::unique_ptr<fst::SymbolTable> output_symbols(compiler.make_output_symbols());
+        for (fst::StateIterator<fst::StdVectorFst> siter(*lex_fst); !siter.Done(); siter.Next()){
+            for (fst::MutableArcIterator<fst::StdVectorFst> aiter(lex_fst.get(), siter.Value()); !aiter.Done(); aiter.Next()){
+                auto arc = aiter.Value();
+                arc.olabel = 0;
+                aiter.SetValue(arc);
+            }
+        }
+        lex_fst->SetInputSymbols(input_symbols.get());
+        lex_fst->SetOutputSymbols(output_symbols.get());
+        fs::path fst_path = directory / "unlabeled_lexicon.fst";
+        EXPECT_TRUE(asr::myfst::write_const_fst(lex_fst.get(), fst_path));
+        return fst_path;
+    }
+
+    // unigrams, upper case like the librispeech lm
+    fs::path write_lm(){
+        fs::path lm_path = directory / "lm.arpa";
+        std::ofstream(lm_path) << "\\data\\\n"
+                                  "ngram 1=6\n\n"
+                                  "\\1-grams:\n"
+                                  "-1.0\t<unk>\n"
+                                  "-99\t<s>\n"
+                                  "-1.0\t</s>\n"
+                                  "-0.5\tCAT\n"
+                                  "-0.7\tBAT\n"
+                                  "-2.0\tRAT\n\n"
+                                  "\\end\\\n";
+        return lm_path;
+    }
+
+    const std::string tokens = "-|abcrtx";
+    fs::path directory   = fs::temp_directory_path() / "test_ctc_decoder";
+    fs::path tokens_path = directory / "tokens.txt";
+};
+
+
+TEST_F(ctcDecoderTest, DecodesOverACompiledLexicon){
+    // the compiled automaton shares its suffixes, so its start state is not the first state built
+    auto fst_path = compile_lexicon({"bat", "car", "cat", "rat"});
+    ctcDecoder decoder(tokens_path.string(), 5, fst_path, "none");
+    EXPECT_EQ(decoder.get_search_variant(), "fst lexicon + no lm");
+
+    auto log_probs = spell("cat");
+    size_t num_frames = log_probs.size() / tokens.size();
+    EXPECT_EQ(best_sequence(decoder.decode_log_probs(log_probs.data(), num_frames)), "cat");
+
+    // "xat" is not a prefix of the lexicon: the best beam keeps to the words
+    decoder.reset();
+    log_probs = spell("xat");
+    auto sequence = best_sequence(decoder.decode_log_probs(log_probs.data(), num_frames));
+    EXPECT_EQ(sequence.find('x'), std::string::npos) << sequence;
+}
+
+
+TEST_F(ctcDecoderTest, KeepsItsResourcesVersionUntilReset){
+    beam::resourceRegistry registry;
+    ASSERT_TRUE(registry.swap_lexicon(compile_lexicon({"bat", "cat"}, "first.fst")));
+    ctcDecoder decoder(tokens_path.string(), 5);
+    decoder.attach(registry);
+    EXPECT_EQ(decoder.get_resources_version(), 1);
+    EXPECT_EQ(decoder.get_search_variant(), "fst lexicon + no lm");
+
+    auto log_probs = spell("cat");
+    size_t num_frames = log_probs.size() / tokens.size();
+    decoder.decode_log_probs(log_probs.data(), num_frames / 2);
+
+    // a swap in the middle of an utterance reaches the decoder at its next reset
+    ASSERT_TRUE(registry.swap_lexicon(compile_lexicon({"rat"}, "second.fst")));
+    decoder.decode_log_probs(log_probs.data() + (num_frames / 2) * tokens.size(), num_frames - num_frames / 2);
+    EXPECT_EQ(decoder.get_resources_version(), 1);
+    EXPECT_EQ(best_sequence(decoder.get_top_beams()), "cat");
+
+    decoder.reset();
+    EXPECT_EQ(decoder.get_resources_version(), 2);
+    log_probs = spell("rat");
+    EXPECT_EQ(best_sequence(decoder.decode_log_probs(log_probs.data(), num_frames)), "rat");
+}
+
+
+TEST_F(ctcDecoderTest, SelectsTheSearchOfItsResources){
+    auto fst_path = compile_lexicon({"bat", "cat", "rat"});
+    auto lm_path  = write_lm();
+    beam::resourceRegistry lm_only, lexicon_only, lexicon_and_lm, unlabeled_and_lm;
+    ASSERT_TRUE(lm_only.swap_lm(lm_path));
+    ASSERT_TRUE(lexicon_only.swap_lexicon(fst_path));
+    ASSERT_TRUE(lexicon_and_lm.swap(fst_path, lm_path));
+    ASSERT_TRUE(unlabeled_and_lm.swap(compile_unlabeled_lexicon({"bat", "cat", "rat"}), lm_path));
+
+    ctcDecoder decoder(tokens_path.string(), 5);
+    EXPECT_EQ(decoder.get_search_variant(), "no lexicon + no lm");
+    decoder.attach(lm_only);
+    EXPECT_EQ(decoder.get_search_variant(), "no lexicon + kenlm (strings)");
+    decoder.attach(lexicon_only);
+    EXPECT_EQ(decoder.get_search_variant(), "fst lexicon + no lm");
+    decoder.attach(lexicon_and_lm);
+    EXPECT_EQ(decoder.get_search_variant(), "fst lexicon + kenlm (word ids)");
+    EXPECT_FALSE(decoder.get_word_map().empty());
+    decoder.attach(unlabeled_and_lm);
+    EXPECT_EQ(decoder.get_search_variant(), "fst lexicon + kenlm (strings)");
+    EXPECT_TRUE(decoder.get_word_map().empty());
+}
+
+
+TEST_F(ctcDecoderTest, NoLexiconWithAnLmScoresWordsOnTopOfTheSameBeams){
+    beam::resourceRegistry lm_only;
+    ASSERT_TRUE(lm_only.swap_lm(write_lm()));
+    auto log_probs = spell("cat|bat|rat|");
+    size_t num_frames = log_probs.size() / tokens.size();
+
+    ctcDecoder tokens_only(tokens_path.string(), 5);
+    auto expected_beams = tokens_only.decode_log_probs(log_probs.data(), num_frames);
+    ASSERT_FALSE(expected_beams.empty());
+
+    // with alpha = beta = 0 the lm search must find the very same beams, scores and word windows
+    ctcDecoder with_lm(tokens_path.string(), 5);
+    with_lm.attach(lm_only);
+    ASSERT_EQ(with_lm.get_search_variant(), "no lexicon + kenlm (strings)");
+    with_lm.set_lm_weight(0);
+    with_lm.set_word_bonus(0);
+    auto beams = with_lm.decode_log_probs(log_probs.data(), num_frames);
+    ASSERT_EQ(beams.size(), expected_beams.size());
+    for (size_t i = 0; i < beams.size(); ++i){
+        EXPECT_EQ(beams[i]->get_sequence(), expected_beams[i]->get_sequence());
+        EXPECT_DOUBLE_EQ(beams[i]->get_score(), expected_beams[i]->get_score());
+        EXPECT_EQ(beams[i]->last_word_window.word_begin, expected_beams[i]->last_word_window.word_begin);
+        EXPECT_EQ(beams[i]->last_word_window.word_end, expected_beams[i]->last_word_window.word_end);
+    }
+    EXPECT_EQ(best_sequence(beams), "cat|bat|rat|");
+
+    // and with a weight, every completed word is scored
+    with_lm.reset();
+    with_lm.set_lm_weight(1);
+    beams = with_lm.decode_log_probs(log_probs.data(), num_frames);
+    ASSERT_FALSE(beams.empty());
+    auto best = std::max_element(beams.begin(), beams.end(),
+                                 [](const beam::ctcBeam* x, const beam::ctcBeam* y){return x->score < y->score;});
+    auto expected_best = std::max_element(expected_beams.begin(), expected_beams.end(),
+                                          [](const beam::ctcBeam* x, const beam::ctcBeam* y){return x->score < y->score;});
+    EXPECT_NE((*best)->get_score(), (*expected_best)->get_score());
+}
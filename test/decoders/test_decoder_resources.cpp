@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "decoders/decoder_resources.hpp"
+#include "decoders/lexicon_compiler.hpp"
+
+namespace fs = std::filesystem;
+using namespace beam;
+
+
+class decoderResourcesTest : public testing::Test{
+protected:
+    decoderResourcesTest(){
+        fs::create_directories(directory);
+
+        asr::lexicon::lexiconCompiler compiler;
+        for (std::string word : {"bat", "cat", "rat"}) compiler.add_word(word, word);
+        EXPECT_TRUE(compiler.compile());
+        EXPECT_TRUE(compiler.write(fst_path));
+
+        std::ofstream(lm_path) << "\\data\\\n"
+                                  "ngram 1=5\n\n"
+                                  "\\1-grams:\n"
+                                  "-1.0\t<unk>\n"
+                                  "-99\t<s>\n"
+                                  "-1.0\t</s>\n"
+                                  "-0.5\tCAT\n"
+                                  "-0.7\tBAT\n\n"
+                                  "\\end\\\n";
+    };
+    ~decoderResourcesTest(){
+        fs::remove_all(directory);
+    }
+
+    fs::path directory = fs::temp_directory_path() / "test_decoder_resources";
+    fs::path fst_path  = directory / "lexicon.fst";
+    fs::path lm_path   = directory / "lm.arpa";
+    resourceRegistry registry;
+};
+
+
+TEST_F(decoderResourcesTest, StartsEmptyAndUnpublished){
+    auto resources = registry.acquire();
+    ASSERT_TRUE(resources);
+    EXPECT_EQ(resources->version, 0);
+    EXPECT_FALSE(resources->has_lexicon());
+    EXPECT_FALSE(resources->has_lm());
+}
+
+
+TEST_F(decoderResourcesTest, PublishBumpsTheVersionAndKeepsOldReaders){
+    auto first = std::make_shared<decoderResources>();
+    EXPECT_EQ(registry.publish(first), 1);
+    auto pinned = registry.acquire();
+    EXPECT_EQ(pinned.get(), first.get());
+
+    EXPECT_EQ(registry.publish(std::make_shared<decoderResources>()), 2);
+    EXPECT_EQ(registry.get_version(), 2);
+
+    // a reader that pinned version 1 still holds it, unchanged
+    EXPECT_EQ(pinned->version, 1);
+    EXPECT_NE(registry.acquire().get(), pinned.get());
+}
+
+
+TEST_F(decoderResourcesTest, SwapsKeepTheOtherResource){
+    ASSERT_TRUE(registry.swap_lexicon(fst_path));
+    auto lexicon_only = registry.acquire();
+    EXPECT_EQ(lexicon_only->version, 1);
+    EXPECT_TRUE(lexicon_only->has_lexicon());
+    EXPECT_FALSE(lexicon_only->has_lm());
+    EXPECT_TRUE(lexicon_only->word_map.empty());
+
+    ASSERT_TRUE(registry.swap_lm(lm_path));
+    auto both = registry.acquire();
+    EXPECT_EQ(both->version, 2);
+    EXPECT_EQ(both->dictionary, lexicon_only->dictionary); // the lexicon stays mapped
+    EXPECT_TRUE(both->has_lm());
+    EXPECT_EQ(both->word_map.get_num_words(), 3);
+    EXPECT_EQ(both->word_map.get_num_oov(), 1); // rat (the map looks the words up in upper case)
+
+    ASSERT_TRUE(registry.swap_lexicon(fst_path));
+    EXPECT_EQ(registry.get_version(), 3);
+    EXPECT_EQ(registry.acquire()->lm_model, both->lm_model); // the lm stays loaded
+}
+
+
+TEST_F(decoderResourcesTest, FailedSwapsPublishNothing){
+    ASSERT_TRUE(registry.swap(fst_path, lm_path));
+    auto current = registry.acquire();
+
+    EXPECT_FALSE(registry.swap_lexicon(directory / "missing.fst"));
+    EXPECT_FALSE(registry.swap_lm(directory / "missing.arpa"));
+    EXPECT_FALSE(registry.swap(fst_path, directory / "missing.arpa"));
+    EXPECT_EQ(registry.get_version(), 1);
+    EXPECT_EQ(registry.acquire().get(), current.get());
+}
+
+
+TEST_F(decoderResourcesTest, ReadersSeeIncreasingVersions){
+    constexpr uint64_t num_versions = 200;
+    std::atomic<bool> done{false};
+    std::atomic<bool> ordered{true};
+    std::vector<std::thread> readers;
+    for (size_t i = 0; i < 4; ++i){
+        readers.emplace_back([&](){
+            uint64_t last_version = 0;
+            while (!done.load()){
+                uint64_t version = registry.acquire()->version;
+                if (version < last_version) ordered = false;
+                last_version = version;
+            }
+        });
+    }
+    for (uint64_t v = 1; v <= num_versions; ++v){
+        EXPECT_EQ(registry.publish(std::make_shared<decoderResources>()), v);
+    }
+    done = true;
+    for (auto& reader : readers) reader.join();
+    EXPECT_TRUE(ordered);
+    EXPECT_EQ(registry.get_version(), num_versions);
+}
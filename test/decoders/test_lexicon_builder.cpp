@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "decoders/lexicon.hpp"
+
+namespace fs = std::filesystem;
+
+
+class lexiconBuilderTest : public testing::Test{
+protected:
+    lexiconBuilderTest(){
+        fs::create_directories(directory);
+    };
+    ~lexiconBuilderTest(){
+        fs::remove_all(directory);
+    }
+
+    fs::path write_corpus(const std::string& name, const std::string& corpus){
+        fs::path path = directory / name;
+        std::ofstream(path, std::ios::binary) << corpus;
+        return path;
+    }
+
+    // the written lexicon: word -> spelling
+    std::map<std::string, std::string> build(const fs::path& corpus_path, const lexiconBuilderConfig& config){
+        fs::path lexicon_path = directory / ("lexicon_" + std::to_string(num_builds++) + ".txt");
+        {
+            GraphemeLexiconBuilder builder(corpus_path.string());
+            builder.generate_lexicon(lexicon_path.string(), config);
+        }
+        std::map<std::string, std::string> lexicon;
+        std::ifstream lexicon_file(lexicon_path);
+        std::string line;
+        while (std::getline(lexicon_file, line)){
+            auto tab = line.find('\t');
+            EXPECT_NE(tab, std::string::npos) << line;
+            lexicon[line.substr(0, tab)] = line.substr(tab + 1);
+        }
+        return lexicon;
+    }
+
+    lexiconBuilderConfig config_with(size_t num_threads){
+        lexiconBuilderConfig config;
+        config.num_threads = num_threads;
+        return config;
+    }
+
+    fs::path directory = fs::temp_directory_path() / "test_lexicon_builder";
+    size_t num_builds  = 0;
+};
+
+
+TEST_F(lexiconBuilderTest, ChunksGiveTheSameLexiconAsOneThread){
+    // lines of every length, so the chunk boundaries fall inside lines, words and separator runs
+    std::ostringstream corpus;
+    for (size_t i = 0; i < 500; ++i){
+        corpus << "Word" << (i % 37) << "  the\tquick" << std::string(i % 7, ' ') << "brown" << (i % 11);
+        if (i % 3 == 0) corpus << " " << std::string(i % 50 + 1, 'x');
+        corpus << (i % 5 == 0 ? "\n\n" : "\n");
+    }
+    corpus << "last line without a break";
+    auto corpus_path = write_corpus("corpus.txt", corpus.str());
+
+    for (bool first_word_only : {false, true}){
+        auto config = config_with(1);
+        config.first_word_only = first_word_only;
+        auto expected = build(corpus_path, config);
+        ASSERT_FALSE(expected.empty());
+        for (size_t num_threads : {2, 3, 7, 16, 64}){
+            config.num_threads = num_threads;
+            EXPECT_EQ(build(corpus_path, config), expected) << num_threads << " threads, first_word_only " << first_word_only;
+        }
+    }
+}
+
+
+TEST_F(lexiconBuilderTest, CorpusSmallerThanTheThreads){
+    auto corpus_path = write_corpus("tiny.txt", "ab\n");
+    auto lexicon = build(corpus_path, config_with(64));
+    ASSERT_EQ(lexicon.size(), 1);
+    EXPECT_EQ(lexicon.begin()->first, "ab");
+
+    auto one_byte_path = write_corpus("one_byte.txt", "a");
+    EXPECT_EQ(build(one_byte_path, config_with(64)).size(), 1);
+}
+
+
+TEST_F(lexiconBuilderTest, FirstWordOnly){
+    auto corpus_path = write_corpus("word_list.txt", "Hello world\nfoo bar baz\n  spaced out\nsingle\n");
+    auto config = config_with(3);
+    config.first_word_only = true;
+    auto lexicon = build(corpus_path, config);
+
+    std::vector<std::string> words;
+    for (const auto& [word, spelling] : lexicon) words.push_back(word);
+    EXPECT_EQ(words, (std::vector<std::string>{"foo", "hello", "single", "spaced"}));
+}
+
+
+TEST_F(lexiconBuilderTest, MinCountAndTopN){
+    // counts: a 5, b 4, c 4, d 2, e 1
+    auto corpus_path = write_corpus("counts.txt", "a a a a a\nb b b b\nc c c c\nd d\ne\n");
+    for (size_t num_threads : {1, 4}){
+        auto config = config_with(num_threads);
+        config.min_count = 2;
+        auto lexicon = build(corpus_path, config);
+        EXPECT_EQ(lexicon.size(), 4);
+        EXPECT_EQ(lexicon.count("e"), 0);
+
+        config.top_n = 2; // b and c tie: the word breaks the tie
+        lexicon = build(corpus_path, config);
+        ASSERT_EQ(lexicon.size(), 2);
+        EXPECT_EQ(lexicon.count("a"), 1);
+        EXPECT_EQ(lexicon.count("b"), 1);
+    }
+}
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <fst/fstlib.h>
+#include "decoders/lexicon_compiler.hpp"
+
+using namespace asr::lexicon;
+
+
+class lexiconCompilerTest : public testing::Test{
+protected:
+    // walks spelling in the fst make_fst wrote: the output label sum, 0 when it is not a word
+    int64_t fst_word_id(const fst::StdVectorFst& lex_fst, const fst::SymbolTable& input_symbols, const std::string& spelling){
+        auto state = lex_fst.Start();
+        int64_t word_id = 0;
+        for (char symbol : spelling){
+            int64_t label = input_symbols.Find(std::string(1, symbol));
+            bool found = false;
+            for (fst::ArcIterator<fst::StdVectorFst> aiter(lex_fst, state); !aiter.Done(); aiter.Next()){
+                if (aiter.Value().ilabel != label) continue;
+                word_id += aiter.Value().olabel;
+                state    = aiter.Value().nextstate;
+                found    = true;
+                break;
+            }
+            if (!found) return 0;
+        }
+        return lex_fst.Final(state) != fst::TropicalWeight::Zero() ? word_id : 0;
+    }
+
+    lexiconCompiler compiler{lexiconCompilerConfig{2}};
+};
+
+
+TEST_F(lexiconCompilerTest, SharedSuffixesMerge){
+    for (std::string word : {"cats", "bats", "rats"}) compiler.add_word(word, word);
+    ASSERT_TRUE(compiler.compile());
+    // start -{b,c,r}-> . -a-> . -t-> . -s-> final: one path after the first letter
+    EXPECT_EQ(compiler.get_stats().num_states, 5);
+    EXPECT_EQ(compiler.get_stats().num_arcs, 6);
+}
+
+
+TEST_F(lexiconCompilerTest, WordIdsAreRanksAndPathSums){
+    std::vector<std::string> words = {"a", "ab", "abc", "b", "bc", "cab", "cb", "zzz"};
+    for (auto it = words.rbegin(); it != words.rend(); ++it) compiler.add_word(*it, *it); // unsorted input
+    ASSERT_TRUE(compiler.compile());
+
+    std::unique_ptr<fst::StdVectorFst> lex_fst(compiler.make_fst());
+    std::unique_ptr<fst::SymbolTable> input_symbols(compiler.make_input_symbols());
+    std::unique_ptr<fst::SymbolTable> output_symbols(compiler.make_output_symbols());
+    ASSERT_TRUE(lex_fst);
+    EXPECT_EQ(lex_fst->Start(), 0); // the decoder's beams start at the fst's start state
+
+    for (size_t rank = 0; rank < words.size(); ++rank){
+        int32_t word_id = rank + 1;
+        EXPECT_EQ(compiler.get_word_id(words[rank]), word_id) << words[rank];
+        EXPECT_EQ(compiler.get_word(word_id), words[rank]);
+        EXPECT_EQ(fst_word_id(*lex_fst, *input_symbols, words[rank]), word_id) << words[rank];
+        EXPECT_EQ(output_symbols->Find(words[rank]), word_id);
+    }
+    for (std::string not_a_word : {"", "c", "abcd", "zz", "ba"}){
+        EXPECT_EQ(compiler.get_word_id(not_a_word), 0) << not_a_word;
+        EXPECT_EQ(fst_word_id(*lex_fst, *input_symbols, not_a_word), 0) << not_a_word;
+    }
+}
+
+
+TEST_F(lexiconCompilerTest, DuplicateSpellingsKeepTheFirstWord){
+    compiler.add_word("READ", "r e a d");
+    compiler.add_word("REED", "r e e d");
+    compiler.add_word("RED", "r e a d"); // same spelling as READ
+    compiler.add_word("EMPTY", "   ");   // no symbols: skipped
+    ASSERT_TRUE(compiler.compile());
+
+    EXPECT_EQ(compiler.get_stats().num_words, 2);
+    EXPECT_EQ(compiler.get_stats().num_duplicates, 1);
+    EXPECT_EQ(compiler.get_word(compiler.get_word_id("read")), "READ");
+    EXPECT_EQ(compiler.get_word(compiler.get_word_id("reed")), "REED");
+}
+
+
+TEST_F(lexiconCompilerTest, ManyWordsAcrossSortChunks){
+    // more than one sort chunk (4096 entries each), in reverse order
+    std::vector<std::string> words;
+    for (int i = 0; i < 20000; ++i){
+        std::string word;
+        for (int value = i; ; value /= 7){
+            word += static_cast<char>('a' + value % 7);
+            if (value < 7) break;
+        }
+        words.push_back(word + "s");
+    }
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    for (auto it = words.rbegin(); it != words.rend(); ++it) compiler.add_word(*it, *it);
+    ASSERT_TRUE(compiler.compile());
+
+    EXPECT_EQ(compiler.get_stats().num_words, words.size());
+    for (size_t rank = 0; rank < words.size(); rank += 97){
+        EXPECT_EQ(compiler.get_word_id(words[rank]), static_cast<int32_t>(rank + 1)) << words[rank];
+    }
+}
+
+
+TEST_F(lexiconCompilerTest, NoWords){
+    EXPECT_FALSE(compiler.compile());
+    EXPECT_EQ(compiler.make_fst(), nullptr);
+}
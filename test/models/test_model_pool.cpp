@@ -0,0 +1,95 @@
+#include "models/model_pool.hpp"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <iostream>
+#include <cmath>
+
+namespace fs = std::filesystem;
+
+class torchModelPoolTest : public testing::Test{
+protected:
+    torchModelPoolTest(){};
+
+    modelPoolConfig get_config(size_t num_workers){
+        modelPoolConfig config;
+        config.num_workers      = num_workers;
+        config.intra_op_threads = 1;
+        return config;
+    }
+
+    fs::path get_model_path(){
+        char* project_root = std::getenv("PROJECT_ROOT");
+        if (!project_root) return fs::path();
+        return fs::path(project_root) / "data" / "models" / "model.pt";
+    }
+};
+
+
+TEST_F(torchModelPoolTest, handles_invalid_model_file){
+    torchModelPool model_pool{get_config(2)};
+    fs::path invalid_model_path = fs::current_path() / "fake.pt";
+    EXPECT_FALSE(model_pool.load_model(invalid_model_path));
+    EXPECT_EQ(model_pool.get_num_workers(), 0);
+}
+
+TEST_F(torchModelPoolTest, submit_without_model_returns_nullopt){
+    torchModelPool model_pool{get_config(2)};
+    std::vector<float> dummy_input(1000, 0.0f);
+    EXPECT_EQ(model_pool.pass_forward(dummy_input), std::nullopt);
+}
+
+TEST_F(torchModelPoolTest, starts_configured_number_of_workers){
+    ASSERT_TRUE(std::getenv("PROJECT_ROOT")) << "project root variable must be set";
+    torchModelPool model_pool{get_config(3)};
+    ASSERT_TRUE(model_pool.load_model(get_model_path()));
+    EXPECT_EQ(model_pool.get_num_workers(), 3);
+}
+
+TEST_F(torchModelPoolTest, matches_single_model_output){
+    ASSERT_TRUE(std::getenv("PROJECT_ROOT")) << "project root variable must be set";
+    torchScriptModel script_model;
+    ASSERT_TRUE(script_model.load_model(get_model_path()));
+    torchModelPool model_pool{get_config(2)};
+    ASSERT_TRUE(model_pool.load_model(get_model_path()));
+
+    std::vector<float> dummy_input;
+    for (size_t i = 0; i < 16000; ++i)
+        dummy_input.push_back(std::sin(0.01f * i));
+
+    auto expected = script_model.pass_forward(dummy_input);
+    ASSERT_TRUE(expected.has_value());
+
+    // several requests in flight at once
+    std::vector<std::future<std::optional<torch::Tensor>>> results;
+    for (size_t i = 0; i < 4; ++i)
+        results.push_back(model_pool.submit(dummy_input));
+
+    for (auto& result : results){
+        auto output = result.get();
+        ASSERT_TRUE(output.has_value());
+        EXPECT_TRUE(torch::allclose(output.value(), expected.value(), 1e-4, 1e-5));
+    }
+
+    auto stats = model_pool.get_stats();
+    EXPECT_EQ(stats.completed, 4);
+    EXPECT_EQ(stats.queue_depth, 0);
+    std::cout << "max queue depth: " << stats.max_queue_depth
+              << ", mean wait (ms): " << stats.mean_wait_ms
+              << ", mean forward (ms): " << stats.mean_forward_ms << std::endl;
+}
+
+TEST_F(torchModelPoolTest, failed_reload_keeps_serving_the_previous_model){
+    ASSERT_TRUE(std::getenv("PROJECT_ROOT")) << "project root variable must be set";
+    torchModelPool model_pool{get_config(2)};
+    ASSERT_TRUE(model_pool.load_model(get_model_path()));
+
+    std::vector<float> dummy_input(16000, 0.1f);
+    auto pending = model_pool.submit(dummy_input);
+    EXPECT_FALSE(model_pool.load_model(fs::current_path() / "fake.pt"));
+    EXPECT_TRUE(model_pool.is_loaded());
+    EXPECT_EQ(model_pool.get_num_workers(), 2);
+
+    ASSERT_EQ(pending.wait_for(std::chrono::seconds(30)), std::future_status::ready);
+    EXPECT_TRUE(pending.get().has_value());
+    EXPECT_TRUE(model_pool.pass_forward(dummy_input).has_value());
+}
@@ -2,6 +2,7 @@
 #include <gtest/gtest.h>
 #include <filesystem>
 #include <iostream>
+#include <thread>
 
 namespace fs = std::filesystem;
 using namespace asr::ngrams;
@@ -76,3 +77,154 @@ TEST_F(nGramsModelTest, scoring_makes_sense){
 
 }
 
+
+TEST_F(nGramsModelTest, prefault_touches_the_vocab){
+    EXPECT_EQ(ngrams_model.prefault(), 0) << "nothing to prefault without a model";
+
+    char* project_root = std::getenv("PROJECT_ROOT");
+    ASSERT_TRUE(project_root) << "project root variable must be set";
+    fs::path model_path = fs::path(project_root) / "data" / "models" / "3-gram.pruned.1e-7.arpa";
+    ASSERT_TRUE(ngrams_model.setup_model_from(model_path)) << "failed to load the model";
+
+    EXPECT_GT(ngrams_model.prefault(), 0);
+}
+
+
+TEST_F(nGramsModelTest, binary_model_matches_arpa){
+    char* project_root = std::getenv("PROJECT_ROOT");
+    ASSERT_TRUE(project_root) << "project root variable must be set";
+    fs::path arpa_path   = fs::path(project_root) / "data" / "models" / "3-gram.pruned.1e-7.arpa";
+    fs::path binary_path = fs::temp_directory_path() / "test_ngrams_model.bin";
+    ASSERT_TRUE(compile_arpa_to_binary(arpa_path, binary_path));
+
+    auto sentence = get_words_from_sentence("I LOVE YOU");
+    ASSERT_TRUE(ngrams_model.setup_model_from(arpa_path));
+    EXPECT_FALSE(ngrams_model.is_binary());
+    float arpa_score = ngrams_model.score_sentence(sentence, LOGITS);
+
+    for (auto load_method : {util::LAZY, util::POPULATE_OR_READ, util::READ}){
+        nGramsModelWrapper binary_model;
+        ASSERT_TRUE(binary_model.setup_model_from(binary_path, load_method));
+        EXPECT_TRUE(binary_model.is_binary());
+        EXPECT_NEAR(binary_model.score_sentence(sentence, LOGITS), arpa_score, 1e-4);
+        MYLOG(INFO) << "load method " << load_method << ": " << binary_model.get_load_seconds()
+                    << " s (arpa: " << ngrams_model.get_load_seconds() << " s)\n";
+    }
+    fs::remove(binary_path);
+}
+
+
+TEST_F(nGramsModelTest, loads_every_model_type_from_the_header){
+    char* project_root = std::getenv("PROJECT_ROOT");
+    ASSERT_TRUE(project_root) << "project root variable must be set";
+    fs::path arpa_path = fs::path(project_root) / "data" / "models" / "3-gram.pruned.1e-7.arpa";
+    auto sentence = get_words_from_sentence("I LOVE YOU");
+    ASSERT_TRUE(ngrams_model.setup_model_from(arpa_path));
+    float arpa_score = ngrams_model.score_sentence(sentence, LOGITS);
+
+    for (auto model_type : {lm::ngram::TRIE, lm::ngram::QUANT_TRIE, lm::ngram::ARRAY_TRIE, lm::ngram::QUANT_ARRAY_TRIE}){
+        fs::path binary_path = fs::temp_directory_path() / "test_ngrams_model_type.bin";
+        ASSERT_TRUE(compile_arpa_to_binary(arpa_path, binary_path, model_type));
+
+        nGramsModelWrapper binary_model;
+        ASSERT_TRUE(binary_model.setup_model_from(binary_path));
+        EXPECT_EQ(binary_model.get_model_type(), model_type);
+        EXPECT_EQ(binary_model.get_order(), 3);
+        // the quantized tries store 8-bit probabilities
+        float tolerance = (model_type == lm::ngram::QUANT_TRIE || model_type == lm::ngram::QUANT_ARRAY_TRIE) ? 0.1f : 1e-4f;
+        EXPECT_NEAR(binary_model.score_sentence(sentence, LOGITS), arpa_score, tolerance) << model_type_name(model_type);
+        fs::remove(binary_path);
+    }
+}
+
+
+TEST_F(nGramsModelTest, one_model_scores_from_many_threads){
+    char* project_root = std::getenv("PROJECT_ROOT");
+    ASSERT_TRUE(project_root) << "project root variable must be set";
+    fs::path model_path = fs::path(project_root) / "data" / "models" / "3-gram.pruned.1e-7.arpa";
+    ASSERT_TRUE(ngrams_model.setup_model_from(model_path));
+
+    std::vector<std::vector<std::string>> sentences = {get_words_from_sentence("I LOVE YOU"),
+                                                       get_words_from_sentence("I BLUE YOU"),
+                                                       get_words_from_sentence("THE CAT SAT ON THE MAT")};
+    // reference: the caller owned states, walked from <s> on one thread
+    auto score_from_begin = [&](const std::vector<std::string>& sentence){
+        State state, out_state;
+        ngrams_model.begin_sentence_state(&state);
+        float total = 0;
+        for (const auto& word : sentence){
+            total += ngrams_model.score(state, ngrams_model.get_word_index(word), &out_state);
+            std::swap(state, out_state);
+        }
+        return total;
+    };
+    std::vector<float> expected;
+    for (const auto& sentence : sentences) expected.push_back(score_from_begin(sentence));
+    EXPECT_GT(expected[0], expected[1]);
+
+    const size_t num_threads = 8;
+    std::vector<size_t> mismatches(num_threads, 0);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t){
+        threads.emplace_back([&, t]{
+            for (size_t repeat = 0; repeat < 2000; ++repeat){
+                size_t i = (repeat + t) % sentences.size();
+                if (score_from_begin(sentences[i]) != expected[i]) ++mismatches[t];
+                if (ngrams_model.score_sentence(sentences[i], LOGITS) != ngrams_model.score_sentence(sentences[i], LOGITS)) ++mismatches[t];
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    for (size_t t = 0; t < num_threads; ++t) EXPECT_EQ(mismatches[t], 0) << "thread " << t;
+}
+
+
+TEST_F(nGramsModelTest, word_ids_score_like_strings){
+    char* project_root = std::getenv("PROJECT_ROOT");
+    ASSERT_TRUE(project_root) << "project root variable must be set";
+    fs::path model_path = fs::path(project_root) / "data" / "models" / "3-gram.pruned.1e-7.arpa";
+    ASSERT_TRUE(ngrams_model.setup_model_from(model_path));
+
+    auto sentence = get_words_from_sentence("<s> I LOVE");
+    std::vector<WordIndex> ngram;
+    for (const auto& word : sentence) ngram.push_back(ngrams_model.get_word_index(word));
+    EXPECT_FLOAT_EQ(ngrams_model.score_ngram(ngram, LOGITS), ngrams_model.score_sentence(sentence, LOGITS));
+
+    ngram.back() = 0; // out of vocabulary
+    EXPECT_LT(ngrams_model.score_ngram(ngram, LOGITS), ngrams_model.score_sentence(sentence, LOGITS));
+}
+
+
+TEST_F(nGramsModelTest, batch_scores_match_single_lookups){
+    char* project_root = std::getenv("PROJECT_ROOT");
+    ASSERT_TRUE(project_root) << "project root variable must be set";
+    fs::path model_path = fs::path(project_root) / "data" / "models" / "3-gram.pruned.1e-7.arpa";
+    ASSERT_TRUE(ngrams_model.setup_model_from(model_path));
+
+    // contexts <s>, <s> I, <s> YOU and the words completed after them, with repeats
+    State begin_state, out_state;
+    ngrams_model.begin_sentence_state(&begin_state);
+    std::vector<State> contexts(3, begin_state);
+    ngrams_model.score(begin_state, ngrams_model.get_word_index("I"), &contexts[1]);
+    ngrams_model.score(begin_state, ngrams_model.get_word_index("YOU"), &contexts[2]);
+    auto words = get_words_from_sentence("LOVE KNOW LOVE THE LOVE");
+
+    std::vector<lmQuery> queries;
+    std::vector<State> out_states(contexts.size() * words.size());
+    for (size_t c = 0; c < contexts.size(); ++c){
+        for (size_t w = 0; w < words.size(); ++w){
+            lmQuery query;
+            query.in_state  = &contexts[c];
+            query.word_id   = ngrams_model.get_word_index(words[w]);
+            query.out_state = &out_states[c * words.size() + w];
+            queries.push_back(query);
+        }
+    }
+    size_t num_lookups = ngrams_model.score_batch(queries.data(), queries.size());
+    EXPECT_EQ(num_lookups, contexts.size() * 3) << "LOVE repeats after every context";
+
+    for (const auto& query : queries){
+        EXPECT_FLOAT_EQ(query.score, ngrams_model.score(*query.in_state, query.word_id, &out_state));
+        EXPECT_TRUE(*query.out_state == out_state);
+    }
+}
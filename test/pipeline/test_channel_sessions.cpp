@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#include "pipeline/channel_sessions.hpp"
+#include "utils/wav_reader.hpp"
+
+namespace fs = std::filesystem;
+using namespace asr;
+
+
+class channelSessionsTest : public testing::Test{
+protected:
+    channelSessionsTest(){};
+
+    fs::path get_data_path(){
+        char* project_root = std::getenv("PROJECT_ROOT");
+        if (!project_root) return fs::path();
+        return fs::path(project_root) / "data";
+    }
+
+    std::unique_ptr<ctcDecoder> make_decoder(){
+        return std::make_unique<ctcDecoder>((get_data_path() / "dictionary" / "tokens.txt").string(), 10);
+    }
+
+    // what one decoder makes of audio alone, over the chunks the sessions cut
+    std::string decode_alone(torchModelPool& model_pool, const std::vector<float>& audio){
+        auto decoder = make_decoder();
+        for (size_t begin = 0; begin < audio.size(); begin += chunk_frames){
+            size_t end = std::min(begin + chunk_frames, audio.size());
+            auto emissions = model_pool.pass_forward(std::vector<float>(audio.begin() + begin, audio.begin() + end));
+            EXPECT_TRUE(emissions.has_value());
+            if (emissions.has_value()) decoder->decode_chunk(emissions.value());
+        }
+        auto top_beams = decoder->get_top_beams();
+        return top_beams.empty() ? "" : top_beams.front()->get_sequence();
+    }
+
+    const size_t chunk_frames = 8000;
+};
+
+
+TEST_F(channelSessionsTest, routes_every_transcript_to_its_channel){
+    ASSERT_TRUE(std::getenv("PROJECT_ROOT")) << "project root variable must be set";
+    audio::wavReader wav_reader(get_data_path() / "audio" / "test.wav");
+    ASSERT_TRUE(wav_reader.is_open());
+    std::vector<float> speech = wav_reader.read_all();
+    ASSERT_GT(speech.size(), 2 * chunk_frames);
+
+    // a different signal on every channel: the speech, silence, the speech starting half way
+    std::vector<std::vector<float>> channels(3, speech);
+    std::fill(channels[1].begin(), channels[1].end(), 0.0f);
+    std::rotate(channels[2].begin(), channels[2].begin() + speech.size() / 2, channels[2].end());
+
+    modelPoolConfig pool_config;
+    pool_config.num_workers = 2;
+    torchModelPool model_pool{pool_config};
+    ASSERT_TRUE(model_pool.load_model(get_data_path() / "models" / "model.pt"));
+    std::vector<std::string> expected;
+    for (const auto& channel : channels) expected.push_back(decode_alone(model_pool, channel));
+    EXPECT_NE(expected[0], expected[1]);
+    EXPECT_NE(expected[0], expected[2]);
+
+    // the rings hold the whole signal, so the capture side never drops
+    audio::multiChannelCaptureSink capture_sink(16000, speech.size() + chunk_frames, channels.size());
+    pipeline::channelSessionConfig config;
+    config.chunk_frames = chunk_frames;
+    pipeline::channelSessions sessions(capture_sink, model_pool,
+                                       [this](size_t){return make_decoder();}, config);
+    ASSERT_EQ(sessions.get_num_channels(), channels.size());
+    sessions.start();
+
+    const size_t block = 512;
+    std::vector<float> interleaved;
+    for (size_t begin = 0; begin < speech.size(); begin += block){
+        size_t num_frames = std::min(block, speech.size() - begin);
+        interleaved.clear();
+        for (size_t t = begin; t < begin + num_frames; ++t){
+            for (const auto& channel : channels) interleaved.push_back(channel[t]);
+        }
+        capture_sink.on_audio(interleaved.data(), num_frames, begin / 16000.0, 0, false, false);
+    }
+
+    // every full chunk is taken by its session, stop() decodes the partial last one
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+    for (size_t c = 0; c < channels.size(); ++c){
+        while (capture_sink.get_channel(c).get_available() >= chunk_frames &&
+               std::chrono::steady_clock::now() < deadline){
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+    auto transcripts = sessions.stop();
+    EXPECT_EQ(transcripts, expected);
+
+    for (const auto& channel_stats : sessions.get_stats()){
+        EXPECT_EQ(channel_stats.num_frames, speech.size());
+        EXPECT_EQ(channel_stats.num_chunks, (speech.size() + chunk_frames - 1) / chunk_frames);
+        EXPECT_TRUE(channel_stats.error.empty()) << channel_stats.error;
+    }
+}
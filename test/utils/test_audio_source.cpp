@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <cmath>
+#include <unistd.h>
+#include "utils/audio_source.hpp"
+
+namespace fs = std::filesystem;
+using namespace asr::audio;
+
+
+namespace {
+    void put_u16(std::string& bytes, uint16_t value){bytes.append(reinterpret_cast<const char*>(&value), 2);}
+    void put_u32(std::string& bytes, uint32_t value){bytes.append(reinterpret_cast<const char*>(&value), 4);}
+
+    // mono 16 bit pcm at 16 kHz
+    void write_wav(const fs::path& path, const std::vector<int16_t>& samples){
+        std::string fmt;
+        put_u16(fmt, 1); put_u16(fmt, 1); put_u32(fmt, 16000); put_u32(fmt, 32000);
+        put_u16(fmt, 2); put_u16(fmt, 16);
+
+        std::string body = "WAVE";
+        body += "fmt "; put_u32(body, fmt.size()); body += fmt;
+        body += "data"; put_u32(body, samples.size() * 2);
+        body.append(reinterpret_cast<const char*>(samples.data()), samples.size() * 2);
+
+        std::ofstream file(path, std::ios::binary);
+        file << "RIFF";
+        std::string size; put_u32(size, body.size());
+        file << size << body;
+    }
+
+    // reads everything the source delivers until it reports the end
+    std::vector<float> drain(audioSource& source){
+        std::vector<float> audio, chunk;
+        auto* sink = source.get_capture_sink();
+        while (true){
+            bool ended = source.at_end(); // frames written before the end are visible after it
+            if (sink->read(chunk, 4096) > 0){
+                audio.insert(audio.end(), chunk.begin(), chunk.end());
+            }
+            else if (ended){
+                break;
+            }
+            else{
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        return audio;
+    }
+}
+
+
+class audioSourceTest : public testing::Test{
+protected:
+    audioSourceTest(){
+        for (size_t i = 0; i < num_samples; ++i)
+            samples.push_back(static_cast<int16_t>(20000 * std::sin(0.01 * i)));
+    };
+    ~audioSourceTest(){
+        fs::remove(wav_path);
+        fs::remove(raw_path);
+    }
+
+    const size_t num_samples = 10007; // not a multiple of the buffer
+    std::vector<int16_t> samples;
+    fs::path wav_path = fs::temp_directory_path() / "test_audio_source.wav";
+    fs::path raw_path = fs::temp_directory_path() / "test_audio_source.pcm";
+};
+
+
+TEST_F(audioSourceTest, replays_a_wav_file_with_back_pressure){
+    write_wav(wav_path, samples);
+    sourceConfig config;
+    config.speed          = 0;
+    config.buffer_seconds = 0.05; // much smaller than the file: the source has to wait for the reader
+    fileSource source(wav_path, config);
+    ASSERT_TRUE(source.is_open());
+    EXPECT_EQ(source.get_sample_rate(), 16000);
+    ASSERT_TRUE(source.start());
+
+    auto audio = drain(source);
+    source.stop();
+    ASSERT_EQ(audio.size(), num_samples);
+    EXPECT_FLOAT_EQ(audio[1234], samples[1234] / 32768.0f);
+    EXPECT_EQ(source.get_capture_sink()->get_stats().frames_dropped, 0);
+    EXPECT_EQ(source.get_capture_sink()->get_stats().discontinuities, 0);
+}
+
+TEST_F(audioSourceTest, replays_raw_pcm_at_the_requested_speed){
+    std::ofstream(raw_path, std::ios::binary).write(reinterpret_cast<const char*>(samples.data()), samples.size() * 2);
+    sourceConfig config;
+    config.speed = 10; // 0.625 s of audio in ~62 ms
+    fileSource source(raw_path, config, rawPcmFormat{16000, CAPTURE_INT16});
+    ASSERT_TRUE(source.is_open());
+    EXPECT_EQ(source.get_capture_sink()->get_format(), CAPTURE_INT16);
+
+    auto start_time = std::chrono::steady_clock::now();
+    ASSERT_TRUE(source.start());
+    auto audio = drain(source);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    source.stop();
+
+    ASSERT_EQ(audio.size(), num_samples);
+    EXPECT_FLOAT_EQ(audio.back(), samples.back() / 32768.0f);
+    EXPECT_GE(elapsed, 0.9 * num_samples / 16000.0 / config.speed);
+}
+
+TEST_F(audioSourceTest, reads_raw_pcm_from_a_pipe){
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    sourceConfig config;
+    config.buffer_seconds = 0.05; // the reads wrap around the ring many times
+    fdSource source(fds[0], 16000, CAPTURE_INT16, config, true);
+    ASSERT_TRUE(source.start());
+
+    // odd-sized writes split samples across reads
+    std::thread writer([&]{
+        const char* bytes = reinterpret_cast<const char*>(samples.data());
+        size_t total = samples.size() * 2;
+        for (size_t offset = 0; offset < total; ){
+            size_t size = std::min<size_t>(333, total - offset);
+            offset += write(fds[1], bytes + offset, size);
+        }
+        close(fds[1]);
+    });
+    auto audio = drain(source);
+    writer.join();
+    source.stop();
+
+    ASSERT_EQ(audio.size(), num_samples);
+    for (size_t i = 0; i < num_samples; i += 997){
+        EXPECT_FLOAT_EQ(audio[i], samples[i] / 32768.0f);
+    }
+    EXPECT_EQ(source.get_frames_read(), num_samples);
+}
+
+TEST_F(audioSourceTest, stops_while_the_writer_is_silent){
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    {
+        fdSource source(fds[0], 16000, CAPTURE_FLOAT32);
+        ASSERT_TRUE(source.start());
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        source.stop();
+        EXPECT_FALSE(source.at_end());
+    }
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST_F(audioSourceTest, synthetic_source_is_deterministic){
+    syntheticConfig synthetic_config;
+    synthetic_config.noise_amplitude  = 0.1f;
+    synthetic_config.duration_seconds = 0.5;
+    sourceConfig config;
+    config.speed = 0;
+    syntheticSource source(synthetic_config, config);
+
+    ASSERT_TRUE(source.start());
+    auto first_run = drain(source);
+    source.stop();
+    ASSERT_EQ(first_run.size(), 8000);
+
+    ASSERT_TRUE(source.start()); // restarts from the same seed
+    auto second_run = drain(source);
+    source.stop();
+    EXPECT_EQ(first_run, second_run);
+}
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <numeric>
+#include "utils/capture_sink.hpp"
+
+using namespace asr::audio;
+
+
+class captureSinkTest : public testing::Test{
+protected:
+    captureSinkTest(){
+        buffer.resize(frames_per_buffer);
+    };
+
+    // one callback worth of frames, starting at the given adc time
+    void callback(double adc_time, bool overflow = false){
+        std::iota(buffer.begin(), buffer.end(), static_cast<float>(next_value));
+        next_value += frames_per_buffer;
+        sink.on_audio(buffer.data(), frames_per_buffer, adc_time, adc_time + 0.005, overflow, false);
+    }
+
+    const double sample_rate        = 16000;
+    const size_t frames_per_buffer  = 160; // 10 ms
+    captureSink sink{sample_rate, 1024};
+    std::vector<float> buffer;
+    size_t next_value = 0;
+};
+
+
+TEST_F(captureSinkTest, records_frames_and_timestamps){
+    callback(1.00);
+    callback(1.01);
+    std::vector<float> out;
+    ASSERT_EQ(sink.read(out, 1000), 2 * frames_per_buffer);
+    EXPECT_EQ(out.back(), 2 * frames_per_buffer - 1);
+
+    auto stats = sink.get_stats();
+    EXPECT_EQ(stats.num_callbacks, 2);
+    EXPECT_EQ(stats.frames_captured, 2 * frames_per_buffer);
+    EXPECT_DOUBLE_EQ(stats.first_adc_time, 1.00);
+    EXPECT_DOUBLE_EQ(stats.last_adc_time, 1.01);
+    EXPECT_NEAR(stats.max_callback_latency, 0.005, 1e-9);
+    EXPECT_EQ(stats.discontinuities, 0);
+}
+
+TEST_F(captureSinkTest, counts_xruns){
+    callback(0.00);
+    callback(0.05, true); // 40 ms were lost and the driver flagged it
+    auto stats = sink.get_stats();
+    EXPECT_EQ(stats.input_overflows, 1);
+    EXPECT_EQ(stats.discontinuities, 1);
+}
+
+TEST_F(captureSinkTest, drops_when_the_consumer_lags){
+    for (size_t i = 0; i < 8; ++i) callback(i * 0.01); // 1280 frames into a 1024 ring
+    auto stats = sink.get_stats();
+    EXPECT_EQ(stats.frames_captured, 1024);
+    EXPECT_EQ(stats.frames_dropped, 8 * frames_per_buffer - 1024);
+
+    std::vector<float> out;
+    sink.read(out, 1024);
+    EXPECT_EQ(out.front(), 0); // the oldest frames were kept
+}
+
+TEST_F(captureSinkTest, consumer_waits_for_frames){
+    EXPECT_FALSE(sink.wait_for(frames_per_buffer, std::chrono::milliseconds(5)));
+
+    std::thread producer([this]{
+        for (size_t i = 0; i < 4; ++i){
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            callback(i * 0.01);
+        }
+    });
+    EXPECT_TRUE(sink.wait_for(4 * frames_per_buffer, std::chrono::milliseconds(2000)));
+    producer.join();
+    EXPECT_EQ(sink.get_available(), 4 * frames_per_buffer);
+}
+
+TEST_F(captureSinkTest, int16_frames_are_converted_on_read){
+    captureSink int16_sink(sample_rate, 1024, CAPTURE_INT16);
+    EXPECT_EQ(int16_sink.get_bytes_per_frame(), 2);
+
+    std::vector<int16_t> raw(1000);
+    for (size_t i = 0; i < raw.size(); ++i) raw[i] = static_cast<int16_t>(i * 65 - 32768);
+    // twice, so the second read wraps around the ring
+    for (int round = 0; round < 2; ++round){
+        int16_sink.on_audio(raw.data(), raw.size(), round * 0.1, round * 0.1, false, false);
+        std::vector<float> out;
+        ASSERT_EQ(int16_sink.read(out, 2000), raw.size());
+        for (size_t i = 0; i < raw.size(); ++i){
+            ASSERT_FLOAT_EQ(out[i], raw[i] / 32768.0f);
+        }
+    }
+}
+
+TEST_F(captureSinkTest, mixed_formats_are_converted_on_write){
+    captureSink int16_sink(sample_rate, 1024, CAPTURE_INT16);
+    std::vector<float> samples = {-1.5f, -1.0f, -0.5f, 0.0f, 0.5f, 1.0f};
+    int16_sink.on_audio(samples.data(), samples.size(), 0, 0, false, false);
+    std::vector<float> out;
+    int16_sink.read(out, samples.size());
+    ASSERT_EQ(out.size(), samples.size());
+    EXPECT_NEAR(out[0], -1.0f, 1e-4); // clamped
+    EXPECT_NEAR(out[2], -0.5f, 1e-4);
+    EXPECT_NEAR(out[4],  0.5f, 1e-4);
+
+    std::vector<int16_t> raw = {-16384, 16384};
+    sink.on_audio(raw.data(), raw.size(), 0, 0, false, false);
+    sink.read(out, 2);
+    EXPECT_FLOAT_EQ(out[0], -0.5f);
+    EXPECT_FLOAT_EQ(out[1],  0.5f);
+}
+
+TEST_F(captureSinkTest, deinterleaves_channels_into_their_own_rings){
+    for (size_t num_channels : {1, 2, 3, 8}){
+        multiChannelCaptureSink multi_sink(sample_rate, 4096, num_channels);
+        const size_t num_frames = 1500; // more than one split block, not a multiple of 8
+        std::vector<float> interleaved(num_frames * num_channels);
+        for (size_t i = 0; i < num_frames; ++i){
+            for (size_t c = 0; c < num_channels; ++c) interleaved[i * num_channels + c] = c * 10000.0f + i;
+        }
+        multi_sink.on_audio(interleaved.data(), num_frames, 0.5, 0.51, true, false);
+
+        for (size_t c = 0; c < num_channels; ++c){
+            auto& channel = multi_sink.get_channel(c);
+            std::vector<float> out;
+            ASSERT_EQ(channel.read(out, 2 * num_frames), num_frames);
+            for (size_t i = 0; i < num_frames; ++i) ASSERT_EQ(out[i], c * 10000.0f + i);
+            EXPECT_EQ(channel.get_stats().input_overflows, 1);
+            EXPECT_EQ(channel.get_stats().discontinuities, 0);
+        }
+    }
+}
+
+TEST_F(captureSinkTest, deinterleaves_int16_stereo){
+    multiChannelCaptureSink multi_sink(sample_rate, 1024, 2, CAPTURE_INT16);
+    std::vector<int16_t> interleaved;
+    for (int16_t i = 0; i < 100; ++i){
+        interleaved.push_back(i);
+        interleaved.push_back(-i);
+    }
+    multi_sink.on_audio(interleaved.data(), 100, 0, 0, false, false);
+    std::vector<float> left, right;
+    multi_sink.get_channel(0).read(left, 100);
+    multi_sink.get_channel(1).read(right, 100);
+    ASSERT_EQ(left.size(), 100);
+    ASSERT_EQ(right.size(), 100);
+    for (size_t i = 0; i < 100; ++i){
+        EXPECT_FLOAT_EQ(left[i],   i / 32768.0f);
+        EXPECT_FLOAT_EQ(right[i], -(i / 32768.0f));
+    }
+}
+
+TEST_F(captureSinkTest, rejects_unsupported_channel_counts){
+    EXPECT_THROW(multiChannelCaptureSink(sample_rate, 1024, 0), std::runtime_error);
+    EXPECT_THROW(multiChannelCaptureSink(sample_rate, 1024, multiChannelCaptureSink::MAX_CHANNELS + 1), std::runtime_error);
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <cmath>
+#include "utils/emission_cache.hpp"
+
+namespace fs = std::filesystem;
+using namespace asr::emissions;
+
+
+class emissionCacheTest : public testing::Test{
+protected:
+    emissionCacheTest(){
+        for (size_t t = 0; t < num_frames; ++t)
+            for (size_t v = 0; v < vocab_size; ++v)
+                log_probs.push_back(-0.25f * v - 0.01f * t);
+    };
+    ~emissionCacheTest(){
+        fs::remove(cache_path);
+    }
+
+    const size_t num_frames = 50;
+    const size_t vocab_size = 29;
+    std::vector<float> log_probs;
+    fs::path cache_path = fs::temp_directory_path() / "test_emission_cache.emis";
+};
+
+
+TEST_F(emissionCacheTest, handles_missing_file){
+    emissionCache emission_cache;
+    EXPECT_FALSE(emission_cache.open(fs::temp_directory_path() / "missing.emis"));
+    EXPECT_FALSE(emission_cache.is_open());
+}
+
+TEST_F(emissionCacheTest, rejects_invalid_file){
+    std::ofstream invalid_file(cache_path, std::ios::binary);
+    invalid_file << "this is not an emission cache, just some text that is long enough";
+    invalid_file.close();
+
+    emissionCache emission_cache;
+    EXPECT_FALSE(emission_cache.open(cache_path));
+}
+
+TEST_F(emissionCacheTest, round_trips_fp32_without_copies){
+    ASSERT_TRUE(write_emission_cache(cache_path, log_probs.data(), num_frames, vocab_size, 50.0f, FP32));
+
+    emissionCache emission_cache(cache_path);
+    EXPECT_EQ(emission_cache.get_num_frames(), num_frames);
+    EXPECT_EQ(emission_cache.get_vocab_size(), vocab_size);
+    EXPECT_FLOAT_EQ(emission_cache.get_frame_rate(), 50.0f);
+
+    const float* data = emission_cache.get_fp32_data();
+    ASSERT_NE(data, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(data) % EMISSION_CACHE_ALIGNMENT, 0);
+    for (size_t i = 0; i < log_probs.size(); ++i)
+        ASSERT_EQ(data[i], log_probs[i]);
+}
+
+TEST_F(emissionCacheTest, round_trips_fp16_within_precision){
+    ASSERT_TRUE(write_emission_cache(cache_path, log_probs.data(), num_frames, vocab_size, 50.0f, FP16));
+
+    emissionCache emission_cache(cache_path);
+    EXPECT_EQ(emission_cache.get_dtype(), FP16);
+    EXPECT_EQ(emission_cache.get_fp32_data(), nullptr);
+
+    std::vector<float> frame(vocab_size);
+    for (size_t t = 0; t < num_frames; ++t){
+        emission_cache.read_frame(t, frame.data());
+        for (size_t v = 0; v < vocab_size; ++v){
+            float expected = log_probs[t * vocab_size + v];
+            ASSERT_NEAR(frame[v], expected, std::abs(expected) * 1e-3 + 1e-6);
+        }
+    }
+}
+
+TEST(halfConversionTest, handles_special_values){
+    EXPECT_EQ(half_to_float(float_to_half(0.0f)), 0.0f);
+    EXPECT_EQ(half_to_float(float_to_half(-2.5f)), -2.5f);
+    EXPECT_TRUE(std::isinf(half_to_float(float_to_half(-1e10f))));
+    EXPECT_NEAR(half_to_float(float_to_half(1e-6f)), 1e-6f, 1e-7f);
+}
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <numeric>
+#include "utils/file_ingest.hpp"
+
+namespace fs = std::filesystem;
+using namespace asr::audio;
+
+
+class fileIngestTest : public testing::Test{
+protected:
+    fileIngestTest(){
+        fs::create_directories(directory);
+        // sizes around the read size: empty, short, exactly one read, several reads with a tail
+        std::vector<size_t> sizes = {0, 1, 4096, 4097, 3 * 4096 + 17, 100000};
+        for (size_t i = 0; i < 24; ++i){
+            size_t size = sizes[i % sizes.size()] + i;
+            std::string bytes(size, '\0');
+            for (size_t b = 0; b < size; ++b) bytes[b] = static_cast<char>((b * 31 + i) & 0xff);
+            paths.push_back(directory / ("file_" + std::to_string(i) + ".bin"));
+            std::ofstream(paths.back(), std::ios::binary) << bytes;
+            expected.push_back(bytes);
+        }
+        paths.push_back(directory / "missing.bin");
+    };
+    ~fileIngestTest(){
+        fs::remove_all(directory);
+    }
+
+    // checks that every file reached a consumer exactly once with the right bytes
+    void check_run(ingestConfig config){
+        std::mutex mutex;
+        std::vector<size_t> seen(paths.size(), 0);
+        size_t mismatches = 0, failures = 0;
+        fileIngestor ingestor(config);
+        auto stats = ingestor.run(paths, [&](const ingestedFile& file){
+            std::lock_guard<std::mutex> lock(mutex);
+            ++seen[file.index];
+            if (!file.ok){
+                ++failures;
+                return;
+            }
+            if (std::string(reinterpret_cast<const char*>(file.data), file.size) != expected[file.index]) ++mismatches;
+        });
+
+        for (size_t count : seen) EXPECT_EQ(count, 1);
+        EXPECT_EQ(mismatches, 0);
+        EXPECT_EQ(failures, 1);
+        EXPECT_EQ(stats.failed_files, 1);
+        EXPECT_EQ(stats.num_files, paths.size());
+        size_t total = std::accumulate(expected.begin(), expected.end(), size_t{0},
+                                       [](size_t sum, const std::string& bytes){return sum + bytes.size();});
+        EXPECT_EQ(stats.bytes_read, total);
+    }
+
+    fs::path directory = fs::temp_directory_path() / "test_file_ingest";
+    std::vector<fs::path> paths;
+    std::vector<std::string> expected;
+};
+
+
+TEST_F(fileIngestTest, pread_backend_delivers_every_file){
+    ingestConfig config;
+    config.backend        = INGEST_PREAD;
+    config.read_size      = 4096;
+    config.max_buffers    = 3; // fewer buffers than files: readers wait for the workers
+    config.num_io_threads = 2;
+    config.num_workers    = 2;
+    check_run(config);
+}
+
+TEST_F(fileIngestTest, io_uring_backend_delivers_every_file){
+    if (!fileIngestor::is_io_uring_available()){
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    ingestConfig config;
+    config.backend     = INGEST_IO_URING;
+    config.read_size   = 4096;
+    config.queue_depth = 4; // less than the reads of one large file
+    config.max_buffers = 3;
+    config.num_workers = 2;
+    check_run(config);
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <fst/fstlib.h>
+#include "utils/fst_artifact.hpp"
+
+namespace fs = std::filesystem;
+using namespace asr;
+
+
+class fstArtifactTest : public testing::Test{
+protected:
+    fstArtifactTest(){
+        fs::create_directories(directory);
+
+        // "ab" -> word 1, "ba" -> word 2, "bb" -> word 3 (a trie, arcs added out of label order)
+        input_symbols.AddSymbol("<eps>");
+        input_symbols.AddSymbol("a");
+        input_symbols.AddSymbol("b");
+        output_symbols.AddSymbol("<eps>");
+        output_symbols.AddSymbol("ab");
+        output_symbols.AddSymbol("ba");
+        output_symbols.AddSymbol("bb");
+        for (int i = 0; i < 6; ++i) lexicon_fst.AddState();
+        lexicon_fst.SetStart(0);
+        lexicon_fst.AddArc(0, fst::StdArc(2, 0, 1, 2));
+        lexicon_fst.AddArc(0, fst::StdArc(1, 0, 1, 1));
+        lexicon_fst.AddArc(1, fst::StdArc(2, 1, 1, 3));
+        lexicon_fst.AddArc(2, fst::StdArc(2, 3, 1, 5));
+        lexicon_fst.AddArc(2, fst::StdArc(1, 2, 1, 4));
+        for (int state : {3, 4, 5}) lexicon_fst.SetFinal(state, 0);
+        lexicon_fst.SetInputSymbols(&input_symbols);
+        lexicon_fst.SetOutputSymbols(&output_symbols);
+    };
+    ~fstArtifactTest(){
+        fs::remove_all(directory);
+    }
+
+    // (ilabel, olabel, nextstate) of every arc, state by state
+    template <class FST>
+    std::vector<std::vector<std::vector<int64_t>>> get_arcs(const FST& lex_fst){
+        std::vector<std::vector<std::vector<int64_t>>> arcs(lex_fst.NumStates());
+        for (int64_t state = 0; state < lex_fst.NumStates(); ++state){
+            for (fst::ArcIterator<FST> aiter(lex_fst, state); !aiter.Done(); aiter.Next()){
+                const auto& arc = aiter.Value();
+                arcs[state].push_back({arc.ilabel, arc.olabel, arc.nextstate});
+            }
+        }
+        return arcs;
+    }
+
+    fs::path directory = fs::temp_directory_path() / "test_fst_artifact";
+    fst::SymbolTable input_symbols{"input"};
+    fst::SymbolTable output_symbols{"output"};
+    fst::StdVectorFst lexicon_fst;
+};
+
+
+TEST_F(fstArtifactTest, RoundTripsThroughAMappedConstFst){
+    fs::path fst_path = directory / "lexicon.fst";
+    ASSERT_TRUE(myfst::write_const_fst(&lexicon_fst, fst_path));
+
+    fst::FstHeader header;
+    std::ifstream fst_stream(fst_path, std::ios::binary);
+    ASSERT_TRUE(header.Read(fst_stream, fst_path.string()));
+    EXPECT_EQ(header.FstType(), myfst::CONST_FST_TYPE);
+
+    std::unique_ptr<fst::StdConstFst> read_fst(myfst::read_lexicon_fst(fst_path));
+    ASSERT_TRUE(read_fst);
+    EXPECT_EQ(read_fst->Start(), 0);
+    EXPECT_EQ(read_fst->NumStates(), 6);
+    EXPECT_TRUE(read_fst->Properties(fst::kILabelSorted, true));
+
+    // nothing but the arc order changed: no state was merged and no label moved
+    EXPECT_EQ(get_arcs(*read_fst), get_arcs(lexicon_fst));
+    EXPECT_EQ(get_arcs(*read_fst)[0], (std::vector<std::vector<int64_t>>{{1, 0, 1}, {2, 0, 2}}));
+    EXPECT_EQ(get_arcs(*read_fst)[2], (std::vector<std::vector<int64_t>>{{1, 2, 4}, {2, 3, 5}}));
+    for (int state : {3, 4, 5}) EXPECT_EQ(read_fst->Final(state), fst::TropicalWeight::One());
+    EXPECT_EQ(read_fst->Final(0), fst::TropicalWeight::Zero());
+
+    ASSERT_TRUE(read_fst->InputSymbols());
+    ASSERT_TRUE(read_fst->OutputSymbols());
+    EXPECT_EQ(read_fst->InputSymbols()->Find("b"), 2);
+    EXPECT_EQ(read_fst->OutputSymbols()->Find("bb"), 3);
+}
+
+
+TEST_F(fstArtifactTest, ConvertsAnOlderVectorFst){
+    fs::path fst_path = directory / "vector.fst";
+    fst::ArcSort(&lexicon_fst, fst::ILabelCompare<fst::StdArc>());
+    ASSERT_TRUE(lexicon_fst.Write(fst_path.string()));
+
+    std::unique_ptr<fst::StdConstFst> read_fst(myfst::read_lexicon_fst(fst_path));
+    ASSERT_TRUE(read_fst);
+    EXPECT_EQ(get_arcs(*read_fst), get_arcs(lexicon_fst));
+}
+
+
+TEST_F(fstArtifactTest, MissingFile){
+    EXPECT_EQ(myfst::read_lexicon_fst(directory / "missing.fst"), nullptr);
+    EXPECT_FALSE(myfst::write_const_fst(nullptr, directory / "null.fst"));
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+#include "utils/resampler.hpp"
+
+using namespace asr::audio;
+
+
+namespace {
+    std::vector<float> make_tone(float frequency, uint32_t sample_rate, size_t num_samples){
+        std::vector<float> tone(num_samples);
+        for (size_t i = 0; i < num_samples; ++i)
+            tone[i] = 0.5f * std::sin(2 * M_PI * frequency * i / sample_rate);
+        return tone;
+    }
+
+    double rms(const std::vector<float>& signal, size_t begin, size_t end){
+        double sum = 0;
+        for (size_t i = begin; i < end; ++i) sum += signal[i] * signal[i];
+        return std::sqrt(sum / (end - begin));
+    }
+}
+
+
+TEST(resamplerTest, rejects_invalid_rates){
+    EXPECT_THROW(polyphaseResampler(0, 16000), std::runtime_error);
+}
+
+TEST(resamplerTest, passthrough_for_equal_rates){
+    polyphaseResampler resampler(16000, 16000);
+    EXPECT_TRUE(resampler.is_passthrough());
+    auto tone = make_tone(440, 16000, 1000);
+    EXPECT_EQ(resampler.process(tone), tone);
+}
+
+TEST(resamplerTest, keeps_tones_in_band_aligned){
+    // output sample m must match the tone at time m / output_rate (filter delay compensated)
+    for (uint32_t input_rate : {48000u, 44100u, 8000u}){
+        auto tone   = make_tone(1000, input_rate, input_rate);
+        auto output = polyphaseResampler::resample(tone, input_rate, 16000);
+        ASSERT_EQ(output.size(), 16000) << input_rate;
+        auto expected = make_tone(1000, 16000, 16000);
+        for (size_t m = 100; m + 100 < output.size(); ++m)
+            ASSERT_NEAR(output[m], expected[m], 1e-3) << input_rate << " Hz, sample " << m;
+    }
+}
+
+TEST(resamplerTest, rejects_aliases){
+    // 12 kHz is above the 8 kHz nyquist of the output and would fold back to 4 kHz
+    auto tone   = make_tone(12000, 48000, 48000);
+    auto output = polyphaseResampler::resample(tone, 48000, 16000);
+    EXPECT_LT(rms(output, 200, output.size() - 200), 1e-3 * rms(tone, 0, tone.size()));
+}
+
+TEST(resamplerTest, chunked_matches_one_shot){
+    auto tone     = make_tone(700, 44100, 44100);
+    auto one_shot = polyphaseResampler::resample(tone, 44100, 16000);
+
+    polyphaseResampler resampler(44100, 16000);
+    std::vector<float> chunked;
+    for (size_t begin = 0; begin < tone.size(); begin += 441)
+        resampler.process(tone.data() + begin, std::min<size_t>(441, tone.size() - begin), chunked);
+    resampler.flush(chunked);
+
+    ASSERT_EQ(chunked.size(), one_shot.size());
+    for (size_t i = 0; i < chunked.size(); ++i)
+        ASSERT_FLOAT_EQ(chunked[i], one_shot[i]);
+}
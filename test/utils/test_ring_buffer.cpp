@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <numeric>
+#include "utils/ring_buffer.hpp"
+
+using namespace asr;
+
+
+TEST(spscRingBufferTest, rounds_capacity_to_power_of_two){
+    spscRingBuffer<float> ring(1000);
+    EXPECT_EQ(ring.capacity(), 1024);
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(spscRingBufferTest, reading_empty_ring_returns_zero){
+    spscRingBuffer<float> ring(16);
+    float out[4];
+    EXPECT_EQ(ring.read(out, 4), 0);
+    EXPECT_TRUE(ring.peek().empty());
+}
+
+TEST(spscRingBufferTest, counts_overflow_without_overwriting){
+    spscRingBuffer<int> ring(8);
+    std::vector<int> data(12);
+    std::iota(data.begin(), data.end(), 0);
+
+    EXPECT_EQ(ring.write(data.data(), data.size()), 8);
+    EXPECT_EQ(ring.get_overflow_count(), 4);
+
+    std::vector<int> out(8);
+    ASSERT_EQ(ring.read(out.data(), out.size()), 8);
+    EXPECT_EQ(out, std::vector<int>(data.begin(), data.begin() + 8)); // the oldest data survived
+}
+
+TEST(spscRingBufferTest, wraps_around_in_two_segments){
+    spscRingBuffer<int> ring(8);
+    std::vector<int> data(6), out(6);
+    std::iota(data.begin(), data.end(), 0);
+    ring.write(data.data(), 6);
+    ring.read(out.data(), 6);
+
+    std::iota(data.begin(), data.end(), 100);
+    ASSERT_EQ(ring.write(data.data(), 6), 6); // positions 6,7 then 0..3
+
+    auto view = ring.peek();
+    ASSERT_EQ(view.first.size, 2);
+    ASSERT_EQ(view.second.size, 4);
+    EXPECT_EQ(view.first.data[0], 100);
+    EXPECT_EQ(view.second.data[0], 102);
+    ring.consume(3);
+    EXPECT_EQ(ring.size(), 3);
+
+    ASSERT_EQ(ring.read(out.data(), 6), 3);
+    EXPECT_EQ(out[0], 103);
+}
+
+TEST(spscRingBufferTest, producer_views_commit_in_place){
+    spscRingBuffer<int> ring(4);
+    auto view = ring.prepare_write(3);
+    ASSERT_EQ(view.size(), 3);
+    for (size_t i = 0; i < view.first.size; ++i) view.first.data[i] = 7;
+    ring.commit(view.size());
+    EXPECT_EQ(ring.size(), 3);
+    EXPECT_EQ(ring.prepare_write(10).size(), 1);
+}
+
+TEST(spscRingBufferTest, keeps_order_across_threads){
+    const size_t total = 1 << 20;
+    spscRingBuffer<uint32_t> ring(4096);
+
+    std::thread producer([&ring, total]{
+        std::vector<uint32_t> block(256);
+        for (size_t sent = 0; sent < total; ){
+            size_t count = std::min(block.size(), total - sent);
+            for (size_t i = 0; i < count; ++i) block[i] = static_cast<uint32_t>(sent + i);
+            size_t written = 0;
+            while (written < count){
+                auto view = ring.prepare_write(count - written); // never drops: wait for room
+                std::copy(block.begin() + written, block.begin() + written + view.first.size, view.first.data);
+                std::copy(block.begin() + written + view.first.size, block.begin() + written + view.size(), view.second.data);
+                ring.commit(view.size());
+                written += view.size();
+                if (view.empty()) std::this_thread::yield();
+            }
+            sent += count;
+        }
+    });
+
+    std::vector<uint32_t> out(300);
+    size_t received = 0;
+    bool in_order = true;
+    while (received < total){
+        size_t count = ring.read(out.data(), out.size());
+        for (size_t i = 0; i < count; ++i) in_order &= (out[i] == received + i);
+        received += count;
+        if (count == 0) std::this_thread::yield();
+    }
+    producer.join();
+    EXPECT_TRUE(in_order);
+    EXPECT_EQ(ring.get_overflow_count(), 0);
+}
+
+TEST(spscRingBufferTest, size_from_a_third_thread_stays_within_capacity){
+    const size_t total = 1 << 18;
+    spscRingBuffer<uint32_t> ring(64);
+    std::atomic<bool> done{false};
+    std::atomic<size_t> max_size{0};
+
+    std::thread observer([&]{
+        while (!done.load()){
+            size_t size = ring.size();
+            if (size > max_size.load()) max_size = size;
+        }
+    });
+    std::thread producer([&ring, total]{
+        uint32_t block[16] = {};
+        for (size_t sent = 0; sent < total; ){
+            size_t written = ring.write(block, 16);
+            sent += written;
+            if (written == 0) std::this_thread::yield();
+        }
+    });
+
+    uint32_t out[16];
+    for (size_t received = 0; received < total; ){
+        size_t count = ring.read(out, 16);
+        received += count;
+        if (count == 0) std::this_thread::yield();
+    }
+    producer.join();
+    done = true;
+    observer.join();
+    EXPECT_LE(max_size.load(), ring.capacity());
+}
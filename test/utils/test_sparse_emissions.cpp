@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <stdexcept>
+#include "utils/sparse_emissions.hpp"
+
+using namespace asr::emissions;
+
+
+class sparseEmissionsTest : public testing::Test{
+protected:
+    sparseEmissionsTest(){
+        // token (t % vocab) is the best of frame t, the others decay with their distance to it
+        for (size_t t = 0; t < num_frames; ++t)
+            for (size_t v = 0; v < vocab_size; ++v)
+                log_probs.push_back(-0.5f * ((v + vocab_size - t % vocab_size) % vocab_size) - 0.1f);
+    };
+
+    const size_t num_frames = 40;
+    const size_t vocab_size = 29;
+    std::vector<float> log_probs;
+};
+
+
+TEST_F(sparseEmissionsTest, keeps_sorted_top_k){
+    sparseEmissionsConfig config;
+    config.top_k = 4;
+    auto sparse = sparseEmissions::from_log_probs(log_probs.data(), num_frames, vocab_size, config);
+    EXPECT_EQ(sparse.get_num_frames(), num_frames);
+    EXPECT_EQ(sparse.get_top_k(), 4);
+
+    std::vector<std::pair<size_t, double>> frame;
+    for (size_t t = 0; t < num_frames; ++t){
+        sparse.get_frame(t, frame);
+        ASSERT_EQ(frame.size(), 4);
+        for (size_t i = 0; i < frame.size(); ++i){
+            EXPECT_EQ(frame[i].first, (t + i) % vocab_size);
+            EXPECT_FLOAT_EQ(frame[i].second, log_probs[t * vocab_size + frame[i].first]);
+        }
+        EXPECT_FLOAT_EQ(sparse.get_blank_log_prob(t), log_probs[t * vocab_size]);
+    }
+}
+
+TEST_F(sparseEmissionsTest, quantizes_within_one_step){
+    for (auto quantization : {QUANTIZE_16, QUANTIZE_8}){
+        sparseEmissionsConfig config;
+        config.quantization = quantization;
+        auto sparse = sparseEmissions::from_log_probs(log_probs.data(), num_frames, vocab_size, config);
+
+        float step = -config.min_log_prob / ((1u << quantization) - 1);
+        std::vector<std::pair<size_t, double>> frame;
+        for (size_t t = 0; t < num_frames; ++t){
+            sparse.get_frame(t, frame);
+            for (auto& [token, log_prob] : frame)
+                ASSERT_NEAR(log_prob, log_probs[t * vocab_size + token], step / 2 + 1e-5);
+        }
+    }
+}
+
+TEST_F(sparseEmissionsTest, is_smaller_than_dense){
+    size_t dense_bytes = log_probs.size() * sizeof(float);
+    sparseEmissionsConfig config;
+    auto fp32 = sparseEmissions::from_log_probs(log_probs.data(), num_frames, vocab_size, config);
+    config.quantization = QUANTIZE_8;
+    auto q8 = sparseEmissions::from_log_probs(log_probs.data(), num_frames, vocab_size, config);
+    EXPECT_LT(fp32.get_size_bytes(), dense_bytes / 3);
+    EXPECT_LT(q8.get_size_bytes(), fp32.get_size_bytes());
+}
+
+TEST_F(sparseEmissionsTest, appends_chunks){
+    sparseEmissionsConfig config;
+    auto first  = sparseEmissions::from_log_probs(log_probs.data(), 10, vocab_size, config);
+    auto second = sparseEmissions::from_log_probs(log_probs.data() + 10 * vocab_size, num_frames - 10, vocab_size, config);
+    sparseEmissions merged;
+    merged.append(first);
+    merged.append(second);
+    EXPECT_EQ(merged.get_num_frames(), num_frames);
+
+    std::vector<std::pair<size_t, double>> frame;
+    merged.get_frame(25, frame);
+    EXPECT_EQ(frame[0].first, 25);
+
+    config.top_k = 2;
+    auto other_layout = sparseEmissions::from_log_probs(log_probs.data(), 1, vocab_size, config);
+    EXPECT_THROW(merged.append(other_layout), std::runtime_error);
+}
+
+TEST(sparseEmissionsLimitsTest, rejects_large_vocab){
+    EXPECT_THROW(sparseEmissions(300, sparseEmissionsConfig{}), std::runtime_error);
+}
@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include "utils/spsc_queue.hpp"
+
+using namespace asr;
+
+
+TEST(spscQueueTest, rejects_push_when_full){
+    spscQueue<int> queue(2);
+    EXPECT_TRUE(queue.try_push(1));
+    EXPECT_TRUE(queue.try_push(2));
+    EXPECT_FALSE(queue.try_push(3));
+    EXPECT_EQ(queue.size(), 2);
+}
+
+TEST(spscQueueTest, rejects_pop_when_empty){
+    spscQueue<int> queue(2);
+    int value = 0;
+    EXPECT_FALSE(queue.try_pop(value));
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(spscQueueTest, keeps_order_across_threads){
+    const int num_items = 100000;
+    spscQueue<std::vector<int>> queue(8);
+
+    std::thread producer([&queue, num_items](){
+        for (int i = 0; i < num_items; ++i){
+            std::vector<int> item{i};
+            while (!queue.try_push(std::move(item))) std::this_thread::yield();
+        }
+    });
+
+    int expected = 0;
+    std::vector<int> item;
+    while (expected < num_items){
+        if (!queue.try_pop(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        ASSERT_EQ(item.size(), 1);
+        ASSERT_EQ(item[0], expected);
+        ++expected;
+    }
+    producer.join();
+    EXPECT_TRUE(queue.empty());
+}
@@ -73,4 +73,32 @@ TEST_F(streamHandlerTest, shows_big_sample_rate_not_supported){
 TEST_F(streamHandlerTest, shows_acceptable_sample_rate_supported){
     s_handler.is_sample_rate_supported(250000);
     EXPECT_TRUE(s_handler.is_sample_rate_supported(15000));
-}
\ No newline at end of file
+}
+TEST_F(streamHandlerTest, int16_capture_format){
+    EXPECT_EQ(s_handler.get_sample_format(), paFloat32);
+    EXPECT_TRUE(s_handler.set_sample_format(paInt16));
+    EXPECT_EQ(s_handler.get_sample_format(), paInt16);
+    EXPECT_FALSE(s_handler.set_sample_format(paInt24));
+    EXPECT_EQ(s_handler.get_sample_format(), paInt16);
+}
+
+TEST_F(streamHandlerTest, sets_the_number_of_channels){
+    s_handler.set_number_of_channles(2, 0);
+    EXPECT_EQ(s_handler.get_number_of_channels(), std::make_tuple(2, 0));
+    s_handler.set_number_of_channles(64, 0); // more than the capture sink supports
+    EXPECT_EQ(std::get<0>(s_handler.get_number_of_channels()), 8);
+}
+
+TEST_F(streamHandlerTest, does_not_replace_the_sink_of_an_open_stream){
+    ASSERT_EQ(s_handler.init_portaudio(), 1);
+    ASSERT_EQ(s_handler.open_stream(), 1);
+    auto capture_sink = s_handler.get_capture_sink();
+    EXPECT_EQ(s_handler.open_stream(), -1); // the callback still writes into capture_sink
+    EXPECT_EQ(s_handler.get_capture_sink(), capture_sink);
+
+    EXPECT_EQ(s_handler.close_stream(), 1);
+    EXPECT_EQ(s_handler.close_stream(), 0); // nothing left to close
+    EXPECT_EQ(s_handler.open_stream(), 1);
+    EXPECT_EQ(s_handler.close_stream(), 1);
+    s_handler.terminate_portaudio();
+}
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <numeric>
+#include "utils/stream_player.hpp"
+
+using namespace asr::audio;
+
+
+class streamPlayerTest : public testing::Test{
+protected:
+    streamPlayerTest(){
+        audio.resize(sample_rate / 10); // 100 ms
+        std::iota(audio.begin(), audio.end(), 0.0f);
+    };
+
+    void add_streams(multiStreamPlayer& player, size_t num_streams, size_t capacity){
+        for (size_t i = 0; i < num_streams; ++i){
+            sinks.push_back(std::make_unique<captureSink>(sample_rate, capacity));
+            player.add_stream(audio, *sinks.back());
+        }
+    }
+
+    void wait_until_finished(multiStreamPlayer& player){
+        while (!player.all_finished()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        player.stop();
+    }
+
+    const size_t sample_rate = 16000;
+    std::vector<float> audio;
+    std::vector<std::unique_ptr<captureSink>> sinks;
+};
+
+
+TEST_F(streamPlayerTest, paced_playback_delivers_every_frame){
+    streamPlayerConfig config;
+    config.speed = 10; // 100 ms of audio in ~10 ms
+    multiStreamPlayer player(config);
+    add_streams(player, 8, sample_rate);
+
+    player.start();
+    wait_until_finished(player);
+    EXPECT_GE(player.get_elapsed(), 0.009);
+    for (auto& sink : sinks){
+        std::vector<float> out;
+        ASSERT_EQ(sink->read(out, audio.size() + 1), audio.size());
+        EXPECT_EQ(out, audio);
+        EXPECT_EQ(sink->get_stats().num_callbacks, audio.size() / config.frames_per_buffer);
+        EXPECT_EQ(sink->get_stats().discontinuities, 0);
+    }
+}
+
+TEST_F(streamPlayerTest, capture_time_follows_speed_and_stagger){
+    streamPlayerConfig config;
+    config.speed = 2;
+    config.stagger_seconds = 0.5;
+    multiStreamPlayer player(config);
+    add_streams(player, 2, 1024);
+    EXPECT_DOUBLE_EQ(player.get_capture_time(0, sample_rate), 0.5);
+    EXPECT_DOUBLE_EQ(player.get_capture_time(1, sample_rate), 0.75);
+}
+
+TEST_F(streamPlayerTest, as_fast_as_possible_applies_back_pressure){
+    streamPlayerConfig config;
+    config.speed = 0;
+    multiStreamPlayer player(config);
+    add_streams(player, 2, 512); // much smaller than the audio
+
+    player.start();
+    std::vector<std::vector<float>> received(sinks.size());
+    std::vector<float> out;
+    while (!player.all_finished() || sinks[0]->get_available() || sinks[1]->get_available()){
+        for (size_t i = 0; i < sinks.size(); ++i){
+            sinks[i]->read(out, 100);
+            received[i].insert(received[i].end(), out.begin(), out.end());
+        }
+        std::this_thread::yield();
+    }
+    player.stop();
+    for (size_t i = 0; i < sinks.size(); ++i){
+        EXPECT_EQ(received[i], audio);
+        EXPECT_EQ(sinks[i]->get_stats().frames_dropped, 0);
+    }
+}
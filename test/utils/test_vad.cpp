@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include "utils/vad.hpp"
+#include "utils/simd_kernels.hpp"
+
+using namespace asr::audio;
+
+
+class vadTest : public testing::Test{
+protected:
+    vadTest(){};
+
+    // quiet white noise (~-70 dB)
+    void add_silence(std::vector<float>& audio, size_t ms){
+        std::normal_distribution<float> noise(0.0f, 3e-4f);
+        for (size_t i = 0; i < ms * 16; ++i) audio.push_back(noise(rng));
+    }
+
+    // voiced-like tone (~-13 dB)
+    void add_speech(std::vector<float>& audio, size_t ms){
+        for (size_t i = 0; i < ms * 16; ++i) audio.push_back(0.3f * std::sin(2 * M_PI * 220 * i / 16000.0));
+    }
+
+    size_t forwarded(const std::vector<vadChunk>& chunks){
+        size_t total = 0;
+        for (const auto& chunk : chunks) total += chunk.samples.size();
+        return total;
+    }
+
+    size_t closed_segments(const std::vector<vadChunk>& chunks){
+        return std::count_if(chunks.begin(), chunks.end(), [](const vadChunk& c){return c.end_of_segment;});
+    }
+
+    std::mt19937 rng{7};
+};
+
+
+TEST_F(vadTest, frame_kernels_match_scalar){
+    std::vector<float> x(1003);
+    std::uniform_real_distribution<float> dist(-1, 1);
+    for (auto& v : x) v = dist(rng);
+
+    float sum = 0;
+    size_t crossings = 0;
+    for (size_t i = 0; i < x.size(); ++i){
+        sum += x[i] * x[i];
+        if (i + 1 < x.size()) crossings += (x[i] < 0) != (x[i + 1] < 0);
+    }
+    EXPECT_NEAR(asr::simd::sum_of_squares(x.data(), x.size()), sum, 1e-2);
+    EXPECT_EQ(asr::simd::zero_crossings(x.data(), x.size()), crossings);
+    EXPECT_EQ(asr::simd::zero_crossings(x.data(), 1), 0);
+}
+
+TEST_F(vadTest, silence_is_not_forwarded){
+    std::vector<float> audio;
+    add_silence(audio, 2000);
+    energyVad vad;
+    std::vector<vadChunk> chunks;
+    vad.process(audio.data(), audio.size(), chunks);
+    vad.flush(chunks);
+    EXPECT_EQ(forwarded(chunks), 0);
+    EXPECT_NEAR(vad.get_stats().get_saved_fraction(), 1.0, 1e-9);
+}
+
+TEST_F(vadTest, speech_is_forwarded_with_padding){
+    std::vector<float> audio;
+    add_silence(audio, 1000);
+    add_speech(audio, 500);
+    add_silence(audio, 1000);
+
+    vadConfig config;
+    energyVad vad(config);
+    std::vector<vadChunk> chunks;
+    vad.process(audio.data(), audio.size(), chunks);
+    vad.flush(chunks);
+
+    ASSERT_EQ(closed_segments(chunks), 1);
+    EXPECT_TRUE(chunks.back().end_of_segment);
+    // speech + pre-roll + hangover (one frame of slack each side)
+    size_t expected = (500 + config.preroll_ms + config.hangover_ms) * 16;
+    EXPECT_NEAR(static_cast<double>(forwarded(chunks)), expected, 2 * vad.get_frame_size());
+    EXPECT_GT(vad.get_stats().get_saved_fraction(), 0.5);
+    EXPECT_FALSE(vad.in_speech());
+}
+
+TEST_F(vadTest, gaps_close_segments_across_calls){
+    std::vector<float> audio;
+    for (int i = 0; i < 3; ++i){
+        add_silence(audio, 800);
+        add_speech(audio, 300);
+    }
+    add_silence(audio, 800);
+
+    energyVad vad;
+    std::vector<vadChunk> chunks;
+    for (size_t begin = 0; begin < audio.size(); begin += 1234){ // not a multiple of the frame size
+        size_t size = std::min<size_t>(1234, audio.size() - begin);
+        vad.process(audio.data() + begin, size, chunks);
+    }
+    vad.flush(chunks);
+    EXPECT_EQ(closed_segments(chunks), 3);
+    EXPECT_EQ(vad.get_stats().num_segments, 3);
+    EXPECT_EQ(vad.get_stats().samples_in, audio.size());
+}
+
+TEST_F(vadTest, short_clicks_do_not_open_a_segment){
+    std::vector<float> audio;
+    add_silence(audio, 500);
+    add_speech(audio, 10); // one frame
+    add_silence(audio, 500);
+    energyVad vad;
+    std::vector<vadChunk> chunks;
+    vad.process(audio.data(), audio.size(), chunks);
+    vad.flush(chunks);
+    EXPECT_EQ(forwarded(chunks), 0);
+}
+
+TEST_F(vadTest, flush_closes_an_open_segment){
+    std::vector<float> audio;
+    add_silence(audio, 300);
+    add_speech(audio, 305);
+    energyVad vad;
+    std::vector<vadChunk> chunks;
+    vad.process(audio.data(), audio.size(), chunks);
+    EXPECT_TRUE(vad.in_speech());
+    vad.flush(chunks);
+    EXPECT_EQ(closed_segments(chunks), 1);
+    EXPECT_EQ(vad.get_stats().samples_forwarded, forwarded(chunks));
+}
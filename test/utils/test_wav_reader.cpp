@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+#include <cmath>
+#include "utils/wav_reader.hpp"
+#include "utils/simd_kernels.hpp"
+
+namespace fs = std::filesystem;
+using namespace asr::audio;
+
+
+namespace {
+    void put_u16(std::string& bytes, uint16_t value){bytes.append(reinterpret_cast<const char*>(&value), 2);}
+    void put_u32(std::string& bytes, uint32_t value){bytes.append(reinterpret_cast<const char*>(&value), 4);}
+
+    // writes a wav with an extra LIST chunk (odd size) between fmt and data
+    void write_wav(const fs::path& path, uint16_t format_tag, uint16_t channels, uint16_t bits,
+                   const std::string& samples, bool extensible = false){
+        std::string fmt;
+        uint16_t block_align = channels * bits / 8;
+        put_u16(fmt, extensible ? 0xFFFE : format_tag);
+        put_u16(fmt, channels);
+        put_u32(fmt, 16000);
+        put_u32(fmt, 16000 * block_align);
+        put_u16(fmt, block_align);
+        put_u16(fmt, bits);
+        if (extensible){
+            put_u16(fmt, 22); put_u16(fmt, bits); put_u32(fmt, 0);
+            put_u16(fmt, format_tag); fmt.append(14, '\0');
+        }
+
+        std::string body = "WAVE";
+        body += "fmt "; put_u32(body, fmt.size()); body += fmt;
+        body += "LIST"; put_u32(body, 3); body += "abc"; body += '\0';
+        body += "data"; put_u32(body, samples.size()); body += samples;
+
+        std::ofstream file(path, std::ios::binary);
+        file << "RIFF";
+        std::string size; put_u32(size, body.size());
+        file << size << body;
+    }
+}
+
+
+class wavReaderTest : public testing::Test{
+protected:
+    wavReaderTest(){
+        for (size_t i = 0; i < num_samples; ++i)
+            reference.push_back(0.8f * std::sin(0.01f * i));
+    };
+    ~wavReaderTest(){
+        fs::remove(wav_path);
+    }
+
+    const size_t num_samples = 10007; // not a multiple of any vector width
+    std::vector<float> reference;
+    fs::path wav_path = fs::temp_directory_path() / "test_wav_reader.wav";
+};
+
+
+TEST_F(wavReaderTest, rejects_invalid_files){
+    wavReader wav_reader;
+    EXPECT_FALSE(wav_reader.open(fs::temp_directory_path() / "missing.wav"));
+
+    std::ofstream invalid_file(wav_path, std::ios::binary);
+    invalid_file << "RIFF....WAVEnot a fmt chunk";
+    invalid_file.close();
+    EXPECT_FALSE(wav_reader.open(wav_path));
+}
+
+TEST_F(wavReaderTest, reads_pcm16){
+    std::string samples;
+    for (float value : reference) put_u16(samples, static_cast<int16_t>(std::lround(value * 32767)));
+    write_wav(wav_path, 1, 1, 16, samples);
+
+    wavReader wav_reader(wav_path);
+    EXPECT_EQ(wav_reader.get_info().format, WAV_PCM_16);
+    EXPECT_EQ(wav_reader.get_info().sample_rate, 16000);
+    auto audio = wav_reader.read_all();
+    ASSERT_EQ(audio.size(), num_samples);
+    for (size_t i = 0; i < num_samples; ++i)
+        ASSERT_NEAR(audio[i], reference[i], 1e-4);
+}
+
+TEST_F(wavReaderTest, reads_pcm24_extensible){
+    std::string samples;
+    for (float value : reference){
+        int32_t level = static_cast<int32_t>(std::lround(value * 8388607));
+        samples.append(reinterpret_cast<const char*>(&level), 3);
+    }
+    write_wav(wav_path, 1, 1, 24, samples, true);
+
+    wavReader wav_reader(wav_path);
+    EXPECT_EQ(wav_reader.get_info().format, WAV_PCM_24);
+    auto audio = wav_reader.read_all();
+    ASSERT_EQ(audio.size(), num_samples);
+    for (size_t i = 0; i < num_samples; ++i)
+        ASSERT_NEAR(audio[i], reference[i], 1e-6);
+}
+
+TEST_F(wavReaderTest, reads_pcm32_stereo_as_mono){
+    std::string samples;
+    for (float value : reference){
+        put_u32(samples, static_cast<uint32_t>(static_cast<int32_t>(std::lround(value * 2147483647.0))));
+        put_u32(samples, 0); // silent right channel
+    }
+    write_wav(wav_path, 1, 2, 32, samples);
+
+    wavReader wav_reader(wav_path);
+    EXPECT_EQ(wav_reader.get_info().num_channels, 2);
+    auto audio = wav_reader.read_all();
+    ASSERT_EQ(audio.size(), num_samples);
+    for (size_t i = 0; i < num_samples; ++i)
+        ASSERT_NEAR(audio[i], reference[i] / 2, 1e-6);
+}
+
+TEST_F(wavReaderTest, streams_float32_in_chunks){
+    std::string samples(reinterpret_cast<const char*>(reference.data()), reference.size() * sizeof(float));
+    write_wav(wav_path, 3, 1, 32, samples);
+
+    wavReader wav_reader(wav_path);
+    EXPECT_EQ(wav_reader.get_info().format, WAV_FLOAT_32);
+    std::vector<float> chunk, audio;
+    while (wav_reader.read(chunk, 1000) > 0)
+        audio.insert(audio.end(), chunk.begin(), chunk.end());
+    EXPECT_TRUE(wav_reader.eof());
+    EXPECT_EQ(audio, reference);
+
+    ASSERT_TRUE(wav_reader.seek(5000));
+    ASSERT_EQ(wav_reader.read(chunk, 10), 10);
+    EXPECT_EQ(chunk[0], reference[5000]);
+    EXPECT_FALSE(wav_reader.seek(num_samples + 1));
+}
+
+TEST_F(wavReaderTest, parses_a_file_in_memory){
+    std::string samples(reinterpret_cast<const char*>(reference.data()), reference.size() * sizeof(float));
+    write_wav(wav_path, 3, 1, 32, samples);
+    std::ifstream file(wav_path, std::ios::binary);
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    wavReader wav_reader;
+    ASSERT_TRUE(wav_reader.open_memory(bytes.data(), bytes.size()));
+    EXPECT_EQ(wav_reader.read_all(), reference);
+    wav_reader.close(); // the buffer is not unmapped
+    EXPECT_FALSE(wav_reader.open_memory(bytes.data(), 8));
+}
+
+TEST(simdKernelsTest, downmix_matches_scalar){
+    for (size_t channels : {2, 3}){
+        std::vector<float> interleaved(37 * channels), mono(37);
+        for (size_t i = 0; i < interleaved.size(); ++i) interleaved[i] = 0.01f * i;
+        asr::simd::downmix_to_mono(interleaved.data(), mono.data(), 37, channels);
+        for (size_t i = 0; i < 37; ++i){
+            float expected = 0;
+            for (size_t c = 0; c < channels; ++c) expected += interleaved[i * channels + c];
+            ASSERT_NEAR(mono[i], expected / channels, 1e-6);
+        }
+    }
+}